@@ -90,7 +90,17 @@ class connection_basic { // not-templated base class for rapid developmet of som
     volatile uint32_t m_want_close_connection;
     std::atomic<bool> m_was_shutdown;
     critical_section m_send_que_lock;
-    std::list<std::string> m_send_que;
+    /// A part of a buffer that may be queued on other connections too
+    struct send_slice
+    {
+      shared_buffer buffer;
+      size_t offset;
+      size_t length;
+
+      const char* data() const { return buffer->data() + offset; }
+      size_t size() const { return length; }
+    };
+    std::list<send_slice> m_send_que;
     volatile bool m_is_multithreaded;
     double m_start_time;
     /// Strand to ensure the connection's handlers are not called concurrently.
@@ -31,6 +31,8 @@
 
 #include <boost/uuid/uuid.hpp>
 #include <boost/asio/io_service.hpp>
+#include <boost/shared_ptr.hpp>
+#include <string>
 #include <typeinfo>
 #include <type_traits>
 #include "serialization/keyvalue_serialization.h"
@@ -280,9 +282,14 @@ namespace net_utils
 	/************************************************************************/
 	/*                                                                      */
 	/************************************************************************/
+	/// Immutable bytes which may sit in the send queues of many connections at once
+	typedef boost::shared_ptr<const std::string> shared_buffer;
+
 	struct i_service_endpoint
 	{
 		virtual bool do_send(const void* ptr, size_t cb)=0;
+    /// Queues the whole buffer, endpoints able to keep a reference to it do so instead of copying
+    virtual bool do_send_buffer(const shared_buffer& buf) { return do_send(buf->data(), buf->size()); }
     virtual bool close()=0;
     virtual bool call_run_once_service_io()=0;
     virtual bool request_callback()=0;
@@ -140,7 +140,7 @@ void BlockchainDB::add_transaction(const crypto::hash& blk_hash, const transacti
     crypto::hash btc_hash;
     uint64_t height = 0;
     int signer_idx = -1;
-    if (verify_embedded_ntz_data(tx, btc_hash, height, signer_idx))
+    if (verify_embedded_ntz_data(tx, btc_hash, height, signer_idx, &tx_hash))
     {
       if (!btc_tx_exists(btc_hash)) {
         add_btc_tx(btc_hash, blk_hash);
@@ -227,10 +227,16 @@ uint64_t BlockchainDB::add_block( const block& blk
   add_transaction(blk_hash, blk.miner_tx);
   int tx_i = 0;
   crypto::hash tx_hash = crypto::null_hash;
+  const crypto::hash tree_hash = get_tx_tree_hash(blk);
   for (const transaction& tx : txs)
   {
     tx_hash = blk.tx_hashes[tx_i];
     add_transaction(blk_hash, tx, &tx_hash);
+    if (is_ntz_tx(tx))
+    {
+      add_ntz_tx(tx_hash, prev_height, tree_hash);
+      push_ntz_state(tx_hash, prev_height, tree_hash);
+    }
     ++tx_i;
   }
   TIME_MEASURE_FINISH(time1);
@@ -239,6 +245,14 @@ uint64_t BlockchainDB::add_block( const block& blk
   // call out to subclass implementation to add the block & metadata
   time1 = epee::misc_utils::get_tick_count();
   add_block(blk, block_size, cumulative_difficulty, coins_generated, blk_hash);
+  add_block_tree_hash(prev_height, tree_hash);
+  {
+    CRITICAL_REGION_LOCAL(m_mom_index_lock);
+    if (m_mom_index.height() == prev_height)
+      m_mom_index.push(tree_hash);
+    else
+      m_mom_index.reset(prev_height + 1);
+  }
   TIME_MEASURE_FINISH(time1);
   time_add_block1 += time1;
 
@@ -261,6 +275,11 @@ void BlockchainDB::pop_block(block& blk, std::vector<transaction>& txs)
   blk = get_top_block();
 
   remove_block();
+  remove_block_tree_hash(height());
+  {
+    CRITICAL_REGION_LOCAL(m_mom_index_lock);
+    m_mom_index.pop();
+  }
 
   for (const auto& h : boost::adaptors::reverse(blk.tx_hashes))
   {
@@ -284,7 +303,7 @@ void BlockchainDB::remove_transaction(const crypto::hash& tx_hash)
     crypto::hash btc_hash = crypto::null_hash;
     uint64_t height = 0;
     int signer_idx = -1;
-    if (verify_embedded_ntz_data(tx, btc_hash, height, signer_idx))
+    if (verify_embedded_ntz_data(tx, btc_hash, height, signer_idx, &tx_hash))
     {
       if (btc_tx_exists(btc_hash)) {
         remove_btc_tx_data(btc_hash);
@@ -294,6 +313,12 @@ void BlockchainDB::remove_transaction(const crypto::hash& tx_hash)
     }
   }
 
+  if (is_ntz_tx(tx))
+  {
+    remove_ntz_tx_data(tx_hash);
+    pop_ntz_state();
+  }
+
   for (const txin_v& tx_input : tx.vin)
   {
     if (tx_input.type() == typeid(txin_to_key))
@@ -306,6 +331,171 @@ void BlockchainDB::remove_transaction(const crypto::hash& tx_hash)
   remove_transaction_data(tx_hash, tx);
 }
 
+static void append_ntz(ntz_state_t& state, notarized_tree_hashes& merkle, const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash)
+{
+  if (state.ntz_tx_count && height > state.notarized_height)
+    state.notarized_prevheight = state.notarized_height;
+  state.notarized_height = height;
+  state.notarized_txid = tx_hash;
+  ++state.ntz_tx_count;
+  merkle.push(height, tree_hash);
+}
+
+void BlockchainDB::push_ntz_state(const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash)
+{
+  CRITICAL_REGION_LOCAL(m_ntz_state_lock);
+  append_ntz(m_ntz_state, m_ntz_merkle, tx_hash, height, tree_hash);
+  m_ntz_state.notarized_MoM = m_ntz_merkle.root();
+}
+
+void BlockchainDB::pop_ntz_state()
+{
+  CRITICAL_REGION_LOCAL(m_ntz_state_lock);
+  m_ntz_state.notarized_height = get_notarized_height(m_ntz_state.notarized_txid);
+  m_ntz_state.notarized_prevheight = get_notarized_prevheight();
+  if (m_ntz_state.ntz_tx_count)
+    --m_ntz_state.ntz_tx_count;
+  m_ntz_merkle.pop();
+  m_ntz_state.notarized_MoM = m_ntz_merkle.root();
+}
+
+bool ntzpool_cache::txid_less::operator()(const crypto::hash& a, const crypto::hash& b) const
+{
+  // same as compare_hash32 in the LMDB backend: 32 bit words, last first
+  const uint32_t *va = (const uint32_t*)a.data;
+  const uint32_t *vb = (const uint32_t*)b.data;
+  for (int n = 7; n >= 0; n--)
+  {
+    if (va[n] != vb[n])
+      return va[n] < vb[n];
+  }
+  return false;
+}
+
+ntzpool_cache::ntzpool_cache(): m_snapshot(std::make_shared<const entries_t>())
+{
+}
+
+ntzpool_cache::snapshot_t ntzpool_cache::snapshot() const
+{
+  return std::atomic_load(&m_snapshot);
+}
+
+void ntzpool_cache::publish(std::shared_ptr<entries_t> entries)
+{
+  std::atomic_store(&m_snapshot, snapshot_t(std::move(entries)));
+}
+
+void ntzpool_cache::reset(entries_t entries)
+{
+  CRITICAL_REGION_LOCAL(m_write_lock);
+  publish(std::make_shared<entries_t>(std::move(entries)));
+}
+
+void ntzpool_cache::put(const crypto::hash& txid, ntzpool_entry entry)
+{
+  CRITICAL_REGION_LOCAL(m_write_lock);
+  std::shared_ptr<entries_t> entries = std::make_shared<entries_t>(*snapshot());
+  (*entries)[txid] = std::move(entry);
+  publish(std::move(entries));
+}
+
+bool ntzpool_cache::update_meta(const crypto::hash& txid, const ntzpool_tx_meta_t& meta)
+{
+  CRITICAL_REGION_LOCAL(m_write_lock);
+  std::shared_ptr<entries_t> entries = std::make_shared<entries_t>(*snapshot());
+  auto it = entries->find(txid);
+  if (it == entries->end())
+    return false;
+  it->second.meta = meta;
+  publish(std::move(entries));
+  return true;
+}
+
+bool ntzpool_cache::erase(const crypto::hash& txid)
+{
+  CRITICAL_REGION_LOCAL(m_write_lock);
+  std::shared_ptr<entries_t> entries = std::make_shared<entries_t>(*snapshot());
+  if (!entries->erase(txid))
+    return false;
+  publish(std::move(entries));
+  return true;
+}
+
+void BlockchainDB::load_ntz_state()
+{
+  CRITICAL_REGION_LOCAL(m_ntz_state_lock);
+  m_ntz_state = ntz_state_t();
+  m_ntz_merkle.clear();
+  for_all_ntz_txs([this](uint64_t ntz_idx, const crypto::hash& tx_hash, uint64_t height, const crypto::hash& tree_hash)->bool
+  {
+    append_ntz(m_ntz_state, m_ntz_merkle, tx_hash, height, tree_hash);
+    return true;
+  });
+  m_ntz_state.notarized_MoM = m_ntz_merkle.root();
+}
+
+ntz_state_t BlockchainDB::get_ntz_state() const
+{
+  CRITICAL_REGION_LOCAL(m_ntz_state_lock);
+  return m_ntz_state;
+}
+
+bool BlockchainDB::get_notarization_covering(uint64_t height, uint64_t& ntz_height, uint64_t& prev_height, crypto::hash& ntz_txid) const
+{
+  ntz_height = prev_height = 0;
+  ntz_txid = crypto::null_hash;
+  {
+    CRITICAL_REGION_LOCAL(m_ntz_state_lock);
+    if (!m_ntz_merkle.covering(height, ntz_height, prev_height))
+      return false;
+  }
+  for_ntz_txs_range(ntz_height, ntz_height, [&ntz_txid](uint64_t ntz_idx, const crypto::hash& tx_hash, uint64_t ntz_blk_height, const crypto::hash& tree_hash)->bool
+  {
+    ntz_txid = tx_hash;
+    return false;
+  });
+  return true;
+}
+
+void BlockchainDB::load_mom_index()
+{
+  const uint64_t chain_height = height();
+  uint64_t count = std::min<uint64_t>(chain_height, DPOW_MOM_INDEX_HEIGHTS);
+  std::vector<crypto::hash> tree_hashes;
+  try
+  {
+    get_block_tree_hashes(chain_height - count, count, tree_hashes);
+  }
+  catch (const BLOCK_DNE&)
+  {
+    // the column is still being built; start empty at the tip
+    count = 0;
+    tree_hashes.clear();
+  }
+
+  CRITICAL_REGION_LOCAL(m_mom_index_lock);
+  m_mom_index.reset(chain_height - count);
+  for (const auto& tree_hash : tree_hashes)
+    m_mom_index.push(tree_hash);
+}
+
+crypto::hash BlockchainDB::get_MoM(const uint64_t height, const uint64_t depth) const
+{
+  if (depth == 0 || depth > height + 1 || height >= this->height())
+    return crypto::null_hash;
+
+  {
+    CRITICAL_REGION_LOCAL(m_mom_index_lock);
+    if (m_mom_index.covers(height, depth))
+      return m_mom_index.root(height, depth);
+  }
+
+  std::vector<crypto::hash> tree_hashes;
+  get_block_tree_hashes(height - depth + 1, depth, tree_hashes);
+  return get_tx_tree_hash(tree_hashes);
+}
+
 block BlockchainDB::get_block_from_height(const uint64_t& height) const
 {
   blobdata bd = get_block_blob_from_height(height);
@@ -32,6 +32,8 @@
 #pragma once
 
 #include <list>
+#include <map>
+#include <memory>
 #include <string>
 #include <exception>
 #include <boost/program_options.hpp>
@@ -41,7 +43,9 @@
 #include "cryptonote_basic/cryptonote_basic.h"
 #include "cryptonote_basic/difficulty.h"
 #include "cryptonote_basic/hardfork.h"
+#include "cryptonote_basic/ntz_signers.h"
 #include "db_structs.h"
+#include "ntz_state.h"
 
 /** \file
  * Cryptonote Blockchain Database Interface
@@ -187,7 +191,76 @@ struct ntzpool_tx_meta_t
   uint8_t  sig_count;                 /* 1  *    = 150 */
                                       /* (13)     = 163 */
   int signers_index[DPOW_SIG] = { VALUEX(DPOW_SIG_COUNT) };
-  uint8_t padding[(42-DPOW_SIG_COUNT)];                /* till 192 bytes */
+  uint64_t signers_mask;              /* 8  */
+  uint8_t padding[(42-DPOW_SIG_COUNT)-8];              /* till 192 bytes */
+};
+
+/**
+ * @brief an ntzpool transaction as held in memory
+ */
+struct ntzpool_entry
+{
+  ntzpool_tx_meta_t meta;
+  cryptonote::blobdata blob;
+  cryptonote::blobdata ptx_blob;
+};
+
+/**
+ * @brief copy-on-write, in-memory copy of the ntzpool
+ *
+ * Readers take the current snapshot and walk it without holding any lock,
+ * even while writers publish newer ones; a snapshot, once taken, never
+ * changes.  Writers copy the current map, modify the copy and publish it.
+ * The ntzpool holds a few dozen entries at most, so copying is cheap next
+ * to the lock contention it removes.
+ */
+class ntzpool_cache
+{
+public:
+  //! orders txids as the LMDB ntzpool tables do, so walks keep their order
+  struct txid_less
+  {
+    bool operator()(const crypto::hash& a, const crypto::hash& b) const;
+  };
+  typedef std::map<crypto::hash, ntzpool_entry, txid_less> entries_t;
+  typedef std::shared_ptr<const entries_t> snapshot_t;
+
+  ntzpool_cache();
+
+  /**
+   * @brief gets the current contents, without blocking on writers
+   */
+  snapshot_t snapshot() const;
+
+  /**
+   * @brief replaces the whole contents
+   */
+  void reset(entries_t entries);
+
+  /**
+   * @brief adds or replaces an entry
+   */
+  void put(const crypto::hash& txid, ntzpool_entry entry);
+
+  /**
+   * @brief replaces the metadata of an entry
+   *
+   * @return false if there is no entry for txid
+   */
+  bool update_meta(const crypto::hash& txid, const ntzpool_tx_meta_t& meta);
+
+  /**
+   * @brief removes an entry
+   *
+   * @return false if there was no entry for txid
+   */
+  bool erase(const crypto::hash& txid);
+
+private:
+  void publish(std::shared_ptr<entries_t> entries);
+
+  snapshot_t m_snapshot;  //!< only accessed through std::atomic_load/atomic_store
+  epee::critical_section m_write_lock;  //!< serializes writers' copy-and-publish
 };
 
 #define DBF_SAFE       1
@@ -526,6 +599,62 @@ private:
   virtual uint64_t add_btc_tx(crypto::hash const& btc_hash, crypto::hash const& blk_hash) = 0;
   virtual void remove_btc_tx_data(crypto::hash const& btc_hash) = 0;
 
+  /**
+   * @brief store a notarization transaction in the notarization index
+   *
+   * The subclass implementing this will append the notarization tx hash,
+   * the height of the block containing it and that block's tx tree hash to
+   * its notarization index. Notarizations are appended in chain order, so
+   * the most recent entry is always the most recently notarized height.
+   *
+   * If any of this cannot be done, the subclass should throw the corresponding
+   * subclass of DB_EXCEPTION
+   *
+   * @param tx_hash the hash of the notarization transaction
+   * @param height the height of the block containing the transaction
+   * @param tree_hash the tx tree hash of the block containing the transaction
+   *
+   * @return the index of the notarization in the index
+   */
+  virtual uint64_t add_ntz_tx(const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash) = 0;
+
+  /**
+   * @brief remove a notarization transaction from the notarization index
+   *
+   * Since blocks are only ever popped from the top, the notarization being
+   * removed must be the most recent entry of the index.
+   *
+   * If any of this cannot be done, the subclass should throw the corresponding
+   * subclass of DB_EXCEPTION
+   *
+   * @param tx_hash the hash of the notarization transaction to remove
+   */
+  virtual void remove_ntz_tx_data(const crypto::hash& tx_hash) = 0;
+
+  /**
+   * @brief store the tx tree hash of a newly added block
+   *
+   * The subclass implementing this will append the hash to its per-block
+   * tree hash column, which MoM queries read instead of the blocks.
+   *
+   * If any of this cannot be done, the subclass should throw the corresponding
+   * subclass of DB_EXCEPTION
+   *
+   * @param height the height of the block
+   * @param tree_hash the tx tree hash of the block
+   */
+  virtual void add_block_tree_hash(const uint64_t height, const crypto::hash& tree_hash) = 0;
+
+  /**
+   * @brief remove the tx tree hash of the top block
+   *
+   * If any of this cannot be done, the subclass should throw the corresponding
+   * subclass of DB_EXCEPTION
+   *
+   * @param height the height of the block being removed
+   */
+  virtual void remove_block_tree_hash(const uint64_t height) = 0;
+
   /**
    * @brief remove a spent key
    *
@@ -560,6 +689,23 @@ private:
    */
   void remove_transaction(const crypto::hash& tx_hash);
 
+  /**
+   * @brief fold a newly added notarization into the cached notarization state
+   *
+   * @param tx_hash the hash of the notarization transaction
+   * @param height the height of the block containing the transaction
+   * @param tree_hash the tx tree hash of the block containing the transaction
+   */
+  void push_ntz_state(const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash);
+
+  /**
+   * @brief drop the most recent notarization from the cached notarization state
+   *
+   * Must be called after the notarization was removed from the index, as the
+   * new top of the index is read back from the subclass.
+   */
+  void pop_ntz_state();
+
   uint64_t num_calls = 0;  //!< a performance metric
   uint64_t time_blk_hash = 0;  //!< a performance metric
   uint64_t time_add_block1 = 0;  //!< a performance metric
@@ -586,6 +732,21 @@ protected:
 
   HardFork* m_hardfork;
 
+  /**
+   * @brief rebuild the cached notarization state from the notarization index
+   *
+   * Subclasses should call this once the database is opened, and whenever a
+   * write is rolled back, so the cache matches what is actually stored.
+   */
+  void load_ntz_state();
+
+  /**
+   * @brief reload the in-memory MoM index from the block tree hash column
+   *
+   * Subclasses should call this alongside load_ntz_state().
+   */
+  void load_mom_index();
+
 public:
 
   /**
@@ -1183,14 +1344,93 @@ public:
   virtual uint64_t get_tx_count() const = 0;
 
   /**
-   * @brief fetches corresponding index for notarization
+   * @brief fetches the total number of notarization transactions
+   *
+   * The subclass should return the number of entries in its notarization
+   * index, without walking the transactions themselves.
+   *
+   * @return the number of notarization transactions in the blockchain
+   */
+  virtual uint64_t get_ntz_tx_count() const = 0;
+
+  /**
+   * @brief fetches the most recently notarized height
+   *
+   * The subclass should return the height of the block containing the most
+   * recent notarization transaction, along with that transaction's hash.
+   *
+   * If there are no notarizations, the subclass should return 0 and set
+   * ntz_txid to null_hash.
+   *
+   * @param ntz_txid return-by-reference the hash of the latest notarization tx
+   *
+   * @return the latest notarized height
+   */
+  virtual uint64_t get_notarized_height(crypto::hash& ntz_txid) const = 0;
+
+  /**
+   * @brief fetches the notarized height preceding the latest one
+   *
+   * The subclass should return the greatest notarized height which is
+   * strictly lower than the latest notarized height, or 0 if there is none.
+   *
+   * @return the previous notarized height
+   */
+  virtual uint64_t get_notarized_prevheight() const = 0;
+
+  /**
+   * @brief fetches the cached notarization state
+   *
+   * The state, including the Merkle-of-Merkles over the tx tree hashes of
+   * notarized blocks, is updated incrementally as blocks are added and
+   * popped, so this does not touch the database.
+   *
+   * @return a copy of the current notarization state
+   */
+  ntz_state_t get_ntz_state() const;
+
+  /**
+   * @brief fetches the notarization covering a block
+   *
+   * The notarized height is found by bisecting the cached notarized heights,
+   * and its first notarization tx is then sought in the notarization index.
    *
-   * The subclass should returm a uint64_t corresponding to a notarizations
-   * chronological index.
+   * @param height the block height to cover
+   * @param ntz_height return-by-reference the lowest notarized height >= height
+   * @param prev_height return-by-reference the notarized height below ntz_height, or 0
+   * @param ntz_txid return-by-reference the first notarization tx at ntz_height
    *
-   * @return the index of notarization in the blockchain
+   * @return false if no notarized height reaches height, otherwise true
    */
-//  virtual uint64_t get_notarization_index(crypto::hash const& h) const = 0;
+  bool get_notarization_covering(uint64_t height, uint64_t& ntz_height, uint64_t& prev_height, crypto::hash& ntz_txid) const;
+
+  /**
+   * @brief fetches the tx tree hashes of a run of blocks
+   *
+   * The subclass should read them from its per-block tree hash column, in
+   * ascending height order, without loading the blocks.
+   *
+   * The subclass should throw BLOCK_DNE if any of the heights is not stored.
+   *
+   * @param start_height the height of the first block
+   * @param count the number of blocks
+   * @param hashes return-by-reference the tree hashes
+   */
+  virtual void get_block_tree_hashes(const uint64_t start_height, const size_t count, std::vector<crypto::hash>& hashes) const = 0;
+
+  /**
+   * @brief computes the Merkle-of-Merkles over a window of blocks
+   *
+   * The MoM is the tree hash of the tx tree hashes of the blocks from
+   * height - depth + 1 up to height, as for the notarized MoM. Recent windows are answered from an in-memory index
+   * in O(log depth), others are folded from the tree hash column.
+   *
+   * @param height the height of the top block of the window
+   * @param depth the number of blocks in the window
+   *
+   * @return the MoM, or null_hash if the window is empty or not in the chain
+   */
+  crypto::hash get_MoM(const uint64_t height, const uint64_t depth) const;
 
   /**
    * @brief fetches a list of transactions based on their hashes
@@ -1335,6 +1575,22 @@ public:
    * @param outputs return-by-reference a list of outputs' metadata
    */
   virtual void get_output_key(const uint64_t &amount, const std::vector<uint64_t> &offsets, std::vector<output_data_t> &outputs, bool allow_partial = false) = 0;
+
+  /**
+   * @brief gets outputs' data, and optionally their tx hashes and indices
+   *
+   * This function is a mirror of
+   * get_output_key(const uint64_t &amount, const std::vector<uint64_t> &offsets, std::vector<output_data_t> &outputs, bool allow_partial)
+   * but for outputs of any amount, and can fill in what
+   * get_output_tx_and_index() would return for each output at the same time.
+   *
+   * If an output cannot be found, the subclass should throw OUTPUT_DNE.
+   *
+   * @param outputs a list of (amount, amount-specific output index) pairs
+   * @param data return-by-reference a list of outputs' metadata, in the same order
+   * @param tx_out_indices if not NULL, return-by-reference a list of tx hashes and output indices, in the same order
+   */
+  virtual void get_output_keys_batch(const std::vector<std::pair<uint64_t, uint64_t>> &outputs, std::vector<output_data_t> &data, std::vector<tx_out_index> *tx_out_indices = NULL) const = 0;
   
   /*
    * FIXME: Need to check with git blame and ask what this does to
@@ -1358,6 +1614,21 @@ public:
    */
   virtual std::vector<uint64_t> get_tx_amount_output_indices(const uint64_t tx_id) const = 0;
 
+  /**
+   * @brief gets output indices (amount-specific) for several transactions' outputs
+   *
+   * This function is a mirror of
+   * get_tx_amount_output_indices(const uint64_t tx_id),
+   * but for a list of transactions, given by hash, looked up together
+   * within a single read transaction.
+   *
+   * If a transaction does not exist, the subclass should throw TX_DNE.
+   *
+   * @param tx_hashes a list of transaction hashes
+   * @param amount_output_indices return-by-reference a list of amount-specific output indices for each transaction, in the same order
+   */
+  virtual void get_tx_amount_output_indices_batch(const std::vector<crypto::hash>& tx_hashes, std::vector<std::vector<uint64_t>>& amount_output_indices) const = 0;
+
   /**
    * @brief check if a key image is stored as spent
    *
@@ -1573,6 +1844,37 @@ public:
    */
   virtual bool for_all_transactions(std::function<bool(const crypto::hash&, const cryptonote::transaction&)>) const = 0;
 
+  /**
+   * @brief runs a function over all notarization transactions stored
+   *
+   * The subclass should run the passed function for each entry of its
+   * notarization index in chain order, passing (ntz_index, tx_hash,
+   * block_height, block_tree_hash) as its parameters.
+   *
+   * If any call to the function returns false, the subclass should return
+   * false.  Otherwise, the subclass returns true.
+   *
+   * @param std::function f the function to run
+   *
+   * @return false if the function returns false for any notarization, otherwise true
+   */
+  virtual bool for_all_ntz_txs(std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)> f) const = 0;
+
+  /**
+   * @brief runs a function over the notarizations of a range of blocks
+   *
+   * As for_all_ntz_txs, but only for notarizations whose block height
+   * lies in [h1, h2].  The subclass should locate the first such entry
+   * without walking the index from its start.
+   *
+   * @param h1 the lowest notarized block height to visit
+   * @param h2 the highest notarized block height to visit
+   * @param std::function f the function to run
+   *
+   * @return false if the function returns false for any notarization, otherwise true
+   */
+  virtual bool for_ntz_txs_range(const uint64_t& h1, const uint64_t& h2, std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)> f) const = 0;
+
   /**
    * @brief runs a function over all outputs stored
    *
@@ -1664,6 +1966,13 @@ public:
   bool m_open;  //!< Whether or not the BlockchainDB is open/ready for use
   mutable epee::critical_section m_synchronization_lock;  //!< A lock, currently for when BlockchainLMDB needs to resize the backing db file
 
+private:
+  ntz_state_t m_ntz_state;  //!< cached summary of the notarizations on the main chain
+  notarized_tree_hashes m_ntz_merkle;  //!< tx tree hashes of notarized blocks, one leaf per ntz tx
+  mutable epee::critical_section m_ntz_state_lock;  //!< guards m_ntz_state and m_ntz_merkle
+  mom_index m_mom_index;  //!< subtree roots over the tree hashes of the most recent blocks
+  mutable epee::critical_section m_mom_index_lock;  //!< guards m_mom_index
+
 };  // class BlockchainDB
 
 BlockchainDB *new_db(const std::string& db_type);
@@ -57,6 +57,15 @@ struct btc_data_t
 };
 #pragma pack(pop)
 
+#pragma pack(push, 1)
+struct ntz_data_t
+{
+  crypto::hash tx_hash;
+  uint64_t height;
+  crypto::hash tree_hash;
+};
+#pragma pack(pop)
+
 namespace cryptonote {
 
 typedef struct mdb_block_info
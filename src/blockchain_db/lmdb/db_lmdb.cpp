@@ -35,6 +35,8 @@
 #include <memory>  // std::unique_ptr
 #include <cstring>  // memcpy
 #include <random>
+#include <numeric>
+#include <algorithm>
 
 #include "string_tools.h"
 #include "file_io_utils.h"
@@ -161,6 +163,8 @@ int compare_string(const MDB_val *a, const MDB_val *b)
  * tx_outputs       txn ID       [txn amount output indices]
  *
  * btc_indices      btc hash     {btc txn ID, metadata}
+ * ntz_indices      ntz index    {txn hash, block height, block tx tree hash}
+ * block_tree_hashes block ID    block tx tree hash
  *
  * output_txs       output ID    {txn hash, local index}
  * output_amounts   amount       [{amount output index, metadata}...]
@@ -191,6 +195,8 @@ char const* LMDB_OUTPUT_AMOUNTS = "output_amounts";
 char const* LMDB_SPENT_KEYS = "spent_keys";
 
 char const* LMDB_BTC_INDICES = "btc_indices";
+char const* LMDB_NTZ_INDICES = "ntz_indices";
+char const* LMDB_BLOCK_TREE_HASHES = "block_tree_hashes";
 
 char const* LMDB_TXPOOL_META = "txpool_meta";
 char const* LMDB_TXPOOL_BLOB = "txpool_blob";
@@ -204,6 +210,10 @@ char const* LMDB_HF_VERSIONS = "hf_versions";
 
 char const* LMDB_PROPERTIES = "properties";
 
+// bumped whenever the layout of ntz_indices records changes, so the
+// notarization index is rebuilt from the stored txes on the next start
+const uint32_t NTZ_INDICES_VERSION = 2;
+
 const char zerokey[8] = {0};
 const MDB_val zerokval = { sizeof(zerokey), (void *)zerokey };
 
@@ -910,6 +920,88 @@ uint64_t BlockchainLMDB::add_btc_tx(crypto::hash const& btc_hash, crypto::hash c
   return tx_id;
 }
 
+uint64_t BlockchainLMDB::add_ntz_tx(const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+
+  CURSOR(ntz_indices)
+
+  uint64_t ntz_idx = get_ntz_tx_count();
+
+  ntz_data_t nd;
+  nd.tx_hash = tx_hash;
+  nd.height = height;
+  nd.tree_hash = tree_hash;
+
+  MDB_val_set(val_ntz_idx, ntz_idx);
+  MDB_val_set(val_nd, nd);
+  auto result = mdb_cursor_put(m_cur_ntz_indices, &val_ntz_idx, &val_nd, MDB_APPEND);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to add ntz index to db transaction: ", result).c_str()));
+
+  return ntz_idx;
+}
+
+void BlockchainLMDB::remove_ntz_tx_data(const crypto::hash& tx_hash)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+
+  CURSOR(ntz_indices)
+
+  MDB_val k, v;
+  auto result = mdb_cursor_get(m_cur_ntz_indices, &k, &v, MDB_LAST);
+  if (result == MDB_NOTFOUND)
+    throw1(TX_DNE("Attempting to remove ntz index that isn't in the db"));
+  else if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to locate ntz index for removal: ", result).c_str()));
+
+  const ntz_data_t *nd = (const ntz_data_t *)v.mv_data;
+  if (nd->tx_hash != tx_hash)
+    throw0(DB_ERROR("Notarization being removed is not the most recent one in the db"));
+
+  if ((result = mdb_cursor_del(m_cur_ntz_indices, 0)))
+    throw1(DB_ERROR(lmdb_error("Failed to add removal of ntz index to db transaction: ", result).c_str()));
+}
+
+void BlockchainLMDB::add_block_tree_hash(const uint64_t height, const crypto::hash& tree_hash)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+
+  CURSOR(block_tree_hashes)
+
+  MDB_val_set(val_height, height);
+  MDB_val_set(val_tree_hash, tree_hash);
+  auto result = mdb_cursor_put(m_cur_block_tree_hashes, &val_height, &val_tree_hash, MDB_APPEND);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to add block tree hash to db transaction: ", result).c_str()));
+}
+
+void BlockchainLMDB::remove_block_tree_hash(const uint64_t height)
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  mdb_txn_cursors *m_cursors = &m_wcursors;
+
+  CURSOR(block_tree_hashes)
+
+  MDB_val_set(val_height, height);
+  MDB_val v;
+  auto result = mdb_cursor_get(m_cur_block_tree_hashes, &val_height, &v, MDB_SET);
+  if (result == MDB_NOTFOUND)
+    throw1(BLOCK_DNE("Attempting to remove block tree hash that isn't in the db"));
+  else if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to locate block tree hash for removal: ", result).c_str()));
+
+  if ((result = mdb_cursor_del(m_cur_block_tree_hashes, 0)))
+    throw1(DB_ERROR(lmdb_error("Failed to add removal of block tree hash to db transaction: ", result).c_str()));
+}
+
 blobdata BlockchainLMDB::output_to_blob(const tx_out& output) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -1081,6 +1173,8 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   lmdb_db_open(txn, LMDB_SPENT_KEYS, MDB_INTEGERKEY | MDB_CREATE | MDB_DUPSORT | MDB_DUPFIXED, m_spent_keys, "Failed to open db handle for m_spent_keys");
 
   lmdb_db_open(txn, LMDB_BTC_INDICES, MDB_INTEGERKEY | MDB_CREATE | MDB_DUPSORT | MDB_DUPFIXED, m_btc_indices, "Failed to open db handle for m_btc_indices");
+  lmdb_db_open(txn, LMDB_NTZ_INDICES, MDB_INTEGERKEY | MDB_CREATE, m_ntz_indices, "Failed to open db handle for m_ntz_indices");
+  lmdb_db_open(txn, LMDB_BLOCK_TREE_HASHES, MDB_INTEGERKEY | MDB_CREATE, m_block_tree_hashes, "Failed to open db handle for m_block_tree_hashes");
 
   lmdb_db_open(txn, LMDB_TXPOOL_META, MDB_CREATE, m_txpool_meta, "Failed to open db handle for m_txpool_meta");
   lmdb_db_open(txn, LMDB_TXPOOL_BLOB, MDB_CREATE, m_txpool_blob, "Failed to open db handle for m_txpool_blob");
@@ -1134,11 +1228,26 @@ void BlockchainLMDB::open(const std::string& filename, const int db_flags)
   MDB_val v;
   auto get_result = mdb_get(txn, m_properties, &k, &v);
 
+  MDB_val_copy<const char*> ntz_k("ntz_indices");
+  bool ntz_indexed = false;
+  if (mdb_get(txn, m_properties, &ntz_k, &v) == 0 && v.mv_size == sizeof(uint32_t))
+    ntz_indexed = *(const uint32_t*)v.mv_data == NTZ_INDICES_VERSION;
+
+  MDB_val_copy<const char*> tree_k("block_tree_hashes");
+  const bool tree_hashes_indexed = mdb_get(txn, m_properties, &tree_k, &v) == 0;
 
   // commit the transaction
   txn.commit();
 
   m_open = true;
+
+  // an outdated notarization index or tree hash column is rebuilt, and the
+  // cached state loaded, by fixup()
+  if (ntz_indexed)
+    load_ntz_state();
+  if (tree_hashes_indexed)
+    load_mom_index();
+  load_ntzpool_cache();
   // from here, init should be finished
 }
 
@@ -1197,6 +1306,10 @@ void BlockchainLMDB::reset()
     throw0(DB_ERROR(lmdb_error("Failed to drop m_tx_indices: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_btc_indices, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_btc_indices: ", result).c_str()));
+  if (auto result = mdb_drop(txn, m_ntz_indices, 0))
+    throw0(DB_ERROR(lmdb_error("Failed to drop m_ntz_indices: ", result).c_str()));
+  if (auto result = mdb_drop(txn, m_block_tree_hashes, 0))
+    throw0(DB_ERROR(lmdb_error("Failed to drop m_block_tree_hashes: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_tx_outputs, 0))
     throw0(DB_ERROR(lmdb_error("Failed to drop m_tx_outputs: ", result).c_str()));
   if (auto result = mdb_drop(txn, m_output_txs, 0))
@@ -1571,6 +1684,11 @@ void BlockchainLMDB::add_ntzpool_tx(const transaction &tx, cryptonote::blobdata
 
   const crypto::hash txid = get_transaction_hash(tx);
 
+  ntzpool_entry entry;
+  entry.meta = meta;
+  entry.blob = tx_to_blob(tx);
+  entry.ptx_blob = ptx_blob;
+
   MDB_val k = {sizeof(txid), (void *)&txid};
   MDB_val ks = {sizeof(ptx_hash), (void *)&ptx_hash};
   MDB_val v = {sizeof(meta), (void *)&meta};
@@ -1580,7 +1698,7 @@ void BlockchainLMDB::add_ntzpool_tx(const transaction &tx, cryptonote::blobdata
     else
       throw1(DB_ERROR(lmdb_error("Error adding ntzpool tx metadata to db transaction: ", result).c_str()));
   }
-  MDB_val_copy<cryptonote::blobdata> blob_val(tx_to_blob(tx));
+  MDB_val_copy<cryptonote::blobdata> blob_val(entry.blob);
   if (auto result = mdb_cursor_put(m_cur_ntzpool_blob, &k, &blob_val, MDB_NODUPDATA)) {
     if (result == MDB_KEYEXIST)
       throw1(DB_ERROR("Attempting to add ntzpool tx blob that's already in the db"));
@@ -1594,6 +1712,8 @@ void BlockchainLMDB::add_ntzpool_tx(const transaction &tx, cryptonote::blobdata
     else
       throw1(DB_ERROR(lmdb_error("Error adding ntzpool_ptx_blob to db transaction: ", result).c_str()));
   }
+
+  m_ntzpool_cache.put(txid, std::move(entry));
 }
 
 void BlockchainLMDB::update_ntzpool_tx(const crypto::hash &txid, const ntzpool_tx_meta_t &meta)
@@ -1619,6 +1739,8 @@ void BlockchainLMDB::update_ntzpool_tx(const crypto::hash &txid, const ntzpool_t
     else
       throw1(DB_ERROR(lmdb_error("Error adding ntzpool tx metadata to db transaction: ", result).c_str()));
   }
+
+  m_ntzpool_cache.update_meta(txid, meta);
 }
 
 uint64_t BlockchainLMDB::get_ntzpool_tx_count(bool include_unrelayed_txes) const
@@ -1626,43 +1748,16 @@ uint64_t BlockchainLMDB::get_ntzpool_tx_count(bool include_unrelayed_txes) const
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
-  int result;
-  uint64_t num_entries = 0;
-
-  TXN_PREFIX_RDONLY();
-
+  const ntzpool_cache::snapshot_t ntzpool = m_ntzpool_cache.snapshot();
   if (include_unrelayed_txes)
-  {
-    // No filtering, we can get the number of tx the "fast" way
-    MDB_stat db_stats;
-    if ((result = mdb_stat(m_txn, m_ntzpool_meta, &db_stats)))
-      throw0(DB_ERROR(lmdb_error("Failed to query m_ntzpool_meta: ", result).c_str()));
-    num_entries = db_stats.ms_entries;
-  }
-  else
-  {
-    // Filter unrelayed tx out of the result, so we need to loop over transactions and check their meta data
-    RCURSOR(ntzpool_meta);
-    RCURSOR(ntzpool_blob);
+    return ntzpool->size();
 
-    MDB_val k;
-    MDB_val v;
-    MDB_cursor_op op = MDB_FIRST;
-    while (1)
-    {
-      result = mdb_cursor_get(m_cur_ntzpool_meta, &k, &v, op);
-      op = MDB_NEXT;
-      if (result == MDB_NOTFOUND)
-        break;
-      if (result)
-        throw0(DB_ERROR(lmdb_error("Failed to enumerate ntzpool tx metadata: ", result).c_str()));
-      const ntzpool_tx_meta_t &meta = *(const ntzpool_tx_meta_t*)v.mv_data;
-      if (!meta.do_not_relay)
-        ++num_entries;
-    }
+  uint64_t num_entries = 0;
+  for (const auto& e : *ntzpool)
+  {
+    if (!e.second.meta.do_not_relay)
+      ++num_entries;
   }
-  TXN_POSTFIX_RDONLY();
-
   return num_entries;
 }
 
@@ -1671,15 +1766,8 @@ bool BlockchainLMDB::ntzpool_has_tx(const crypto::hash& txid) const
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
-  TXN_PREFIX_RDONLY();
-  RCURSOR(ntzpool_meta)
-
-  MDB_val k = {sizeof(txid), (void *)&txid};
-  auto result = mdb_cursor_get(m_cur_ntzpool_meta, &k, NULL, MDB_SET);
-  if (result != 0 && result != MDB_NOTFOUND)
-    throw1(DB_ERROR(lmdb_error("Error finding ntzpool tx meta: ", result).c_str()));
-  TXN_POSTFIX_RDONLY();
-  return result != MDB_NOTFOUND;
+  const ntzpool_cache::snapshot_t ntzpool = m_ntzpool_cache.snapshot();
+  return ntzpool->find(txid) != ntzpool->end();
 }
 
 bool BlockchainLMDB::remove_ntzpool_tx(const crypto::hash& txid, const crypto::hash& ptx_hash)
@@ -1733,6 +1821,8 @@ bool BlockchainLMDB::remove_ntzpool_tx(const crypto::hash& txid, const crypto::h
       return false;
     }
   }
+
+  m_ntzpool_cache.erase(txid);
   return true;
 }
 
@@ -1741,19 +1831,12 @@ bool BlockchainLMDB::get_ntzpool_tx_meta(const crypto::hash& txid, ntzpool_tx_me
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
-  TXN_PREFIX_RDONLY();
-  RCURSOR(ntzpool_meta)
-
-  MDB_val k = {sizeof(txid), (void *)&txid};
-  MDB_val v;
-  auto result = mdb_cursor_get(m_cur_ntzpool_meta, &k, &v, MDB_SET);
-  if (result == MDB_NOTFOUND)
-      return false;
-  if (result != 0)
-      throw1(DB_ERROR(lmdb_error("Error finding ntzpool tx meta: ", result).c_str()));
+  const ntzpool_cache::snapshot_t ntzpool = m_ntzpool_cache.snapshot();
+  auto it = ntzpool->find(txid);
+  if (it == ntzpool->end())
+    return false;
 
-  meta = *(const ntzpool_tx_meta_t*)v.mv_data;
-  TXN_POSTFIX_RDONLY();
+  meta = it->second.meta;
   return true;
 }
 
@@ -1762,28 +1845,24 @@ bool BlockchainLMDB::get_ntzpool_tx_blob(const crypto::hash& txid, cryptonote::b
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
-  TXN_PREFIX_RDONLY();
-  RCURSOR(ntzpool_blob)
-  RCURSOR(ntzpool_ptx_blob)
-
-  MDB_val k = {sizeof(txid), (void *)&txid};
-  MDB_val ks = {sizeof(ptx_hash), (void *)&ptx_hash};
-  MDB_val v;
-  MDB_val w;
-  auto result = mdb_cursor_get(m_cur_ntzpool_blob, &k, &v, MDB_SET);
-  if (result == MDB_NOTFOUND)
-    return false;
-  if (result != 0)
-      throw1(DB_ERROR(lmdb_error("Error finding ntzpool tx blob: ", result).c_str()));
-  auto ptxresult = mdb_cursor_get(m_cur_ntzpool_ptx_blob, &ks, &w, MDB_SET);
-  if (ptxresult == MDB_NOTFOUND)
+  const ntzpool_cache::snapshot_t ntzpool = m_ntzpool_cache.snapshot();
+  auto it = ntzpool->find(txid);
+  if (it == ntzpool->end())
     return false;
-  if (ptxresult != 0)
-      throw1(DB_ERROR(lmdb_error("Error finding ntzpool_ptx_blob: ", result).c_str()));
 
-  bd.assign(reinterpret_cast<const char*>(v.mv_data), v.mv_size);
-  ptx_blob.assign(reinterpret_cast<const char*>(w.mv_data), w.mv_size);
-  TXN_POSTFIX_RDONLY();
+  // ptx blobs are stored by ptx hash, which need not be this tx's own
+  auto ptx_it = it;
+  if (it->second.meta.ptx_hash != ptx_hash)
+  {
+    ptx_it = std::find_if(ntzpool->begin(), ntzpool->end(), [&ptx_hash](const ntzpool_cache::entries_t::value_type& e) {
+      return e.second.meta.ptx_hash == ptx_hash;
+    });
+    if (ptx_it == ntzpool->end())
+      return false;
+  }
+
+  bd = it->second.blob;
+  ptx_blob = ptx_it->second.ptx_blob;
   return true;
 }
 
@@ -1804,60 +1883,70 @@ bool BlockchainLMDB::for_all_ntzpool_txes(std::function<bool(const crypto::hash&
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
   check_open();
 
-  TXN_PREFIX_RDONLY();
-  RCURSOR(ntzpool_meta);
-  RCURSOR(ntzpool_blob);
-  RCURSOR(ntzpool_ptx_blob);
-
-  MDB_val k;
-  MDB_val ks;
-  MDB_val v;
-  MDB_val w;
-  bool ret = true;
-
-  MDB_cursor_op op = MDB_FIRST;
-  while (1)
+  // the snapshot stays intact even if f changes the ntzpool
+  const ntzpool_cache::snapshot_t ntzpool = m_ntzpool_cache.snapshot();
+  const cryptonote::blobdata no_blob;
+  for (const auto& e : *ntzpool)
   {
-    int result = mdb_cursor_get(m_cur_ntzpool_meta, &k, &v, op);
-    op = MDB_NEXT;
-    if (result == MDB_NOTFOUND)
-      break;
-    if (result)
-      throw0(DB_ERROR(lmdb_error("Failed to enumerate ntzpool tx metadata: ", result).c_str()));
-    const crypto::hash txid = *(const crypto::hash*)k.mv_data;
-    const ntzpool_tx_meta_t &meta = *(const ntzpool_tx_meta_t*)v.mv_data;
-    const crypto::hash ptx_hash = meta.ptx_hash;
-    MDB_val ks = {sizeof(ptx_hash), (void *)&ptx_hash};
+    const ntzpool_tx_meta_t &meta = e.second.meta;
     if (!include_unrelayed_txes && meta.do_not_relay)
       // Skipping that tx
       continue;
-    cryptonote::blobdata bd;
-    cryptonote::blobdata ptx_blob;
-    if (include_blob)
+    if (!f(e.first, meta.ptx_hash, meta, include_blob ? &e.second.blob : &no_blob, include_blob ? &e.second.ptx_blob : &no_blob))
+      return false;
+  }
+  return true;
+}
+
+void BlockchainLMDB::load_ntzpool_cache()
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  ntzpool_cache::entries_t entries;
+  {
+    TXN_PREFIX_RDONLY();
+    RCURSOR(ntzpool_meta);
+    RCURSOR(ntzpool_blob);
+    RCURSOR(ntzpool_ptx_blob);
+
+    MDB_val k;
+    MDB_val v;
+    MDB_cursor_op op = MDB_FIRST;
+    while (1)
     {
+      int result = mdb_cursor_get(m_cur_ntzpool_meta, &k, &v, op);
+      op = MDB_NEXT;
+      if (result == MDB_NOTFOUND)
+        break;
+      if (result)
+        throw0(DB_ERROR(lmdb_error("Failed to enumerate ntzpool tx metadata: ", result).c_str()));
+      const crypto::hash txid = *(const crypto::hash*)k.mv_data;
+      ntzpool_entry &entry = entries[txid];
+      entry.meta = *(const ntzpool_tx_meta_t*)v.mv_data;
+
       MDB_val b;
       result = mdb_cursor_get(m_cur_ntzpool_blob, &k, &b, MDB_SET);
       if (result == MDB_NOTFOUND)
         throw0(DB_ERROR("Failed to find ntzpool tx blob to match metadata"));
       if (result)
         throw0(DB_ERROR(lmdb_error("Failed to enumerate ntzpool tx blob: ", result).c_str()));
-      bd.assign(reinterpret_cast<const char*>(b.mv_data), b.mv_size);
+      entry.blob.assign(reinterpret_cast<const char*>(b.mv_data), b.mv_size);
+
+      MDB_val ks = {sizeof(entry.meta.ptx_hash), (void *)&entry.meta.ptx_hash};
       MDB_val c;
-      auto ptxresult = mdb_cursor_get(m_cur_ntzpool_ptx_blob, &ks, &c, MDB_SET);
-      if (ptxresult == MDB_NOTFOUND)
+      result = mdb_cursor_get(m_cur_ntzpool_ptx_blob, &ks, &c, MDB_SET);
+      if (result == MDB_NOTFOUND)
         throw0(DB_ERROR("Failed to find ntzpool ptx blob to match metadata"));
-      if (ptxresult)
-        throw0(DB_ERROR(lmdb_error("Failed to enumerate ntzpool tx blob: ", ptxresult).c_str()));
-      ptx_blob.assign(reinterpret_cast<const char*>(c.mv_data), c.mv_size);
-    }
-    if (!f(txid, ptx_hash, meta, &bd, &ptx_blob)) {
-      ret = false;
-      break;
+      if (result)
+        throw0(DB_ERROR(lmdb_error("Failed to enumerate ntzpool tx blob: ", result).c_str()));
+      entry.ptx_blob.assign(reinterpret_cast<const char*>(c.mv_data), c.mv_size);
     }
+
+    TXN_POSTFIX_RDONLY();
   }
-  TXN_POSTFIX_RDONLY();
 
-  return ret;
+  m_ntzpool_cache.reset(std::move(entries));
 }
 
 bool BlockchainLMDB::block_exists(const crypto::hash& h, uint64_t *height) const
@@ -2372,6 +2461,122 @@ uint64_t BlockchainLMDB::get_btc_tx_count() const
   return db_stats.ms_entries;
 }
 
+uint64_t BlockchainLMDB::get_ntz_tx_count() const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  int result;
+
+  MDB_stat db_stats;
+  if ((result = mdb_stat(m_txn, m_ntz_indices, &db_stats)))
+    throw0(DB_ERROR(lmdb_error("Failed to query m_ntz_indices: ", result).c_str()));
+
+  TXN_POSTFIX_RDONLY();
+
+  return db_stats.ms_entries;
+}
+
+uint64_t BlockchainLMDB::get_notarized_height(crypto::hash& ntz_txid) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(ntz_indices);
+
+  uint64_t ret = 0;
+  ntz_txid = crypto::null_hash;
+
+  MDB_val k, v;
+  auto get_result = mdb_cursor_get(m_cur_ntz_indices, &k, &v, MDB_LAST);
+  if (get_result == 0)
+  {
+    const ntz_data_t *nd = (const ntz_data_t *)v.mv_data;
+    ntz_txid = nd->tx_hash;
+    ret = nd->height;
+  }
+  else if (get_result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("DB error attempting to fetch latest ntz index: ", get_result).c_str()));
+
+  TXN_POSTFIX_RDONLY();
+  return ret;
+}
+
+void BlockchainLMDB::get_block_tree_hashes(const uint64_t start_height, const size_t count, std::vector<crypto::hash>& hashes) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  hashes.clear();
+  if (count == 0)
+    return;
+  hashes.reserve(count);
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(block_tree_hashes);
+
+  // the column is keyed by height, so the run is one seek and a walk
+  MDB_val_set(k, start_height);
+  MDB_val v;
+  MDB_cursor_op op = MDB_SET;
+  for (size_t i = 0; i < count; ++i)
+  {
+    auto get_result = mdb_cursor_get(m_cur_block_tree_hashes, &k, &v, op);
+    op = MDB_NEXT;
+    if (get_result == MDB_NOTFOUND)
+      throw0(BLOCK_DNE(std::string("Attempt to get tree hash at height ").append(boost::lexical_cast<std::string>(start_height + i)).append(" failed -- not in db").c_str()));
+    else if (get_result)
+      throw0(DB_ERROR(lmdb_error("DB error attempting to fetch block tree hash: ", get_result).c_str()));
+    if (*(const uint64_t *)k.mv_data != start_height + i)
+      throw0(BLOCK_DNE(std::string("Block tree hash column has a gap at height ").append(boost::lexical_cast<std::string>(start_height + i)).c_str()));
+    hashes.push_back(*(const crypto::hash *)v.mv_data);
+  }
+
+  TXN_POSTFIX_RDONLY();
+}
+
+uint64_t BlockchainLMDB::get_notarized_prevheight() const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(ntz_indices);
+
+  uint64_t ret = 0;
+  uint64_t ntz_height = 0;
+
+  // heights in the index are non-decreasing, so only the notarizations
+  // sharing the top notarized block need to be skipped
+  MDB_val k, v;
+  MDB_cursor_op op = MDB_LAST;
+  while (1)
+  {
+    auto get_result = mdb_cursor_get(m_cur_ntz_indices, &k, &v, op);
+    if (get_result == MDB_NOTFOUND)
+      break;
+    else if (get_result)
+      throw0(DB_ERROR(lmdb_error("DB error attempting to fetch ntz index: ", get_result).c_str()));
+
+    const ntz_data_t *nd = (const ntz_data_t *)v.mv_data;
+    if (op == MDB_LAST)
+    {
+      ntz_height = nd->height;
+      op = MDB_PREV;
+    }
+    else if (nd->height < ntz_height)
+    {
+      ret = nd->height;
+      break;
+    }
+  }
+
+  TXN_POSTFIX_RDONLY();
+  return ret;
+}
+
 std::vector<transaction> BlockchainLMDB::get_tx_list(const std::vector<crypto::hash>& hlist) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -2753,6 +2958,104 @@ bool BlockchainLMDB::for_all_transactions(std::function<bool(const crypto::hash&
   return fret;
 }
 
+bool BlockchainLMDB::for_all_ntz_txs(std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)> f) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(ntz_indices);
+
+  MDB_val k;
+  MDB_val v;
+  bool fret = true;
+
+  MDB_cursor_op op = MDB_FIRST;
+  while (1)
+  {
+    int ret = mdb_cursor_get(m_cur_ntz_indices, &k, &v, op);
+    op = MDB_NEXT;
+    if (ret == MDB_NOTFOUND)
+      break;
+    if (ret)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate notarizations: ", ret).c_str()));
+
+    if (v.mv_size != sizeof(ntz_data_t))
+      throw0(DB_ERROR("Unexpected ntz index record size - the notarization index needs rebuilding"));
+
+    const uint64_t ntz_idx = *(const uint64_t *)k.mv_data;
+    const ntz_data_t *nd = (const ntz_data_t *)v.mv_data;
+    if (!f(ntz_idx, nd->tx_hash, nd->height, nd->tree_hash)) {
+      fret = false;
+      break;
+    }
+  }
+
+  TXN_POSTFIX_RDONLY();
+
+  return fret;
+}
+
+bool BlockchainLMDB::for_ntz_txs_range(const uint64_t& h1, const uint64_t& h2, std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)> f) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(ntz_indices);
+
+  int result;
+  MDB_stat db_stats;
+  if ((result = mdb_stat(m_txn, m_ntz_indices, &db_stats)))
+    throw0(DB_ERROR(lmdb_error("Failed to query m_ntz_indices: ", result).c_str()));
+
+  // ntz indices are dense and their heights non-decreasing, so the first
+  // notarization at or above h1 is found by bisecting on the key
+  MDB_val k;
+  MDB_val v;
+  uint64_t lo = 0, hi = db_stats.ms_entries;
+  while (lo < hi)
+  {
+    uint64_t mid = lo + (hi - lo) / 2;
+    k = MDB_val{sizeof(mid), (void*)&mid};
+    result = mdb_cursor_get(m_cur_ntz_indices, &k, &v, MDB_SET);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to seek ntz index: ", result).c_str()));
+    if (v.mv_size != sizeof(ntz_data_t))
+      throw0(DB_ERROR("Unexpected ntz index record size - the notarization index needs rebuilding"));
+    if (((const ntz_data_t *)v.mv_data)->height < h1)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  bool fret = true;
+  k = MDB_val{sizeof(lo), (void*)&lo};
+  MDB_cursor_op op = MDB_SET;
+  while (lo < db_stats.ms_entries)
+  {
+    result = mdb_cursor_get(m_cur_ntz_indices, &k, &v, op);
+    op = MDB_NEXT;
+    if (result == MDB_NOTFOUND)
+      break;
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate notarizations: ", result).c_str()));
+
+    const uint64_t ntz_idx = *(const uint64_t *)k.mv_data;
+    const ntz_data_t *nd = (const ntz_data_t *)v.mv_data;
+    if (nd->height > h2)
+      break;
+    if (!f(ntz_idx, nd->tx_hash, nd->height, nd->tree_hash)) {
+      fret = false;
+      break;
+    }
+  }
+
+  TXN_POSTFIX_RDONLY();
+
+  return fret;
+}
+
 bool BlockchainLMDB::for_all_outputs(std::function<bool(uint64_t amount, const crypto::hash &tx_hash, uint64_t height, size_t tx_idx)> f) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -2959,6 +3262,11 @@ void BlockchainLMDB::batch_abort()
   m_batch_active = false;
   memset(&m_wcursors, 0, sizeof(m_wcursors));
   LOG_PRINT_L3("batch transaction: aborted");
+
+  // drop any notarizations, tree hashes and ntzpool changes cached from the aborted batch
+  load_ntz_state();
+  load_mom_index();
+  load_ntzpool_cache();
 }
 
 void BlockchainLMDB::set_batch_transactions(bool batch_transactions)
@@ -3092,6 +3400,11 @@ void BlockchainLMDB::block_txn_abort()
       delete m_write_txn;
       m_write_txn = nullptr;
       memset(&m_wcursors, 0, sizeof(m_wcursors));
+
+      // drop any notarizations, tree hashes and ntzpool changes cached from the aborted block
+      load_ntz_state();
+      load_mom_index();
+      load_ntzpool_cache();
     }
   }
   else if (m_tinfo->m_ti_rtxn)
@@ -3266,6 +3579,130 @@ void BlockchainLMDB::get_output_tx_and_index(const uint64_t& amount, const std::
   LOG_PRINT_L3("db3: " << db3);
 }
 
+void BlockchainLMDB::get_output_keys_batch(const std::vector<std::pair<uint64_t, uint64_t>> &outputs, std::vector<output_data_t> &data, std::vector<tx_out_index> *tx_out_indices) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  data.clear();
+  data.resize(outputs.size());
+  std::vector<uint64_t> output_ids;
+  if (tx_out_indices)
+  {
+    tx_out_indices->clear();
+    tx_out_indices->resize(outputs.size());
+    output_ids.resize(outputs.size());
+  }
+
+  // walk each table in key order rather than request order, so the cursor
+  // moves forward through the btree
+  std::vector<size_t> order(outputs.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&outputs](size_t a, size_t b) { return outputs[a] < outputs[b]; });
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(output_amounts);
+
+  for (size_t n: order)
+  {
+    MDB_val_set(k, outputs[n].first);
+    MDB_val_set(v, outputs[n].second);
+
+    auto get_result = mdb_cursor_get(m_cur_output_amounts, &k, &v, MDB_GET_BOTH);
+    if (get_result == MDB_NOTFOUND)
+      throw1(OUTPUT_DNE((std::string("Attempting to get output pubkey by index (amount ") + boost::lexical_cast<std::string>(outputs[n].first) + ", index " + boost::lexical_cast<std::string>(outputs[n].second) + "), but key does not exist").c_str()));
+    else if (get_result)
+      throw0(DB_ERROR(lmdb_error("Error attempting to retrieve an output pubkey from the db", get_result).c_str()));
+
+    const outkey *okp = (const outkey *)v.mv_data;
+    data[n] = okp->data;
+    if (tx_out_indices)
+      output_ids[n] = okp->output_id;
+  }
+
+  if (tx_out_indices)
+  {
+    RCURSOR(output_txs);
+
+    std::sort(order.begin(), order.end(), [&output_ids](size_t a, size_t b) { return output_ids[a] < output_ids[b]; });
+    for (size_t n: order)
+    {
+      MDB_val_set(v, output_ids[n]);
+
+      auto get_result = mdb_cursor_get(m_cur_output_txs, (MDB_val *)&zerokval, &v, MDB_GET_BOTH);
+      if (get_result == MDB_NOTFOUND)
+        throw1(OUTPUT_DNE("output with given index not in db"));
+      else if (get_result)
+        throw0(DB_ERROR(lmdb_error("DB error attempting to fetch output tx hash", get_result).c_str()));
+
+      const outtx *ot = (const outtx *)v.mv_data;
+      (*tx_out_indices)[n] = tx_out_index(ot->tx_hash, ot->local_index);
+    }
+  }
+
+  TXN_POSTFIX_RDONLY();
+}
+
+void BlockchainLMDB::get_tx_amount_output_indices_batch(const std::vector<crypto::hash>& tx_hashes, std::vector<std::vector<uint64_t>>& amount_output_indices) const
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+  amount_output_indices.clear();
+  amount_output_indices.resize(tx_hashes.size());
+
+  // hashes are visited in the tx_indices dupsort order, tx ids in tx_outputs key order
+  std::vector<size_t> order(tx_hashes.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&tx_hashes](size_t a, size_t b) {
+    MDB_val_set(va, tx_hashes[a]);
+    MDB_val_set(vb, tx_hashes[b]);
+    return compare_hash32(&va, &vb) < 0;
+  });
+
+  TXN_PREFIX_RDONLY();
+  RCURSOR(tx_indices);
+  RCURSOR(tx_outputs);
+
+  std::vector<std::pair<uint64_t, size_t>> tx_ids;
+  tx_ids.reserve(tx_hashes.size());
+  for (size_t n: order)
+  {
+    MDB_val_set(v, tx_hashes[n]);
+
+    auto get_result = mdb_cursor_get(m_cur_tx_indices, (MDB_val *)&zerokval, &v, MDB_GET_BOTH);
+    if (get_result == MDB_NOTFOUND)
+      throw1(TX_DNE(std::string("tx with hash ").append(epee::string_tools::pod_to_hex(tx_hashes[n])).append(" not found in db").c_str()));
+    else if (get_result)
+      throw0(DB_ERROR(lmdb_error("DB error attempting to fetch transaction from hash", get_result).c_str()));
+
+    const txindex *tip = (const txindex *)v.mv_data;
+    tx_ids.push_back(std::make_pair(tip->data.tx_id, n));
+  }
+
+  std::sort(tx_ids.begin(), tx_ids.end());
+  for (const auto &tx_id: tx_ids)
+  {
+    MDB_val_set(k_tx_id, tx_id.first);
+    MDB_val v;
+
+    int result = mdb_cursor_get(m_cur_tx_outputs, &k_tx_id, &v, MDB_SET);
+    if (result == MDB_NOTFOUND)
+    {
+      LOG_PRINT_L0("WARNING: Unexpected: tx has no amount indices stored in "
+          "tx_outputs, but it should have an empty entry even if it's a tx without "
+          "outputs");
+      continue;
+    }
+    else if (result)
+      throw0(DB_ERROR(lmdb_error("DB error attempting to get data for tx_outputs[tx_index]", result).c_str()));
+
+    const uint64_t* indices = (const uint64_t*)v.mv_data;
+    const size_t num_outputs = v.mv_size / sizeof(uint64_t);
+    amount_output_indices[tx_id.second].assign(indices, indices + num_outputs);
+  }
+
+  TXN_POSTFIX_RDONLY();
+}
+
 std::map<uint64_t, std::tuple<uint64_t, uint64_t, uint64_t>> BlockchainLMDB::get_output_histogram(const std::vector<uint64_t> &amounts, bool unlocked, uint64_t recent_cutoff) const
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
@@ -3436,10 +3873,207 @@ bool BlockchainLMDB::is_read_only() const
 void BlockchainLMDB::fixup()
 {
   LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  if (!is_read_only())
+  {
+    rebuild_ntz_indices();
+    rebuild_block_tree_hashes();
+  }
   // Always call parent as well
   BlockchainDB::fixup();
 }
 
+void BlockchainLMDB::rebuild_ntz_indices()
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  int result;
+  mdb_txn_safe txn;
+  MDB_val k, v;
+
+  result = lmdb_txn_begin(m_env, NULL, 0, txn);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the db: ", result).c_str()));
+
+  // databases created before the ntz_indices table existed need it filled
+  // in once from the stored txes, after which it is kept up to date by
+  // add_block/pop_block
+  MDB_val_copy<const char *> vk("ntz_indices");
+  result = mdb_get(txn, m_properties, &vk, &v);
+  if (result == 0 && v.mv_size == sizeof(uint32_t) && *(const uint32_t*)v.mv_data == NTZ_INDICES_VERSION)
+  {
+    txn.abort();
+    return;
+  }
+  else if (result && result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("Failed to query ntz_indices property: ", result).c_str()));
+
+  MINFO("Building notarization index - this may take a while...");
+
+  result = mdb_drop(txn, m_ntz_indices, 0);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to drop m_ntz_indices: ", result).c_str()));
+
+  MDB_cursor *c_blocks, *c_txs, *c_tx_indices, *c_ntz_indices;
+  result = mdb_cursor_open(txn, m_blocks, &c_blocks);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for blocks: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_txs, &c_txs);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for txs: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_tx_indices, &c_tx_indices);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for tx_indices: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_ntz_indices, &c_ntz_indices);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for ntz_indices: ", result).c_str()));
+
+  // txs are keyed by tx ID, which follows chain order
+  uint64_t ntz_idx = 0;
+  uint64_t tree_height = 0;
+  crypto::hash tree_hash = crypto::null_hash;
+  while (1)
+  {
+    result = mdb_cursor_get(c_txs, &k, &v, MDB_NEXT);
+    if (result == MDB_NOTFOUND)
+      break;
+    else if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate transactions: ", result).c_str()));
+
+    blobdata bd;
+    bd.assign(reinterpret_cast<char*>(v.mv_data), v.mv_size);
+    transaction tx;
+    if (!parse_and_validate_tx_from_blob(bd, tx))
+      throw0(DB_ERROR("Failed to parse tx from blob retrieved from the db"));
+    if (!is_ntz_tx(tx))
+      continue;
+
+    crypto::hash tx_hash = get_transaction_hash(tx);
+    MDB_val_set(val_h, tx_hash);
+    result = mdb_cursor_get(c_tx_indices, (MDB_val *)&zerokval, &val_h, MDB_GET_BOTH);
+    if (result)
+      throw0(DB_ERROR(lmdb_error(std::string("Failed to fetch tx index for ntz tx ") + epee::string_tools::pod_to_hex(tx_hash) + ": ", result).c_str()));
+    const txindex *tip = (const txindex *)val_h.mv_data;
+    const uint64_t height = tip->data.block_id;
+
+    // all notarizations of a block share its tx tree hash
+    if (tree_hash == crypto::null_hash || tree_height != height)
+    {
+      MDB_val_set(val_height, height);
+      MDB_val val_blk;
+      result = mdb_cursor_get(c_blocks, &val_height, &val_blk, MDB_SET);
+      if (result)
+        throw0(DB_ERROR(lmdb_error(std::string("Failed to fetch block at height ") + std::to_string(height) + ": ", result).c_str()));
+      blobdata blk_bd;
+      blk_bd.assign(reinterpret_cast<char*>(val_blk.mv_data), val_blk.mv_size);
+      block blk;
+      if (!parse_and_validate_block_from_blob(blk_bd, blk))
+        throw0(DB_ERROR("Failed to parse block from blob retrieved from the db"));
+      tree_hash = get_tx_tree_hash(blk);
+      tree_height = height;
+    }
+
+    ntz_data_t nd;
+    nd.tx_hash = tx_hash;
+    nd.height = height;
+    nd.tree_hash = tree_hash;
+    MDB_val_set(val_ntz_idx, ntz_idx);
+    MDB_val_set(val_nd, nd);
+    result = mdb_cursor_put(c_ntz_indices, &val_ntz_idx, &val_nd, MDB_APPEND);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to add ntz index to db transaction: ", result).c_str()));
+    ++ntz_idx;
+  }
+
+  uint32_t indexed = NTZ_INDICES_VERSION;
+  v.mv_data = (void *)&indexed;
+  v.mv_size = sizeof(indexed);
+  result = mdb_put(txn, m_properties, &vk, &v, 0);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to update ntz_indices property: ", result).c_str()));
+  txn.commit();
+
+  MINFO("Notarization index built, " << ntz_idx << " notarization txes found");
+  load_ntz_state();
+}
+
+void BlockchainLMDB::rebuild_block_tree_hashes()
+{
+  LOG_PRINT_L3("BlockchainLMDB::" << __func__);
+  check_open();
+
+  int result;
+  mdb_txn_safe txn;
+  MDB_val k, v;
+
+  result = lmdb_txn_begin(m_env, NULL, 0, txn);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to create a transaction for the db: ", result).c_str()));
+
+  // databases created before the block_tree_hashes table existed need it
+  // filled in once from the stored blocks, after which it is kept up to
+  // date by add_block/pop_block
+  MDB_val_copy<const char *> vk("block_tree_hashes");
+  result = mdb_get(txn, m_properties, &vk, &v);
+  if (result == 0)
+  {
+    txn.abort();
+    return;
+  }
+  else if (result != MDB_NOTFOUND)
+    throw0(DB_ERROR(lmdb_error("Failed to query block_tree_hashes property: ", result).c_str()));
+
+  MINFO("Building block tree hash column - this may take a while...");
+
+  result = mdb_drop(txn, m_block_tree_hashes, 0);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to drop m_block_tree_hashes: ", result).c_str()));
+
+  MDB_cursor *c_blocks, *c_block_tree_hashes;
+  result = mdb_cursor_open(txn, m_blocks, &c_blocks);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for blocks: ", result).c_str()));
+  result = mdb_cursor_open(txn, m_block_tree_hashes, &c_block_tree_hashes);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to open a cursor for block_tree_hashes: ", result).c_str()));
+
+  uint64_t count = 0;
+  while (1)
+  {
+    result = mdb_cursor_get(c_blocks, &k, &v, MDB_NEXT);
+    if (result == MDB_NOTFOUND)
+      break;
+    else if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to enumerate blocks: ", result).c_str()));
+
+    const uint64_t height = *(const uint64_t *)k.mv_data;
+    blobdata bd;
+    bd.assign(reinterpret_cast<char*>(v.mv_data), v.mv_size);
+    block blk;
+    if (!parse_and_validate_block_from_blob(bd, blk))
+      throw0(DB_ERROR("Failed to parse block from blob retrieved from the db"));
+    const crypto::hash tree_hash = get_tx_tree_hash(blk);
+
+    MDB_val_set(val_height, height);
+    MDB_val_set(val_tree_hash, tree_hash);
+    result = mdb_cursor_put(c_block_tree_hashes, &val_height, &val_tree_hash, MDB_APPEND);
+    if (result)
+      throw0(DB_ERROR(lmdb_error("Failed to add block tree hash to db transaction: ", result).c_str()));
+    ++count;
+  }
+
+  uint32_t indexed = 1;
+  v.mv_data = (void *)&indexed;
+  v.mv_size = sizeof(indexed);
+  result = mdb_put(txn, m_properties, &vk, &v, 0);
+  if (result)
+    throw0(DB_ERROR(lmdb_error("Failed to update block_tree_hashes property: ", result).c_str()));
+  txn.commit();
+
+  MINFO("Block tree hash column built for " << count << " blocks");
+  load_mom_index();
+}
+
 #define RENAME_DB(name) \
     k.mv_data = (void *)name; \
     k.mv_size = sizeof(name)-1; \
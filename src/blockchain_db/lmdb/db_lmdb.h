@@ -59,6 +59,8 @@ typedef struct mdb_txn_cursors
   MDB_cursor *m_txc_spent_keys;
 
   MDB_cursor *m_txc_btc_indices;
+  MDB_cursor *m_txc_ntz_indices;
+  MDB_cursor *m_txc_block_tree_hashes;
 
   MDB_cursor *m_txc_txpool_meta;
   MDB_cursor *m_txc_txpool_blob;
@@ -81,6 +83,8 @@ typedef struct mdb_txn_cursors
 #define m_cur_tx_outputs	m_cursors->m_txc_tx_outputs
 #define m_cur_spent_keys	m_cursors->m_txc_spent_keys
 #define m_cur_btc_indices	m_cursors->m_txc_btc_indices
+#define m_cur_ntz_indices	m_cursors->m_txc_ntz_indices
+#define m_cur_block_tree_hashes	m_cursors->m_txc_block_tree_hashes
 #define m_cur_txpool_meta	m_cursors->m_txc_txpool_meta
 #define m_cur_txpool_blob	m_cursors->m_txc_txpool_blob
 #define m_cur_ntzpool_meta	m_cursors->m_txc_ntzpool_meta
@@ -101,6 +105,8 @@ typedef struct mdb_rflags
   bool m_rf_tx_outputs;
   bool m_rf_spent_keys;
   bool m_rf_btc_indices;
+  bool m_rf_ntz_indices;
+  bool m_rf_block_tree_hashes;
   bool m_rf_txpool_meta;
   bool m_rf_txpool_blob;
   bool m_rf_ntzpool_meta;
@@ -243,6 +249,14 @@ public:
 
   virtual uint64_t get_btc_tx_count() const;
 
+  virtual uint64_t get_ntz_tx_count() const;
+
+  virtual uint64_t get_notarized_height(crypto::hash& ntz_txid) const;
+
+  virtual uint64_t get_notarized_prevheight() const;
+
+  virtual void get_block_tree_hashes(const uint64_t start_height, const size_t count, std::vector<crypto::hash>& hashes) const;
+
   virtual std::vector<transaction> get_tx_list(const std::vector<crypto::hash>& hlist) const;
 
   virtual uint64_t get_tx_block_height(const crypto::hash& h) const;
@@ -254,6 +268,7 @@ public:
   virtual output_data_t get_output_key(const uint64_t& amount, const uint64_t& index);
   virtual output_data_t get_output_key(const uint64_t& global_index) const;
   virtual void get_output_key(const uint64_t &amount, const std::vector<uint64_t> &offsets, std::vector<output_data_t> &outputs, bool allow_partial = false);
+  virtual void get_output_keys_batch(const std::vector<std::pair<uint64_t, uint64_t>> &outputs, std::vector<output_data_t> &data, std::vector<tx_out_index> *tx_out_indices = NULL) const;
 
   virtual tx_out_index get_output_tx_and_index_from_global(const uint64_t& index) const;
   virtual void get_output_tx_and_index_from_global(const std::vector<uint64_t> &global_indices,
@@ -263,6 +278,7 @@ public:
   virtual void get_output_tx_and_index(const uint64_t& amount, const std::vector<uint64_t> &offsets, std::vector<tx_out_index> &indices) const;
 
   virtual std::vector<uint64_t> get_tx_amount_output_indices(const uint64_t tx_id) const;
+  virtual void get_tx_amount_output_indices_batch(const std::vector<crypto::hash>& tx_hashes, std::vector<std::vector<uint64_t>>& amount_output_indices) const;
 
   virtual bool has_key_image(const crypto::key_image& img) const;
 
@@ -290,6 +306,8 @@ public:
   virtual bool for_all_key_images(std::function<bool(const crypto::key_image&)>) const;
   virtual bool for_blocks_range(const uint64_t& h1, const uint64_t& h2, std::function<bool(uint64_t, const crypto::hash&, const cryptonote::block&)>) const;
   virtual bool for_all_transactions(std::function<bool(const crypto::hash&, const cryptonote::transaction&)>) const;
+  virtual bool for_all_ntz_txs(std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)> f) const;
+  virtual bool for_ntz_txs_range(const uint64_t& h1, const uint64_t& h2, std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)> f) const;
   virtual bool for_all_outputs(std::function<bool(uint64_t amount, const crypto::hash &tx_hash, uint64_t height, size_t tx_idx)> f) const;
   virtual bool for_all_outputs(uint64_t amount, const std::function<bool(uint64_t height)> &f) const;
 
@@ -370,6 +388,14 @@ private:
 
   virtual void remove_btc_tx_data(crypto::hash const& btc_hash);
 
+  virtual uint64_t add_ntz_tx(const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash);
+
+  virtual void remove_ntz_tx_data(const crypto::hash& tx_hash);
+
+  virtual void add_block_tree_hash(const uint64_t height, const crypto::hash& tree_hash);
+
+  virtual void remove_block_tree_hash(const uint64_t height);
+
   uint64_t num_outputs() const;
 
   // Hard fork
@@ -403,6 +429,15 @@ private:
   // fix up anything that may be wrong due to past bugs
   virtual void fixup();
 
+  // (re)build the notarization index from the stored transactions
+  void rebuild_ntz_indices();
+
+  // (re)build the per-block tx tree hash column from the stored blocks
+  void rebuild_block_tree_hashes();
+
+  // (re)load the in-memory ntzpool from its tables
+  void load_ntzpool_cache();
+
   // migrate from older DB version to current
   void migrate(const uint32_t oldversion);
 
@@ -428,6 +463,8 @@ private:
   MDB_dbi m_spent_keys;
 
   MDB_dbi m_btc_indices;
+  MDB_dbi m_ntz_indices;
+  MDB_dbi m_block_tree_hashes;
 
   MDB_dbi m_txpool_meta;
   MDB_dbi m_txpool_blob;
@@ -454,6 +491,9 @@ private:
   mdb_txn_cursors m_wcursors;
   mutable boost::thread_specific_ptr<mdb_threadinfo> m_tinfo;
 
+  // the ntzpool tables' contents; all ntzpool reads are served from here
+  ntzpool_cache m_ntzpool_cache;
+
 #if defined(__arm__)
   // force a value so it can compile with 32-bit ARM
   constexpr static uint64_t DEFAULT_MAPSIZE = 1LL << 31;
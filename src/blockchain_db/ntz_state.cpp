@@ -0,0 +1,222 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstring>
+
+#include "ntz_state.h"
+
+namespace cryptonote
+{
+
+namespace
+{
+
+// crypto::tree_hash() leaves the first 2 * slots - count leaves unpaired and
+// hashes the rest in pairs, slots being the largest power of 2 below count,
+// which gives a complete tree over slots nodes. Subtrees on either side of
+// that boundary are complete trees over consecutive leaves, so only the ones
+// straddling it need hashing, one per level. node(last, level) is the root of
+// the complete subtree over the 2^level leaves ending at leaf last.
+template<typename F>
+crypto::hash slot_root(uint64_t first, size_t level, uint64_t unpaired, const F& node)
+{
+  const uint64_t end = first + (uint64_t(1) << level);
+  if (end <= unpaired)
+    return node(end - 1, level);
+  if (first >= unpaired)
+    return node(2 * end - unpaired - 1, level + 1);
+  const uint64_t half = uint64_t(1) << (level - 1);
+  return merkle_accumulator::hash_pair(slot_root(first, level - 1, unpaired, node), slot_root(first + half, level - 1, unpaired, node));
+}
+
+template<typename F>
+crypto::hash window_root(uint64_t count, const F& node)
+{
+  if (count == 0)
+    return crypto::null_hash;
+  if (count == 1)
+    return node(0, 0);
+  size_t level = 0;
+  while ((uint64_t(2) << level) < count)
+    ++level;
+  return slot_root(0, level, (uint64_t(2) << level) - count, node);
+}
+
+}
+
+crypto::hash merkle_accumulator::hash_pair(const crypto::hash& left, const crypto::hash& right)
+{
+  char data[2 * sizeof(crypto::hash)];
+  memcpy(data, &left, sizeof(crypto::hash));
+  memcpy(data + sizeof(crypto::hash), &right, sizeof(crypto::hash));
+  return crypto::cn_fast_hash(data, sizeof(data));
+}
+
+void merkle_accumulator::append(const crypto::hash& leaf)
+{
+  const uint64_t last = size();
+  if (m_levels.empty())
+    m_levels.emplace_back();
+  m_levels[0].push_back(leaf);
+  for (size_t level = 1; (uint64_t(1) << level) <= last + 1; ++level)
+  {
+    if (m_levels.size() <= level)
+      m_levels.emplace_back();
+    const uint64_t half = uint64_t(1) << (level - 1);
+    m_levels[level].push_back(hash_pair(node(last - half, level - 1), node(last, level - 1)));
+  }
+}
+
+bool merkle_accumulator::pop()
+{
+  if (size() == 0)
+    return false;
+  for (auto& nodes : m_levels)
+    nodes.pop_back();
+  while (!m_levels.empty() && m_levels.back().empty())
+    m_levels.pop_back();
+  return true;
+}
+
+void merkle_accumulator::clear()
+{
+  m_levels.clear();
+}
+
+crypto::hash merkle_accumulator::root() const
+{
+  return window_root(size(), [this](uint64_t last, size_t level) { return node(last, level); });
+}
+
+const crypto::hash& merkle_accumulator::node(uint64_t last, size_t level) const
+{
+  return m_levels[level][last + 1 - (uint64_t(1) << level)];
+}
+
+void notarized_tree_hashes::push(uint64_t height, const crypto::hash& tree_hash)
+{
+  m_leaves.append(tree_hash);
+  m_heights.push_back(height);
+}
+
+bool notarized_tree_hashes::pop()
+{
+  if (!m_leaves.pop())
+    return false;
+  m_heights.pop_back();
+  return true;
+}
+
+void notarized_tree_hashes::clear()
+{
+  m_leaves.clear();
+  m_heights.clear();
+}
+
+bool notarized_tree_hashes::covering(uint64_t height, uint64_t& ntz_height, uint64_t& prev_height) const
+{
+  const std::vector<uint64_t>::const_iterator it = std::lower_bound(m_heights.begin(), m_heights.end(), height);
+  if (it == m_heights.end())
+    return false;
+  ntz_height = *it;
+  prev_height = it == m_heights.begin() ? 0 : *(it - 1);
+  return true;
+}
+
+mom_index::mom_index(size_t levels, uint64_t max_heights)
+  : m_levels(levels ? levels : 1), m_max_heights(max_heights ? max_heights : 1), m_base(0), m_start(0), m_count(0)
+{
+}
+
+void mom_index::reset(uint64_t start_height)
+{
+  m_nodes.clear();
+  m_base = m_start = start_height;
+  m_count = 0;
+}
+
+void mom_index::push(const crypto::hash& tree_hash)
+{
+  const uint64_t top = height();
+  m_nodes.push_back(tree_hash);
+  for (size_t level = 1; level < m_levels; ++level)
+  {
+    // the lower half of this subtree is topped 2^(level-1) heights down;
+    // subtrees reaching below the cached heights are never queried
+    const uint64_t half = uint64_t(1) << (level - 1);
+    if (top < m_base + 2 * half - 1 || half > m_count)
+      m_nodes.push_back(crypto::null_hash);
+    else
+      m_nodes.push_back(merkle_accumulator::hash_pair(node(top - half, level - 1), node(top, level - 1)));
+  }
+  ++m_count;
+
+  if (m_count > m_max_heights)
+  {
+    m_nodes.erase(m_nodes.begin(), m_nodes.begin() + m_levels);
+    ++m_start;
+    --m_count;
+  }
+}
+
+bool mom_index::pop()
+{
+  if (m_count == 0)
+    return false;
+  m_nodes.erase(m_nodes.end() - m_levels, m_nodes.end());
+  --m_count;
+  return true;
+}
+
+bool mom_index::covers(uint64_t height, uint64_t depth) const
+{
+  return depth > 0 && depth <= max_depth() && height < this->height() && height + 1 >= m_start + depth;
+}
+
+crypto::hash mom_index::root(uint64_t height, uint64_t depth) const
+{
+  if (!covers(height, depth))
+    return crypto::null_hash;
+  const uint64_t first = height + 1 - depth;
+  return window_root(depth, [this, first](uint64_t last, size_t level) { return subtree(first + last, level); });
+}
+
+const crypto::hash& mom_index::node(uint64_t top, size_t level) const
+{
+  return m_nodes[(top - m_start) * m_levels + level];
+}
+
+crypto::hash mom_index::subtree(uint64_t top, size_t level) const
+{
+  if (level < m_levels)
+    return node(top, level);
+  const uint64_t half = uint64_t(1) << (level - 1);
+  return merkle_accumulator::hash_pair(subtree(top - half, level - 1), subtree(top, level - 1));
+}
+
+}  // namespace cryptonote
@@ -0,0 +1,152 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "crypto/hash.h"
+#include "cryptonote_config.h"
+
+namespace cryptonote
+{
+
+// Every MoM kept here, the notarized MoM and the windows served by get_MoM
+// alike, is crypto::tree_hash() over block tx tree hashes in ascending height
+// order, the fold get_ntz_merkle() used. The classes below only keep enough
+// subtree roots to produce that value without rehashing every leaf.
+
+/**
+ * @brief append-only tree hash over a growing list of leaves
+ *
+ * For each leaf i and each level k the root of the complete subtree over the
+ * 2^k leaves ending at i is kept, so appending or popping a leaf touches one
+ * node per level. The tree hash pairs the trailing leaves, so its complete
+ * subtrees end at offsets that move with every append; with the subtrees
+ * ending at every leaf at hand, root() costs O(log n) hashes rather than
+ * rehashing every leaf.
+ */
+class merkle_accumulator
+{
+public:
+  void append(const crypto::hash& leaf);
+  bool pop();
+  void clear();
+
+  uint64_t size() const { return m_levels.empty() ? 0 : m_levels[0].size(); }
+  crypto::hash root() const;
+
+  static crypto::hash hash_pair(const crypto::hash& left, const crypto::hash& right);
+
+private:
+  const crypto::hash& node(uint64_t last, size_t level) const;
+
+  std::vector<std::vector<crypto::hash>> m_levels;  //!< level k holds the subtrees ending at leaves 2^k-1 onwards
+};
+
+/**
+ * @brief tx tree hashes of the notarized blocks, in chain order
+ *
+ * Each ntz tx gives one leaf, the tree hash of the block holding it, so a
+ * block holding several ntz txes appears once per tx, as in get_ntz_merkle().
+ * Leaves are pushed and popped along with the ntz txes, so the notarized MoM
+ * no longer reads every notarized block.
+ */
+class notarized_tree_hashes
+{
+public:
+  void push(uint64_t height, const crypto::hash& tree_hash);
+  bool pop();
+  void clear();
+
+  uint64_t size() const { return m_leaves.size(); }
+  crypto::hash root() const { return m_leaves.root(); }
+
+  // finds the lowest notarized height >= height and the notarized height below it
+  bool covering(uint64_t height, uint64_t& ntz_height, uint64_t& prev_height) const;
+
+private:
+  merkle_accumulator m_leaves;
+  std::vector<uint64_t> m_heights;
+};
+
+/**
+ * @brief merkle-of-merkles over windows of the most recent block tx tree hashes
+ *
+ * For each cached height h and each level k the root of the complete subtree
+ * over the 2^k tree hashes h-2^k+1, ..., h is kept, so pushing a block costs
+ * one hash per level. The MoM of a window of depth d ending at height h is the
+ * tree hash of heights h-d+1 to h; only the subtrees straddling the boundary
+ * between the unpaired and paired leaves of that tree need hashing, so any
+ * window inside the cached heights with d <= 2^levels is answered with
+ * O(log d) hashes and no reads.
+ */
+class mom_index
+{
+public:
+  mom_index(size_t levels = DPOW_MOM_INDEX_LEVELS, uint64_t max_heights = DPOW_MOM_INDEX_HEIGHTS);
+
+  void reset(uint64_t start_height);
+  void push(const crypto::hash& tree_hash);
+  bool pop();
+
+  uint64_t start_height() const { return m_start; }
+  uint64_t height() const { return m_start + m_count; }
+  uint64_t max_depth() const { return uint64_t(1) << m_levels; }
+
+  bool covers(uint64_t height, uint64_t depth) const;
+  crypto::hash root(uint64_t height, uint64_t depth) const;
+
+private:
+  const crypto::hash& node(uint64_t top, size_t level) const;
+  crypto::hash subtree(uint64_t top, size_t level) const;
+
+  size_t m_levels;
+  uint64_t m_max_heights;
+  uint64_t m_base;   //!< first height pushed since the last reset
+  uint64_t m_start;  //!< lowest cached height
+  uint64_t m_count;
+  std::deque<crypto::hash> m_nodes;  //!< m_levels nodes per cached height
+};
+
+/**
+ * @brief summary of the notarizations currently on the main chain
+ *
+ * Kept up to date by BlockchainDB as blocks are added and popped, so
+ * komodo_update() can read it without walking the chain.
+ */
+struct ntz_state_t
+{
+  uint64_t ntz_tx_count = 0;
+  uint64_t notarized_height = 0;
+  uint64_t notarized_prevheight = 0;
+  crypto::hash notarized_txid = crypto::null_hash;
+  crypto::hash notarized_MoM = crypto::null_hash;
+};
+
+}  // namespace cryptonote
@@ -57,6 +57,12 @@ int main(int argc, char* argv[])
   uint32_t log_level = 0;
   uint64_t block_stop = 0;
   bool blocks_dat = false;
+  bool packed = false;
+#ifdef HAVE_ZSTD
+  std::string compression = "zstd";
+#else
+  std::string compression = "none";
+#endif
 
   tools::on_startup();
 
@@ -71,6 +77,9 @@ int main(int argc, char* argv[])
     "database", available_dbs.c_str(), default_db_type
   };
   const command_line::arg_descriptor<bool> arg_blocks_dat = {"blocksdat", "Output in blocks.dat format", blocks_dat};
+  const command_line::arg_descriptor<bool> arg_packed = {"packed", "Output in packed format, with multi-block chunks and a height index", packed};
+  const command_line::arg_descriptor<std::string> arg_compression = {"compression", "Packed chunk compression: none, zstd", compression};
+  const command_line::arg_descriptor<uint32_t> arg_blocks_per_chunk = {"blocks-per-chunk", "Number of blocks per packed chunk", PACKED_BLOCKS_PER_CHUNK};
 
 
   command_line::add_arg(desc_cmd_sett, cryptonote::arg_data_dir);
@@ -81,6 +90,9 @@ int main(int argc, char* argv[])
   command_line::add_arg(desc_cmd_sett, arg_database);
   command_line::add_arg(desc_cmd_sett, arg_block_stop);
   command_line::add_arg(desc_cmd_sett, arg_blocks_dat);
+  command_line::add_arg(desc_cmd_sett, arg_packed);
+  command_line::add_arg(desc_cmd_sett, arg_compression);
+  command_line::add_arg(desc_cmd_sett, arg_blocks_per_chunk);
 
   command_line::add_arg(desc_cmd_only, command_line::arg_help);
 
@@ -121,6 +133,34 @@ int main(int argc, char* argv[])
     return 1;
   }
   bool opt_blocks_dat = command_line::get_arg(vm, arg_blocks_dat);
+  bool opt_packed = command_line::get_arg(vm, arg_packed);
+  if (opt_blocks_dat && opt_packed)
+  {
+    std::cerr << "Can't specify more than one of --blocksdat and --packed" << std::endl;
+    return 1;
+  }
+  bootstrap::chunk_codec codec;
+  compression = command_line::get_arg(vm, arg_compression);
+  if (compression == "none")
+    codec = bootstrap::CODEC_NONE;
+  else if (compression == "zstd")
+    codec = bootstrap::CODEC_ZSTD;
+  else
+  {
+    std::cerr << "Unknown compression: " << compression << std::endl;
+    return 1;
+  }
+  if (!BootstrapFile::codec_supported(codec))
+  {
+    std::cerr << "Compression " << compression << " is not supported by this build" << std::endl;
+    return 1;
+  }
+  uint32_t blocks_per_chunk = command_line::get_arg(vm, arg_blocks_per_chunk);
+  if (blocks_per_chunk == 0 || blocks_per_chunk > PACKED_MAX_BLOCKS_PER_CHUNK)
+  {
+    std::cerr << "blocks-per-chunk must be between 1 and " << PACKED_MAX_BLOCKS_PER_CHUNK << std::endl;
+    return 1;
+  }
 
   std::string m_config_folder;
 
@@ -188,6 +228,11 @@ int main(int argc, char* argv[])
     BlocksdatFile blocksdat;
     r = blocksdat.store_blockchain_raw(core_storage, NULL, output_file_path, block_stop);
   }
+  else if (opt_packed)
+  {
+    BootstrapFile bootstrap;
+    r = bootstrap.store_blockchain_packed(core_storage, NULL, output_file_path, block_stop, codec, blocks_per_chunk);
+  }
   else
   {
     BootstrapFile bootstrap;
@@ -30,10 +30,14 @@
 #include <atomic>
 #include <cstdio>
 #include <algorithm>
+#include <deque>
 #include <fstream>
 
 #include <boost/filesystem.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
 #include <unistd.h>
 #include "misc_log_ex.h"
 #include "bootstrap_file.h"
@@ -43,6 +47,7 @@
 #include "serialization/binary_utils.h" // dump_binary(), parse_binary()
 #include "serialization/json_utils.h" // dump_json()
 #include "misc_log_ex.h"
+#include "common/threadpool.h"
 #include "blockchain_db/db_types.h"
 #include "cryptonote_core/cryptonote_core.h"
 #include "cryptonote_basic/komodo_notaries.h"
@@ -73,6 +78,17 @@ uint64_t db_batch_size = 100;
 // frequently saved
 uint64_t db_batch_size_verify = 5000;
 
+// number of chunks the reader thread may read ahead of the parser
+size_t read_ahead_chunks = 4096;
+
+// number of blocks parsed together on the threadpool; one group is parsed
+// while the previous one is being added to the db
+size_t parse_group_size = 512;
+
+// number of packed chunks the reader checks and decompresses together on
+// the threadpool
+size_t unpack_group_size = 16;
+
 std::string refresh_string = "\r                                    \r";
 }
 
@@ -169,7 +185,7 @@ int pop_blocks(cryptonote::core& core, int num_blocks)
   return num_blocks;
 }
 
-int check_flush(cryptonote::core &core, std::list<block_complete_entry> &blocks, bool force)
+int check_flush(cryptonote::core &core, std::list<block_complete_entry> &blocks, std::list<crypto::hash> &hashes, bool force)
 {
   if (blocks.empty())
     return 0;
@@ -181,34 +197,30 @@ int check_flush(cryptonote::core &core, std::list<block_complete_entry> &blocks,
   if (!force && new_height % HASH_OF_HASHES_STEP)
     return 0;
 
-  std::list<crypto::hash> hashes;
-  for (const auto &b: blocks)
-  {
-    cryptonote::block block;
-    if (!parse_and_validate_block_from_blob(b.block, block))
-    {
-      MERROR("Failed to parse block: "
-          << epee::string_tools::pod_to_hex(get_blob_hash(b.block)));
-      core.cleanup_handle_incoming_blocks();
-      return 1;
-    }
-    hashes.push_back(cryptonote::get_block_hash(block));
-  }
+  // block hashes were computed by the parser threads
   core.prevalidate_block_hashes(core.get_blockchain_storage().get_db().height(), hashes);
 
   core.prepare_handle_incoming_blocks(blocks);
 
   for(const block_complete_entry& block_entry: blocks)
   {
-    // process transactions
-    for(auto& tx_blob: block_entry.txs)
+    // process transactions, a block's worth at a time so they are
+    // checked in parallel
+    std::vector<tx_verification_context> tvc;
+    core.handle_incoming_txs(block_entry.txs, tvc, true, true, false);
+    if (tvc.size() != block_entry.txs.size())
     {
-      tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-      core.handle_incoming_tx(tx_blob, tvc, true, true, false);
-      if(tvc.m_verifivation_failed)
+      MERROR("Internal error: tvc.size() != block_entry.txs.size()");
+      core.cleanup_handle_incoming_blocks();
+      return 1;
+    }
+    std::list<blobdata>::const_iterator it = block_entry.txs.begin();
+    for (size_t i = 0; i < tvc.size(); ++i, ++it)
+    {
+      if(tvc[i].m_verifivation_failed)
       {
         MERROR("transaction verification failed, tx_id = "
-            << epee::string_tools::pod_to_hex(get_blob_hash(tx_blob)));
+            << epee::string_tools::pod_to_hex(get_blob_hash(*it)));
         core.cleanup_handle_incoming_blocks();
         return 1;
       }
@@ -239,9 +251,298 @@ int check_flush(cryptonote::core &core, std::list<block_complete_entry> &blocks,
     return 1;
 
   blocks.clear();
+  hashes.clear();
   return 0;
 }
 
+// Reads raw chunks from a bootstrap file on its own thread, staying up to a
+// fixed number of chunks ahead of the consumer. Packed files are split back
+// into one chunk per block, so the consumer sees the same stream either way.
+class chunk_reader
+{
+public:
+  struct chunk
+  {
+    std::string data;
+    std::streampos end_pos; // file position right after this chunk
+    uint64_t file_bytes;    // bytes of the file read for this chunk; a packed
+                            // chunk counts them all on its first block
+  };
+
+  enum end_reason { END_NONE, END_OF_FILE, END_TRUNCATED, END_ERROR };
+
+  // for packed files, pass their index: reading starts at the chunk holding
+  // start_height, and the blocks before it are skipped
+  chunk_reader(std::ifstream &import_file, size_t max_queued,
+      const bootstrap::packed_index *index = NULL, uint64_t start_height = 0):
+    m_file(import_file), m_max_queued(max_queued), m_index(index), m_height(start_height), m_next_chunk(0),
+    m_stop(false), m_end(END_NONE)
+  {
+    if (m_index)
+      m_next_chunk = BootstrapFile::find_packed_chunk(*m_index, start_height);
+  }
+  ~chunk_reader() { stop(); }
+
+  void start()
+  {
+    m_thread = boost::thread(&chunk_reader::run, this);
+  }
+
+  void stop()
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cond.notify_all();
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+
+  // waits for the next chunk, returns false once the reader has ended
+  bool next(chunk &c)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (m_queue.empty() && m_end == END_NONE)
+      m_cond.wait(lock);
+    if (m_queue.empty())
+      return false;
+    c = std::move(m_queue.front());
+    m_queue.pop_front();
+    m_cond.notify_all();
+    return true;
+  }
+
+  end_reason end(std::string &error)
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    error = m_error;
+    return m_end;
+  }
+
+private:
+  void finish(end_reason reason, const std::string &error = std::string())
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(m_mutex);
+      m_end = reason;
+      m_error = error;
+    }
+    m_cond.notify_all();
+  }
+
+  void run()
+  {
+    if (m_index)
+      run_packed();
+    else
+      run_raw();
+  }
+
+  // waits until the consumer has room, returns the number of free slots,
+  // or 0 when asked to stop
+  size_t wait_for_room()
+  {
+    boost::unique_lock<boost::mutex> lock(m_mutex);
+    while (m_queue.size() >= m_max_queued && !m_stop)
+      m_cond.wait(lock);
+    return m_stop ? 0 : m_max_queued - m_queue.size();
+  }
+
+  void run_packed()
+  {
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    std::vector<bootstrap::chunk_header> headers;
+    std::vector<std::string> payloads;
+    std::vector<uint64_t> sizes;
+    std::vector<std::vector<std::string>> blocks;
+    std::vector<char> ok;
+
+    if (m_next_chunk < m_index->chunks.size())
+      m_file.seekg(m_index->chunks[m_next_chunk].offset);
+    while (true)
+    {
+      // a group only takes as many blocks as there is room for, so the queue
+      // overshoots its bound by less than one chunk
+      const size_t room = wait_for_room();
+      if (!room)
+        return;
+
+      headers.clear();
+      payloads.clear();
+      sizes.clear();
+      uint64_t group_blocks = 0;
+      while (headers.size() < unpack_group_size && m_next_chunk < m_index->chunks.size())
+      {
+        const bootstrap::chunk_index_entry &entry = m_index->chunks[m_next_chunk];
+        if (!headers.empty() && group_blocks + entry.block_count > room)
+          break;
+        const std::streampos start_pos = m_file.tellg();
+        bootstrap::chunk_header header;
+        if (!BootstrapFile::read_chunk_header(m_file, header) || header.block_first != entry.block_first
+            || header.block_count != entry.block_count)
+        {
+          finish(END_ERROR, "Error reading chunk header at height " + std::to_string(entry.block_first));
+          return;
+        }
+        std::string payload(header.packed_size, 0);
+        m_file.read(&payload[0], payload.size());
+        if (! m_file)
+        {
+          if (m_file.eof())
+            finish(END_TRUNCATED);
+          else
+            finish(END_ERROR, "ERROR: unexpected end of file in chunk at height " + std::to_string(entry.block_first));
+          return;
+        }
+        headers.push_back(header);
+        payloads.push_back(std::move(payload));
+        sizes.push_back(m_file.tellg() - start_pos);
+        group_blocks += entry.block_count;
+        ++m_next_chunk;
+      }
+      if (headers.empty())
+      {
+        finish(END_OF_FILE);
+        return;
+      }
+
+      blocks.clear();
+      blocks.resize(headers.size());
+      ok.assign(headers.size(), 0);
+      tools::threadpool::waiter waiter;
+      for (size_t i = 0; i < headers.size(); ++i)
+        tpool.submit(&waiter, [&headers, &payloads, &blocks, &ok, i](){ ok[i] = BootstrapFile::unpack_chunk(headers[i], payloads[i], blocks[i]); });
+      waiter.wait();
+
+      for (size_t i = 0; i < headers.size(); ++i)
+      {
+        if (!ok[i])
+        {
+          finish(END_ERROR, "Error unpacking chunk at height " + std::to_string(headers[i].block_first));
+          return;
+        }
+        {
+          boost::unique_lock<boost::mutex> lock(m_mutex);
+          uint64_t file_bytes = sizes[i];
+          for (size_t j = 0; j < blocks[i].size(); ++j)
+          {
+            if (headers[i].block_first + j < m_height)
+              continue;
+            chunk c;
+            c.data = std::move(blocks[i][j]);
+            c.file_bytes = file_bytes;
+            file_bytes = 0;
+            m_queue.push_back(std::move(c));
+          }
+        }
+        m_cond.notify_all();
+      }
+    }
+  }
+
+  void run_raw()
+  {
+    char buffer1[1024];
+    std::string str1;
+    while (true)
+    {
+      if (!wait_for_room())
+        return;
+
+      uint32_t chunk_size;
+      m_file.read(buffer1, sizeof(chunk_size));
+      // TODO: bootstrap.read_chunk();
+      if (! m_file) {
+        finish(END_OF_FILE);
+        return;
+      }
+
+      str1.assign(buffer1, sizeof(chunk_size));
+      if (! ::serialization::parse_binary(str1, chunk_size))
+      {
+        finish(END_ERROR, "Error in deserialization of chunk size");
+        return;
+      }
+      MDEBUG("chunk_size: " << chunk_size);
+
+      if (chunk_size > BUFFER_SIZE)
+      {
+        MWARNING("WARNING: chunk_size " << chunk_size << " > BUFFER_SIZE " << BUFFER_SIZE);
+        finish(END_ERROR, "Aborting: chunk size exceeds buffer size");
+        return;
+      }
+      if (chunk_size > CHUNK_SIZE_WARNING_THRESHOLD)
+      {
+        MINFO("NOTE: chunk_size " << chunk_size << " > " << CHUNK_SIZE_WARNING_THRESHOLD);
+      }
+      else if (chunk_size == 0) {
+        finish(END_ERROR, "ERROR: chunk_size == 0");
+        return;
+      }
+
+      chunk c;
+      c.data.resize(chunk_size);
+      m_file.read(&c.data[0], chunk_size);
+      if (! m_file) {
+        if (m_file.eof())
+          finish(END_TRUNCATED);
+        else
+          finish(END_ERROR, "ERROR: unexpected end of file: bytes read before error: "
+              + std::to_string(m_file.gcount()) + " of chunk_size " + std::to_string(chunk_size));
+        return;
+      }
+      c.end_pos = m_file.tellg();
+      c.file_bytes = sizeof(chunk_size) + chunk_size;
+
+      {
+        boost::unique_lock<boost::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(c));
+      }
+      m_cond.notify_all();
+    }
+  }
+
+  std::ifstream &m_file;
+  const size_t m_max_queued;
+  const bootstrap::packed_index *m_index;
+  uint64_t m_height;
+  size_t m_next_chunk;
+  boost::thread m_thread;
+  boost::mutex m_mutex;
+  boost::condition_variable m_cond;
+  std::deque<chunk> m_queue;
+  bool m_stop;
+  end_reason m_end;
+  std::string m_error;
+};
+
+// A chunk as deserialized by the parser threads
+struct parsed_chunk
+{
+  bool ok;
+  bootstrap::block_package bp;
+  crypto::hash hash;
+  block_complete_entry entry; // blobs to verify, only filled in with opt_verify
+};
+
+void parse_chunk(const std::string &data, parsed_chunk &parsed)
+{
+  parsed.ok = ::serialization::parse_binary(data, parsed.bp);
+  if (!parsed.ok)
+    return;
+  parsed.hash = cryptonote::get_block_hash(parsed.bp.block);
+  if (opt_verify)
+  {
+    cryptonote::block_to_blob(parsed.bp.block, parsed.entry.block);
+    for (const auto &tx: parsed.bp.txs)
+    {
+      parsed.entry.txs.push_back(cryptonote::blobdata());
+      cryptonote::tx_to_blob(tx, parsed.entry.txs.back());
+    }
+  }
+}
+
 int import_from_file(cryptonote::core& core, const std::string& import_file_path, uint64_t block_stop=0)
 {
   // Reset stats, in case we're using newly created db, accumulating stats
@@ -265,7 +566,18 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
   BootstrapFile bootstrap;
   std::streampos pos;
   // BootstrapFile bootstrap(import_file_path);
-  uint64_t total_source_blocks = bootstrap.count_blocks(import_file_path, pos, seek_height);
+  // packed files carry an index, so there is no need to scan them first
+  const bool packed = BootstrapFile::is_packed_file(import_file_path);
+  bootstrap::packed_index index;
+  uint64_t total_source_blocks;
+  if (packed)
+  {
+    if (!bootstrap.load_packed_index(import_file_path, index))
+      return false;
+    total_source_blocks = index.block_end;
+  }
+  else
+    total_source_blocks = bootstrap.count_blocks(import_file_path, pos, seek_height);
   MINFO("bootstrap file last block number: " << total_source_blocks-1 << " (zero-based height)  total blocks: " << total_source_blocks);
 
   if (total_source_blocks-1 <= start_height)
@@ -289,15 +601,10 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
   }
 
   // 4 byte magic + (currently) 1024 byte header structures
-  bootstrap.seek_to_first_chunk(import_file);
+  bootstrap.seek_to_first_chunk(import_file, packed);
 
-  std::string str1;
-  char buffer1[1024];
-  char buffer_block[BUFFER_SIZE];
-  block b;
-  transaction tx;
   int quit = 0;
-  uint64_t bytes_read;
+  uint64_t bytes_read = 0;
 
   // Note that a new blockchain will start with block number 0 (total blocks: 1)
   // due to genesis block being added at initialization.
@@ -318,8 +625,15 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
   std::cout << ENDL;
 
   std::list<block_complete_entry> blocks;
+  std::list<crypto::hash> hashes;
 
-  // Skip to start_height before we start adding.
+  // Skip to start_height before we start adding. The packed reader seeks
+  // there through the index itself.
+  if (packed)
+  {
+    h = start_height;
+  }
+  else
   {
     bool q2 = false;
     import_file.seekg(pos);
@@ -336,204 +650,209 @@ int import_from_file(cryptonote::core& core, const std::string& import_file_path
   {
     uint64_t bytes, h2;
     bool q2;
-    pos = import_file.tellg();
-    bytes = bootstrap.count_bytes(import_file, db_batch_size, h2, q2);
-    if (import_file.eof())
-      import_file.clear();
-    import_file.seekg(pos);
-    core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
-  }
-  while (! quit)
-  {
-    uint32_t chunk_size;
-    import_file.read(buffer1, sizeof(chunk_size));
-    // TODO: bootstrap.read_chunk();
-    if (! import_file) {
-      std::cout << refresh_string;
-      MINFO("End of file reached");
-      quit = 1;
-      break;
-    }
-    bytes_read += sizeof(chunk_size);
-
-    str1.assign(buffer1, sizeof(chunk_size));
-    if (! ::serialization::parse_binary(str1, chunk_size))
+    if (packed)
     {
-      throw std::runtime_error("Error in deserialization of chunk size");
+      bytes = BootstrapFile::count_packed_bytes(index, h, db_batch_size);
     }
-    MDEBUG("chunk_size: " << chunk_size);
-
-    if (chunk_size > BUFFER_SIZE)
+    else
     {
-      MWARNING("WARNING: chunk_size " << chunk_size << " > BUFFER_SIZE " << BUFFER_SIZE);
-      throw std::runtime_error("Aborting: chunk size exceeds buffer size");
+      pos = import_file.tellg();
+      bytes = bootstrap.count_bytes(import_file, db_batch_size, h2, q2);
+      if (import_file.eof())
+        import_file.clear();
+      import_file.seekg(pos);
     }
-    if (chunk_size > CHUNK_SIZE_WARNING_THRESHOLD)
+    core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
+  }
+
+  // Three stages: the reader thread reads chunks ahead, the threadpool
+  // deserializes and hashes a group of them while this thread adds the
+  // previous group to the db.
+  {
+    // the reader thread owns import_file's position, so sizing the next db
+    // batch reads through a handle of its own
+    std::ifstream size_file;
+    if (use_batch && !packed)
+      size_file.open(import_file_path, std::ios_base::binary | std::ifstream::in);
+
+    chunk_reader reader(import_file, read_ahead_chunks, packed ? &index : NULL, h);
+    reader.start();
+
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    std::vector<chunk_reader::chunk> raw[2];
+    std::vector<parsed_chunk> parsed[2];
+    tools::threadpool::waiter waiter[2];
+    uint64_t h_read = h; // height of the next chunk to take from the reader
+
+    auto read_and_parse = [&](size_t group)
     {
-      MINFO("NOTE: chunk_size " << chunk_size << " > " << CHUNK_SIZE_WARNING_THRESHOLD);
-    }
-    else if (chunk_size == 0) {
-      MFATAL("ERROR: chunk_size == 0");
-      return 2;
-    }
-    import_file.read(buffer_block, chunk_size);
-    if (! import_file) {
-      if (import_file.eof())
+      raw[group].clear();
+      while (raw[group].size() < parse_group_size && h_read <= block_stop)
       {
-        std::cout << refresh_string;
-        MINFO("End of file reached - file was truncated");
-        quit = 1;
-        break;
-      }
-      else
-      {
-        MFATAL("ERROR: unexpected end of file: bytes read before error: "
-            << import_file.gcount() << " of chunk_size " << chunk_size);
-        return 2;
+        chunk_reader::chunk c;
+        if (!reader.next(c))
+          break;
+        raw[group].push_back(std::move(c));
+        ++h_read;
       }
-    }
-    bytes_read += chunk_size;
-    MDEBUG("Total bytes read: " << bytes_read);
-
-    if (h > block_stop)
+      parsed[group].clear();
+      parsed[group].resize(raw[group].size());
+      for (size_t i = 0; i < raw[group].size(); ++i)
+        tpool.submit(&waiter[group], [&raw, &parsed, group, i](){ parse_chunk(raw[group][i].data, parsed[group][i]); });
+    };
+
+    size_t cur = 0;
+    read_and_parse(cur);
+    while (! quit)
     {
-      std::cout << refresh_string << "block " << h-1
-        << " / " << block_stop
-        << std::flush;
-      std::cout << ENDL << ENDL;
-      MINFO("Specified block number reached - stopping.  block: " << h-1 << "  total blocks: " << h);
-      quit = 1;
-      break;
-    }
+      waiter[cur].wait();
+      if (parsed[cur].empty())
+        break;
+      read_and_parse(cur ^ 1);
 
-    try
-    {
-      str1.assign(buffer_block, chunk_size);
-      bootstrap::block_package bp;
-      if (! ::serialization::parse_binary(str1, bp))
-        throw std::runtime_error("Error in deserialization of chunk");
-
-      int display_interval = 1000;
-      int progress_interval = 10;
-      // NOTE: use of NUM_BLOCKS_PER_CHUNK is a placeholder in case multi-block chunks are later supported.
-      for (int chunk_ind = 0; chunk_ind < NUM_BLOCKS_PER_CHUNK; ++chunk_ind)
+      for (size_t i = 0; i < parsed[cur].size() && ! quit; ++i)
       {
-        ++h;
-        if ((h-1) % display_interval == 0)
-        {
-          std::cout << refresh_string;
-          MDEBUG("loading block number " << h-1);
-        }
-        else
-        {
-          MDEBUG("loading block number " << h-1);
-        }
-        b = bp.block;
-        MDEBUG("block prev_id: " << b.prev_id << ENDL);
-
-        if ((h-1) % progress_interval == 0)
-        {
-          std::cout << refresh_string << "block " << h-1
-            << " / " << block_stop
-            << std::flush;
-        }
+        bytes_read += raw[cur][i].file_bytes;
+        MDEBUG("Total bytes read: " << bytes_read);
 
-        if (opt_verify)
+        try
         {
-          cryptonote::blobdata block;
-          cryptonote::block_to_blob(bp.block, block);
-          std::list<cryptonote::blobdata> txs;
-          for (const auto &tx: bp.txs)
+          parsed_chunk &pc = parsed[cur][i];
+          if (! pc.ok)
+            throw std::runtime_error("Error in deserialization of chunk");
+
+          int display_interval = 1000;
+          int progress_interval = 10;
+          ++h;
+          if ((h-1) % display_interval == 0)
           {
-            txs.push_back(cryptonote::blobdata());
-            cryptonote::tx_to_blob(tx, txs.back());
+            std::cout << refresh_string;
+            MDEBUG("loading block number " << h-1);
           }
-          blocks.push_back({block, txs});
-          int ret = check_flush(core, blocks, false);
-          if (ret)
+          else
           {
-            quit = 2; // make sure we don't commit partial block data
-            break;
+            MDEBUG("loading block number " << h-1);
           }
-        }
-        else
-        {
-          std::vector<transaction> txs;
-          std::vector<transaction> archived_txs;
+          MDEBUG("block prev_id: " << pc.bp.block.prev_id << ENDL);
 
-          archived_txs = bp.txs;
-
-          // tx number 1: coinbase tx
-          // tx number 2 onwards: archived_txs
-          for (const transaction &tx : archived_txs)
+          if ((h-1) % progress_interval == 0)
           {
-            // add blocks with verification.
-            // for Blockchain and blockchain_storage add_new_block().
-            // for add_block() method, without (much) processing.
-            // don't add coinbase transaction to txs.
-            //
-            // because add_block() calls
-            // add_transaction(blk_hash, blk.miner_tx) first, and
-            // then a for loop for the transactions in txs.
-            txs.push_back(tx);
+            std::cout << refresh_string << "block " << h-1
+              << " / " << block_stop
+              << std::flush;
           }
 
-          size_t block_size;
-          difficulty_type cumulative_difficulty;
-          uint64_t coins_generated;
-
-          block_size = bp.block_size;
-          cumulative_difficulty = bp.cumulative_difficulty;
-          coins_generated = bp.coins_generated;
-
-          try
-          {
-            core.get_blockchain_storage().get_db().add_block(b, block_size, cumulative_difficulty, coins_generated, txs);
-          }
-          catch (const std::exception& e)
+          if (opt_verify)
           {
-            std::cout << refresh_string;
-            MFATAL("Error adding block to blockchain: " << e.what());
-            quit = 2; // make sure we don't commit partial block data
-            break;
+            blocks.push_back(std::move(pc.entry));
+            hashes.push_back(pc.hash);
+            int ret = check_flush(core, blocks, hashes, false);
+            if (ret)
+            {
+              quit = 2; // make sure we don't commit partial block data
+              break;
+            }
           }
-
-          if (use_batch)
+          else
           {
-            if ((h-1) % db_batch_size == 0)
+            // add_block() adds the coinbase transaction itself, so the
+            // archived txs don't include it
+            try
+            {
+              core.get_blockchain_storage().get_db().add_block(pc.bp.block, pc.bp.block_size, pc.bp.cumulative_difficulty, pc.bp.coins_generated, pc.bp.txs);
+            }
+            catch (const std::exception& e)
             {
-              uint64_t bytes, h2;
-              bool q2;
               std::cout << refresh_string;
-              // zero-based height
-              std::cout << ENDL << "[- batch commit at height " << h-1 << " -]" << ENDL;
-              core.get_blockchain_storage().get_db().batch_stop();
-              pos = import_file.tellg();
-              bytes = bootstrap.count_bytes(import_file, db_batch_size, h2, q2);
-              import_file.seekg(pos);
-              core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
-              std::cout << ENDL;
-              core.get_blockchain_storage().get_db().show_stats();
+              MFATAL("Error adding block to blockchain: " << e.what());
+              quit = 2; // make sure we don't commit partial block data
+              break;
+            }
+
+            if (use_batch)
+            {
+              if ((h-1) % db_batch_size == 0)
+              {
+                uint64_t bytes, h2;
+                bool q2;
+                std::cout << refresh_string;
+                // zero-based height
+                std::cout << ENDL << "[- batch commit at height " << h-1 << " -]" << ENDL;
+                core.get_blockchain_storage().get_db().batch_stop();
+                if (packed)
+                {
+                  bytes = BootstrapFile::count_packed_bytes(index, h, db_batch_size);
+                }
+                else
+                {
+                  size_file.clear();
+                  size_file.seekg(raw[cur][i].end_pos);
+                  bytes = bootstrap.count_bytes(size_file, db_batch_size, h2, q2);
+                }
+                core.get_blockchain_storage().get_db().batch_start(db_batch_size, bytes);
+                std::cout << ENDL;
+                core.get_blockchain_storage().get_db().show_stats();
+              }
             }
           }
+          ++num_imported;
+        }
+        catch (const std::exception& e)
+        {
+          std::cout << refresh_string;
+          MFATAL("exception while reading from file, height=" << h << ": " << e.what());
+          // the other group may still be parsing into the buffers
+          waiter[0].wait();
+          waiter[1].wait();
+          reader.stop();
+          return 2;
         }
-        ++num_imported;
       }
-    }
-    catch (const std::exception& e)
+
+      raw[cur].clear();
+      parsed[cur].clear();
+      cur ^= 1;
+    } // while
+
+    // no parser task may outlive the buffers it writes to
+    waiter[0].wait();
+    waiter[1].wait();
+    reader.stop();
+
+    if (! quit)
     {
+      std::string error;
       std::cout << refresh_string;
-      MFATAL("exception while reading from file, height=" << h << ": " << e.what());
-      return 2;
+      if (h > block_stop)
+      {
+        std::cout << "block " << h-1
+          << " / " << block_stop
+          << std::flush;
+        std::cout << ENDL << ENDL;
+        MINFO("Specified block number reached - stopping.  block: " << h-1 << "  total blocks: " << h);
+      }
+      else switch (reader.end(error))
+      {
+        case chunk_reader::END_TRUNCATED:
+          MINFO("End of file reached - file was truncated");
+          break;
+        case chunk_reader::END_ERROR:
+          MFATAL(error);
+          return 2;
+        default:
+          MINFO("End of file reached");
+          break;
+      }
+      quit = 1;
     }
-  } // while
+  }
 
 quitting:
   import_file.close();
 
   if (opt_verify)
   {
-    int ret = check_flush(core, blocks, true);
+    int ret = check_flush(core, blocks, hashes, true);
     if (ret)
       return ret;
   }
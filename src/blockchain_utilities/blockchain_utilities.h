@@ -34,5 +34,8 @@
 #define BUFFER_SIZE 1000000
 #define CHUNK_SIZE_WARNING_THRESHOLD 500000
 #define NUM_BLOCKS_PER_CHUNK 1
+#define PACKED_BLOCKS_PER_CHUNK 256
+#define PACKED_MAX_BLOCKS_PER_CHUNK 4096
+#define PACKED_ZSTD_LEVEL 3
 #define BLOCKCHAIN_RAW "blockchain.raw"
 
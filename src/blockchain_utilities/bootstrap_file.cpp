@@ -32,6 +32,15 @@
 #include "serialization/json_utils.h" // dump_json()
 
 #include "bootstrap_file.h"
+#include "common/int-util.h"
+#include "crypto/hash.h"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "bcutil"
@@ -46,14 +55,101 @@ namespace
   // This number was picked by taking the leading 4 bytes from this output:
   // echo Blur bootstrap file | sha1sum
   const uint32_t blockchain_raw_magic = 0x9147080a;
+  // echo Blur packed bootstrap file | sha1sum
+  const uint32_t blockchain_packed_magic = 0x1b055126;
   const uint32_t header_size = 1024;
 
+  // packed file trailer: index offset, chunk count, block end, index hash, magic
+  const uint64_t packed_index_entry_size = 8 + 8 + 4 + 4;
+  const uint64_t packed_trailer_size = 8 + 8 + 8 + sizeof(crypto::hash) + 4;
+  const uint32_t max_chunk_header_size = 256;
+
   std::string refresh_string = "\r                                    \r";
-}
 
+  void put_le32(std::string& s, uint32_t v)
+  {
+    v = SWAP32LE(v);
+    s.append((const char*)&v, sizeof(v));
+  }
 
+  void put_le64(std::string& s, uint64_t v)
+  {
+    v = SWAP64LE(v);
+    s.append((const char*)&v, sizeof(v));
+  }
 
-bool BootstrapFile::open_writer(const boost::filesystem::path& file_path)
+  uint32_t get_le32(const char* p)
+  {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return SWAP32LE(v);
+  }
+
+  uint64_t get_le64(const char* p)
+  {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return SWAP64LE(v);
+  }
+
+  bool compress_chunk(bootstrap::chunk_codec codec, const char* data, size_t size, std::string& packed)
+  {
+    switch (codec)
+    {
+      case bootstrap::CODEC_NONE:
+        packed.assign(data, size);
+        return true;
+#ifdef HAVE_ZSTD
+      case bootstrap::CODEC_ZSTD:
+      {
+        packed.resize(ZSTD_compressBound(size));
+        size_t r = ZSTD_compress(&packed[0], packed.size(), data, size, PACKED_ZSTD_LEVEL);
+        if (ZSTD_isError(r))
+        {
+          MERROR("zstd compression failed: " << ZSTD_getErrorName(r));
+          return false;
+        }
+        packed.resize(r);
+        return true;
+      }
+#endif
+      default:
+        MERROR("Unsupported chunk codec: " << unsigned(codec));
+        return false;
+    }
+  }
+
+  bool decompress_chunk(bootstrap::chunk_codec codec, const std::string& packed, size_t raw_size, std::string& raw)
+  {
+    switch (codec)
+    {
+#ifdef HAVE_ZSTD
+      case bootstrap::CODEC_ZSTD:
+      {
+        raw.resize(raw_size);
+        size_t r = ZSTD_decompress(&raw[0], raw.size(), packed.data(), packed.size());
+        if (ZSTD_isError(r))
+        {
+          MERROR("zstd decompression failed: " << ZSTD_getErrorName(r));
+          return false;
+        }
+        if (r != raw_size)
+        {
+          MERROR("Decompressed chunk size " << r << " does not match expected size " << raw_size);
+          return false;
+        }
+        return true;
+      }
+#endif
+      default:
+        MERROR("Unsupported chunk codec: " << unsigned(codec));
+        return false;
+    }
+  }
+}
+
+
+bool BootstrapFile::prepare_output_dir(const boost::filesystem::path& file_path)
 {
   const boost::filesystem::path dir_path = file_path.parent_path();
   if (!dir_path.empty())
@@ -75,8 +171,13 @@ bool BootstrapFile::open_writer(const boost::filesystem::path& file_path)
       }
     }
   }
+  return true;
+}
 
-  m_raw_data_file = new std::ofstream();
+bool BootstrapFile::open_writer(const boost::filesystem::path& file_path)
+{
+  if (!prepare_output_dir(file_path))
+    return false;
 
   bool do_initialize_file = false;
   uint64_t num_blocks = 0;
@@ -89,11 +190,17 @@ bool BootstrapFile::open_writer(const boost::filesystem::path& file_path)
   }
   else
   {
+    if (is_packed_file(file_path.string()))
+    {
+      MFATAL("Can't append to packed bootstrap file " << file_path << " in raw format");
+      return false;
+    }
     num_blocks = count_blocks(file_path.string());
     MDEBUG("appending to existing file with height: " << num_blocks-1 << "  total blocks: " << num_blocks);
   }
   m_height = num_blocks;
 
+  m_raw_data_file = new std::ofstream();
   if (do_initialize_file)
     m_raw_data_file->open(file_path.string(), std::ios_base::binary | std::ios_base::out | std::ios::trunc);
   else
@@ -211,6 +318,12 @@ void BootstrapFile::flush_chunk()
 void BootstrapFile::write_block(block& block)
 {
   bootstrap::block_package bp;
+  fill_package(block, bp);
+  write_package(bp);
+}
+
+void BootstrapFile::fill_package(block& block, bootstrap::block_package& bp)
+{
   bp.block = block;
 
   std::vector<transaction> txs;
@@ -245,8 +358,22 @@ void BootstrapFile::write_block(block& block)
     bp.cumulative_difficulty = cumulative_difficulty;
     bp.coins_generated = coins_generated;
   }
+}
 
+void BootstrapFile::write_package(const bootstrap::block_package& bp)
+{
   blobdata bd = t_serializable_object_to_blob(bp);
+  if (m_packed)
+  {
+    // packed chunks hold several blocks, so each one carries its own size
+    std::string blob;
+    uint32_t block_blob_size = bd.size();
+    if (! ::serialization::dump_binary(block_blob_size, blob))
+    {
+      throw std::runtime_error("Error in serialization of block size");
+    }
+    m_output_stream->write(blob.data(), blob.size());
+  }
   m_output_stream->write((const char*)bd.data(), bd.size());
 }
 
@@ -266,6 +393,7 @@ bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
 {
   uint64_t num_blocks_written = 0;
   m_max_chunk = 0;
+  m_packed = false;
   m_blockchain_storage = _blockchain_storage;
   m_tx_pool = _tx_pool;
   uint64_t progress_interval = 100;
@@ -281,18 +409,7 @@ bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
   // from last exported block, block_start doesn't need to add 1 here, as it's already at the next
   // height.
   uint64_t block_start = m_height;
-  uint64_t block_stop = 0;
-  MINFO("source blockchain height: " <<  m_blockchain_storage->get_current_blockchain_height()-1);
-  if ((requested_block_stop > 0) && (requested_block_stop < m_blockchain_storage->get_current_blockchain_height()))
-  {
-    MINFO("Using requested block height: " << requested_block_stop);
-    block_stop = requested_block_stop;
-  }
-  else
-  {
-    block_stop = m_blockchain_storage->get_current_blockchain_height() - 1;
-    MINFO("Using block height of source blockchain: " << block_stop);
-  }
+  uint64_t block_stop = export_block_stop(requested_block_stop);
   for (m_cur_height = block_start; m_cur_height <= block_stop; ++m_cur_height)
   {
     // this method's height refers to 0-based height (genesis block = height 0)
@@ -324,7 +441,519 @@ bool BootstrapFile::store_blockchain_raw(Blockchain* _blockchain_storage, tx_mem
   return BootstrapFile::close();
 }
 
-uint64_t BootstrapFile::seek_to_first_chunk(std::ifstream& import_file)
+uint64_t BootstrapFile::export_block_stop(uint64_t requested_block_stop)
+{
+  uint64_t block_stop = 0;
+  MINFO("source blockchain height: " <<  m_blockchain_storage->get_current_blockchain_height()-1);
+  if ((requested_block_stop > 0) && (requested_block_stop < m_blockchain_storage->get_current_blockchain_height()))
+  {
+    MINFO("Using requested block height: " << requested_block_stop);
+    block_stop = requested_block_stop;
+  }
+  else
+  {
+    block_stop = m_blockchain_storage->get_current_blockchain_height() - 1;
+    MINFO("Using block height of source blockchain: " << block_stop);
+  }
+  return block_stop;
+}
+
+bool BootstrapFile::codec_supported(bootstrap::chunk_codec codec)
+{
+  switch (codec)
+  {
+    case bootstrap::CODEC_NONE:
+      return true;
+    case bootstrap::CODEC_ZSTD:
+#ifdef HAVE_ZSTD
+      return true;
+#else
+      return false;
+#endif
+    default:
+      return false;
+  }
+}
+
+bool BootstrapFile::open_packed_writer(const boost::filesystem::path& file_path)
+{
+  if (!prepare_output_dir(file_path))
+    return false;
+
+  bool do_initialize_file = false;
+  m_index.chunks.clear();
+  m_index.block_end = 0;
+  m_index.data_end = 0;
+
+  if (! boost::filesystem::exists(file_path))
+  {
+    MDEBUG("creating packed file");
+    do_initialize_file = true;
+  }
+  else
+  {
+    if (!is_packed_file(file_path.string()))
+    {
+      MFATAL("Can't append to raw bootstrap file " << file_path << " in packed format");
+      return false;
+    }
+    if (!load_packed_index(file_path.string(), m_index))
+      return false;
+    // the index and trailer are rewritten after the new chunks
+    boost::filesystem::resize_file(file_path, m_index.data_end);
+    MDEBUG("appending to existing packed file with height: " << m_index.block_end-1 << "  total blocks: " << m_index.block_end);
+  }
+  m_height = m_index.block_end;
+
+  m_raw_data_file = new std::ofstream();
+  if (do_initialize_file)
+    m_raw_data_file->open(file_path.string(), std::ios_base::binary | std::ios_base::out | std::ios::trunc);
+  else
+    m_raw_data_file->open(file_path.string(), std::ios_base::binary | std::ios_base::out | std::ios::app | std::ios::ate);
+
+  if (m_raw_data_file->fail())
+    return false;
+
+  m_output_stream = new boost::iostreams::stream<boost::iostreams::back_insert_device<buffer_type>>(m_buffer);
+
+  if (do_initialize_file)
+  {
+    initialize_packed_file();
+    m_index.data_end = m_raw_data_file->tellp();
+  }
+
+  return true;
+}
+
+bool BootstrapFile::initialize_packed_file()
+{
+  std::string blob;
+  if (! ::serialization::dump_binary(blockchain_packed_magic, blob))
+  {
+    throw std::runtime_error("Error in serialization of file magic");
+  }
+  *m_raw_data_file << blob;
+
+  bootstrap::file_info bfi;
+  bfi.major_version = 1;
+  bfi.minor_version = 0;
+  bfi.header_size = header_size;
+
+  blobdata bd = t_serializable_object_to_blob(bfi);
+  MDEBUG("bootstrap::file_info size: " << bd.size());
+  uint32_t bd_size = bd.size();
+  if (! ::serialization::dump_binary(bd_size, blob))
+  {
+    throw std::runtime_error("Error in serialization of bootstrap::file_info size");
+  }
+
+  std::string header = blob + bd;
+  header.resize(header_size, 0); // fill in rest with null bytes
+  *m_raw_data_file << header;
+  return true;
+}
+
+void BootstrapFile::flush_packed_chunk()
+{
+  m_output_stream->flush();
+  if (m_chunk_blocks == 0)
+    return;
+
+  bootstrap::chunk_header header;
+  header.codec = m_codec;
+  header.block_first = m_index.block_end;
+  header.block_count = m_chunk_blocks;
+  header.raw_size = m_buffer.size();
+
+  std::string payload;
+  if (!compress_chunk(m_codec, m_buffer.data(), m_buffer.size(), payload))
+  {
+    throw std::runtime_error("Error compressing chunk");
+  }
+  header.packed_size = payload.size();
+  header.checksum = crypto::cn_fast_hash(payload.data(), payload.size());
+
+  blobdata bd = t_serializable_object_to_blob(header);
+  uint32_t chunk_header_size = bd.size();
+  std::string blob;
+  if (! ::serialization::dump_binary(chunk_header_size, blob))
+  {
+    throw std::runtime_error("Error in serialization of chunk header size");
+  }
+
+  bootstrap::chunk_index_entry entry;
+  entry.block_first = header.block_first;
+  entry.offset = m_raw_data_file->tellp();
+  entry.block_count = header.block_count;
+  entry.raw_size = header.raw_size;
+
+  *m_raw_data_file << blob << bd;
+  m_raw_data_file->write(payload.data(), payload.size());
+  m_raw_data_file->flush();
+  if (m_raw_data_file->fail())
+  {
+    MFATAL("Error writing chunk:  height: " << header.block_first << "  blocks: " << header.block_count << "  size: " << payload.size());
+    throw std::runtime_error("Error writing chunk");
+  }
+
+  m_index.chunks.push_back(entry);
+  m_index.block_end += header.block_count;
+  m_index.data_end = m_raw_data_file->tellp();
+  if (m_max_chunk < header.packed_size)
+  {
+    m_max_chunk = header.packed_size;
+  }
+
+  m_buffer.clear();
+  delete m_output_stream;
+  m_output_stream = new boost::iostreams::stream<boost::iostreams::back_insert_device<buffer_type>>(m_buffer);
+  m_chunk_blocks = 0;
+  MDEBUG("flushed packed chunk:  blocks: " << header.block_count << "  raw size: " << header.raw_size << "  packed size: " << header.packed_size);
+}
+
+void BootstrapFile::write_packed_index()
+{
+  std::string index;
+  index.reserve(m_index.chunks.size() * packed_index_entry_size);
+  for (const auto& entry: m_index.chunks)
+  {
+    put_le64(index, entry.block_first);
+    put_le64(index, entry.offset);
+    put_le32(index, entry.block_count);
+    put_le32(index, entry.raw_size);
+  }
+  crypto::hash index_hash = crypto::cn_fast_hash(index.data(), index.size());
+
+  std::string trailer;
+  put_le64(trailer, m_index.data_end);
+  put_le64(trailer, m_index.chunks.size());
+  put_le64(trailer, m_index.block_end);
+  trailer.append((const char*)&index_hash, sizeof(index_hash));
+  put_le32(trailer, blockchain_packed_magic);
+
+  *m_raw_data_file << index << trailer;
+  m_raw_data_file->flush();
+  if (m_raw_data_file->fail())
+    throw std::runtime_error("Error writing chunk index");
+  MDEBUG("wrote chunk index:  chunks: " << m_index.chunks.size() << "  size: " << index.size());
+}
+
+bool BootstrapFile::store_blockchain_packed(Blockchain* _blockchain_storage, tx_memory_pool* _tx_pool, boost::filesystem::path& output_file, uint64_t requested_block_stop,
+    bootstrap::chunk_codec codec, uint32_t blocks_per_chunk)
+{
+  m_blockchain_storage = _blockchain_storage;
+  m_tx_pool = _tx_pool;
+  const uint64_t block_stop = export_block_stop(requested_block_stop);
+  return store_packages_packed([this](uint64_t height, bootstrap::block_package& bp) {
+    block b;
+    crypto::hash hash = m_blockchain_storage->get_block_id_by_height(height);
+    m_blockchain_storage->get_block_by_hash(hash, b);
+    fill_package(b, bp);
+  }, output_file, block_stop, codec, blocks_per_chunk);
+}
+
+bool BootstrapFile::store_packages_packed(const package_source& source, boost::filesystem::path& output_file, uint64_t block_stop,
+    bootstrap::chunk_codec codec, uint32_t blocks_per_chunk)
+{
+  m_max_chunk = 0;
+  m_packed = true;
+  m_codec = codec;
+  m_chunk_blocks = 0;
+  uint64_t progress_interval = 100;
+  if (!codec_supported(codec))
+  {
+    MFATAL("chunk codec " << unsigned(codec) << " is not supported by this build");
+    return false;
+  }
+  if (blocks_per_chunk == 0 || blocks_per_chunk > PACKED_MAX_BLOCKS_PER_CHUNK)
+  {
+    MFATAL("blocks per chunk must be between 1 and " << PACKED_MAX_BLOCKS_PER_CHUNK);
+    return false;
+  }
+  MINFO("Storing blocks packed data...");
+  if (!BootstrapFile::open_packed_writer(output_file))
+  {
+    MFATAL("failed to open packed file for write");
+    return false;
+  }
+  bootstrap::block_package bp;
+
+  uint64_t block_start = m_height;
+  for (m_cur_height = block_start; m_cur_height <= block_stop; ++m_cur_height)
+  {
+    source(m_cur_height, bp);
+    write_package(bp);
+    if (++m_chunk_blocks == blocks_per_chunk)
+      flush_packed_chunk();
+    if (m_cur_height % progress_interval == 0) {
+      std::cout << refresh_string;
+      std::cout << "block " << m_cur_height << "/" << block_stop << std::flush;
+    }
+  }
+  flush_packed_chunk();
+  write_packed_index();
+  std::cout << refresh_string;
+  std::cout << "block " << m_cur_height-1 << "/" << block_stop << ENDL;
+
+  MINFO("Number of blocks exported: " << m_index.block_end - block_start);
+  if (m_index.block_end > block_start)
+    MINFO("Largest chunk: " << m_max_chunk << " bytes");
+
+  return BootstrapFile::close();
+}
+
+bool BootstrapFile::is_packed_file(const std::string& file_path)
+{
+  std::ifstream import_file(file_path, std::ios_base::binary | std::ifstream::in);
+  char buf[sizeof(blockchain_packed_magic)];
+  import_file.read(buf, sizeof(buf));
+  if (! import_file)
+    return false;
+  uint32_t file_magic;
+  if (! ::serialization::parse_binary(std::string(buf, sizeof(buf)), file_magic))
+    return false;
+  return file_magic == blockchain_packed_magic;
+}
+
+bool BootstrapFile::read_chunk_header(std::istream& import_file, bootstrap::chunk_header& header)
+{
+  char buf[max_chunk_header_size];
+  uint32_t chunk_header_size;
+  import_file.read(buf, sizeof(chunk_header_size));
+  if (! import_file)
+    return false;
+  if (! ::serialization::parse_binary(std::string(buf, sizeof(chunk_header_size)), chunk_header_size))
+    return false;
+  if (chunk_header_size == 0 || chunk_header_size > max_chunk_header_size)
+  {
+    MERROR("Bad chunk header size: " << chunk_header_size);
+    return false;
+  }
+  import_file.read(buf, chunk_header_size);
+  if (! import_file)
+    return false;
+  if (! ::serialization::parse_binary(std::string(buf, chunk_header_size), header))
+  {
+    MERROR("Error in deserialization of chunk header");
+    return false;
+  }
+
+  // sanity limits, so a corrupt header can't ask for huge allocations
+  const uint64_t max_raw_size = (uint64_t)header.block_count * (BUFFER_SIZE + sizeof(uint32_t));
+  if (header.block_count == 0 || header.block_count > PACKED_MAX_BLOCKS_PER_CHUNK
+      || header.raw_size > max_raw_size
+      || header.packed_size > header.raw_size + header.raw_size / 128 + 1024)
+  {
+    MERROR("Bad chunk header at height " << header.block_first << ":  blocks: " << header.block_count
+        << "  raw size: " << header.raw_size << "  packed size: " << header.packed_size);
+    return false;
+  }
+  return true;
+}
+
+bool BootstrapFile::unpack_chunk(const bootstrap::chunk_header& header, const std::string& payload, std::vector<std::string>& blocks)
+{
+  if (payload.size() != header.packed_size)
+  {
+    MERROR("Chunk at height " << header.block_first << " has " << payload.size() << " bytes, expected " << header.packed_size);
+    return false;
+  }
+  if (crypto::cn_fast_hash(payload.data(), payload.size()) != header.checksum)
+  {
+    MERROR("Checksum mismatch in chunk at height " << header.block_first);
+    return false;
+  }
+
+  std::string decompressed;
+  const std::string* raw = &payload;
+  if (header.codec != bootstrap::CODEC_NONE)
+  {
+    if (!decompress_chunk((bootstrap::chunk_codec)header.codec, payload, header.raw_size, decompressed))
+    {
+      MERROR("Error decompressing chunk at height " << header.block_first);
+      return false;
+    }
+    raw = &decompressed;
+  }
+  else if (header.raw_size != header.packed_size)
+  {
+    MERROR("Uncompressed chunk at height " << header.block_first << " has mismatched sizes");
+    return false;
+  }
+
+  blocks.clear();
+  blocks.reserve(header.block_count);
+  size_t pos = 0;
+  for (uint32_t i = 0; i < header.block_count; ++i)
+  {
+    uint32_t block_blob_size;
+    if (raw->size() - pos < sizeof(block_blob_size)
+        || ! ::serialization::parse_binary(raw->substr(pos, sizeof(block_blob_size)), block_blob_size))
+    {
+      MERROR("Error reading block size in chunk at height " << header.block_first);
+      return false;
+    }
+    pos += sizeof(block_blob_size);
+    if (block_blob_size > BUFFER_SIZE || raw->size() - pos < block_blob_size)
+    {
+      MERROR("Bad block size " << block_blob_size << " in chunk at height " << header.block_first);
+      return false;
+    }
+    blocks.push_back(raw->substr(pos, block_blob_size));
+    pos += block_blob_size;
+  }
+  if (pos != raw->size())
+  {
+    MERROR("Trailing data in chunk at height " << header.block_first);
+    return false;
+  }
+  return true;
+}
+
+// Walks the chunk headers from the current position, for files whose export
+// was interrupted before the index was written.
+bool BootstrapFile::scan_packed_chunks(std::ifstream& import_file, bootstrap::packed_index& index)
+{
+  import_file.seekg(0, std::ios_base::end);
+  const uint64_t file_size = import_file.tellg();
+  import_file.seekg(index.data_end);
+
+  while (index.data_end < file_size)
+  {
+    bootstrap::chunk_header header;
+    if (!read_chunk_header(import_file, header))
+      break;
+    if (!index.chunks.empty() && header.block_first != index.block_end)
+      break;
+    const uint64_t chunk_end = (uint64_t)import_file.tellg() + header.packed_size;
+    if (chunk_end > file_size)
+      break;
+
+    bootstrap::chunk_index_entry entry;
+    entry.block_first = header.block_first;
+    entry.offset = index.data_end;
+    entry.block_count = header.block_count;
+    entry.raw_size = header.raw_size;
+    index.chunks.push_back(entry);
+    index.block_end = header.block_first + header.block_count;
+    index.data_end = chunk_end;
+    import_file.seekg(chunk_end);
+  }
+  import_file.clear();
+  return true;
+}
+
+bool BootstrapFile::load_packed_index(const std::string& file_path, bootstrap::packed_index& index)
+{
+  namespace bip = boost::interprocess;
+
+  index.chunks.clear();
+  index.block_end = 0;
+  index.data_end = 0;
+
+  boost::system::error_code ec;
+  const uint64_t file_size = boost::filesystem::file_size(file_path, ec);
+  if (ec)
+  {
+    MFATAL("bootstrap file not found: " << file_path);
+    return false;
+  }
+  std::ifstream import_file(file_path, std::ios_base::binary | std::ifstream::in);
+  if (import_file.fail())
+  {
+    MFATAL("import_file.open() fail");
+    return false;
+  }
+  const uint64_t first_chunk_pos = seek_to_first_chunk(import_file, true);
+
+  if (file_size >= first_chunk_pos + packed_trailer_size)
+  {
+    try
+    {
+      bip::file_mapping mapping(file_path.c_str(), bip::read_only);
+      bip::mapped_region trailer_region(mapping, bip::read_only, file_size - packed_trailer_size, packed_trailer_size);
+      const char* trailer = (const char*)trailer_region.get_address();
+      const uint64_t index_offset = get_le64(trailer);
+      const uint64_t chunk_count = get_le64(trailer + 8);
+      const uint64_t block_end = get_le64(trailer + 16);
+      crypto::hash index_hash;
+      memcpy(&index_hash, trailer + 24, sizeof(index_hash));
+      const uint32_t trailer_magic = get_le32(trailer + 24 + sizeof(index_hash));
+
+      if (trailer_magic == blockchain_packed_magic && index_offset >= first_chunk_pos
+          && index_offset <= file_size - packed_trailer_size
+          && chunk_count <= (file_size - index_offset) / packed_index_entry_size
+          && index_offset + chunk_count * packed_index_entry_size + packed_trailer_size == file_size)
+      {
+        const size_t index_size = chunk_count * packed_index_entry_size;
+        const char* p = NULL;
+        bip::mapped_region index_region;
+        if (index_size)
+        {
+          index_region = bip::mapped_region(mapping, bip::read_only, index_offset, index_size);
+          p = (const char*)index_region.get_address();
+        }
+        if (crypto::cn_fast_hash(p, index_size) == index_hash)
+        {
+          bool valid = true;
+          index.chunks.resize(chunk_count);
+          for (uint64_t i = 0; i < chunk_count && valid; ++i, p += packed_index_entry_size)
+          {
+            bootstrap::chunk_index_entry& entry = index.chunks[i];
+            entry.block_first = get_le64(p);
+            entry.offset = get_le64(p + 8);
+            entry.block_count = get_le32(p + 16);
+            entry.raw_size = get_le32(p + 20);
+            if (i > 0)
+            {
+              const bootstrap::chunk_index_entry& prev = index.chunks[i - 1];
+              valid = entry.offset > prev.offset && entry.block_first == prev.block_first + prev.block_count;
+            }
+            valid = valid && entry.offset >= first_chunk_pos && entry.offset < index_offset;
+          }
+          if (valid && (chunk_count == 0 || index.chunks.back().block_first + index.chunks.back().block_count == block_end))
+          {
+            index.block_end = block_end;
+            index.data_end = index_offset;
+            MINFO("Loaded chunk index:  chunks: " << chunk_count << "  blocks: " << block_end);
+            return true;
+          }
+        }
+      }
+    }
+    catch (const bip::interprocess_exception& e)
+    {
+      MWARNING("Failed to map chunk index: " << e.what());
+    }
+    index.chunks.clear();
+  }
+
+  MWARNING("No valid chunk index found in " << file_path << ", scanning chunk headers");
+  index.data_end = first_chunk_pos;
+  scan_packed_chunks(import_file, index);
+  MINFO("Scanned chunk headers:  chunks: " << index.chunks.size() << "  blocks: " << index.block_end);
+  return true;
+}
+
+size_t BootstrapFile::find_packed_chunk(const bootstrap::packed_index& index, uint64_t height)
+{
+  auto it = std::upper_bound(index.chunks.begin(), index.chunks.end(), height,
+      [](uint64_t h, const bootstrap::chunk_index_entry& entry) { return h < entry.block_first; });
+  if (it != index.chunks.begin())
+    --it;
+  return it - index.chunks.begin();
+}
+
+uint64_t BootstrapFile::count_packed_bytes(const bootstrap::packed_index& index, uint64_t height, uint64_t blocks)
+{
+  auto it = index.chunks.begin() + find_packed_chunk(index, height);
+  uint64_t bytes = 0;
+  for (; it != index.chunks.end() && it->block_first < height + blocks; ++it)
+    bytes += it->raw_size;
+  return bytes;
+}
+
+uint64_t BootstrapFile::seek_to_first_chunk(std::ifstream& import_file, bool packed)
 {
   uint32_t file_magic;
 
@@ -338,7 +967,7 @@ uint64_t BootstrapFile::seek_to_first_chunk(std::ifstream& import_file)
   if (! ::serialization::parse_binary(str1, file_magic))
     throw std::runtime_error("Error in deserialization of file_magic");
 
-  if (file_magic != blockchain_raw_magic)
+  if (file_magic != (packed ? blockchain_packed_magic : blockchain_raw_magic))
   {
     MFATAL("bootstrap file not recognized");
     throw std::runtime_error("Aborting");
@@ -433,6 +1062,17 @@ uint64_t BootstrapFile::count_bytes(std::ifstream& import_file, uint64_t blocks,
 
 uint64_t BootstrapFile::count_blocks(const std::string& import_file_path)
 {
+  if (is_packed_file(import_file_path))
+  {
+    bootstrap::packed_index index;
+    if (!load_packed_index(import_file_path, index))
+      throw std::runtime_error("Aborting");
+    std::cout << ENDL;
+    std::cout << "Number of chunks: " << index.chunks.size() << ENDL;
+    std::cout << "Number of blocks: " << index.block_end << ENDL;
+    std::cout << ENDL;
+    return index.block_end;
+  }
   std::streampos dummy_pos;
   uint64_t dummy_height = 0;
   return count_blocks(import_file_path, dummy_pos, dummy_height);
@@ -43,10 +43,12 @@
 #include <fstream>
 #include <boost/iostreams/copy.hpp>
 #include <atomic>
+#include <functional>
 
 #include "common/command_line.h"
 
 #include "blockchain_utilities.h"
+#include "bootstrap_serialization.h"
 
 
 using namespace cryptonote;
@@ -59,11 +61,32 @@ public:
   uint64_t count_bytes(std::ifstream& import_file, uint64_t blocks, uint64_t& h, bool& quit);
   uint64_t count_blocks(const std::string& dir_path, std::streampos& start_pos, uint64_t& seek_height);
   uint64_t count_blocks(const std::string& dir_path);
-  uint64_t seek_to_first_chunk(std::ifstream& import_file);
+  uint64_t seek_to_first_chunk(std::ifstream& import_file, bool packed=false);
 
   bool store_blockchain_raw(cryptonote::Blockchain* cs, cryptonote::tx_memory_pool* txp,
       boost::filesystem::path& output_file, uint64_t use_block_height=0);
 
+  // packed format: multi-block, optionally compressed chunks with a trailing index
+  bool store_blockchain_packed(cryptonote::Blockchain* cs, cryptonote::tx_memory_pool* txp,
+      boost::filesystem::path& output_file, uint64_t use_block_height=0,
+      bootstrap::chunk_codec codec=bootstrap::CODEC_NONE, uint32_t blocks_per_chunk=PACKED_BLOCKS_PER_CHUNK);
+
+  // fills in the package for a (0-based) height
+  typedef std::function<void(uint64_t height, bootstrap::block_package& bp)> package_source;
+  // packed export of the packages from the file's current end up to block_stop
+  bool store_packages_packed(const package_source& source, boost::filesystem::path& output_file, uint64_t block_stop,
+      bootstrap::chunk_codec codec=bootstrap::CODEC_NONE, uint32_t blocks_per_chunk=PACKED_BLOCKS_PER_CHUNK);
+
+  static bool is_packed_file(const std::string& file_path);
+  static bool codec_supported(bootstrap::chunk_codec codec);
+  bool load_packed_index(const std::string& file_path, bootstrap::packed_index& index);
+  static uint64_t count_packed_bytes(const bootstrap::packed_index& index, uint64_t height, uint64_t blocks);
+  // position in index.chunks of the chunk holding height, or of the first
+  // chunk if height is below it
+  static size_t find_packed_chunk(const bootstrap::packed_index& index, uint64_t height);
+  static bool read_chunk_header(std::istream& import_file, bootstrap::chunk_header& header);
+  static bool unpack_chunk(const bootstrap::chunk_header& header, const std::string& payload, std::vector<std::string>& blocks);
+
 protected:
 
   Blockchain* m_blockchain_storage;
@@ -75,15 +98,30 @@ protected:
   boost::iostreams::stream<boost::iostreams::back_insert_device<buffer_type>>* m_output_stream;
 
   // open export file for write
+  bool prepare_output_dir(const boost::filesystem::path& file_path);
   bool open_writer(const boost::filesystem::path& file_path);
   bool initialize_file();
   bool close();
   void write_block(block& block);
+  void fill_package(block& block, bootstrap::block_package& bp);
+  void write_package(const bootstrap::block_package& bp);
   void flush_chunk();
+  uint64_t export_block_stop(uint64_t requested_block_stop);
+
+  bool open_packed_writer(const boost::filesystem::path& file_path);
+  bool initialize_packed_file();
+  bool scan_packed_chunks(std::ifstream& import_file, bootstrap::packed_index& index);
+  void flush_packed_chunk();
+  void write_packed_index();
 
 private:
 
   uint64_t m_height;
   uint64_t m_cur_height; // tracks current height during export
   uint32_t m_max_chunk;
+
+  bool m_packed;
+  bootstrap::chunk_codec m_codec;
+  bootstrap::packed_index m_index;
+  uint32_t m_chunk_blocks; // blocks buffered for the current packed chunk
 };
@@ -83,6 +83,51 @@ namespace cryptonote
       END_SERIALIZE()
     };
 
+    // Packed bootstrap files (file_info major_version 1) group several
+    // length-prefixed block_packages into each chunk, optionally compress the
+    // chunk, and end with an index of chunk offsets followed by a trailer.
+    enum chunk_codec : uint8_t
+    {
+      CODEC_NONE = 0,
+      CODEC_ZSTD = 1,
+    };
+
+    struct chunk_header
+    {
+      uint8_t  codec;
+      uint64_t block_first;
+      uint32_t block_count;
+      uint32_t raw_size;    // size of the chunk once decompressed
+      uint32_t packed_size; // size of the payload following this header
+      crypto::hash checksum; // cn_fast_hash of the payload as stored
+
+      BEGIN_SERIALIZE_OBJECT()
+        FIELD(codec);
+        VARINT_FIELD(block_first);
+        VARINT_FIELD(block_count);
+        VARINT_FIELD(raw_size);
+        VARINT_FIELD(packed_size);
+        FIELD(checksum);
+      END_SERIALIZE()
+    };
+
+    // One index record per chunk, stored as fixed-width little endian
+    // fields so the index can be mapped and read in place.
+    struct chunk_index_entry
+    {
+      uint64_t block_first;
+      uint64_t offset;      // file position of the chunk's header size field
+      uint32_t block_count;
+      uint32_t raw_size;
+    };
+
+    struct packed_index
+    {
+      std::vector<chunk_index_entry> chunks;
+      uint64_t block_end; // height after the last block in the file
+      uint64_t data_end;  // file position right after the last whole chunk
+    };
+
   }
 
 }
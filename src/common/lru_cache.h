@@ -0,0 +1,120 @@
+// Copyright (c) 2018-2022, Blur Network
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace tools
+{
+
+/**
+ * @brief bounded key/value cache evicting the least recently used entries
+ *
+ * Each entry has a weight (1 unless given), and the capacity bounds the sum
+ * of the weights, so it can count entries or, say, bytes.
+ * Not thread safe: callers sharing an instance must serialize access.
+ */
+template<typename K, typename V, typename Hash = std::hash<K>>
+class lru_cache
+{
+public:
+  explicit lru_cache(size_t capacity): m_capacity(capacity), m_weight(0) {}
+
+  /**
+   * @brief look up an entry and mark it as most recently used
+   *
+   * @return a pointer to the value, or NULL if absent; it stays valid
+   *         until the entry is evicted or erased
+   */
+  V *find(const K &key)
+  {
+    const auto i = m_index.find(key);
+    if (i == m_index.end())
+      return NULL;
+    m_entries.splice(m_entries.begin(), m_entries, i->second);
+    return &i->second->value;
+  }
+
+  /**
+   * @brief insert or replace an entry, evicting least recently used ones
+   *        until the weights fit; an entry heavier than the capacity is
+   *        not kept
+   */
+  void put(const K &key, V value, size_t weight = 1)
+  {
+    erase(key);
+    if (weight > m_capacity)
+      return;
+    while (m_weight + weight > m_capacity)
+      erase(m_entries.back().key);
+    m_entries.push_front(entry{key, std::move(value), weight});
+    m_index.emplace(key, m_entries.begin());
+    m_weight += weight;
+  }
+
+  bool erase(const K &key)
+  {
+    const auto i = m_index.find(key);
+    if (i == m_index.end())
+      return false;
+    m_weight -= i->second->weight;
+    m_entries.erase(i->second);
+    m_index.erase(i);
+    return true;
+  }
+
+  void clear()
+  {
+    m_index.clear();
+    m_entries.clear();
+    m_weight = 0;
+  }
+
+  size_t size() const { return m_index.size(); }
+  size_t weight() const { return m_weight; }
+  size_t capacity() const { return m_capacity; }
+
+private:
+  struct entry
+  {
+    K key;
+    V value;
+    size_t weight;
+  };
+  typedef std::list<entry> entry_list;
+
+  size_t m_capacity;
+  size_t m_weight;
+  entry_list m_entries;
+  std::unordered_map<K, typename entry_list::iterator, Hash> m_index;
+};
+
+}
@@ -35,18 +35,21 @@
 #include "cryptonote_config.h"
 #include "common/util.h"
 
-static __thread int depth = 0;
+// the pool worker running on this thread, if any
+static __thread size_t worker_index = std::numeric_limits<size_t>::max();
+// the priority of the task running on this thread, if any
+static __thread int current_priority = -1;
 
 namespace tools
 {
-threadpool::threadpool() : running(true), active(0) {
+threadpool::threadpool() : pending(0), next_queue(0), running(true), n_submitted(0), n_executed(0), n_stolen(0), n_helped(0) {
   boost::thread::attributes attrs;
   attrs.set_stack_size(THREAD_STACK_SIZE);
   max = tools::get_max_concurrency();
-  size_t i = max;
-  while(i--) {
-    threads.push_back(boost::thread(attrs, boost::bind(&threadpool::run, this)));
-  }
+  for (int i = 0; i < max; ++i)
+    queues.emplace_back(new worker_queue());
+  for (int i = 0; i < max; ++i)
+    threads.push_back(boost::thread(attrs, boost::bind(&threadpool::run, this, i)));
 }
 
 threadpool::~threadpool() {
@@ -61,27 +64,102 @@ threadpool::~threadpool() {
 }
 
 void threadpool::submit(waiter *obj, std::function<void()> f) {
-  entry e = {obj, f};
-  boost::unique_lock<boost::mutex> lock(mutex);
-  if ((active == max && !queue.empty()) || depth > 0) {
-    // if all available threads are already running
-    // and there's work waiting, just run in current thread
-    lock.unlock();
-    ++depth;
-    f();
-    --depth;
+  submit(obj, std::move(f), current_priority < 0 ? PRIORITY_NORMAL : (priority)current_priority);
+}
+
+void threadpool::submit(waiter *obj, std::function<void()> f, priority p) {
+  CHECK_AND_ASSERT_THROW_MES(p < PRIORITY_COUNT, "Invalid threadpool task priority");
+  std::shared_ptr<entry> e = std::make_shared<entry>(obj, std::move(f), p);
+  ++pending;
+  ++n_submitted;
+  if (obj)
+    obj->push(e);
+  if (worker_index < queues.size()) {
+    // a task's subtasks are likely what it waits on next, run them first
+    worker_queue &q = *queues[worker_index];
+    const boost::unique_lock<boost::mutex> lock(q.mutex);
+    q.tasks[p].push_front(std::move(e));
   } else {
-    if (obj)
-      obj->inc();
-    queue.push_back(e);
-    has_work.notify_one();
+    worker_queue &q = *queues[next_queue++ % queues.size()];
+    const boost::unique_lock<boost::mutex> lock(q.mutex);
+    q.tasks[p].push_back(std::move(e));
   }
+  {
+    // an idle worker checks pending with the mutex held before sleeping
+    const boost::unique_lock<boost::mutex> lock(mutex);
+  }
+  has_work.notify_one();
 }
 
 int threadpool::get_max_concurrency() {
   return max;
 }
 
+threadpool::stats threadpool::get_stats() const {
+  stats s;
+  s.submitted = n_submitted;
+  s.executed = n_executed;
+  s.stolen = n_stolen;
+  s.helped = n_helped;
+  return s;
+}
+
+bool threadpool::claim(entry &e) {
+  bool expected = false;
+  if (!e.claimed.compare_exchange_strong(expected, true))
+    return false;
+  --pending;
+  return true;
+}
+
+bool threadpool::pop(std::shared_ptr<entry> &e, bool &stolen) {
+  if (pending == 0)
+    return false;
+  const bool worker = worker_index < queues.size();
+  const size_t start = worker ? worker_index : 0;
+  for (size_t p = 0; p < PRIORITY_COUNT; ++p) {
+    for (size_t n = 0; n < queues.size(); ++n) {
+      worker_queue &q = *queues[(start + n) % queues.size()];
+      const boost::unique_lock<boost::mutex> lock(q.mutex);
+      std::deque<std::shared_ptr<entry>> &tasks = q.tasks[p];
+      stolen = !worker || n > 0;
+      while (!tasks.empty()) {
+        if (stolen) {
+          e = std::move(tasks.back());
+          tasks.pop_back();
+        } else {
+          e = std::move(tasks.front());
+          tasks.pop_front();
+        }
+        // tasks their waiter already ran are dropped here
+        if (claim(*e))
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
+void threadpool::execute(entry &e) {
+  const int previous_priority = current_priority;
+  current_priority = e.p;
+  try {
+    e.f();
+  }
+  catch (const std::exception &ex) {
+    MERROR("Exception in threadpool task: " << ex.what());
+  }
+  catch (...) {
+    MERROR("Unknown exception in threadpool task");
+  }
+  current_priority = previous_priority;
+  // the other copy of the entry may stay queued for a while, drop the captures now
+  e.f = nullptr;
+  ++n_executed;
+  if (e.wo)
+    e.wo->dec();
+}
+
 threadpool::waiter::~waiter()
 {
   {
@@ -100,8 +178,35 @@ threadpool::waiter::~waiter()
 }
 
 void threadpool::waiter::wait() {
+  threadpool &tpool = threadpool::getInstance();
   boost::unique_lock<boost::mutex> lock(mt);
-  while(num) cv.wait(lock);
+  while(num) {
+    // rather than block a thread the pool may need, run the tasks we wait on
+    // that no worker has picked yet. Only ours, as an unrelated task could
+    // want a lock this thread holds.
+    if (!queued.empty()) {
+      const std::shared_ptr<entry> e = std::move(queued.front());
+      queued.pop_front();
+      if (!tpool.claim(*e))
+        continue;
+      lock.unlock();
+      ++tpool.n_helped;
+      tpool.execute(*e);
+      lock.lock();
+      continue;
+    }
+    // woken by dec() once the last task is done, or by push()
+    cv.wait(lock);
+  }
+  // whatever is left was run by the workers
+  queued.clear();
+}
+
+void threadpool::waiter::push(std::shared_ptr<entry> e) {
+  const boost::unique_lock<boost::mutex> lock(mt);
+  num++;
+  queued.push_back(std::move(e));
+  cv.notify_one();
 }
 
 void threadpool::waiter::inc() {
@@ -116,26 +221,22 @@ void threadpool::waiter::dec() {
     cv.notify_one();
 }
 
-void threadpool::run() {
-  boost::unique_lock<boost::mutex> lock(mutex);
-  while (running) {
-    entry e;
-    while(queue.empty() && running)
+void threadpool::run(size_t index) {
+  worker_index = index;
+  while (true) {
+    std::shared_ptr<entry> e;
+    bool stolen;
+    if (pop(e, stolen)) {
+      if (stolen)
+        ++n_stolen;
+      execute(*e);
+      continue;
+    }
+    boost::unique_lock<boost::mutex> lock(mutex);
+    if (!running)
+      break;
+    if (pending == 0)
       has_work.wait(lock);
-    if (!running) break;
-
-    active++;
-    e = queue.front();
-    queue.pop_front();
-    lock.unlock();
-    ++depth;
-    e.f();
-    --depth;
-
-    if (e.wo)
-      e.wo->dec();
-    lock.lock();
-    active--;
   }
 }
 }
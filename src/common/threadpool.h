@@ -30,59 +30,108 @@
 #include <boost/thread/condition_variable.hpp>
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/thread.hpp>
+#include <atomic>
 #include <cstddef>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <stdexcept>
+#include <stdint.h>
 
 namespace tools
 {
 //! A global thread pool
 class threadpool
 {
+  struct entry;
 public:
   static threadpool& getInstance() {
     static threadpool instance;
     return instance;
   }
 
+  // Queued tasks of a higher priority run before any of a lower one
+  enum priority
+  {
+    PRIORITY_HIGH,    // block and transaction verification
+    PRIORITY_NORMAL,
+    PRIORITY_LOW,     // background work, such as wallet scanning
+    PRIORITY_COUNT
+  };
+
+  struct stats
+  {
+    uint64_t submitted;  // tasks queued
+    uint64_t executed;   // tasks run, by workers or waiters
+    uint64_t stolen;     // tasks a worker took from another worker's queue
+    uint64_t helped;     // tasks run by the thread waiting for them
+  };
+
   // The waiter lets the caller know when all of its
   // tasks are completed.
   class waiter {
     boost::mutex mt;
     boost::condition_variable cv;
     int num;
+    // our tasks, each also in a worker's queue, for wait() to run
+    // without searching the pool for them
+    std::deque<std::shared_ptr<entry>> queued;
+    void push(std::shared_ptr<entry> e);
+    friend class threadpool;
     public:
     void inc();
     void dec();
-    void wait();  //! Wait for a set of tasks to finish.
+    //! Wait for a set of tasks to finish, running those still queued meanwhile.
+    void wait();
     waiter() : num(0){}
     ~waiter();
   };
 
   // Submit a task to the pool. The waiter pointer may be
   // NULL if the caller doesn't care to wait for the
-  // task to finish.
+  // task to finish. Without a priority, a task submitted
+  // from another task gets that task's priority, and one
+  // submitted from elsewhere PRIORITY_NORMAL.
   void submit(waiter *waiter, std::function<void()> f);
+  void submit(waiter *waiter, std::function<void()> f, priority p);
 
   int get_max_concurrency();
 
+  stats get_stats() const;
+
   private:
     threadpool();
     ~threadpool();
-    typedef struct entry {
+    struct entry {
+      entry(waiter *wo, std::function<void()> f, priority p) : wo(wo), f(std::move(f)), p(p), claimed(false) {}
       waiter *wo;
       std::function<void()> f;
-    } entry;
-    std::deque<entry> queue;
+      priority p;
+      // a task is queued both to a worker and to its waiter, whichever
+      // claims it first runs it and the other drops it
+      std::atomic<bool> claimed;
+    };
+    // Each worker takes from the front of its own queue, where the tasks
+    // it submits go, and steals from the back of the others' when empty
+    struct worker_queue {
+      boost::mutex mutex;
+      std::deque<std::shared_ptr<entry>> tasks[PRIORITY_COUNT];
+    };
+    std::vector<std::unique_ptr<worker_queue>> queues;
+    std::atomic<size_t> pending;
+    std::atomic<size_t> next_queue;
     boost::condition_variable has_work;
     boost::mutex mutex;
     std::vector<boost::thread> threads;
-    int active;
     int max;
     bool running;
-    void run();
+    std::atomic<uint64_t> n_submitted, n_executed, n_stolen, n_helped;
+    bool claim(entry &e);
+    bool pop(std::shared_ptr<entry> &e, bool &stolen);
+    void execute(entry &e);
+    void run(size_t index);
 };
 
 }
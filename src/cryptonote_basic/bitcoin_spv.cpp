@@ -0,0 +1,414 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cstring>
+
+#include "misc_log_ex.h"
+#include "bitcoin_spv.h"
+#include "komodo_sha256.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "btc.spv"
+
+namespace cryptonote
+{
+  namespace
+  {
+    typedef btc_spv::work_type work_type;
+
+    void write_le32(uint8_t* p, uint32_t x)
+    {
+      p[0] = (uint8_t)x; p[1] = (uint8_t)(x >> 8); p[2] = (uint8_t)(x >> 16); p[3] = (uint8_t)(x >> 24);
+    }
+
+    uint32_t read_le32(uint8_t const* p)
+    {
+      return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+
+    // headers and merkle trees carry hashes in internal (reversed) order
+    void reverse_hash(const crypto::hash& in, uint8_t* out)
+    {
+      std::reverse_copy((const uint8_t*)&in, (const uint8_t*)&in + sizeof(in), out);
+    }
+
+    crypto::hash reversed_hash(uint8_t const* in)
+    {
+      crypto::hash out;
+      std::reverse_copy(in, in + sizeof(out), (uint8_t*)&out);
+      return out;
+    }
+
+    // display order double SHA-256
+    crypto::hash doublesha256(uint8_t const* data, size_t len)
+    {
+      uint8_t first[32], second[32];
+      komodo::sha256(data, len, first);
+      komodo::sha256(first, sizeof(first), second);
+      return reversed_hash(second);
+    }
+
+    bool compact_to_target(uint32_t bits, work_type& target)
+    {
+      const uint32_t size = bits >> 24;
+      const uint32_t word = bits & 0x007fffff;
+      if (word && (bits & 0x00800000))
+        return false;
+      if (word && (size > 34 || (word > 0xff && size > 33) || (word > 0xffff && size > 32)))
+        return false;
+      target = word;
+      if (size <= 3)
+        target >>= 8 * (3 - size);
+      else
+        target <<= 8 * (size - 3);
+      return target != 0;
+    }
+
+    work_type hash_to_work_type(const crypto::hash& hash)
+    {
+      work_type value;
+      boost::multiprecision::import_bits(value, (const uint8_t*)&hash, (const uint8_t*)&hash + sizeof(hash));
+      return value;
+    }
+  }
+
+  //---------------------------------------------------------------
+  void btc_block_header::serialize(uint8_t out[size]) const
+  {
+    write_le32(out, (uint32_t)version);
+    reverse_hash(prev_hash, out + 4);
+    reverse_hash(merkle_root, out + 36);
+    write_le32(out + 68, timestamp);
+    write_le32(out + 72, bits);
+    write_le32(out + 76, nonce);
+  }
+  //---------------------------------------------------------------
+  bool btc_block_header::parse(uint8_t const* data, size_t len)
+  {
+    if (len != size)
+      return false;
+    version = (int32_t)read_le32(data);
+    prev_hash = reversed_hash(data + 4);
+    merkle_root = reversed_hash(data + 36);
+    timestamp = read_le32(data + 68);
+    bits = read_le32(data + 72);
+    nonce = read_le32(data + 76);
+    return true;
+  }
+  //---------------------------------------------------------------
+  crypto::hash btc_block_header::hash() const
+  {
+    uint8_t blob[size];
+    serialize(blob);
+    return doublesha256(blob, sizeof(blob));
+  }
+  //---------------------------------------------------------------
+  btc_spv::btc_spv(const btc_spv_params& params):
+    m_params(params),
+    m_base_height(0),
+    m_running(false),
+    m_worker_alive(false)
+  {
+  }
+  //---------------------------------------------------------------
+  btc_spv::~btc_spv()
+  {
+    stop();
+  }
+  //---------------------------------------------------------------
+  bool btc_spv::start(const btc_block_header& checkpoint, uint64_t height)
+  {
+    boost::unique_lock<boost::mutex> lock(m_queue_lock);
+    if (m_worker_alive)
+      return false;
+
+    m_headers.clear();
+    m_main_chain.clear();
+    m_tx_blocks.clear();
+
+    indexed_header entry;
+    entry.header = checkpoint;
+    entry.hash = checkpoint.hash();
+    entry.height = height;
+    entry.chain_work = get_block_work(checkpoint.bits);
+    m_headers[entry.hash] = entry;
+    m_base_height = height;
+    m_main_chain.push_back(entry.hash);
+
+    m_running = true;
+    m_worker_alive = true;
+    m_thread = boost::thread(&btc_spv::run, this);
+    MINFO("BTC SPV header sync started from " << entry.hash << " at height " << height);
+    return true;
+  }
+  //---------------------------------------------------------------
+  void btc_spv::stop()
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(m_queue_lock);
+      if (!m_running)
+        return;
+      m_running = false;
+      m_queue_cond.notify_all();
+    }
+    if (m_thread.joinable())
+      m_thread.join();
+  }
+  //---------------------------------------------------------------
+  void btc_spv::run()
+  {
+    while (true)
+    {
+      std::function<void()> task;
+      {
+        boost::unique_lock<boost::mutex> lock(m_queue_lock);
+        while (m_queue.empty() && m_running)
+          m_queue_cond.wait(lock);
+        if (m_queue.empty())
+        {
+          m_worker_alive = false;
+          return;
+        }
+        task = std::move(m_queue.front());
+        m_queue.pop_front();
+      }
+      task();
+    }
+  }
+  //---------------------------------------------------------------
+  void btc_spv::post(std::function<void()> task)
+  {
+    boost::unique_lock<boost::mutex> lock(m_queue_lock);
+    if (!m_worker_alive)
+    {
+      // nothing else can touch the index while the worker is down
+      task();
+      return;
+    }
+    m_queue.push_back(std::move(task));
+    m_queue_cond.notify_one();
+  }
+  //---------------------------------------------------------------
+  std::future<size_t> btc_spv::submit_headers(std::vector<btc_block_header> headers)
+  {
+    auto promise = std::make_shared<std::promise<size_t>>();
+    auto batch = std::make_shared<std::vector<btc_block_header>>(std::move(headers));
+    post([this, promise, batch]() {
+      size_t added_count = 0;
+      for (const auto& header: *batch)
+      {
+        bool added = false;
+        if (!add_header(header, added))
+          break;
+        if (added)
+          ++added_count;
+      }
+      promise->set_value(added_count);
+    });
+    return promise->get_future();
+  }
+  //---------------------------------------------------------------
+  std::future<bool> btc_spv::add_tx_proof(const crypto::hash& txid, const crypto::hash& block_hash, std::vector<crypto::hash> branch, uint32_t index)
+  {
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto proof = std::make_shared<std::vector<crypto::hash>>(std::move(branch));
+    post([this, promise, proof, txid, block_hash, index]() {
+      const auto it = m_headers.find(block_hash);
+      if (it == m_headers.end())
+      {
+        MDEBUG("No header for block " << block_hash << " holding tx " << txid);
+        promise->set_value(false);
+        return;
+      }
+      if (merkle_root_from_branch(txid, *proof, index) != it->second.header.merkle_root)
+      {
+        MERROR("Merkle branch for tx " << txid << " does not match block " << block_hash);
+        promise->set_value(false);
+        return;
+      }
+      m_tx_blocks[txid] = block_hash;
+      promise->set_value(true);
+    });
+    return promise->get_future();
+  }
+  //---------------------------------------------------------------
+  std::future<boost::optional<btc_spv::indexed_header>> btc_spv::get_header(const crypto::hash& block_hash)
+  {
+    auto promise = std::make_shared<std::promise<boost::optional<indexed_header>>>();
+    post([this, promise, block_hash]() {
+      const auto it = m_headers.find(block_hash);
+      promise->set_value(it == m_headers.end() ? boost::none : boost::optional<indexed_header>(it->second));
+    });
+    return promise->get_future();
+  }
+  //---------------------------------------------------------------
+  std::future<uint64_t> btc_spv::get_confirmations(const crypto::hash& txid)
+  {
+    auto promise = std::make_shared<std::promise<uint64_t>>();
+    post([this, promise, txid]() {
+      uint64_t confirmations = 0;
+      const auto tx_it = m_tx_blocks.find(txid);
+      if (tx_it != m_tx_blocks.end())
+      {
+        const auto it = m_headers.find(tx_it->second);
+        if (it != m_headers.end() && is_on_main_chain(it->second))
+          confirmations = m_base_height + m_main_chain.size() - it->second.height;
+      }
+      promise->set_value(confirmations);
+    });
+    return promise->get_future();
+  }
+  //---------------------------------------------------------------
+  std::future<uint64_t> btc_spv::get_height()
+  {
+    auto promise = std::make_shared<std::promise<uint64_t>>();
+    post([this, promise]() {
+      promise->set_value(m_main_chain.empty() ? 0 : m_base_height + m_main_chain.size() - 1);
+    });
+    return promise->get_future();
+  }
+  //---------------------------------------------------------------
+  crypto::hash btc_spv::merkle_root_from_branch(const crypto::hash& leaf, const std::vector<crypto::hash>& branch, uint32_t index)
+  {
+    uint8_t pair[64];
+    crypto::hash node = leaf;
+    for (const auto& sibling: branch)
+    {
+      if (index & 1)
+      {
+        reverse_hash(sibling, pair);
+        reverse_hash(node, pair + 32);
+      }
+      else
+      {
+        reverse_hash(node, pair);
+        reverse_hash(sibling, pair + 32);
+      }
+      node = doublesha256(pair, sizeof(pair));
+      index >>= 1;
+    }
+    return node;
+  }
+  //---------------------------------------------------------------
+  bool btc_spv::check_pow(const crypto::hash& hash, uint32_t bits)
+  {
+    work_type target;
+    if (!compact_to_target(bits, target))
+      return false;
+    return hash_to_work_type(hash) <= target;
+  }
+  //---------------------------------------------------------------
+  btc_spv::work_type btc_spv::get_block_work(uint32_t bits)
+  {
+    work_type target;
+    if (!compact_to_target(bits, target))
+      return 0;
+    // 2^256 / (target + 1), without needing a 257 bit type
+    return (~target / (target + 1)) + 1;
+  }
+  //---------------------------------------------------------------
+  bool btc_spv::check_bits(const indexed_header& prev, uint32_t bits) const
+  {
+    work_type target, limit, prev_target;
+    if (!compact_to_target(bits, target) || !compact_to_target(m_params.pow_limit_bits, limit) || target > limit)
+      return false;
+    if (bits == prev.header.bits)
+      return true;
+    if (m_params.no_retargeting || (prev.height + 1) % m_params.retarget_interval)
+      return false;
+    // the target may not be eased by more than the retarget limit; a
+    // harder target only makes a forged chain more expensive
+    if (!compact_to_target(prev.header.bits, prev_target))
+      return false;
+    return target <= prev_target * 4;
+  }
+  //---------------------------------------------------------------
+  bool btc_spv::add_header(const btc_block_header& header, bool& added)
+  {
+    added = false;
+    const crypto::hash hash = header.hash();
+    if (m_headers.find(hash) != m_headers.end())
+      return true;
+
+    const auto prev_it = m_headers.find(header.prev_hash);
+    if (prev_it == m_headers.end())
+    {
+      MDEBUG("Header " << hash << " does not connect to a known header");
+      return false;
+    }
+    const indexed_header& prev = prev_it->second;
+    if (!check_bits(prev, header.bits))
+    {
+      MERROR("Header " << hash << " has unexpected target bits " << header.bits);
+      return false;
+    }
+    if (!check_pow(hash, header.bits))
+    {
+      MERROR("Header " << hash << " does not meet its target");
+      return false;
+    }
+
+    indexed_header entry;
+    entry.header = header;
+    entry.hash = hash;
+    entry.height = prev.height + 1;
+    entry.chain_work = prev.chain_work + get_block_work(header.bits);
+    const indexed_header& tip = m_headers[m_main_chain.back()];
+    const bool new_tip = entry.chain_work > tip.chain_work;
+    m_headers[hash] = entry;
+    added = true;
+
+    if (new_tip)
+      set_main_chain_tip(entry);
+    return true;
+  }
+  //---------------------------------------------------------------
+  bool btc_spv::is_on_main_chain(const indexed_header& entry) const
+  {
+    if (entry.height < m_base_height || entry.height - m_base_height >= m_main_chain.size())
+      return false;
+    return m_main_chain[entry.height - m_base_height] == entry.hash;
+  }
+  //---------------------------------------------------------------
+  void btc_spv::set_main_chain_tip(const indexed_header& tip)
+  {
+    // walk back to the fork point, then swap in the new branch
+    std::vector<crypto::hash> branch;
+    const indexed_header* entry = &tip;
+    while (!is_on_main_chain(*entry))
+    {
+      branch.push_back(entry->hash);
+      entry = &m_headers[entry->header.prev_hash];
+    }
+    const uint64_t fork_height = entry->height;
+    if (fork_height - m_base_height + 1 < m_main_chain.size())
+      MINFO("BTC SPV reorg: " << m_main_chain.size() - (fork_height - m_base_height + 1) << " blocks replaced at height " << fork_height + 1);
+    m_main_chain.resize(fork_height - m_base_height + 1);
+    m_main_chain.insert(m_main_chain.end(), branch.rbegin(), branch.rend());
+  }
+}
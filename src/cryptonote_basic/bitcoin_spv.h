@@ -0,0 +1,181 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/optional.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <deque>
+#include <functional>
+#include <future>
+#include <unordered_map>
+#include <vector>
+
+#include "crypto/hash.h"
+
+namespace cryptonote
+{
+  /**
+   * @brief an 80 byte bitcoin block header
+   *
+   * Hashes are kept in display order, i.e. as printed by bitcoind and as
+   * embedded in notarization data, so they compare directly with the
+   * btc hashes stored in the blockchain db.
+   */
+  struct btc_block_header
+  {
+    int32_t version = 0;
+    crypto::hash prev_hash = crypto::null_hash;
+    crypto::hash merkle_root = crypto::null_hash;
+    uint32_t timestamp = 0;
+    uint32_t bits = 0;
+    uint32_t nonce = 0;
+
+    static const size_t size = 80;
+
+    void serialize(uint8_t out[size]) const;
+    bool parse(uint8_t const* data, size_t len);
+    crypto::hash hash() const;
+  };
+
+  /**
+   * @brief consensus parameters the header chain is checked against
+   */
+  struct btc_spv_params
+  {
+    uint32_t pow_limit_bits;
+    bool no_retargeting;
+    uint64_t retarget_interval;
+
+    static btc_spv_params mainnet() { return { 0x1d00ffff, false, 2016 }; }
+    static btc_spv_params regtest() { return { 0x207fffff, true, 2016 }; }
+  };
+
+  /**
+   * @brief in-process bitcoin SPV header index
+   *
+   * Replaces forking a libbtc tool per query. Headers are validated and
+   * indexed by a single long-lived worker thread: each header must link to
+   * a known parent, meet its own target and, unless retargeting is
+   * disabled, keep its parent's target between retarget heights. The chain
+   * with the most work is the main chain.
+   *
+   * Queries are queued behind any headers submitted before them and are
+   * answered by the worker through a future, so callers on the
+   * notarization verification path never block on header sync.
+   */
+  class btc_spv
+  {
+  public:
+    typedef boost::multiprecision::uint256_t work_type;
+
+    struct indexed_header
+    {
+      btc_block_header header;
+      crypto::hash hash;
+      uint64_t height;
+      work_type chain_work;
+    };
+
+    btc_spv(const btc_spv_params& params = btc_spv_params::mainnet());
+    ~btc_spv();
+
+    /**
+     * @brief start the worker from a trusted checkpoint header
+     *
+     * @param checkpoint the header at height, not checked for work
+     * @param height the bitcoin height of the checkpoint
+     *
+     * @return false if the worker is already running
+     */
+    bool start(const btc_block_header& checkpoint, uint64_t height);
+    void stop();
+
+    /**
+     * @brief queue a run of headers for validation and indexing
+     *
+     * Headers are processed in order; the first one that fails validation
+     * ends the batch.
+     *
+     * @return the number of headers added to the index
+     */
+    std::future<size_t> submit_headers(std::vector<btc_block_header> headers);
+
+    /**
+     * @brief record that txid is in a block, given its merkle branch
+     *
+     * @param txid the tx hash
+     * @param block_hash the hash of the block holding the tx
+     * @param branch the sibling hashes from the leaf up to the root
+     * @param index the position of the tx in the block
+     *
+     * @return false if the block is unknown or the branch does not lead to
+     * its merkle root
+     */
+    std::future<bool> add_tx_proof(const crypto::hash& txid, const crypto::hash& block_hash, std::vector<crypto::hash> branch, uint32_t index);
+
+    std::future<boost::optional<indexed_header>> get_header(const crypto::hash& block_hash);
+
+    /**
+     * @brief number of main chain blocks on top of, and including, the
+     * block holding txid, or 0 if the tx has no proof on the main chain
+     */
+    std::future<uint64_t> get_confirmations(const crypto::hash& txid);
+
+    std::future<uint64_t> get_height();
+
+    static crypto::hash merkle_root_from_branch(const crypto::hash& leaf, const std::vector<crypto::hash>& branch, uint32_t index);
+    static bool check_pow(const crypto::hash& hash, uint32_t bits);
+    static work_type get_block_work(uint32_t bits);
+
+  private:
+    void run();
+    void post(std::function<void()> task);
+    bool add_header(const btc_block_header& header, bool& added);
+    bool check_bits(const indexed_header& prev, uint32_t bits) const;
+    void set_main_chain_tip(const indexed_header& tip);
+    bool is_on_main_chain(const indexed_header& entry) const;
+
+    const btc_spv_params m_params;
+
+    // touched only by the worker thread once started
+    std::unordered_map<crypto::hash, indexed_header> m_headers;
+    std::vector<crypto::hash> m_main_chain; // indexed by height - m_base_height
+    uint64_t m_base_height;
+    std::unordered_map<crypto::hash, crypto::hash> m_tx_blocks;
+
+    boost::mutex m_queue_lock;
+    boost::condition_variable m_queue_cond;
+    std::deque<std::function<void()>> m_queue;
+    bool m_running;       // cleared to ask the worker to drain and exit
+    bool m_worker_alive;  // cleared by the worker once the queue is drained
+    boost::thread m_thread;
+  };
+}
@@ -35,15 +35,19 @@ using namespace epee;
 
 #include <atomic>
 #include <boost/algorithm/string.hpp>
+#include <deque>
 #include <iostream>
 #include <sstream>
 #include <stdio.h>
 #include "common/int-util.h"
+#include "common/threadpool.h"
+#include "syncobj.h"
 #include "wipeable_string.h"
 #include "string_tools.h"
 #include "serialization/string.h"
 #include "cryptonote_format_utils.h"
 #include "komodo_notaries.h"
+#include "komodo_sha256.h"
 #include "cryptonote_config.h"
 #include "crypto/crypto.h"
 #include "crypto/hash.h"
@@ -238,92 +242,106 @@ namespace cryptonote
       return true;
   }
   //---------------------------------------------------------------
-  bool extract_and_parse_opreturn(std::string const& raw_tx_hex, std::string& opreturn, std::string& btchash, std::string& srchash, std::string& desthash, uint64_t& height, std::string& symbol)
+  namespace
   {
-    std::string bintxdata;
-    btchash = epee::string_tools::pod_to_hex(crypto::null_hash);
-    srchash = epee::string_tools::pod_to_hex(crypto::null_hash);
-    desthash = epee::string_tools::pod_to_hex(crypto::null_hash);
-    height = 0;
-    std::vector<uint8_t> bitscontainer;
-
-    if (raw_tx_hex.empty()) {
-      if (opreturn.empty()) {
-        MERROR("No raw_tx_data or opreturn data to extract and/or parse!");
-        return false;
-      }
-    } else {
-      opreturn = raw_tx_hex.substr(raw_tx_hex.size()-158,150);
-      if (!epee::string_tools::parse_hexstr_to_binbuff(raw_tx_hex, bintxdata)) {
-        MERROR("Failed to parse_hexstr_to_binbuff in extract_and_parse_opreturn!");
-        return false;
-      }
-      uint8_t const* txdata = reinterpret_cast<uint8_t const*>(bintxdata.data());
-      bits256 btc_hash = cryptonote::komodo::bits256_doublesha256(txdata, bintxdata.size());
-      for (const auto& each : btc_hash.bytes) {
-        bitscontainer.push_back(each);
-      }
-      btchash = bytes256_to_hex(bitscontainer);
+    std::string bits256_to_hex(bits256 const& bits)
+    {
+      std::vector<uint8_t> vchr(bits.bytes, bits.bytes + sizeof(bits.bytes));
+      return bytes256_to_hex(vchr);
     }
 
-    std::string hexheight, hexsymbol;
-    uint32_t x = 0;
+    // everything extract_and_parse_opreturn() does but hashing the raw tx,
+    // which is left in bintxdata so that callers can hash many at once
+    bool parse_opreturn(std::string const& raw_tx_hex, std::string& opreturn, std::string& bintxdata, std::string& srchash, std::string& desthash, uint64_t& height, std::string& symbol)
+    {
+      bintxdata.clear();
+      srchash = epee::string_tools::pod_to_hex(crypto::null_hash);
+      desthash = epee::string_tools::pod_to_hex(crypto::null_hash);
+      height = 0;
 
-    std::vector<uint8_t> script_vchr = hex_to_bytes4096(opreturn);
+      if (raw_tx_hex.empty()) {
+        if (opreturn.empty()) {
+          MERROR("No raw_tx_data or opreturn data to extract and/or parse!");
+          return false;
+        }
+      } else {
+        opreturn = raw_tx_hex.substr(raw_tx_hex.size()-158,150);
+        if (!epee::string_tools::parse_hexstr_to_binbuff(raw_tx_hex, bintxdata)) {
+          MERROR("Failed to parse_hexstr_to_binbuff in extract_and_parse_opreturn!");
+          return false;
+        }
+      }
 
-    if (script_vchr[x++] != OP_RETURN) {
-      MERROR("hex does not have proper opcode! actual: " << std::to_string(script_vchr[x-1]) << ", expected: " << std::to_string(OP_RETURN));
-      return false;
-    }
+      std::string hexheight, hexsymbol;
+      uint32_t x = 0;
 
-    if (script_vchr[x] <= OP_NEXTBYTES)
-    {
-      size_t data_size = script_vchr[x];
-      //MWARNING("-->OP_NEXTBYTES code found: " << data_size);
+      std::vector<uint8_t> script_vchr = hex_to_bytes4096(opreturn);
 
-      // need to flip encoded hash bytes
-      srchash.clear();
-      for (size_t i = (x + HASHDATA_SIZE); i > x; i--) {
-        srchash += opreturn.substr(i*2, 2);
-      }
-      x += HASHDATA_SIZE;
-      // same for height
-      for (size_t i = (x + HEIGHT_SIZE); i > x; i--) {
-        hexheight += opreturn.substr(i*2,2);
+      if (script_vchr[x++] != OP_RETURN) {
+        MERROR("hex does not have proper opcode! actual: " << std::to_string(script_vchr[x-1]) << ", expected: " << std::to_string(OP_RETURN));
+        return false;
       }
-      x += HEIGHT_SIZE;
 
-      if (data_size >= (x + SYMBOL_SIZE))
+      if (script_vchr[x] <= OP_NEXTBYTES)
       {
-        desthash.clear();
-        // if > 5 bytes left, we probably have a desthash too
+        size_t data_size = script_vchr[x];
+        //MWARNING("-->OP_NEXTBYTES code found: " << data_size);
+
+        // need to flip encoded hash bytes
+        srchash.clear();
         for (size_t i = (x + HASHDATA_SIZE); i > x; i--) {
-          desthash += opreturn.substr(i*2, 2);
+          srchash += opreturn.substr(i*2, 2);
         }
         x += HASHDATA_SIZE;
-      }
+        // same for height
+        for (size_t i = (x + HEIGHT_SIZE); i > x; i--) {
+          hexheight += opreturn.substr(i*2,2);
+        }
+        x += HEIGHT_SIZE;
 
-      //symbol is not flipped
-      hexsymbol = opreturn.substr((opreturn.size()-10), 10);
-      std::string binsymbol;
-      epee::string_tools::parse_hexstr_to_binbuff(hexsymbol, binsymbol);
-      for (size_t i = 0; i < SYMBOL_SIZE; i++)
-      {
-        // exclude null bytes
-        if (std::stoull(hexsymbol.substr(i*2,2),0,16) != 0)
-          symbol += binsymbol.substr(i,1);
-      }
-      x += SYMBOL_SIZE;
-      if (data_size != (x - 1)) {
-        MERROR("Inconsistency in data OP_NEXTBYTES vs actual data size!");
-      }
+        if (data_size >= (x + SYMBOL_SIZE))
+        {
+          desthash.clear();
+          // if > 5 bytes left, we probably have a desthash too
+          for (size_t i = (x + HASHDATA_SIZE); i > x; i--) {
+            desthash += opreturn.substr(i*2, 2);
+          }
+          x += HASHDATA_SIZE;
+        }
 
-      if (symbol != DPOW_SYMBOL) {
-        MERROR("OP_RETURN data is not for " << DPOW_SYMBOL << " - check data!");
-      }
-    }  // else if OP_PUSHDATA(1|2|4)
+        //symbol is not flipped
+        hexsymbol = opreturn.substr((opreturn.size()-10), 10);
+        std::string binsymbol;
+        epee::string_tools::parse_hexstr_to_binbuff(hexsymbol, binsymbol);
+        for (size_t i = 0; i < SYMBOL_SIZE; i++)
+        {
+          // exclude null bytes
+          if (std::stoull(hexsymbol.substr(i*2,2),0,16) != 0)
+            symbol += binsymbol.substr(i,1);
+        }
+        x += SYMBOL_SIZE;
+        if (data_size != (x - 1)) {
+          MERROR("Inconsistency in data OP_NEXTBYTES vs actual data size!");
+        }
 
-    height = std::stoull(hexheight, 0, 16);
+        if (symbol != DPOW_SYMBOL) {
+          MERROR("OP_RETURN data is not for " << DPOW_SYMBOL << " - check data!");
+        }
+      }  // else if OP_PUSHDATA(1|2|4)
+
+      height = std::stoull(hexheight, 0, 16);
+      return true;
+    }
+  }
+  //---------------------------------------------------------------
+  bool extract_and_parse_opreturn(std::string const& raw_tx_hex, std::string& opreturn, std::string& btchash, std::string& srchash, std::string& desthash, uint64_t& height, std::string& symbol)
+  {
+    std::string bintxdata;
+    btchash = epee::string_tools::pod_to_hex(crypto::null_hash);
+    if (!parse_opreturn(raw_tx_hex, opreturn, bintxdata, srchash, desthash, height, symbol))
+      return false;
+    if (!bintxdata.empty())
+      btchash = bits256_to_hex(komodo::bits256_doublesha256(reinterpret_cast<uint8_t const*>(bintxdata.data()), bintxdata.size()));
     return true;
   }
   //---------------------------------------------------------------
@@ -628,43 +646,164 @@ namespace cryptonote
 
   }
   //---------------------------------------------------------------
-  bool verify_embedded_ntz_data(cryptonote::transaction const& tx, crypto::hash& btc_hash, uint64_t& height, int& ntz_signer_idx)
+  bool is_ntz_tx(cryptonote::transaction const& tx)
   {
-    std::vector<uint8_t> new_extra, ntz_data;
-    std::string ntz_blob, opreturn, btchash, srchash, desthash, symbol;
-    uint64_t embed_height = 0;
-    remove_ntz_data_from_tx_extra(tx.extra, new_extra, ntz_data, ntz_blob, ntz_signer_idx);
-    if (!extract_and_parse_opreturn(ntz_blob, opreturn, btchash, srchash, desthash, embed_height, symbol))
+    return (tx.version == (DPOW_NOTA_TX_VERSION)) && !tx.vin.empty() && (tx.vin[0].type() != typeid(txin_gen));
+  }
+  //---------------------------------------------------------------
+  namespace
+  {
+    struct ntz_verification
+    {
+      bool valid;
+      std::string btc_hash;
+      uint64_t height;
+      int signer_idx;
+    };
+
+    // results are a pure function of tx.extra, which the txid commits to,
+    // so a notarization seen in the ntzpool is not re-parsed when it moves
+    // to the txpool and then into a block
+    static const size_t NTZ_VERIFICATION_CACHE_SIZE = 1024;
+    epee::critical_section ntz_verification_cache_lock;
+    std::unordered_map<crypto::hash, ntz_verification> ntz_verification_cache;
+    std::deque<crypto::hash> ntz_verification_cache_order;
+
+    bool get_cached_ntz_verification(const crypto::hash& txid, ntz_verification& result)
+    {
+      CRITICAL_REGION_LOCAL(ntz_verification_cache_lock);
+      const auto it = ntz_verification_cache.find(txid);
+      if (it == ntz_verification_cache.end())
+        return false;
+      result = it->second;
+      return true;
+    }
+
+    void cache_ntz_verification(const crypto::hash& txid, const ntz_verification& result)
+    {
+      CRITICAL_REGION_LOCAL(ntz_verification_cache_lock);
+      if (!ntz_verification_cache.emplace(txid, result).second)
+        return;
+      ntz_verification_cache_order.push_back(txid);
+      while (ntz_verification_cache_order.size() > NTZ_VERIFICATION_CACHE_SIZE)
+      {
+        ntz_verification_cache.erase(ntz_verification_cache_order.front());
+        ntz_verification_cache_order.pop_front();
+      }
+    }
+
+    // leaves the raw btc tx in bintxdata, for the caller to hash
+    void parse_ntz_extra(cryptonote::transaction const& tx, ntz_verification& result, std::string& bintxdata)
+    {
+      std::vector<uint8_t> new_extra, ntz_data;
+      std::string ntz_blob, opreturn, srchash, desthash, symbol;
+      result.btc_hash = epee::string_tools::pod_to_hex(crypto::null_hash);
+      result.height = 0;
+      result.signer_idx = -1;
+      remove_ntz_data_from_tx_extra(tx.extra, new_extra, ntz_data, ntz_blob, result.signer_idx);
+      result.valid = parse_opreturn(ntz_blob, opreturn, bintxdata, srchash, desthash, result.height, symbol);
+      if (!result.valid)
+      {
+        result.btc_hash.clear();
+        result.height = 0;
+        bintxdata.clear();
+      }
+    }
+
+    void verify_ntz_extra(cryptonote::transaction const& tx, ntz_verification& result)
+    {
+      std::string bintxdata;
+      parse_ntz_extra(tx, result, bintxdata);
+      if (!bintxdata.empty())
+        result.btc_hash = bits256_to_hex(komodo::bits256_doublesha256(reinterpret_cast<uint8_t const*>(bintxdata.data()), bintxdata.size()));
+    }
+  }
+  //---------------------------------------------------------------
+  bool verify_embedded_ntz_data(cryptonote::transaction const& tx, crypto::hash& btc_hash, uint64_t& height, int& ntz_signer_idx, crypto::hash const* tx_hash)
+  {
+    ntz_verification result;
+    if (!tx_hash || !get_cached_ntz_verification(*tx_hash, result))
+    {
+      verify_ntz_extra(tx, result);
+      if (tx_hash)
+        cache_ntz_verification(*tx_hash, result);
+    }
+    ntz_signer_idx = result.signer_idx;
+    if (!result.valid)
     {
       btc_hash = crypto::null_hash;
       height = 0;
       MERROR("Failed to parse opreturn from raw_tx_hex in ntzpool conversion!");
       return false;
     }
-    string_to_hash(btchash, btc_hash);
-    height = embed_height;
+    string_to_hash(result.btc_hash, btc_hash);
+    height = result.height;
     return true;
   }
   //---------------------------------------------------------------
-  int32_t verify_embedded_ntz_data(std::vector<cryptonote::transaction> const& txs, std::vector<std::string>& btc_hashes, std::vector<uint64_t>& heights, std::vector<uint32_t>& inferior_idxs)
+  int32_t verify_embedded_ntz_data(std::vector<cryptonote::transaction> const& txs, std::vector<std::string>& btc_hashes, std::vector<uint64_t>& heights, std::vector<uint32_t>& inferior_idxs, std::vector<crypto::hash> const* tx_hashes)
   {
-    for (const auto& tx : txs)
+    std::vector<crypto::hash> txids;
+    if (tx_hashes && tx_hashes->size() == txs.size())
+      txids = *tx_hashes;
+    else
     {
-      std::vector<uint8_t> new_extra, ntz_data;
-      std::string ntz_blob, opreturn, btchash, srchash, desthash, symbol;
-      uint64_t embed_height = 0;
-      int ntz_signer_idx = -1;
-      remove_ntz_data_from_tx_extra(tx.extra, new_extra, ntz_data, ntz_blob, ntz_signer_idx);
-      if (!extract_and_parse_opreturn(ntz_blob, opreturn, btchash, srchash, desthash, embed_height, symbol))
+      txids.reserve(txs.size());
+      for (const auto& tx : txs)
+        txids.push_back(get_transaction_hash(tx));
+    }
+
+    std::vector<ntz_verification> results(txs.size());
+    std::vector<size_t> misses;
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+      if (!get_cached_ntz_verification(txids[i], results[i]))
+        misses.push_back(i);
+    }
+
+    // each tx is parsed independently, so the misses are spread over the
+    // threadpool and joined once; their raw btc txes are then hashed in a
+    // single batch
+    std::vector<std::string> raw_txs(misses.size());
+    if (misses.size() > 1)
+    {
+      tools::threadpool& tpool = tools::threadpool::getInstance();
+      tools::threadpool::waiter waiter;
+      for (size_t j = 0; j < misses.size(); ++j)
+        tpool.submit(&waiter, [&txs, &results, &raw_txs, &misses, j] { parse_ntz_extra(txs[misses[j]], results[misses[j]], raw_txs[j]); });
+      waiter.wait();
+    }
+    else if (!misses.empty())
+      parse_ntz_extra(txs[misses[0]], results[misses[0]], raw_txs[0]);
+
+    std::vector<uint8_t const*> raw_ptrs;
+    std::vector<int32_t> raw_lens;
+    std::vector<size_t> raw_idxs;
+    for (size_t j = 0; j < misses.size(); ++j)
+    {
+      if (raw_txs[j].empty())
+        continue;
+      raw_ptrs.push_back(reinterpret_cast<uint8_t const*>(raw_txs[j].data()));
+      raw_lens.push_back(raw_txs[j].size());
+      raw_idxs.push_back(misses[j]);
+    }
+    std::vector<bits256> raw_hashes(raw_ptrs.size());
+    komodo::bits256_doublesha256_many(raw_ptrs.data(), raw_lens.data(), raw_hashes.data(), raw_hashes.size());
+    for (size_t k = 0; k < raw_idxs.size(); ++k)
+      results[raw_idxs[k]].btc_hash = bits256_to_hex(raw_hashes[k]);
+
+    for (const size_t i : misses)
+      cache_ntz_verification(txids[i], results[i]);
+
+    for (const auto& result : results)
+    {
+      if (!result.valid)
       {
         MERROR("Failed to parse opreturn from raw_tx_hex in ntzpool conversion!");
         return (-1);
       }
-      else
-      {
-        btc_hashes.push_back(btchash);
-        heights.push_back(embed_height);
-      }
+      btc_hashes.push_back(result.btc_hash);
+      heights.push_back(result.height);
     }
     uint64_t max_height = 0;
     for (const auto& each : heights)
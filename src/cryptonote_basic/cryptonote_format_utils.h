@@ -83,8 +83,9 @@ namespace cryptonote
   bool add_tx_pub_key_to_extra(std::vector<uint8_t>& tx_extra, const crypto::public_key& tx_pub_key);
   bool add_ntz_signer_index_to_extra(std::vector<uint8_t>& tx_extra, const uint8_t& idx);
   bool add_ntz_txn_to_extra(std::vector<uint8_t>& tx_extra, const std::string& input);
-  bool verify_embedded_ntz_data(cryptonote::transaction const& tx, crypto::hash& btc_hash, uint64_t& height, int& ntz_signer_idx);
-  int32_t verify_embedded_ntz_data(std::vector<cryptonote::transaction> const& txs, std::vector<std::string>& btc_hashes, std::vector<uint64_t>& heights, std::vector<uint32_t>& inferior_idxs);
+  bool is_ntz_tx(cryptonote::transaction const& tx);
+  bool verify_embedded_ntz_data(cryptonote::transaction const& tx, crypto::hash& btc_hash, uint64_t& height, int& ntz_signer_idx, crypto::hash const* tx_hash = nullptr);
+  int32_t verify_embedded_ntz_data(std::vector<cryptonote::transaction> const& txs, std::vector<std::string>& btc_hashes, std::vector<uint64_t>& heights, std::vector<uint32_t>& inferior_idxs, std::vector<crypto::hash> const* tx_hashes = nullptr);
   bool check_signer_index_with_viewkeys(cryptonote::transaction const& tx);
   std::vector<crypto::public_key> get_additional_tx_pub_keys_from_extra(const std::vector<uint8_t>& tx_extra);
   std::vector<crypto::public_key> get_additional_tx_pub_keys_from_extra(const transaction_prefix& tx);
@@ -0,0 +1,505 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define KOMODO_SHA256_X86
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#include "komodo_sha256.h"
+
+namespace cryptonote {
+namespace komodo {
+
+namespace {
+
+  const uint32_t sha256_iv[8] = {
+    0x6A09E667UL, 0xBB67AE85UL, 0x3C6EF372UL, 0xA54FF53AUL,
+    0x510E527FUL, 0x9B05688CUL, 0x1F83D9ABUL, 0x5BE0CD19UL
+  };
+
+  const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+  };
+
+  // a block of zeroes fed to multi-buffer lanes that have already finished
+  const uint8_t zero_block[64] = {};
+
+  inline uint32_t load32be(uint8_t const* p)
+  {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+  }
+
+  inline void store32be(uint8_t* p, uint32_t x)
+  {
+    p[0] = (uint8_t)(x >> 24); p[1] = (uint8_t)(x >> 16); p[2] = (uint8_t)(x >> 8); p[3] = (uint8_t)x;
+  }
+
+  // writes the final, padded block(s) of a len byte message whose last
+  // len % 64 bytes start at rem, and returns how many blocks were written
+  size_t sha256_pad_tail(uint8_t const* rem, uint64_t len, uint8_t tail[128])
+  {
+    const size_t r = len % 64;
+    const size_t nblocks = r < 56 ? 1 : 2;
+    memcpy(tail, rem, r);
+    tail[r] = 0x80;
+    memset(tail + r + 1, 0, nblocks * 64 - r - 1 - 8);
+    const uint64_t bits = len * 8;
+    for (size_t i = 0; i < 8; ++i)
+      tail[nblocks * 64 - 1 - i] = (uint8_t)(bits >> (8 * i));
+    return nblocks;
+  }
+
+  //------------------------------------------------------------------
+  // following is ported from libtom
+// Various logical functions
+#define RORc(x, y) ( ((((uint32_t)(x)&0xFFFFFFFFUL)>>(uint32_t)((y)&31)) | ((uint32_t)(x)<<(uint32_t)(32-((y)&31)))) & 0xFFFFFFFFUL)
+#define Ch(x,y,z)       (z ^ (x & (y ^ z)))
+#define Maj(x,y,z)      (((x | y) & z) | (x & y))
+#define S(x, n)         RORc((x),(n))
+#define R(x, n)         (((x)&0xFFFFFFFFUL)>>(n))
+#define Sigma0(x)       (S(x, 2) ^ S(x, 13) ^ S(x, 22))
+#define Sigma1(x)       (S(x, 6) ^ S(x, 11) ^ S(x, 25))
+#define Gamma0(x)       (S(x, 7) ^ S(x, 18) ^ R(x, 3))
+#define Gamma1(x)       (S(x, 17) ^ S(x, 19) ^ R(x, 10))
+
+  void sha256_transform_scalar(uint32_t state[8], uint8_t const* blocks, size_t nblocks)
+  {
+    for (; nblocks; --nblocks, blocks += 64)
+    {
+      uint32_t S[8],W[64],t0,t1,i;
+      for (i=0; i<8; i++) // copy state into S
+        S[i] = state[i];
+      for (i=0; i<16; i++) // copy the state into 512-bits into W[0..15]
+        W[i] = load32be(blocks + (4*i));
+      for (i=16; i<64; i++) // fill W[16..63]
+        W[i] = Gamma1(W[i - 2]) + W[i - 7] + Gamma0(W[i - 15]) + W[i - 16];
+
+#define RND(a,b,c,d,e,f,g,h,i,ki)                    \
+t0 = h + Sigma1(e) + Ch(e, f, g) + ki + W[i];   \
+t1 = Sigma0(a) + Maj(a, b, c);                  \
+d += t0;                                        \
+h  = t0 + t1;
+
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],0,0x428a2f98);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],1,0x71374491);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],2,0xb5c0fbcf);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],3,0xe9b5dba5);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],4,0x3956c25b);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],5,0x59f111f1);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],6,0x923f82a4);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],7,0xab1c5ed5);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],8,0xd807aa98);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],9,0x12835b01);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],10,0x243185be);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],11,0x550c7dc3);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],12,0x72be5d74);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],13,0x80deb1fe);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],14,0x9bdc06a7);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],15,0xc19bf174);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],16,0xe49b69c1);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],17,0xefbe4786);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],18,0x0fc19dc6);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],19,0x240ca1cc);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],20,0x2de92c6f);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],21,0x4a7484aa);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],22,0x5cb0a9dc);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],23,0x76f988da);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],24,0x983e5152);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],25,0xa831c66d);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],26,0xb00327c8);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],27,0xbf597fc7);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],28,0xc6e00bf3);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],29,0xd5a79147);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],30,0x06ca6351);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],31,0x14292967);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],32,0x27b70a85);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],33,0x2e1b2138);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],34,0x4d2c6dfc);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],35,0x53380d13);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],36,0x650a7354);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],37,0x766a0abb);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],38,0x81c2c92e);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],39,0x92722c85);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],40,0xa2bfe8a1);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],41,0xa81a664b);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],42,0xc24b8b70);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],43,0xc76c51a3);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],44,0xd192e819);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],45,0xd6990624);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],46,0xf40e3585);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],47,0x106aa070);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],48,0x19a4c116);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],49,0x1e376c08);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],50,0x2748774c);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],51,0x34b0bcb5);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],52,0x391c0cb3);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],53,0x4ed8aa4a);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],54,0x5b9cca4f);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],55,0x682e6ff3);
+        RND(S[0],S[1],S[2],S[3],S[4],S[5],S[6],S[7],56,0x748f82ee);
+        RND(S[7],S[0],S[1],S[2],S[3],S[4],S[5],S[6],57,0x78a5636f);
+        RND(S[6],S[7],S[0],S[1],S[2],S[3],S[4],S[5],58,0x84c87814);
+        RND(S[5],S[6],S[7],S[0],S[1],S[2],S[3],S[4],59,0x8cc70208);
+        RND(S[4],S[5],S[6],S[7],S[0],S[1],S[2],S[3],60,0x90befffa);
+        RND(S[3],S[4],S[5],S[6],S[7],S[0],S[1],S[2],61,0xa4506ceb);
+        RND(S[2],S[3],S[4],S[5],S[6],S[7],S[0],S[1],62,0xbef9a3f7);
+        RND(S[1],S[2],S[3],S[4],S[5],S[6],S[7],S[0],63,0xc67178f2);
+#undef RND
+      for (i=0; i<8; i++) // feedback
+        state[i] = state[i] + S[i];
+    }
+  }
+
+#undef RORc
+#undef Ch
+#undef Maj
+#undef S
+#undef R
+#undef Sigma0
+#undef Sigma1
+#undef Gamma0
+#undef Gamma1
+  // end libtom
+
+#ifdef KOMODO_SHA256_X86
+  //------------------------------------------------------------------
+  __attribute__((target("sha,sse4.1")))
+  void sha256_transform_shani(uint32_t state[8], uint8_t const* blocks, size_t nblocks)
+  {
+    const __m128i bswap_mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    // the sha256rnds2 instruction wants the state as ABEF/CDGH
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[0]), 0xB1);
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&state[4]), 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; nblocks; --nblocks, blocks += 64)
+    {
+      const __m128i abef_save = state0;
+      const __m128i cdgh_save = state1;
+      __m128i msg[4];
+
+      // four rounds per iteration; msg[g % 4] holds W[4g..4g+3], with
+      // the schedule for g >= 4 built from the previous four words
+      for (int g = 0; g < 16; ++g)
+      {
+        __m128i& w = msg[g & 3];
+        if (g < 4)
+          w = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + 16 * g)), bswap_mask);
+        else
+        {
+          const __m128i& w1 = msg[(g + 3) & 3];
+          w = _mm_sha256msg1_epu32(w, msg[(g + 1) & 3]);
+          w = _mm_add_epi32(w, _mm_alignr_epi8(w1, msg[(g + 2) & 3], 4));
+          w = _mm_sha256msg2_epu32(w, w1);
+        }
+        __m128i wk = _mm_add_epi32(w, _mm_loadu_si128((const __m128i*)&sha256_k[4 * g]));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+        wk = _mm_shuffle_epi32(wk, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+      }
+
+      state0 = _mm_add_epi32(state0, abef_save);
+      state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128((__m128i*)&state[0], state0);
+    _mm_storeu_si128((__m128i*)&state[4], state1);
+  }
+
+  //------------------------------------------------------------------
+  __attribute__((target("avx2")))
+  inline __m256i ror256(__m256i x, int n)
+  {
+    return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+  }
+
+  // hashes up to eight whole messages at once, one per 32-bit lane. Lanes
+  // may have different lengths: a lane's state stops being updated once
+  // its own blocks are exhausted.
+  __attribute__((target("avx2")))
+  void sha256_x8_avx2(uint8_t const* const* data, int32_t const* datalen, uint8_t (*hashes)[32], size_t lanes)
+  {
+    uint8_t tail[8][128];
+    size_t full_blocks[8], total_blocks[8];
+    size_t max_blocks = 0;
+    for (size_t j = 0; j < 8; ++j)
+    {
+      full_blocks[j] = total_blocks[j] = 0;
+      if (j >= lanes)
+        continue;
+      const uint64_t len = datalen[j];
+      full_blocks[j] = len / 64;
+      total_blocks[j] = full_blocks[j] + sha256_pad_tail(data[j] + full_blocks[j] * 64, len, tail[j]);
+      if (total_blocks[j] > max_blocks)
+        max_blocks = total_blocks[j];
+    }
+
+    __m256i s[8];
+    for (int i = 0; i < 8; ++i)
+      s[i] = _mm256_set1_epi32(sha256_iv[i]);
+
+    for (size_t b = 0; b < max_blocks; ++b)
+    {
+      uint8_t const* p[8];
+      int32_t active[8];
+      for (size_t j = 0; j < 8; ++j)
+      {
+        active[j] = b < total_blocks[j] ? -1 : 0;
+        p[j] = b < full_blocks[j] ? data[j] + b * 64 : b < total_blocks[j] ? tail[j] + (b - full_blocks[j]) * 64 : zero_block;
+      }
+      const __m256i mask = _mm256_loadu_si256((const __m256i*)active);
+
+      __m256i w[16];
+      for (int i = 0; i < 16; ++i)
+        w[i] = _mm256_set_epi32(load32be(p[7] + 4 * i), load32be(p[6] + 4 * i), load32be(p[5] + 4 * i), load32be(p[4] + 4 * i),
+                                load32be(p[3] + 4 * i), load32be(p[2] + 4 * i), load32be(p[1] + 4 * i), load32be(p[0] + 4 * i));
+
+      __m256i a = s[0], bb = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+      for (int i = 0; i < 64; ++i)
+      {
+        if (i >= 16)
+        {
+          const __m256i w15 = w[(i - 15) & 15], w2 = w[(i - 2) & 15];
+          const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(ror256(w15, 7), ror256(w15, 18)), _mm256_srli_epi32(w15, 3));
+          const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(ror256(w2, 17), ror256(w2, 19)), _mm256_srli_epi32(w2, 10));
+          w[i & 15] = _mm256_add_epi32(_mm256_add_epi32(w[i & 15], s0), _mm256_add_epi32(w[(i - 7) & 15], s1));
+        }
+        const __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(ror256(e, 6), ror256(e, 11)), ror256(e, 25));
+        const __m256i ch = _mm256_xor_si256(g, _mm256_and_si256(e, _mm256_xor_si256(f, g)));
+        const __m256i t0 = _mm256_add_epi32(_mm256_add_epi32(h, sigma1), _mm256_add_epi32(ch, _mm256_add_epi32(_mm256_set1_epi32(sha256_k[i]), w[i & 15])));
+        const __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(ror256(a, 2), ror256(a, 13)), ror256(a, 22));
+        const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, bb), _mm256_and_si256(c, _mm256_or_si256(a, bb)));
+        const __m256i t1 = _mm256_add_epi32(sigma0, maj);
+        h = g; g = f; f = e;
+        e = _mm256_add_epi32(d, t0);
+        d = c; c = bb; bb = a;
+        a = _mm256_add_epi32(t0, t1);
+      }
+
+      const __m256i out[8] = { a, bb, c, d, e, f, g, h };
+      for (int i = 0; i < 8; ++i)
+        s[i] = _mm256_blendv_epi8(s[i], _mm256_add_epi32(s[i], out[i]), mask);
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+      uint32_t words[8];
+      _mm256_storeu_si256((__m256i*)words, s[i]);
+      for (size_t j = 0; j < lanes; ++j)
+        store32be(hashes[j] + 4 * i, words[j]);
+    }
+  }
+#endif
+
+  //------------------------------------------------------------------
+  struct cpu_features
+  {
+    bool sha_ni = false;
+    bool avx2 = false;
+  };
+
+  cpu_features detect_cpu_features()
+  {
+    cpu_features features;
+#ifdef KOMODO_SHA256_X86
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+      return features;
+    const bool ssse3 = ecx & (1 << 9);
+    const bool sse41 = ecx & (1 << 19);
+    bool ymm_enabled = false;
+    if ((ecx & (1 << 27)) && (ecx & (1 << 28))) // OSXSAVE and AVX
+    {
+      uint32_t xcr0_lo, xcr0_hi;
+      __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+      ymm_enabled = (xcr0_lo & 6) == 6;
+    }
+    if (__get_cpuid_max(0, NULL) < 7)
+      return features;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    features.sha_ni = ssse3 && sse41 && (ebx & (1 << 29));
+    features.avx2 = ymm_enabled && (ebx & (1 << 5));
+#endif
+    return features;
+  }
+
+  const cpu_features& get_cpu_features()
+  {
+    static const cpu_features features = detect_cpu_features();
+    return features;
+  }
+
+  sha256_backend best_sha256_backend()
+  {
+    const cpu_features& features = get_cpu_features();
+    if (features.sha_ni)
+      return sha256_backend::sha_ni;
+    if (features.avx2)
+      return sha256_backend::avx2;
+    return sha256_backend::scalar;
+  }
+
+  std::atomic<sha256_backend>& current_backend()
+  {
+    static std::atomic<sha256_backend> backend(best_sha256_backend());
+    return backend;
+  }
+
+  typedef void (*sha256_transform_t)(uint32_t state[8], uint8_t const* blocks, size_t nblocks);
+
+  // single buffer compression function for a backend; avx2 only pays off
+  // across lanes, so lone messages use the scalar code there
+  sha256_transform_t get_transform(sha256_backend backend)
+  {
+#ifdef KOMODO_SHA256_X86
+    if (backend == sha256_backend::sha_ni)
+      return sha256_transform_shani;
+#endif
+    return sha256_transform_scalar;
+  }
+
+  void sha256_oneshot(sha256_transform_t transform, uint8_t const* data, uint64_t len, uint8_t hash[32])
+  {
+    uint32_t state[8];
+    memcpy(state, sha256_iv, sizeof(state));
+    const size_t full_blocks = len / 64;
+    transform(state, data, full_blocks);
+    uint8_t tail[128];
+    transform(state, tail, sha256_pad_tail(data + full_blocks * 64, len, tail));
+    for (int i = 0; i < 8; ++i)
+      store32be(hash + 4 * i, state[i]);
+  }
+
+} // anonymous namespace
+
+  //------------------------------------------------------------------
+  bool sha256_backend_supported(sha256_backend backend)
+  {
+    switch (backend)
+    {
+      case sha256_backend::scalar: return true;
+      case sha256_backend::sha_ni: return get_cpu_features().sha_ni;
+      case sha256_backend::avx2: return get_cpu_features().avx2;
+    }
+    return false;
+  }
+  //------------------------------------------------------------------
+  sha256_backend get_sha256_backend()
+  {
+    return current_backend().load();
+  }
+  //------------------------------------------------------------------
+  bool set_sha256_backend(sha256_backend backend)
+  {
+    if (!sha256_backend_supported(backend))
+      return false;
+    current_backend().store(backend);
+    return true;
+  }
+  //------------------------------------------------------------------
+  char const* sha256_backend_name(sha256_backend backend)
+  {
+    switch (backend)
+    {
+      case sha256_backend::scalar: return "scalar";
+      case sha256_backend::sha_ni: return "sha_ni";
+      case sha256_backend::avx2: return "avx2";
+    }
+    return "unknown";
+  }
+  //------------------------------------------------------------------
+  void sha256_transform(uint32_t state[8], uint8_t const* blocks, size_t nblocks)
+  {
+    get_transform(get_sha256_backend())(state, blocks, nblocks);
+  }
+  //------------------------------------------------------------------
+  void sha256(uint8_t const* data, size_t len, uint8_t hash[32])
+  {
+    sha256_oneshot(get_transform(get_sha256_backend()), data, len, hash);
+  }
+  //------------------------------------------------------------------
+  void sha256_many(uint8_t const* const* data, int32_t const* datalen, uint8_t (*hashes)[32], size_t count, sha256_backend backend)
+  {
+    if (!sha256_backend_supported(backend))
+      backend = sha256_backend::scalar;
+#ifdef KOMODO_SHA256_X86
+    if (backend == sha256_backend::avx2)
+    {
+      for (size_t i = 0; i < count; i += 8)
+        sha256_x8_avx2(data + i, datalen + i, hashes + i, count - i < 8 ? count - i : 8);
+      return;
+    }
+#endif
+    const sha256_transform_t transform = get_transform(backend);
+    for (size_t i = 0; i < count; ++i)
+      sha256_oneshot(transform, data[i], datalen[i], hashes[i]);
+  }
+  //------------------------------------------------------------------
+  void bits256_doublesha256_many(uint8_t const* const* data, int32_t const* datalen, bits256* out, size_t count)
+  {
+    bits256_doublesha256_many(data, datalen, out, count, get_sha256_backend());
+  }
+  //------------------------------------------------------------------
+  void bits256_doublesha256_many(uint8_t const* const* data, int32_t const* datalen, bits256* out, size_t count, sha256_backend backend)
+  {
+    std::vector<uint8_t> hash_buf(2 * 32 * count);
+    uint8_t (*first)[32] = reinterpret_cast<uint8_t (*)[32]>(hash_buf.data());
+    uint8_t (*second)[32] = first + count;
+    sha256_many(data, datalen, first, count, backend);
+
+    std::vector<uint8_t const*> first_ptrs(count);
+    const std::vector<int32_t> first_lens(count, 32);
+    for (size_t i = 0; i < count; ++i)
+      first_ptrs[i] = first[i];
+    sha256_many(first_ptrs.data(), first_lens.data(), second, count, backend);
+
+    for (size_t i = 0; i < count; ++i)
+      for (size_t j = 0; j < sizeof(bits256); ++j)
+        out[i].bytes[j] = second[i][sizeof(bits256) - 1 - j];
+  }
+
+} // namespace komodo
+} // namespace cryptonote
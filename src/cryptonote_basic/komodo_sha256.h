@@ -0,0 +1,72 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cryptonote_format_utils.h"
+
+namespace cryptonote {
+namespace komodo {
+
+  /**
+   * SHA-256 compression backends used for the BTC/KMD style hashing of
+   * notarization data. The fastest one the CPU supports is picked on first
+   * use; sha_ni and avx2 are only available in x86-64 builds.
+   */
+  enum class sha256_backend
+  {
+    scalar,   // portable libtom compression function
+    sha_ni,   // one message at a time with the x86 SHA extensions
+    avx2,     // eight messages in parallel, one per 32-bit AVX2 lane
+  };
+
+  bool sha256_backend_supported(sha256_backend backend);
+  sha256_backend get_sha256_backend();
+  bool set_sha256_backend(sha256_backend backend);
+  char const* sha256_backend_name(sha256_backend backend);
+
+  // run the compression function over nblocks consecutive 64-byte blocks
+  void sha256_transform(uint32_t state[8], uint8_t const* blocks, size_t nblocks);
+
+  // one-shot SHA-256 of a single message
+  void sha256(uint8_t const* data, size_t len, uint8_t hash[32]);
+
+  void sha256_many(uint8_t const* const* data, int32_t const* datalen, uint8_t (*hashes)[32], size_t count, sha256_backend backend);
+
+  /**
+   * Batched bits256_doublesha256(): out[i] is the (byte reversed) double
+   * SHA-256 of data[i]. The avx2 backend hashes eight messages per pass,
+   * so merkle levels and other runs of similar sized inputs should go
+   * through here rather than one call per leaf.
+   */
+  void bits256_doublesha256_many(uint8_t const* const* data, int32_t const* datalen, bits256* out, size_t count);
+  void bits256_doublesha256_many(uint8_t const* const* data, int32_t const* datalen, bits256* out, size_t count, sha256_backend backend);
+
+} // namespace komodo
+} // namespace cryptonote
@@ -0,0 +1,135 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace cryptonote
+{
+  /**
+   * Notary signer sets as a 64-bit mask, one bit per notary node index.
+   *
+   * The ordered signers_index list is still what orders the signatures in a
+   * notarization tx (the last entry picks the viewkey for the next signer), so
+   * the mask travels alongside it rather than replacing it.  It is what
+   * membership queries should use.
+   */
+  static const int NTZ_SIGNERS_MAX = 64;
+
+  inline bool ntz_signer_valid(int signer_index)
+  {
+    return signer_index >= 0 && signer_index < NTZ_SIGNERS_MAX;
+  }
+
+  inline uint64_t ntz_signer_bit(int signer_index)
+  {
+    return ntz_signer_valid(signer_index) ? (uint64_t(1) << signer_index) : 0;
+  }
+
+  inline bool ntz_has_signer(uint64_t signers_mask, int signer_index)
+  {
+    return (signers_mask & ntz_signer_bit(signer_index)) != 0;
+  }
+
+  inline int ntz_signers_count(uint64_t signers_mask)
+  {
+    int count = 0;
+    for (; signers_mask; signers_mask &= signers_mask - 1)
+      ++count;
+    return count;
+  }
+
+  /**
+   * @brief build a signer mask from a list of signer indices
+   *
+   * Unused slots (-1) and out of range indices are skipped.
+   *
+   * @param signers_index any iterable container of int
+   *
+   * @return the signer mask
+   */
+  template<typename T>
+  uint64_t ntz_signers_mask(const T& signers_index)
+  {
+    uint64_t mask = 0;
+    for (const auto& each : signers_index)
+      mask |= ntz_signer_bit(each);
+    return mask;
+  }
+
+  /**
+   * @brief encode a list of signer indices in the zero-padded "%02d" string
+   *        form used by NOTIFY_REQUEST_NTZ_SIG ("-1" for unused slots)
+   *
+   * @param signers_index any iterable container of int
+   *
+   * @return the encoded signer list
+   */
+  template<typename T>
+  std::string ntz_signers_to_string(const T& signers_index)
+  {
+    std::string str;
+    for (const auto& each : signers_index)
+    {
+      if (each > -1 && each < 10)
+        str += "0";
+      str += std::to_string(each);
+    }
+    return str;
+  }
+
+  /**
+   * @brief build a signer mask from the zero-padded "%02d" string form used
+   *        by NOTIFY_REQUEST_NTZ_SIG ("-1" for unused slots)
+   *
+   * @param signers_index the encoded signer list
+   * @param signers_mask return-by-reference the signer mask
+   *
+   * @return false if the string is malformed, otherwise true
+   */
+  inline bool ntz_signers_mask_from_string(const std::string& signers_index, uint64_t& signers_mask)
+  {
+    signers_mask = 0;
+    if (signers_index.size() % 2)
+      return false;
+    for (size_t i = 0; i < signers_index.size(); i += 2)
+    {
+      const char a = signers_index[i], b = signers_index[i + 1];
+      if (a == '-' && b == '1')
+        continue;
+      if (a < '0' || a > '9' || b < '0' || b > '9')
+        return false;
+      const int idx = (a - '0') * 10 + (b - '0');
+      if (!ntz_signer_valid(idx))
+        return false;
+      signers_mask |= ntz_signer_bit(idx);
+    }
+    return true;
+  }
+}
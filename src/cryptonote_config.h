@@ -41,6 +41,12 @@
 #define DPOW_FORK_VERSION                               11
 #define DPOW_NOTA_TX_VERSION                            2
 #define DPOW_NOTARIZATION_WINDOW                        25
+#define DPOW_EVENT_WAIT_MS                              20000 // default long-poll timeout for /wait_ntz_event
+#define DPOW_EVENT_MAX_WAIT_MS                          60000
+#define DPOW_NTZ_SIG_FETCH_TIMEOUT                      10 // seconds before an announced ntz sig tx is fetched again from another peer
+#define DPOW_MAX_NTZ_SIG_MISSING                        (DPOW_SIG_COUNT * DPOW_MAX_NOTA_PER_BLOCK) // most ntz sig txes a peer may request at once
+#define DPOW_MOM_INDEX_LEVELS                           12 // windows of up to 2^12 blocks are answered from the in-memory MoM index
+#define DPOW_MOM_INDEX_HEIGHTS                          16384 // most recent blocks kept in the in-memory MoM index
 #define DPOW_SYMBOL                                     "BLUR"
 
 #define DISABLE_BTC_TX_CHECKS				1
@@ -116,6 +122,8 @@
 #define CRYPTONOTE_MEMPOOL_TX_FROM_ALT_BLOCK_LIVETIME     604800 /* seconds, one week */
 
 #define COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT           1000
+#define COMMAND_RPC_GET_BLOCKS_FAST_CACHE_SIZE          (256*1024*1024) /* bytes of blocks and txes kept ready to serve by getblocks.bin */
+#define FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE             (100*1024*1024) // 100 MB
 
 #define P2P_LOCAL_WHITE_PEERLIST_LIMIT                  1000
 #define P2P_LOCAL_GRAY_PEERLIST_LIMIT                   5000
@@ -139,7 +147,8 @@
 #define P2P_IDLE_CONNECTION_KILL_INTERVAL               (5*60) /* 5 minutes */
 
 #define P2P_SUPPORT_FLAG_FLUFFY_BLOCKS                  0x01
-#define P2P_SUPPORT_FLAGS                               P2P_SUPPORT_FLAG_FLUFFY_BLOCKS
+#define P2P_SUPPORT_FLAG_NTZ_SIG_ANNOUNCE               0x02
+#define P2P_SUPPORT_FLAGS                               (P2P_SUPPORT_FLAG_FLUFFY_BLOCKS | P2P_SUPPORT_FLAG_NTZ_SIG_ANNOUNCE)
 
 #define CRYPTONOTE_NAME                         "blurnetwork"
 #define CRYPTONOTE_BLOCKCHAINDATA_FILENAME      "data.mdb"
@@ -63,8 +63,6 @@
 #undef MONERO_DEFAULT_LOG_CATEGORY
 #define MONERO_DEFAULT_LOG_CATEGORY "blockchain"
 
-#define FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE (100*1024*1024) // 100 MB
-
 using namespace crypto;
 
 //#include "serialization/json_archive.h"
@@ -77,8 +75,6 @@ using namespace crypto;
 
 using namespace cryptonote;
 using epee::string_tools::pod_to_hex;
-extern "C" void slow_hash_allocate_state();
-extern "C" void slow_hash_free_state();
 
 DISABLE_VS_WARNINGS(4267)
 
@@ -157,7 +153,8 @@ static const struct {
 //------------------------------------------------------------------
 Blockchain::Blockchain(tx_memory_pool& tx_pool) :
   m_db(), m_tx_pool(tx_pool), m_hardfork(NULL), m_timestamps_and_difficulties_height(0), m_current_block_cumul_sz_limit(0), m_current_block_cumul_sz_median(0),
-  m_max_prepare_blocks_threads(1), m_db_blocks_per_sync(1), m_db_sync_mode(db_async), m_db_default_sync(false), m_fast_sync(true), m_show_time_stats(false), m_sync_counter(0), m_cancel(false)
+  m_db_blocks_per_sync(1), m_db_sync_mode(db_async), m_db_default_sync(false), m_fast_sync(true), m_show_time_stats(false), m_sync_counter(0), m_cancel(false),
+  m_chain_revision(1), m_ntzpool_revision(1)
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
 }
@@ -182,74 +179,113 @@ bool Blockchain::have_tx_keyimg_as_spent(const crypto::key_image &key_im) const
   return  m_db->has_key_image(key_im);
 }
 //------------------------------------------------------------------
+static uint64_t ntz_txs_to_ntz_count(uint64_t ntz_tx_count)
+{
+  if (ntz_tx_count % (DPOW_SIG_COUNT) == 0)
+  {
+    return (ntz_tx_count/(DPOW_SIG_COUNT));
+  }
+  else
+  {
+    MERROR("Inconsistency in enumeration of ntz_count vs minsigs! Count should be an even multiple of required signatures!");
+    return 0;
+  }
+}
+//------------------------------------------------------------------
+uint64_t Blockchain::get_ntz_count() const
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+  return ntz_txs_to_ntz_count(m_db->get_ntz_tx_count());
+}
+//------------------------------------------------------------------
 uint64_t Blockchain::get_ntz_count(std::vector<std::pair<crypto::hash,uint64_t>>& ret) const
 {
   // vector of hash, height pair for all notarizations in DB
   // return value is total count
   LOG_PRINT_L3("Blockchain::" << __func__);
-  uint64_t count = 0;
-  std::vector<std::pair<crypto::hash,uint64_t>> hash_height;
-  for_all_transactions([this, &hash_height, &count](const crypto::hash &hash, const cryptonote::transaction &tx)->bool
+  ret.clear();
+  m_db->for_all_ntz_txs([&ret](uint64_t ntz_idx, const crypto::hash &hash, uint64_t height, const crypto::hash &tree_hash)->bool
   {
-    if ((tx.version == (DPOW_NOTA_TX_VERSION)) && (tx.vin[0].type() != typeid(txin_gen))) {
-      uint64_t ntz_index = count;
-      const uint64_t height = m_db->get_tx_block_height(hash);
-      auto each = std::make_pair(hash,height);
-      hash_height.push_back(each);
-      count += 1;
-    }
+    ret.push_back(std::make_pair(hash,height));
     return true;
   });
 
-  ret = hash_height;
-  if (count % (DPOW_SIG_COUNT) == 0)
-  {
-    return (count/(DPOW_SIG_COUNT));
-  }
-  else
-  {
-    MERROR("Inconsistency in enumeration of ntz_count vs minsigs! Count should be an even multiple of required signatures!");
-    return 0;
-  }
+  return ntz_txs_to_ntz_count(ret.size());
 }
 //------------------------------------------------------------------
-crypto::hash Blockchain::get_ntz_merkle(std::vector<std::pair<crypto::hash,uint64_t>> const& notarizations)
-{
-  // TODO: this function is incorrect
-  crypto::hash merkle_root = crypto::null_hash;
-  std::vector<crypto::hash> hashes;
-  std::vector<cryptonote::block> blocks;
-  for (const auto& each : notarizations) {
-    cryptonote::block b;
-    crypto::hash each_hash = crypto::null_hash;
-    each_hash = get_block_id_by_height(each.second);
-    if (!get_block_by_hash(each_hash, b))
-      return crypto::null_hash;
-    else {
-      hashes.push_back(get_tx_tree_hash(b));
+bool Blockchain::get_ntz_txs_range(uint64_t start_height, uint64_t end_height, size_t max_count, const std::unordered_set<crypto::hash>& filter, std::vector<ntz_tx_entry>& ntzs, bool& more, uint64_t& next_height) const
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+
+  ntzs.clear();
+  more = false;
+  next_height = 0;
+  if (end_height < start_height)
+    return true;
+
+  m_db->block_txn_start(true);
+  try
+  {
+    m_db->for_ntz_txs_range(start_height, end_height, [&](uint64_t ntz_idx, const crypto::hash& tx_hash, uint64_t height, const crypto::hash& tree_hash)->bool
+    {
+      if (!filter.empty() && filter.find(tx_hash) == filter.end())
+        return true;
+      if (max_count && ntzs.size() >= max_count && ntzs.back().height != height)
+      {
+        more = true;
+        next_height = height;
+        return false;
+      }
+      ntzs.push_back(ntz_tx_entry());
+      ntzs.back().tx_hash = tx_hash;
+      ntzs.back().height = height;
+      return true;
+    });
+
+    uint64_t timestamp_height = std::numeric_limits<uint64_t>::max();
+    uint64_t timestamp = 0;
+    for (auto& e : ntzs)
+    {
+      uint64_t tx_index;
+      if (!m_db->tx_exists(e.tx_hash, tx_index) || !m_db->get_tx_blob(e.tx_hash, e.blob))
+      {
+        MERROR("Notarization " << e.tx_hash << " is indexed but its transaction is not in the db");
+        m_db->block_txn_abort();
+        return false;
+      }
+      e.output_indices = m_db->get_tx_amount_output_indices(tx_index);
+      if (e.height != timestamp_height)
+      {
+        timestamp_height = e.height;
+        timestamp = m_db->get_block_timestamp(e.height);
+      }
+      e.timestamp = timestamp;
     }
   }
-  if (!hashes.empty()) {
-    merkle_root = get_tx_tree_hash(hashes);
+  catch (const std::exception& e)
+  {
+    MERROR("Failed to read notarizations from the db: " << e.what());
+    m_db->block_txn_abort();
+    return false;
   }
-  return merkle_root;
+  m_db->block_txn_stop();
+  return true;
 }
 //------------------------------------------------------------------
 uint64_t Blockchain::get_notarized_height(crypto::hash& ntz_hash) const
 {
-  std::vector<std::pair<crypto::hash,uint64_t>> ntz_txs;
-  uint64_t ntz_count = get_ntz_count(ntz_txs);
-  uint64_t notarized_height = 0;
-  ntz_hash = crypto::null_hash;
-  for (const auto& each : ntz_txs)
-  {
-    if (each.second > notarized_height)
-    {
-      notarized_height = each.second;
-      ntz_hash = each.first;
-    }
-  }
-  return notarized_height;
+  return m_db->get_notarized_height(ntz_hash);
+}
+//------------------------------------------------------------------
+crypto::hash Blockchain::get_MoM(uint64_t height, uint64_t depth) const
+{
+  return m_db->get_MoM(height, depth);
+}
+//------------------------------------------------------------------
+bool Blockchain::get_notarization_covering(uint64_t height, uint64_t& ntz_height, uint64_t& prev_height, crypto::hash& ntz_txid) const
+{
+  return m_db->get_notarization_covering(height, ntz_height, prev_height, ntz_txid);
 }
 //------------------------------------------------------------------
 uint64_t Blockchain::get_notarization_wait() const
@@ -326,36 +362,13 @@ void Blockchain::fetch_raw_src_tx(std::string& raw_src_tx)
 //------------------------------------------------------------------
 void Blockchain::komodo_update()
 {
-    std::vector<std::pair<crypto::hash,uint64_t>> notarizations;
-    uint64_t ntz_count = get_ntz_count(notarizations);
-
-    crypto::hash ntz_txid = crypto::null_hash;
-    uint64_t greatest_height = 0;
-    uint64_t previous_height = 0;
-    for (const auto& each: notarizations)
-    {
-      if (each.second > greatest_height)
-      {
-        greatest_height = each.second;
-        ntz_txid = each.first;
-      }
-    }
-    for (const auto& each : notarizations)
-    {
-      if (each.second > previous_height)
-      {
-        if (each.second == greatest_height)
-        {
-          /* ignore */
-        }
-        else
-        {
-          previous_height = each.second;
-        }
-      }
-    }
-
-    crypto::hash ntz_merkle = get_ntz_merkle(notarizations);
+    // maintained incrementally by the db as blocks are added and popped
+    ntz_state_t const ntz = m_db->get_ntz_state();
+    uint64_t const ntz_count = ntz_txs_to_ntz_count(ntz.ntz_tx_count);
+    uint64_t const greatest_height = ntz.notarized_height;
+    uint64_t const previous_height = ntz.notarized_prevheight;
+    crypto::hash const& ntz_txid = ntz.notarized_txid;
+    crypto::hash const& ntz_merkle = ntz.notarized_MoM;
 
     epee::span<const uint8_t> span_desttxid = epee::as_byte_span(ntz_txid);
     crypto::hash notarizedhash = get_block_id_by_height(greatest_height);
@@ -802,6 +815,7 @@ block Blockchain::pop_block_from_blockchain()
     LOG_ERROR("Error popping block from blockchain, throwing!");
     throw;
   }
+  notify_ntz_event(true, false);
 
   // return transactions from popped block to the tx_pool
   for (transaction& tx : popped_txs)
@@ -1698,6 +1712,7 @@ bool Blockchain::handle_alternative_block(const block& b, const crypto::hash& id
       {
         LOG_PRINT_L1("Blockchain::handle_alternative_block >> Encountered pre-notarization block greater than height: " << std::to_string(ntz_height));
         std::vector<cryptonote::transaction> nota_txs;
+        std::vector<crypto::hash> nota_hashes;
         uint64_t num_ntz_txs = 0;
         std::vector<cryptonote::blobdata> tx_blobs;
         for (const auto& each: bei.bl.tx_hashes)
@@ -1710,16 +1725,17 @@ bool Blockchain::handle_alternative_block(const block& b, const crypto::hash& id
           }
           tx_blobs.push_back(each_blob);
         }
-        for (const auto& txblob: tx_blobs)
+        for (size_t i = 0; i < tx_blobs.size(); ++i)
         {
           cryptonote::transaction tx;
-          if (!parse_and_validate_tx_from_blob(txblob, tx)) {
+          if (!parse_and_validate_tx_from_blob(tx_blobs[i], tx)) {
             MERROR_VER("Failed to parse and validate tx from blob in handle_alternative_block_to_main_chain()!");
             bvc.m_verifivation_failed = true;
             return false;
           }
           if (tx.version == (DPOW_NOTA_TX_VERSION)) {
             nota_txs.push_back(tx);
+            nota_hashes.push_back(bei.bl.tx_hashes[i]);
             num_ntz_txs++;
           }
         }
@@ -1742,7 +1758,7 @@ bool Blockchain::handle_alternative_block(const block& b, const crypto::hash& id
             std::vector<std::string> btc_hashes;
             std::vector<uint64_t> heights;
             std::vector<uint32_t> bad_idxs;
-            int32_t verify_ntz_txs = verify_embedded_ntz_data(nota_txs, btc_hashes, heights, bad_idxs);
+            int32_t verify_ntz_txs = verify_embedded_ntz_data(nota_txs, btc_hashes, heights, bad_idxs, &nota_hashes);
             if (verify_ntz_txs < 1)
             {
               if (verify_ntz_txs == 0)
@@ -2132,15 +2148,13 @@ bool Blockchain::get_random_outs_for_amounts(const COMMAND_RPC_GET_RANDOM_OUTPUT
 //------------------------------------------------------------------
 // This function adds the ringct output at index i to the list
 // unlocked and other such checks should be done by here.
-void Blockchain::add_out_to_get_rct_random_outs(std::list<COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::out_entry>& outs, uint64_t amount, size_t i) const
+void Blockchain::add_out_to_get_rct_random_outs(std::list<COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::out_entry>& outs, uint64_t amount, size_t i, const output_data_t& data) const
 {
   LOG_PRINT_L3("Blockchain::" << __func__);
-  CRITICAL_REGION_LOCAL(m_blockchain_lock);
 
   COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::out_entry& oen = *outs.insert(outs.end(), COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::out_entry());
   oen.amount = amount;
   oen.global_amount_index = i;
-  output_data_t data = m_db->get_output_key(amount, i);
   oen.out_key = data.pubkey;
   oen.commitment = data.commitment;
 }
@@ -2169,20 +2183,23 @@ bool Blockchain::get_random_rct_outs(const COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::r
   }
 
   std::unordered_set<uint64_t> seen_indices;
+  std::vector<std::pair<uint64_t, uint64_t>> candidates;
+  std::vector<output_data_t> outputs;
 
   // if there aren't enough outputs to mix with (or just enough),
   // use all of them.  Eventually this should become impossible.
   if (num_outs <= req.outs_count)
   {
     for (uint64_t i = 0; i < num_outs; i++)
-    {
-      // get tx_hash, tx_out_index from DB
-      tx_out_index toi = m_db->get_output_tx_and_index(0, i);
+      candidates.push_back(std::make_pair(0, i));
+    m_db->get_output_keys_batch(candidates, outputs);
 
+    for (size_t n = 0; n < candidates.size(); ++n)
+    {
       // if tx is unlocked, add output to result_outs
-      if (is_tx_spendtime_unlocked(m_db->get_tx_unlock_time(toi.first)))
+      if (is_tx_spendtime_unlocked(outputs[n].unlock_time))
       {
-        add_out_to_get_rct_random_outs(res.outs, 0, i);
+        add_out_to_get_rct_random_outs(res.outs, 0, candidates[n].second, outputs[n]);
       }
     }
   }
@@ -2197,32 +2214,37 @@ bool Blockchain::get_random_rct_outs(const COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::r
         break;
       }
 
-      // get a random output index from the DB.  If we've already seen it,
-      // return to the top of the loop and try again, otherwise add it to the
-      // list of output indices we've seen.
-
-      // triangular distribution over [a,b) with a=0, mode c=b=up_index_limit
-      uint64_t r = crypto::rand<uint64_t>() % ((uint64_t)1 << 53);
-      double frac = std::sqrt((double)r / ((uint64_t)1 << 53));
-      uint64_t i = (uint64_t)(frac*num_outs);
-      // just in case rounding up to 1 occurs after sqrt
-      if (i == num_outs)
-        --i;
-
-      if (seen_indices.count(i))
+      // draw as many new output indices as we are still missing, then look
+      // them all up in one db batch.  If we've already seen an index, draw
+      // again, otherwise add it to the list of output indices we've seen.
+      candidates.clear();
+      const size_t missing = req.outs_count - res.outs.size();
+      while (candidates.size() < missing && seen_indices.size() < num_outs)
       {
-        continue;
+        // triangular distribution over [a,b) with a=0, mode c=b=up_index_limit
+        uint64_t r = crypto::rand<uint64_t>() % ((uint64_t)1 << 53);
+        double frac = std::sqrt((double)r / ((uint64_t)1 << 53));
+        uint64_t i = (uint64_t)(frac*num_outs);
+        // just in case rounding up to 1 occurs after sqrt
+        if (i == num_outs)
+          --i;
+
+        if (seen_indices.count(i))
+        {
+          continue;
+        }
+        seen_indices.emplace(i);
+        candidates.push_back(std::make_pair(0, i));
       }
-      seen_indices.emplace(i);
-
-      // get tx_hash, tx_out_index from DB
-      tx_out_index toi = m_db->get_output_tx_and_index(0, i);
+      m_db->get_output_keys_batch(candidates, outputs);
 
-      // if the output's transaction is unlocked, add the output's index to
-      // our list.
-      if (is_tx_spendtime_unlocked(m_db->get_tx_unlock_time(toi.first)))
+      for (size_t n = 0; n < candidates.size(); ++n)
       {
-        add_out_to_get_rct_random_outs(res.outs, 0, i);
+        // if the output's transaction is unlocked, add the output to our list.
+        if (is_tx_spendtime_unlocked(outputs[n].unlock_time))
+        {
+          add_out_to_get_rct_random_outs(res.outs, 0, candidates[n].second, outputs[n]);
+        }
       }
     }
   }
@@ -2240,14 +2262,23 @@ bool Blockchain::get_outs(const COMMAND_RPC_GET_OUTPUTS_BIN::request& req, COMMA
 
   res.outs.clear();
   res.outs.reserve(req.outputs.size());
+
+  std::vector<std::pair<uint64_t, uint64_t>> outputs;
+  outputs.reserve(req.outputs.size());
   for (const auto &i: req.outputs)
+    outputs.push_back(std::make_pair(i.amount, i.index));
+
+  // get output data and tx_hash, tx_out_index from DB in one batch; an
+  // output's unlock time is its transaction's
+  std::vector<output_data_t> data;
+  std::vector<tx_out_index> tois;
+  m_db->get_output_keys_batch(outputs, data, &tois);
+  for (size_t n = 0; n < outputs.size(); ++n)
   {
-    // get tx_hash, tx_out_index from DB
-    const output_data_t od = m_db->get_output_key(i.amount, i.index);
-    tx_out_index toi = m_db->get_output_tx_and_index(i.amount, i.index);
-    bool unlocked = is_tx_spendtime_unlocked(m_db->get_tx_unlock_time(toi.first));
+    const output_data_t &od = data[n];
+    bool unlocked = is_tx_spendtime_unlocked(od.unlock_time);
 
-    res.outs.push_back({od.pubkey, od.commitment, unlocked, od.height, toi.first});
+    res.outs.push_back({od.pubkey, od.commitment, unlocked, od.height, tois[n].first});
   }
   return true;
 }
@@ -2688,6 +2719,33 @@ bool Blockchain::get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<u
   return true;
 }
 //------------------------------------------------------------------
+bool Blockchain::get_tx_outputs_gindexs(const std::vector<crypto::hash>& tx_ids, std::vector<std::vector<uint64_t>>& indexs) const
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+  CRITICAL_REGION_LOCAL(m_blockchain_lock);
+  try
+  {
+    m_db->get_tx_amount_output_indices_batch(tx_ids, indexs);
+  }
+  catch (const TX_DNE& e)
+  {
+    MERROR_VER("get_tx_outputs_gindexs failed to find transaction: " << e.what());
+    return false;
+  }
+
+  for (size_t n = 0; n < tx_ids.size(); ++n)
+  {
+    if (indexs[n].empty())
+    {
+      // empty indexs is only valid if the vout is empty, which is legal but rare
+      cryptonote::transaction tx = m_db->get_tx(tx_ids[n]);
+      CHECK_AND_ASSERT_MES(tx.vout.empty(), false, "internal error: global indexes for transaction " << tx_ids[n] << " is empty, and tx vout is not");
+    }
+  }
+
+  return true;
+}
+//------------------------------------------------------------------
 void Blockchain::on_new_tx_from_block(const cryptonote::transaction &tx)
 {
 #if defined(PER_BLOCK_CHECKPOINT)
@@ -2976,7 +3034,7 @@ bool Blockchain::expand_transaction_2(transaction &tx, const crypto::hash &tx_pr
 //        check_tx_input() rather than here, and use this function simply
 //        to iterate the inputs as necessary (splitting the task
 //        using threads, etc.)
-bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height)
+bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height, std::vector<std::function<bool()>>* mg_checks)
 {
   PERF_TIMER(check_tx_inputs);
   LOG_PRINT_L3("Blockchain::" << __func__);
@@ -3161,7 +3219,15 @@ bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc,
         }
       }
 
-      if (!rct::verRctSimple(rv, false))
+      if (mg_checks)
+      {
+        if (!rct::getRctMGChecks(rv, *mg_checks))
+        {
+          MERROR_VER("Failed to check ringct signatures!");
+          return false;
+        }
+      }
+      else if (!rct::verRctSimple(rv, false))
       {
         MERROR_VER("Failed to check ringct signatures!");
         return false;
@@ -3221,7 +3287,15 @@ bool Blockchain::check_tx_inputs(transaction& tx, tx_verification_context &tvc,
         }
       }
 
-      if (!rct::verRct(rv, false))
+      if (mg_checks)
+      {
+        if (!rct::getRctMGChecks(rv, *mg_checks))
+        {
+          MERROR_VER("Failed to check ringct signatures!");
+          return false;
+        }
+      }
+      else if (!rct::verRct(rv, false))
       {
         MERROR_VER("Failed to check ringct signatures!");
         return false;
@@ -3889,14 +3963,11 @@ bool Blockchain::flush_ntz_txes_from_pool(const std::list<crypto::hash> &txids)
     uint8_t sig_count = meta.sig_count;
 
     crypto::hash ptx_hash = meta.ptx_hash;
-    std::list<int> signers_index;
-    for (int i = 0; i < DPOW_SIG_COUNT; i++) {
-      signers_index.push_back(meta.signers_index[i]);
-    }
+    uint64_t signers_mask = meta.signers_mask;
     std::pair<cryptonote::blobdata,cryptonote::blobdata> bd_pair = get_ntzpool_tx_blob(txid, ptx_hash);
     cryptonote::blobdata ptx_blob = bd_pair.second;
     MINFO("Removing txid " << txid << " from the pool");
-    if(has_ntzpool_tx(txid) && !m_tx_pool.take_ntzpool_tx(txid, tx, blob_size, fee, relayed, do_not_relay, double_spend_seen, sig_count, signers_index, ptx_blob, ptx_hash))
+    if(has_ntzpool_tx(txid) && !m_tx_pool.take_ntzpool_tx(txid, tx, blob_size, fee, relayed, do_not_relay, double_spend_seen, sig_count, signers_mask, ptx_blob, ptx_hash))
     {
       MERROR("Failed to remove txid " << txid << " from the pool");
       res = false;
@@ -4058,7 +4129,14 @@ leave:
   else
 #endif
   {
-    proof_of_work = get_block_longhash(bl, m_db->height());
+    auto it = m_blocks_longhash_table.find(id);
+    if (it != m_blocks_longhash_table.end())
+    {
+      precomputed = true;
+      proof_of_work = it->second;
+    }
+    else
+      proof_of_work = get_block_longhash(bl, m_db->height());
 
     uint64_t m_height = get_block_height(bl);
 
@@ -4074,6 +4152,7 @@ leave:
         // height greater than last notarized height
         LOG_PRINT_L1("Blockchain::handle_block_to_main_chain() >> Encountered pre-notarization block greater than height: " << std::to_string(ntz_height));
         std::vector<cryptonote::transaction> nota_txs;
+        std::vector<crypto::hash> nota_hashes;
         uint64_t num_ntz_txs = 0;
         cryptonote::blobdata txblob;
         std::vector<cryptonote::blobdata> tx_blobs;
@@ -4087,10 +4166,10 @@ leave:
           }
           tx_blobs.push_back(each_blob);
         }
-        for (const auto& txblob: tx_blobs)
+        for (size_t i = 0; i < tx_blobs.size(); ++i)
         {
           cryptonote::transaction tx;
-          if (!parse_and_validate_tx_from_blob(txblob, tx))
+          if (!parse_and_validate_tx_from_blob(tx_blobs[i], tx))
           {
             MERROR_VER("Failed to parse and validate tx from blob in handle_block_to_main_chain()!");
             bvc.m_verifivation_failed = true;
@@ -4099,6 +4178,7 @@ leave:
           if (tx.version == (DPOW_NOTA_TX_VERSION))
           {
             nota_txs.push_back(tx);
+            nota_hashes.push_back(bl.tx_hashes[i]);
             num_ntz_txs++;
           }
         }
@@ -4128,7 +4208,7 @@ leave:
             std::vector<std::string> btc_hashes;
             std::vector<uint64_t> heights;
             std::vector<uint32_t> bad_idxs;
-            int32_t verify_ntz_txs = verify_embedded_ntz_data(nota_txs, btc_hashes, heights, bad_idxs);
+            int32_t verify_ntz_txs = verify_embedded_ntz_data(nota_txs, btc_hashes, heights, bad_idxs, &nota_hashes);
             if (verify_ntz_txs < 1)
             {
               if (verify_ntz_txs == 0)
@@ -4233,6 +4313,13 @@ leave:
   std::vector<transaction> txs;
   key_images_container keys;
 
+  // the MG signatures of every tx are checked together once all the inputs
+  // are resolved, so they're spread over the threadpool as one set instead of
+  // a few at a time per tx. The checks refer to the txs, which must not move.
+  std::vector<std::function<bool()>> mg_checks;
+  std::vector<size_t> mg_check_tx_indices;
+  txs.reserve(bl.tx_hashes.size());
+
   uint64_t fee_summary = 0;
   uint64_t t_checktx = 0;
   uint64_t t_exists = 0;
@@ -4307,7 +4394,7 @@ leave:
     {
       // validate that transaction inputs and the keys spending them are correct.
       tx_verification_context tvc;
-      if(!check_tx_inputs(tx, tvc))
+      if(!check_tx_inputs(txs.back(), tvc, NULL, &mg_checks))
       {
         MERROR_VER("Block with id: " << id  << " has at least one transaction (id: " << tx_id << ") with wrong inputs.");
 
@@ -4336,12 +4423,51 @@ leave:
       }
     }
 #endif
+    mg_check_tx_indices.resize(mg_checks.size(), txs.size() - 1);
     TIME_MEASURE_FINISH(cc);
     t_checktx += cc;
     fee_summary += fee;
     cumulative_block_size += blob_size;
   }
 
+  if (!mg_checks.empty())
+  {
+    TIME_MEASURE_START(cc);
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    tools::threadpool::waiter waiter;
+    std::deque<bool> results(mg_checks.size(), true);
+    std::atomic<bool> failed(false);
+    for (size_t i = 0; i < mg_checks.size(); ++i)
+    {
+      tpool.submit(&waiter, [&, i] {
+        // the block is rejected on the first bad signature, so the rest are moot
+        if (failed.load(std::memory_order_relaxed))
+          return;
+        if (!mg_checks[i]())
+        {
+          results[i] = false;
+          failed = true;
+        }
+      }, tools::threadpool::PRIORITY_HIGH);
+    }
+    waiter.wait();
+    TIME_MEASURE_FINISH(cc);
+    t_checktx += cc;
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+      if (!results[i])
+      {
+        MERROR_VER("Block with id: " << id  << " has at least one transaction (id: " << bl.tx_hashes[mg_check_tx_indices[i]] << ") with wrong inputs.");
+        add_block_as_invalid(bl, id);
+        MERROR_VER("Block with id " << id << " added as invalid because of wrong inputs in transactions");
+        bvc.m_verifivation_failed = true;
+        return_tx_to_pool(txs);
+        goto leave;
+      }
+    }
+  }
+
   m_blocks_txs_check.clear();
 
   TIME_MEASURE_START(vmt);
@@ -4428,6 +4554,7 @@ leave:
 
   bvc.m_added_to_main_chain = true;
   ++m_sync_counter;
+  notify_ntz_event(true, false);
 
   // appears to be a NOP *and* is called elsewhere.  wat?
   m_tx_pool.on_blockchain_inc(new_height, id);
@@ -4538,25 +4665,6 @@ bool Blockchain::update_checkpoints(const std::string& file_path)
 
   return true;
 }
-//------------------------------------------------------------------
-void Blockchain::block_longhash_worker(uint64_t height, const std::vector<block> &blocks, std::unordered_map<crypto::hash, crypto::hash> &map) const
-{
-  TIME_MEASURE_START(t);
-  slow_hash_allocate_state();
-
-  for (const auto & block : blocks)
-  {
-    if (m_cancel)
-       break;
-    crypto::hash id = get_block_hash(block);
-    crypto::hash pow = get_block_longhash(block, height++);
-    map.emplace(id, pow);
-  }
-
-  slow_hash_free_state();
-  TIME_MEASURE_FINISH(t);
-}
-
 //------------------------------------------------------------------
 bool Blockchain::cleanup_handle_incoming_blocks(bool force_sync)
 {
@@ -4738,7 +4846,7 @@ uint64_t Blockchain::prevalidate_block_hashes(uint64_t height, const std::list<c
 
 //------------------------------------------------------------------
 // ND: Speedups:
-// 1. Thread long_hash computations if possible (m_max_prepare_blocks_threads = nthreads, default = 4)
+// 1. Thread long_hash computations if possible (see pow_verifier, default = one thread per core)
 // 2. Group all amounts (from txs) and related absolute offsets and form a table of tx_prefix_hash
 //    vs [k_image, output_keys] (m_scan_table). This is faster because it takes advantage of bulk queries
 //    and is threaded if possible. The table (m_scan_table) will be used later when querying output
@@ -4792,95 +4900,51 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::list<block_complete_e
 
   bool blocks_exist = false;
   tools::threadpool& tpool = tools::threadpool::getInstance();
-  uint64_t threads = tpool.get_max_concurrency();
+  uint64_t threads = m_pow_verifier.get_max_threads();
 
-  if (blocks_entry.size() > 1 && threads > 1 && m_max_prepare_blocks_threads > 1)
+  if (blocks_entry.size() > 1 && threads > 1)
   {
-    // limit threads, default limit = 4
-    if(threads > m_max_prepare_blocks_threads)
-      threads = m_max_prepare_blocks_threads;
-
     uint64_t height = m_db->height();
-    int batches = blocks_entry.size() / threads;
-    int extra = blocks_entry.size() % threads;
-    MDEBUG("block_batches: " << batches);
-    std::vector<std::unordered_map<crypto::hash, crypto::hash>> maps(threads);
-    std::vector < std::vector < block >> blocks(threads);
-    auto it = blocks_entry.begin();
-
-    for (uint64_t i = 0; i < threads; i++)
-    {
-      for (int j = 0; j < batches; j++)
-      {
-        block block;
-
-        if (!parse_and_validate_block_from_blob(it->block, block))
-        {
-          std::advance(it, 1);
-          continue;
-        }
-
-        // check first block and skip all blocks if its not chained properly
-        if (i == 0 && j == 0)
-        {
-          crypto::hash tophash = m_db->top_block_hash();
-          if (block.prev_id != tophash)
-          {
-            MDEBUG("Skipping prepare blocks. New blocks don't belong to chain.");
-            return true;
-          }
-        }
-        if (have_block(get_block_hash(block)))
-        {
-          blocks_exist = true;
-          break;
-        }
-
-        blocks[i].push_back(block);
-        std::advance(it, 1);
-      }
-    }
+    std::vector<block> blocks;
+    blocks.reserve(blocks_entry.size());
 
-    for (int i = 0; i < extra && !blocks_exist; i++)
+    // hashes are computed for a consecutive run starting at the chain tip; the
+    // first block that does not parse ends the run and anything after it is
+    // hashed when it is handled
+    for (const auto &entry : blocks_entry)
     {
       block block;
+      if (!parse_and_validate_block_from_blob(entry.block, block))
+        break;
 
-      if (!parse_and_validate_block_from_blob(it->block, block))
+      // check first block and skip all blocks if its not chained properly
+      if (blocks.empty())
       {
-        std::advance(it, 1);
-        continue;
+        crypto::hash tophash = m_db->top_block_hash();
+        if (block.prev_id != tophash)
+        {
+          MDEBUG("Skipping prepare blocks. New blocks don't belong to chain.");
+          return true;
+        }
       }
-
       if (have_block(get_block_hash(block)))
       {
         blocks_exist = true;
         break;
       }
 
-      blocks[i].push_back(block);
-      std::advance(it, 1);
+      blocks.push_back(std::move(block));
     }
 
     if (!blocks_exist)
     {
       m_blocks_longhash_table.clear();
-      uint64_t thread_height = height;
-      tools::threadpool::waiter waiter;
-      for (uint64_t i = 0; i < threads; i++)
-      {
-        tpool.submit(&waiter, boost::bind(&Blockchain::block_longhash_worker, this, thread_height, std::cref(blocks[i]), std::ref(maps[i])));
-        thread_height += blocks[i].size();
-      }
-
-      waiter.wait();
-
-      if (m_cancel)
-         return false;
+      std::vector<crypto::hash> pow;
+      if (!m_pow_verifier.compute(height, blocks, pow, m_cancel))
+        return false;
 
-      for (const auto & map : maps)
-      {
-        m_blocks_longhash_table.insert(map.begin(), map.end());
-      }
+      for (size_t i = 0; i < blocks.size(); ++i)
+        m_blocks_longhash_table.emplace(get_block_hash(blocks[i]), pow[i]);
     }
   }
 
@@ -4903,7 +4967,11 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::list<block_complete_e
   m_fake_pow_calc_time = prepare / blocks_entry.size();
 
   if (blocks_entry.size() > 1 && threads > 1 && m_show_time_stats)
-    MDEBUG("Prepare blocks took: " << prepare << " ms");
+  {
+    const pow_verifier_stats stats = m_pow_verifier.get_stats();
+    MDEBUG("Prepare blocks took: " << prepare << " ms, PoW: " << stats.hashes << " hashes in "
+        << stats.wall_ms << " ms over " << stats.batches << " batches, last on " << stats.threads << " threads");
+  }
 
   TIME_MEASURE_START(scantable);
 
@@ -5007,7 +5075,7 @@ bool Blockchain::prepare_handle_incoming_blocks(const std::list<block_complete_e
     for (size_t i = 0; i < amounts.size(); i++)
     {
       uint64_t amount = amounts[i];
-      tpool.submit(&waiter, boost::bind(&Blockchain::output_scan_worker, this, amount, std::cref(offset_map[amount]), std::ref(tx_map[amount]), std::ref(transactions[i])));
+      tpool.submit(&waiter, boost::bind(&Blockchain::output_scan_worker, this, amount, std::cref(offset_map[amount]), std::ref(tx_map[amount]), std::ref(transactions[i])), tools::threadpool::PRIORITY_HIGH);
     }
     waiter.wait();
   }
@@ -5129,16 +5197,21 @@ bool Blockchain::for_all_ntzpool_txes(std::function<bool(const crypto::hash&, cr
 void Blockchain::add_ntzpool_tx(transaction &tx, cryptonote::blobdata const& ptx_blob, crypto::hash const& ptx_hash, const ntzpool_tx_meta_t &meta)
 {
   m_db->add_ntzpool_tx(tx, ptx_blob, ptx_hash, meta);
+  notify_ntz_event(false, true);
 }
 
 void Blockchain::update_ntzpool_tx(const crypto::hash &txid, const ntzpool_tx_meta_t &meta)
 {
   m_db->update_ntzpool_tx(txid, meta);
+  notify_ntz_event(false, true);
 }
 
 bool Blockchain::remove_ntzpool_tx(const crypto::hash &txid, crypto::hash const& ptx_hash)
 {
-  return m_db->remove_ntzpool_tx(txid, ptx_hash);
+  const bool r = m_db->remove_ntzpool_tx(txid, ptx_hash);
+  if (r)
+    notify_ntz_event(false, true);
+  return r;
 }
 
 bool Blockchain::has_ntzpool_tx(const crypto::hash &txid)
@@ -5167,6 +5240,11 @@ uint64_t Blockchain::get_txpool_tx_count(bool include_unrelayed_txes) const
   return m_db->get_txpool_tx_count(include_unrelayed_txes);
 }
 
+pow_verifier_stats Blockchain::get_pow_verifier_stats() const
+{
+  return m_pow_verifier.get_stats();
+}
+//------------------------------------------------------------------
 uint64_t Blockchain::get_ntzpool_tx_count(bool include_unrelayed_txes) const
 {
   return m_db->get_ntzpool_tx_count(include_unrelayed_txes);
@@ -5182,7 +5260,7 @@ void Blockchain::set_user_options(uint64_t maxthreads, uint64_t blocks_per_sync,
   m_db_sync_mode = sync_mode;
   m_fast_sync = fast_sync;
   m_db_blocks_per_sync = blocks_per_sync;
-  m_max_prepare_blocks_threads = maxthreads;
+  m_pow_verifier.set_max_threads(maxthreads);
 }
 
 void Blockchain::safesyncmode(const bool onoff)
@@ -5252,6 +5330,31 @@ std::list<std::pair<Blockchain::block_extended_info,uint64_t>> Blockchain::get_a
 void Blockchain::cancel()
 {
   m_cancel = true;
+  boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+  m_ntz_event_cond.notify_all();
+}
+//------------------------------------------------------------------
+void Blockchain::notify_ntz_event(bool chain_changed, bool ntzpool_changed)
+{
+  boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+  if (chain_changed)
+    ++m_chain_revision;
+  if (ntzpool_changed)
+    ++m_ntzpool_revision;
+  m_ntz_event_cond.notify_all();
+}
+//------------------------------------------------------------------
+bool Blockchain::wait_for_ntz_event(uint64_t known_chain_revision, uint64_t known_ntzpool_revision, uint64_t timeout_ms, uint64_t& chain_revision, uint64_t& ntzpool_revision)
+{
+  LOG_PRINT_L3("Blockchain::" << __func__);
+  boost::unique_lock<boost::mutex> lock(m_ntz_event_lock);
+  const auto changed = [&]() {
+    return m_cancel || m_chain_revision != known_chain_revision || m_ntzpool_revision != known_ntzpool_revision;
+  };
+  const bool r = m_ntz_event_cond.wait_for(lock, boost::chrono::milliseconds(timeout_ms), changed);
+  chain_revision = m_chain_revision;
+  ntzpool_revision = m_ntzpool_revision;
+  return r && !m_cancel;
 }
 
 #if defined(PER_BLOCK_CHECKPOINT)
@@ -38,6 +38,8 @@
 #include <boost/multi_index/global_fun.hpp>
 #include <boost/multi_index/hashed_index.hpp>
 #include <boost/multi_index/member.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 #include <atomic>
 #include <functional>
 #include <unordered_map>
@@ -52,6 +54,7 @@
 #include "rpc/core_rpc_server_commands_defs.h"
 #include "cryptonote_basic/difficulty.h"
 #include "cryptonote_tx_utils.h"
+#include "pow_verifier.h"
 #include "cryptonote_basic/verification_context.h"
 #include "crypto/hash.h"
 #include "checkpoints/checkpoints.h"
@@ -146,11 +149,66 @@ namespace cryptonote
      */
     bool deinit();
 
+    uint64_t get_ntz_count() const;
     uint64_t get_ntz_count(std::vector<std::pair<crypto::hash,uint64_t>>& ret) const;
-    crypto::hash get_ntz_merkle(std::vector<std::pair<crypto::hash,uint64_t>> const& notarizations);
+
+    /**
+     * @brief a chain notarization with what the RPC needs to describe it
+     */
+    struct ntz_tx_entry
+    {
+      crypto::hash tx_hash;
+      uint64_t height;
+      uint64_t timestamp;
+      cryptonote::blobdata blob;
+      std::vector<uint64_t> output_indices;
+    };
+
+    /**
+     * @brief fetches a page of chain notarizations by notarized height
+     *
+     * Walks the notarization index over [start_height, end_height] and,
+     * inside one read transaction, collects the blob, block timestamp and
+     * output indices of each notarization whose hash is in filter, or of
+     * every one if filter is empty.  A page ends after max_count entries
+     * but never splits the notarizations of a single height.
+     *
+     * @param start_height the lowest notarized height to return
+     * @param end_height the highest notarized height to return
+     * @param max_count the page size, or 0 for no limit
+     * @param filter the tx hashes to return, or empty for all
+     * @param ntzs return-by-reference the notarizations found
+     * @param more return-by-reference whether the range holds further notarizations
+     * @param next_height return-by-reference where the next page starts, if more
+     *
+     * @return false on a DB error, otherwise true
+     */
+    bool get_ntz_txs_range(uint64_t start_height, uint64_t end_height, size_t max_count, const std::unordered_set<crypto::hash>& filter, std::vector<ntz_tx_entry>& ntzs, bool& more, uint64_t& next_height) const;
     bool is_block_notarized(cryptonote::block const& b);
     uint64_t get_notarized_height(crypto::hash& ntz_hash) const;
     uint64_t get_notarization_wait() const;
+
+    /**
+     * @brief computes the Merkle-of-Merkles over a window of blocks
+     *
+     * @param height the height of the top block of the window
+     * @param depth the number of blocks in the window
+     *
+     * @return the MoM, or null_hash if the window is not in the chain
+     */
+    crypto::hash get_MoM(uint64_t height, uint64_t depth) const;
+
+    /**
+     * @brief finds the first notarization covering a height
+     *
+     * @param height the height to look up
+     * @param ntz_height return-by-reference the notarized height at or above height
+     * @param prev_height return-by-reference the notarized height before it, or 0
+     * @param ntz_txid return-by-reference the hash of the notarization tx
+     *
+     * @return false if height is above the latest notarized height, otherwise true
+     */
+    bool get_notarization_covering(uint64_t height, uint64_t& ntz_height, uint64_t& prev_height, crypto::hash& ntz_txid) const;
     void komodo_update();
     void update_raw_src_tx(std::string const& raw_src_tx);
     void fetch_raw_src_tx(std::string& raw_src_tx);
@@ -579,6 +637,20 @@ namespace cryptonote
      */
     bool get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs) const;
 
+    /**
+     * @brief gets the global indices for outputs from several transactions
+     *
+     * This function is a mirror of
+     * get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs),
+     * but looks all the transactions up in one db batch.
+     *
+     * @param tx_ids the hashes of the transactions to fetch indices for
+     * @param indexs return-by-reference the global indices for each transaction's outputs, in the same order
+     *
+     * @return false if any of the transactions does not exist, otherwise true
+     */
+    bool get_tx_outputs_gindexs(const std::vector<crypto::hash>& tx_ids, std::vector<std::vector<uint64_t>>& indexs) const;
+
     /**
      * @brief stores the blockchain
      *
@@ -780,7 +852,7 @@ namespace cryptonote
     /**
      * @brief sets various performance options
      *
-     * @param maxthreads max number of threads when preparing blocks for addition
+     * @param maxthreads max number of threads when preparing blocks for addition, 0 for one per core
      * @param blocks_per_sync number of blocks to cache before syncing to database
      * @param sync_mode the ::blockchain_db_sync_mode to use
      * @param fast_sync sync using built-in block hashes as trusted
@@ -788,6 +860,13 @@ namespace cryptonote
     void set_user_options(uint64_t maxthreads, uint64_t blocks_per_sync,
         blockchain_db_sync_mode sync_mode, bool fast_sync);
 
+    /**
+     * @brief gets the running totals of the batched PoW computation
+     *
+     * @return the pow_verifier counters
+     */
+    pow_verifier_stats get_pow_verifier_stats() const;
+
     /**
      * @brief Put DB in safe sync mode
      */
@@ -970,16 +1049,6 @@ namespace cryptonote
         std::vector<output_data_t> &outputs, std::unordered_map<crypto::hash,
         cryptonote::transaction> &txs) const;
 
-    /**
-     * @brief computes the "short" and "long" hashes for a set of blocks
-     *
-     * @param height the height of the first block
-     * @param blocks the blocks to be hashed
-     * @param map return-by-reference the hashes for each block
-     */
-    void block_longhash_worker(uint64_t height, const std::vector<block> &blocks,
-        std::unordered_map<crypto::hash, crypto::hash> &map) const;
-
     /**
      * @brief returns a set of known alternate chains
      *
@@ -1048,6 +1117,24 @@ namespace cryptonote
 
     void flush_ntzpool();
 
+    /**
+     * @brief blocks until the main chain or the ntzpool changes
+     *
+     * Every block added to or popped from the main chain bumps the chain
+     * revision, and every ntzpool insert, update or removal bumps the
+     * ntzpool revision.  Returns as soon as either one differs from what
+     * the caller last saw, or once the timeout expires.
+     *
+     * @param known_chain_revision the chain revision the caller last saw
+     * @param known_ntzpool_revision the ntzpool revision the caller last saw
+     * @param timeout_ms the maximum time to wait, in milliseconds
+     * @param chain_revision return-by-reference the current chain revision
+     * @param ntzpool_revision return-by-reference the current ntzpool revision
+     *
+     * @return true if either revision changed, false on timeout or cancel
+     */
+    bool wait_for_ntz_event(uint64_t known_chain_revision, uint64_t known_ntzpool_revision, uint64_t timeout_ms, uint64_t& chain_revision, uint64_t& ntzpool_revision);
+
   private:
 
     // TODO: evaluate whether or not each of these typedefs are left over from blockchain_storage
@@ -1092,7 +1179,7 @@ namespace cryptonote
     bool m_show_time_stats;
     bool m_db_default_sync;
     uint64_t m_db_blocks_per_sync;
-    uint64_t m_max_prepare_blocks_threads;
+    pow_verifier m_pow_verifier;
     uint64_t m_fake_pow_calc_time;
     uint64_t m_fake_scan_time;
     uint64_t m_sync_counter;
@@ -1120,6 +1207,20 @@ namespace cryptonote
 
     std::atomic<bool> m_cancel;
 
+    // revisions handed out by wait_for_ntz_event(), see notify_ntz_event()
+    boost::mutex m_ntz_event_lock;
+    boost::condition_variable m_ntz_event_cond;
+    uint64_t m_chain_revision;
+    uint64_t m_ntzpool_revision;
+
+    /**
+     * @brief bumps the chain and/or ntzpool revision and wakes any waiters
+     *
+     * @param chain_changed whether a block was added to or popped from the main chain
+     * @param ntzpool_changed whether the ntzpool was modified
+     */
+    void notify_ntz_event(bool chain_changed, bool ntzpool_changed);
+
     /**
      * @brief collects the keys for all outputs being "spent" as an input
      *
@@ -1176,15 +1277,18 @@ namespace cryptonote
      * of the most recent block which contains an output used in any input set
      *
      * Currently this function calls ring signature validation for each
-     * transaction.
+     * transaction, unless mg_checks is not NULL, in which case the MG
+     * signature checks are appended to it for the caller to run, and tx must
+     * outlive them.
      *
      * @param tx the transaction to validate
      * @param tvc returned information about tx verification
      * @param pmax_related_block_height return-by-pointer the height of the most recent block in the input set
+     * @param mg_checks return-by-pointer the MG signature checks left to run
      *
      * @return false if any validation step fails, otherwise true
      */
-    bool check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height = NULL);
+    bool check_tx_inputs(transaction& tx, tx_verification_context &tvc, uint64_t* pmax_used_block_height = NULL, std::vector<std::function<bool()>>* mg_checks = NULL);
 
     /**
      * @brief performs a blockchain reorganization according to the longest chain rule
@@ -1320,8 +1424,9 @@ namespace cryptonote
      * @param outs return-by-reference the set the output is to be added to
      * @param amount the output amount (0 for rct inputs)
      * @param i the rct output index
+     * @param data the output's data, as read from the db
      */
-    void add_out_to_get_rct_random_outs(std::list<COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::out_entry>& outs, uint64_t amount, size_t i) const;
+    void add_out_to_get_rct_random_outs(std::list<COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS::out_entry>& outs, uint64_t amount, size_t i, const output_data_t& data) const;
 
     /**
      * @brief checks if a transaction is unlocked (its outputs spendable)
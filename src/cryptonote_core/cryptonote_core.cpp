@@ -115,8 +115,8 @@ namespace cryptonote
   };
   static const command_line::arg_descriptor<uint64_t> arg_prep_blocks_threads = {
     "prep-blocks-threads"
-  , "Max number of threads to use when preparing block hashes in groups."
-  , 4
+  , "Max number of threads to use when preparing block hashes in groups, 0 for one per core."
+  , 0
   };
   static const command_line::arg_descriptor<uint64_t> arg_show_time_stats  = {
     "show-time-stats"
@@ -628,20 +628,47 @@ namespace cryptonote
     {
       LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to check tx " << tx_hash << " semantic, rejected");
       tvc.m_verifivation_failed = true;
-      bad_semantics_txes_lock.lock();
-      bad_semantics_txes[0].insert(tx_hash);
-      if (bad_semantics_txes[0].size() >= BAD_SEMANTICS_TXES_MAX_SIZE)
-      {
-        std::swap(bad_semantics_txes[0], bad_semantics_txes[1]);
-        bad_semantics_txes[0].clear();
-      }
-      bad_semantics_txes_lock.unlock();
+      add_bad_semantics_tx(tx_hash);
       return false;
     }
 
     return true;
   }
   //-----------------------------------------------------------------------------------------------
+  void core::add_bad_semantics_tx(const crypto::hash& tx_hash)
+  {
+    bad_semantics_txes_lock.lock();
+    bad_semantics_txes[0].insert(tx_hash);
+    if (bad_semantics_txes[0].size() >= BAD_SEMANTICS_TXES_MAX_SIZE)
+    {
+      std::swap(bad_semantics_txes[0], bad_semantics_txes[1]);
+      bad_semantics_txes[0].clear();
+    }
+    bad_semantics_txes_lock.unlock();
+  }
+  //-----------------------------------------------------------------------------------------------
+  std::vector<bool> core::verify_bulletproofs(const std::vector<const transaction*>& txs) const
+  {
+    std::vector<bool> valid(txs.size(), true);
+    std::vector<const rct::Bulletproof*> proofs;
+    for (const transaction* tx: txs)
+      for (const rct::Bulletproof& proof: tx->rct_signatures.p.bulletproofs)
+        proofs.push_back(&proof);
+    if (proofs.empty() || rct::verBulletproof(proofs))
+      return valid;
+
+    for (size_t i = 0; i < txs.size(); ++i)
+    {
+      if (txs[i]->rct_signatures.p.bulletproofs.empty())
+        continue;
+      proofs.clear();
+      for (const rct::Bulletproof& proof: txs[i]->rct_signatures.p.bulletproofs)
+        proofs.push_back(&proof);
+      valid[i] = rct::verBulletproof(proofs);
+    }
+    return valid;
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::handle_incoming_ntz_sig_pre(const blobdata& tx_blob, ntz_req_verification_context& tvc, cryptonote::transaction &tx, crypto::hash&tx_hash, crypto::hash &tx_prefixt_hash, bool keeped_by_block, bool relayed, bool do_not_relay, int const& sig_count, cryptonote_connection_context const& context)
   {
     // TODO: this is a placeholder for verification
@@ -755,7 +782,7 @@ namespace cryptonote
           MERROR_VER("Exception in handle_incoming_tx_pre: " << e.what());
           results[i].res = false;
         }
-      });
+      }, tools::threadpool::PRIORITY_HIGH);
     }
     waiter.wait();
     it = tx_blobs.begin();
@@ -785,11 +812,31 @@ namespace cryptonote
             MERROR_VER("Exception in handle_incoming_tx_post: " << e.what());
             results[i].res = false;
           }
-        });
+        }, tools::threadpool::PRIORITY_HIGH);
       }
     }
     waiter.wait();
 
+    // a block's worth of range proofs is far cheaper to verify in one go
+    std::vector<const transaction*> bp_txs;
+    std::vector<size_t> bp_indices;
+    for (size_t i = 0; i < tx_blobs.size(); i++) {
+      if (results[i].res && !already_have[i] && !results[i].tx.rct_signatures.p.bulletproofs.empty()) {
+        bp_txs.push_back(&results[i].tx);
+        bp_indices.push_back(i);
+      }
+    }
+    const std::vector<bool> bp_valid = verify_bulletproofs(bp_txs);
+    for (size_t n = 0; n < bp_indices.size(); n++) {
+      if (bp_valid[n])
+        continue;
+      const size_t i = bp_indices[n];
+      LOG_PRINT_L1("WRONG TRANSACTION BLOB, Failed to check tx " << results[i].hash << " bulletproofs, rejected");
+      tvc[i].m_verifivation_failed = true;
+      results[i].res = false;
+      add_bad_semantics_tx(results[i].hash);
+    }
+
     bool ok = true;
     it = tx_blobs.begin();
     for (size_t i = 0; i < tx_blobs.size(); i++, ++it) {
@@ -965,7 +1012,7 @@ namespace cryptonote
           return false;
         case rct::RCTTypeSimple:
         case rct::RCTTypeSimpleBulletproof:
-          if (!rct::verRctSimple(rv, true))
+          if (!rct::verRctSimple(rv, true, false))
           {
             MERROR_VER("rct signature semantics check failed");
             return false;
@@ -973,7 +1020,7 @@ namespace cryptonote
           break;
         case rct::RCTTypeFull:
         case rct::RCTTypeFullBulletproof:
-          if (!rct::verRct(rv, true))
+          if (!rct::verRct(rv, true, false))
           {
             MERROR_VER("rct signature semantics check failed");
             return false;
@@ -1257,19 +1304,8 @@ namespace cryptonote
           return false;
         }
         r.ptx_string = each.ptx_blob;
-        std::string signers_index;
-        const int neg = -1;
-        for (const auto& sig : each.signers_index) {
-          std::string tmp;
-          if ((sig < 10) && (sig > neg)) {
-            tmp = "0" + std::to_string(sig);
-          } else {
-            tmp = std::to_string(sig);
-          }
-          signers_index += tmp;
-        }
-
-        r.signers_index = signers_index;
+        r.signers_index = ntz_signers_to_string(each.signers_index);
+        r.signers_mask = each.signers_mask;
         r.ptx_hash = ptx_hash;
         if (get_protocol()->relay_request_ntz_sig(r, fake_context)) {
           std::string logging = epee::string_tools::pod_to_hex(ntz_hash);
@@ -1354,6 +1390,11 @@ namespace cryptonote
     return m_blockchain_storage.get_tx_outputs_gindexs(tx_id, indexs);
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::get_tx_outputs_gindexs(const std::vector<crypto::hash>& tx_ids, std::vector<std::vector<uint64_t>>& indexs) const
+  {
+    return m_blockchain_storage.get_tx_outputs_gindexs(tx_ids, indexs);
+  }
+  //-----------------------------------------------------------------------------------------------
   void core::pause_mine()
   {
     m_miner.pause();
@@ -1587,6 +1628,11 @@ namespace cryptonote
     return true;
   }
   //-----------------------------------------------------------------------------------------------
+  uint64_t core::get_ntzpool_signers(size_t& count, bool include_sensitive_data) const
+  {
+    return m_mempool.get_ntzpool_signers(count, include_sensitive_data);
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::flush_ntzpool_txs(std::list<crypto::hash> const& hash_list)
   {
     return m_blockchain_storage.flush_ntz_txes_from_pool(hash_list);
@@ -1637,6 +1683,32 @@ namespace cryptonote
     return m_mempool.have_tx(id);
   }
   //-----------------------------------------------------------------------------------------------
+  bool core::ntzpool_has_tx(const crypto::hash &id) const
+  {
+    ntzpool_tx_meta_t meta;
+    return m_blockchain_storage.get_ntzpool_tx_meta(id, meta);
+  }
+  //-----------------------------------------------------------------------------------------------
+  bool core::get_ntz_sig_request(const crypto::hash &id, NOTIFY_REQUEST_NTZ_SIG::request& r) const
+  {
+    ntzpool_tx_meta_t meta;
+    if (!m_blockchain_storage.get_ntzpool_tx_meta(id, meta))
+      return false;
+    if (!m_blockchain_storage.get_ntzpool_tx_blob(id, r.tx_blob, r.ptx_string, meta.ptx_hash))
+      return false;
+    // the prior hashes and payment id are not kept in the pool, same as
+    // for relay_ntzpool_transactions()
+    r.tx_hash = id;
+    r.ptx_hash = meta.ptx_hash;
+    r.prior_tx_hash = crypto::null_hash;
+    r.prior_ptx_hash = crypto::null_hash;
+    r.sig_count = meta.sig_count;
+    const std::vector<int> signers_index(meta.signers_index, meta.signers_index + DPOW_SIG_COUNT);
+    r.signers_index = ntz_signers_to_string(signers_index);
+    r.signers_mask = ntz_signers_mask(signers_index);
+    return true;
+  }
+  //-----------------------------------------------------------------------------------------------
   bool core::get_pool_transactions_and_spent_keys_info(std::vector<tx_info>& tx_infos, std::vector<spent_key_image_info>& key_image_infos, bool include_sensitive_data) const
   {
     return m_mempool.get_transactions_and_spent_keys_info(tx_infos, key_image_infos, include_sensitive_data);
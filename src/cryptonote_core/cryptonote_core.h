@@ -440,6 +440,27 @@ namespace cryptonote
       */
      bool pool_has_tx(const crypto::hash &txid) const;
 
+     /**
+      * @brief check if the ntzpool holds a pending notarization tx
+      *
+      * @param txid the tx hash to look for
+      *
+      * @return true if the tx is in the ntzpool, otherwise false
+      */
+     bool ntzpool_has_tx(const crypto::hash &txid) const;
+
+     /**
+      * @brief rebuild the full NOTIFY_REQUEST_NTZ_SIG for an ntzpool tx
+      *
+      * Used to answer peers that were only sent a NOTIFY_NTZ_SIG_ANNOUNCE.
+      *
+      * @param txid the tx hash to look for
+      * @param r return-by-reference the request, with blobs and signers
+      *
+      * @return false if the tx is not in the ntzpool, otherwise true
+      */
+     bool get_ntz_sig_request(const crypto::hash &txid, NOTIFY_REQUEST_NTZ_SIG::request& r) const;
+
      /**
       * @copydoc tx_memory_pool::get_transactions
       * @param include_unrelayed_txes include unrelayed txes in result
@@ -563,6 +584,13 @@ namespace cryptonote
 
      bool get_ntzpool_tx_count(size_t& count, bool include_sensitive_data) const;
 
+     /**
+      * @copydoc tx_memory_pool::get_ntzpool_signers
+      *
+      * @note see tx_memory_pool::get_ntzpool_signers
+      */
+     uint64_t get_ntzpool_signers(size_t& count, bool include_sensitive_data) const;
+
      bool flush_ntzpool_txs(std::list<crypto::hash> const& hash_list);
      void flush_ntzpool();
 
@@ -617,6 +645,13 @@ namespace cryptonote
       */
      bool get_tx_outputs_gindexs(const crypto::hash& tx_id, std::vector<uint64_t>& indexs) const;
 
+     /**
+      * @copydoc Blockchain::get_tx_outputs_gindexs(const std::vector<crypto::hash>&, std::vector<std::vector<uint64_t>>&) const
+      *
+      * @note see Blockchain::get_tx_outputs_gindexs(const std::vector<crypto::hash>&, std::vector<std::vector<uint64_t>>&) const
+      */
+     bool get_tx_outputs_gindexs(const std::vector<crypto::hash>& tx_ids, std::vector<std::vector<uint64_t>>& indexs) const;
+
      /**
       * @copydoc Blockchain::get_tail_id
       *
@@ -965,7 +1000,9 @@ namespace cryptonote
       *                   input and output total amounts don't overflow,
       *                   output amount <= input amount,
       *                   tx not too large,
-      *                   each input has a different key image.
+      *                   each input has a different key image,
+      *                   rct signature semantics but for bulletproofs,
+      *                   which the caller verifies with verify_bulletproofs.
       *
       * @param tx the transaction to check
       * @param keeped_by_block if the transaction has been in a block
@@ -974,6 +1011,25 @@ namespace cryptonote
       */
      bool check_tx_semantic(const transaction& tx, bool keeped_by_block) const;
 
+     /**
+      * @brief verifies the bulletproofs of a set of transactions
+      *
+      * All proofs are checked as one batch first, and only if that fails
+      * is each transaction checked on its own to find the bad ones.
+      *
+      * @param txs the transactions to check, with outPk already resolved
+      *
+      * @return whether each transaction's bulletproofs are valid
+      */
+     std::vector<bool> verify_bulletproofs(const std::vector<const transaction*>& txs) const;
+
+     /**
+      * @brief remembers a transaction which failed semantics checks
+      *
+      * @param tx_hash the hash of the transaction
+      */
+     void add_bad_semantics_tx(const crypto::hash& tx_hash);
+
      bool handle_incoming_tx_pre(const blobdata& tx_blob, tx_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash, crypto::hash &tx_prefixt_hash, bool keeped_by_block, bool relayed, bool do_not_relay);
      bool handle_incoming_tx_post(const blobdata& tx_blob, tx_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash, crypto::hash &tx_prefixt_hash, bool keeped_by_block, bool relayed, bool do_not_relay);
      bool handle_incoming_ntz_sig_post(const blobdata& tx_blob, ntz_req_verification_context& tvc, cryptonote::transaction &tx, crypto::hash &tx_hash, crypto::hash &tx_prefixt_hash, bool keeped_by_block, bool relayed, bool do_not_relay, const int& sig_count, cryptonote::blobdata const& ptx_string);
@@ -0,0 +1,121 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <boost/bind.hpp>
+
+#include "misc_log_ex.h"
+#include "common/threadpool.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "profile_tools.h"
+#include "pow_verifier.h"
+
+#undef MONERO_DEFAULT_LOG_CATEGORY
+#define MONERO_DEFAULT_LOG_CATEGORY "blockchain"
+
+extern "C" void slow_hash_allocate_state();
+
+namespace cryptonote
+{
+  //---------------------------------------------------------------
+  pow_verifier::pow_verifier()
+    : m_max_threads(0), m_batches(0), m_hashes(0), m_busy_ms(0), m_wall_ms(0), m_last_threads(0)
+  {
+  }
+  //---------------------------------------------------------------
+  void pow_verifier::set_max_threads(uint64_t max_threads)
+  {
+    m_max_threads = max_threads;
+  }
+  //---------------------------------------------------------------
+  uint64_t pow_verifier::get_max_threads() const
+  {
+    uint64_t threads = tools::threadpool::getInstance().get_max_concurrency();
+    const uint64_t max_threads = m_max_threads;
+    if (max_threads > 0 && threads > max_threads)
+      threads = max_threads;
+    return std::max<uint64_t>(threads, 1);
+  }
+  //---------------------------------------------------------------
+  void pow_verifier::worker(uint64_t height, const std::vector<block>& blocks, std::vector<crypto::hash>& pow, std::atomic<size_t>& next, const std::atomic<bool>& cancel)
+  {
+    TIME_MEASURE_START(t);
+    // the scratchpad is thread-local and deliberately not freed here, so the
+    // next batch landing on this pool thread reuses it
+    slow_hash_allocate_state();
+
+    uint64_t hashes = 0;
+    for (size_t i = next++; i < blocks.size() && !cancel; i = next++)
+    {
+      pow[i] = get_block_longhash(blocks[i], height + i);
+      ++hashes;
+    }
+
+    TIME_MEASURE_FINISH(t);
+    m_hashes += hashes;
+    m_busy_ms += t;
+  }
+  //---------------------------------------------------------------
+  bool pow_verifier::compute(uint64_t height, const std::vector<block>& blocks, std::vector<crypto::hash>& pow, const std::atomic<bool>& cancel)
+  {
+    pow.assign(blocks.size(), crypto::null_hash);
+    if (blocks.empty())
+      return true;
+
+    TIME_MEASURE_START(t);
+    const uint64_t threads = std::min<uint64_t>(get_max_threads(), blocks.size());
+    std::atomic<size_t> next(0);
+
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    tools::threadpool::waiter waiter;
+    for (uint64_t i = 0; i < threads; ++i)
+      tpool.submit(&waiter, boost::bind(&pow_verifier::worker, this, height, std::cref(blocks), std::ref(pow), std::ref(next), std::cref(cancel)), tools::threadpool::PRIORITY_HIGH);
+    waiter.wait();
+
+    TIME_MEASURE_FINISH(t);
+    ++m_batches;
+    m_wall_ms += t;
+    m_last_threads = threads;
+
+    if (cancel)
+      return false;
+
+    MDEBUG("Computed " << blocks.size() << " block hashes on " << threads << " threads in " << t << " ms");
+    return true;
+  }
+  //---------------------------------------------------------------
+  pow_verifier_stats pow_verifier::get_stats() const
+  {
+    pow_verifier_stats stats;
+    stats.batches = m_batches;
+    stats.hashes = m_hashes;
+    stats.busy_ms = m_busy_ms;
+    stats.wall_ms = m_wall_ms;
+    stats.threads = m_last_threads;
+    return stats;
+  }
+}
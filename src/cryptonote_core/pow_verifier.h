@@ -0,0 +1,109 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "crypto/hash.h"
+
+namespace cryptonote
+{
+  /**
+   * @brief running totals kept by the pow_verifier
+   */
+  struct pow_verifier_stats
+  {
+    uint64_t batches;   //!< number of batches hashed
+    uint64_t hashes;    //!< number of long hashes computed
+    uint64_t busy_ms;   //!< time spent hashing, summed over all worker threads
+    uint64_t wall_ms;   //!< time from submitting a batch until all its hashes were done
+    uint64_t threads;   //!< worker threads used for the most recent batch
+  };
+
+  /**
+   * @brief computes block long hashes for a run of consecutive blocks on the
+   * shared threadpool
+   *
+   * Workers claim blocks one at a time from a shared index rather than taking
+   * a fixed slice, so a thread that draws cheap iteration counts keeps pulling
+   * work instead of idling while another grinds through expensive ones.  Each
+   * worker keeps its cn_slow_hash scratchpad (huge page backed where the OS
+   * allows it) for as long as the thread lives, so later batches skip the
+   * 2MB allocation.
+   */
+  class pow_verifier
+  {
+  public:
+    pow_verifier();
+
+    /**
+     * @brief sets the number of threads used per batch
+     *
+     * @param max_threads thread limit, 0 for one per available core
+     */
+    void set_max_threads(uint64_t max_threads);
+
+    /**
+     * @brief gets the number of threads a batch will be spread over
+     *
+     * @return the configured limit, capped at the threadpool's concurrency
+     */
+    uint64_t get_max_threads() const;
+
+    /**
+     * @brief computes the long hash of each block in a consecutive run
+     *
+     * @param height the height of the first block
+     * @param blocks the blocks, in chain order
+     * @param pow return-by-reference the long hash for each block, same order as blocks
+     * @param cancel set by the caller to abandon the batch
+     *
+     * @return true if every hash was computed, false if cancelled
+     */
+    bool compute(uint64_t height, const std::vector<block>& blocks, std::vector<crypto::hash>& pow, const std::atomic<bool>& cancel);
+
+    /**
+     * @brief gets the running totals
+     *
+     * @return a snapshot of the counters
+     */
+    pow_verifier_stats get_stats() const;
+
+  private:
+    void worker(uint64_t height, const std::vector<block>& blocks, std::vector<crypto::hash>& pow, std::atomic<size_t>& next, const std::atomic<bool>& cancel);
+
+    std::atomic<uint64_t> m_max_threads;
+    std::atomic<uint64_t> m_batches;
+    std::atomic<uint64_t> m_hashes;
+    std::atomic<uint64_t> m_busy_ms;
+    std::atomic<uint64_t> m_wall_ms;
+    std::atomic<uint64_t> m_last_threads;
+  };
+}
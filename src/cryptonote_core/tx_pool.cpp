@@ -89,6 +89,13 @@ namespace cryptonote
       return get_min_block_size(version) - CRYPTONOTE_COINBASE_BLOB_RESERVED_SIZE;
     }
 
+    // entries written before signers_mask existed have it zeroed (it used to
+    // be padding), so rebuild it from the index array for those
+    uint64_t get_signers_mask(const ntzpool_tx_meta_t& meta)
+    {
+      return meta.signers_mask ? meta.signers_mask : ntz_signers_mask(meta.signers_index);
+    }
+
     // This class is meant to create a batch when none currently exists.
     // If a batch exists, it can't be from another thread, since we can
     // only be called with the txpool lock taken, and it is held during
@@ -108,7 +115,7 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   tx_memory_pool::tx_memory_pool(Blockchain& bchs): m_blockchain(bchs), m_txpool_max_size(648000000ULL), m_txpool_size(0)
   {
-
+    m_template.valid = false;
   }
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::add_tx(transaction &tx, /*const crypto::hash& tx_prefix_hash,*/ const crypto::hash &id, size_t blob_size, tx_verification_context& tvc, bool kept_by_block, bool relayed, bool do_not_relay, uint8_t const& version)
@@ -253,6 +260,7 @@ namespace cryptonote
           if (!insert_key_images(tx, kept_by_block))
             return false;
           m_txs_by_fee_and_receive_time.emplace(std::pair<double, std::time_t>(fee / (double)blob_size, receive_time), id);
+          queue_template_tx(id, tx);
         }
         catch (const std::exception &e)
         {
@@ -296,6 +304,7 @@ namespace cryptonote
         if (!insert_key_images(tx, kept_by_block))
           return false;
         m_txs_by_fee_and_receive_time.emplace(std::pair<double, std::time_t>(fee / (double)blob_size, receive_time), id);
+        queue_template_tx(id, tx);
       }
       catch (const std::exception &e)
       {
@@ -436,6 +445,7 @@ namespace cryptonote
         }
         i++;
       }
+      meta.signers_mask = ntz_signers_mask(signers_index);
       memset(meta.padding, 0, sizeof(meta.padding));
 
         try
@@ -534,6 +544,7 @@ namespace cryptonote
         remove_transaction_keyimages(tx);
         MINFO("Pruned tx " << txid << " from txpool: size: " << it->first.second << ", fee/byte: " << it->first.first);
         m_txs_by_fee_and_receive_time.erase(it--);
+        invalidate_block_template();
       }
       catch (const std::exception &e)
       {
@@ -637,10 +648,11 @@ namespace cryptonote
     }
 
     m_txs_by_fee_and_receive_time.erase(sorted_it);
+    invalidate_block_template();
     return true;
   }
   //---------------------------------------------------------------------------------
-  bool tx_memory_pool::take_ntzpool_tx(const crypto::hash &id, transaction &tx, size_t& blob_size, uint64_t& fee, bool &relayed, bool &do_not_relay, bool &double_spend_seen, uint8_t& sig_count, std::list<int>& signers_index, cryptonote::blobdata& ptx_string, crypto::hash& ptx_hash)
+  bool tx_memory_pool::take_ntzpool_tx(const crypto::hash &id, transaction &tx, size_t& blob_size, uint64_t& fee, bool &relayed, bool &do_not_relay, bool &double_spend_seen, uint8_t& sig_count, uint64_t& signers_mask, cryptonote::blobdata& ptx_string, crypto::hash& ptx_hash)
   {
     CRITICAL_REGION_LOCAL(m_transactions_lock);
     CRITICAL_REGION_LOCAL1(m_blockchain);
@@ -673,9 +685,7 @@ namespace cryptonote
       do_not_relay = meta.do_not_relay;
       double_spend_seen = meta.double_spend_seen;
       sig_count = meta.sig_count;
-      for (int i = 0; i <= (DPOW_SIG_COUNT); i++) {
-        signers_index.push_back(meta.signers_index[i]);
-      }
+      signers_mask = get_signers_mask(meta);
 
       // remove first, in case this throws, so key images aren't removed
       bool r = m_blockchain.remove_ntzpool_tx(id, ptx_hash);
@@ -691,6 +701,7 @@ namespace cryptonote
     }
 
     m_txs_by_fee_and_receive_time.erase(sorted_it);
+    invalidate_block_template();
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -701,11 +712,8 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   sorted_tx_container::iterator tx_memory_pool::find_tx_in_sorted_container(const crypto::hash& id) const
   {
-    return std::find_if( m_txs_by_fee_and_receive_time.begin(), m_txs_by_fee_and_receive_time.end()
-                       , [&](const sorted_tx_container::value_type& a){
-                         return a.second == id;
-                       }
-    );
+    const auto &by_id = m_txs_by_fee_and_receive_time.get<by_txid>();
+    return m_txs_by_fee_and_receive_time.project<by_fee_and_receive_time>(by_id.find(id));
   }
   //---------------------------------------------------------------------------------
   //TODO: investigate whether boolean return is appropriate
@@ -730,6 +738,7 @@ namespace cryptonote
         else
         {
           m_txs_by_fee_and_receive_time.erase(sorted_it);
+          invalidate_block_template();
         }
         m_timed_out_transactions.insert(txid);
         remove.insert(txid);
@@ -752,6 +761,7 @@ namespace cryptonote
         else
         {
           m_txs_by_fee_and_receive_time.erase(sorted_it);
+          invalidate_block_template();
         }
         std::pair<crypto::hash,crypto::hash> hash_pair;
         hash_pair.first = txid;
@@ -963,6 +973,11 @@ namespace cryptonote
     cryptonote::blobdata prior_ptx_blob;
     cryptonote::blobdata ptx_blob;
     ntzpool_tx_meta_t ntz_meta = AUTO_VAL_INIT(ntz_meta);
+    if (!ntz_signers_mask_from_string(signers_index, ntz_meta.signers_mask))
+    {
+      MERROR("Malformed signers_index in req_ntz_sig_inc: " << signers_index);
+      return false;
+    }
     ntzpool_tx_meta_t prior_ntz_meta;
     if (m_blockchain.get_ntzpool_tx_meta(prior_hash, prior_ntz_meta))
     {
@@ -996,8 +1011,6 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   size_t tx_memory_pool::get_ntzpool_transactions_count(bool include_unrelayed_txes) const
   {
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     return m_blockchain.get_ntzpool_tx_count(include_unrelayed_txes);
   }
   //---------------------------------------------------------------------------------
@@ -1018,10 +1031,20 @@ namespace cryptonote
     }, true, include_unrelayed_txes);
   }
   //------------------------------------------------------------------
+  uint64_t tx_memory_pool::get_ntzpool_signers(size_t& count, bool include_unrelayed_txes) const
+  {
+    uint64_t signers_mask = 0;
+    count = 0;
+    m_blockchain.for_all_ntzpool_txes([&signers_mask, &count](const crypto::hash &txid, crypto::hash const& ptx_hash, const ntzpool_tx_meta_t &meta, cryptonote::blobdata const* bd, cryptonote::blobdata const* ptx){
+      signers_mask |= get_signers_mask(meta);
+      ++count;
+      return true;
+    }, false, include_unrelayed_txes);
+    return signers_mask;
+  }
+  //------------------------------------------------------------------
   void tx_memory_pool::get_pending_ntz_pool_transactions(std::list<std::pair<transaction,cryptonote::blobdata>>& txs, bool include_unrelayed_txes) const
   {
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     m_blockchain.for_all_ntzpool_txes([&txs](const crypto::hash &txid, crypto::hash const& ptx_hash, const ntzpool_tx_meta_t &meta, cryptonote::blobdata const* bd, cryptonote::blobdata const* ptx){
       transaction tx;
       if (!bd->empty()) {
@@ -1054,8 +1077,6 @@ namespace cryptonote
   //------------------------------------------------------------------
   void tx_memory_pool::get_pending_ntzpool_transaction_hashes(std::vector<crypto::hash>& txs, bool include_unrelayed_txes) const
   {
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     m_blockchain.for_all_ntzpool_txes([&txs](const crypto::hash &txid, const crypto::hash &ptxid, const ntzpool_tx_meta_t &meta, const cryptonote::blobdata *bd, cryptonote::blobdata const* ptx){
       txs.push_back(txid);
       return true;
@@ -1225,8 +1246,7 @@ namespace cryptonote
   {
     // TODO: This would be a good central place to check signatures against count
     //  and NN addresses, probably. Not sure of the latter, entirely.
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
+    // the ntzpool walk reads a snapshot; only the key images need the pool lock
     m_blockchain.for_all_ntzpool_txes([&tx_infos, key_image_infos, include_sensitive_data](const crypto::hash &txid, crypto::hash const& ptx_hash, const ntzpool_tx_meta_t &meta, cryptonote::blobdata const* bd, cryptonote::blobdata const* ptx){
       ntz_tx_info txi;
       txi.id_hash = epee::string_tools::pod_to_hex(txid);
@@ -1261,10 +1281,12 @@ namespace cryptonote
       for (int i = 0; i < DPOW_SIG_COUNT; i++) {
         txi.signers_index.push_back(meta.signers_index[i]);
       }
+      txi.signers_mask = get_signers_mask(meta);
       tx_infos.push_back(txi);
       return true;
     }, true, include_sensitive_data);
 
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
     ntzpool_tx_meta_t meta;
     for (const key_images_container::value_type& kee : m_spent_key_images) {
       const crypto::key_image& k_image = kee.first;
@@ -1380,7 +1402,7 @@ namespace cryptonote
     }
 
     std::vector<uint32_t> bad_idxs;
-    int32_t verify_ret = verify_embedded_ntz_data(txs, btc_hashes, heights, bad_idxs);
+    int32_t verify_ret = verify_embedded_ntz_data(txs, btc_hashes, heights, bad_idxs, &cn_hashes);
     if (verify_ret < 1)
     {
       if (verify_ret == 0)
@@ -1570,8 +1592,6 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::get_ntzpool_for_rpc(std::vector<cryptonote::rpc::tx_in_ntzpool>& tx_infos, cryptonote::rpc::key_images_with_tx_hashes& key_image_infos) const
   {
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     m_blockchain.for_all_ntzpool_txes([&tx_infos, key_image_infos](const crypto::hash &txid, crypto::hash const& ptx_hash, const ntzpool_tx_meta_t &meta, const cryptonote::blobdata *bd, cryptonote::blobdata const* ptx){
       cryptonote::rpc::tx_in_ntzpool txi;
       txi.tx_hash = txid;
@@ -1590,6 +1610,7 @@ namespace cryptonote
       for (int i = 0; i < DPOW_SIG_COUNT; i++) {
         txi.signers_index.push_back(meta.signers_index[i]);
       }
+      txi.signers_mask = get_signers_mask(meta);
       txi.fee = meta.fee;
       txi.kept_by_block = meta.kept_by_block;
       txi.max_used_block_height = meta.max_used_block_height;
@@ -1605,6 +1626,7 @@ namespace cryptonote
       return true;
     }, true, false);
 
+    CRITICAL_REGION_LOCAL(m_transactions_lock);
     for (const key_images_container::value_type& kee : m_spent_key_images) {
       std::vector<crypto::hash> tx_hashes;
       const std::unordered_set<crypto::hash>& kei_image_set = kee.second;
@@ -1650,8 +1672,6 @@ namespace cryptonote
   //---------------------------------------------------------------------------------
   bool tx_memory_pool::get_ntzpool_transaction(const crypto::hash& id, crypto::hash const& ptx_hash, cryptonote::blobdata& txblob, cryptonote::blobdata& ptx_blob) const
   {
-    CRITICAL_REGION_LOCAL(m_transactions_lock);
-    CRITICAL_REGION_LOCAL1(m_blockchain);
     try
     {
       return m_blockchain.get_ntzpool_tx_blob(id, txblob, ptx_blob, ptx_hash);
@@ -1891,154 +1911,230 @@ namespace cryptonote
     CRITICAL_REGION_LOCAL(m_transactions_lock);
     CRITICAL_REGION_LOCAL1(m_blockchain);
 
-    uint64_t best_coinbase = 0, coinbase = 0;
-    total_size = 0;
-    fee = 0;
-
-    //baseline empty block
-    get_block_reward(median_size, total_size, already_generated_coins, best_coinbase, version);
-
+    const crypto::hash top_id = m_blockchain.get_tail_id();
+    if (!m_template.valid || m_template.top_id != top_id || m_template.median_size != median_size
+        || m_template.already_generated_coins != already_generated_coins || m_template.version != version)
+    {
+      m_template.top_id = top_id;
+      m_template.median_size = median_size;
+      m_template.already_generated_coins = already_generated_coins;
+      m_template.version = version;
+      if (!build_block_template())
+        return false;
+    }
+    else if (!m_template.added.empty())
+    {
+      extend_block_template();
+    }
 
-    size_t max_total_size = 2 * median_size - CRYPTONOTE_COINBASE_BLOB_RESERVED_SIZE;
-    std::unordered_set<crypto::key_image> k_images;
+    bl.tx_hashes.insert(bl.tx_hashes.end(), m_template.tx_hashes.begin(), m_template.tx_hashes.end());
+    total_size = m_template.total_size;
+    fee = m_template.fee;
+    expected_reward = m_template.best_coinbase;
+    LOG_PRINT_L2("Block template filled with " << m_template.tx_hashes.size() << " txes, size "
+        << total_size << "/" << m_template.max_total_size << ", coinbase " << print_money(expected_reward)
+        << " (including " << print_money(fee) << " in fees)");
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::invalidate_block_template()
+  {
+    m_template.valid = false;
+    m_template.added.clear();
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::queue_template_tx(const crypto::hash &id, const transaction &tx)
+  {
+    // which notarizations go in depends on how many there are, so a new
+    // one means choosing again from the whole pool
+    if (tx.version == (DPOW_NOTA_TX_VERSION))
+      invalidate_block_template();
+    else if (m_template.valid)
+      m_template.added.push_back(id);
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::build_block_template()
+  {
+    block_template_cache &t = m_template;
+    t.valid = false;
+    t.added.clear();
+    t.max_total_size = 2 * t.median_size - CRYPTONOTE_COINBASE_BLOB_RESERVED_SIZE;
 
-    LOG_PRINT_L2("Filling block template, median size " << median_size << ", " << m_txs_by_fee_and_receive_time.size() << " txes in the pool");
+    LOG_PRINT_L2("Filling block template, median size " << t.median_size << ", " << m_txs_by_fee_and_receive_time.size() << " txes in the pool");
 
     LockedTXN lock(m_blockchain);
 
-
     std::list<crypto::hash> ids_to_flush;
-    uint64_t num_ntz_txes = 0;
     bool exclude_too_few_notas = false;
 
-  notas_not_ready:
-
-    auto sorted_it = m_txs_by_fee_and_receive_time.begin();
-    while (sorted_it != m_txs_by_fee_and_receive_time.end())
+    // a second pass leaves notarizations out when there are too few of them
+    // for one block, starting again from an empty template
+    for (int pass = 0; pass < 2; ++pass)
     {
-      txpool_tx_meta_t meta;
-      ntzpool_tx_meta_t ntz_meta;
-      if (!m_blockchain.get_txpool_tx_meta(sorted_it->second, meta))
-      {
-        LOG_PRINT_L2("Failed to find txpool tx meta for tx: " << epee::string_tools::pod_to_hex(sorted_it->second));
-        if (m_blockchain.get_ntzpool_tx_meta(sorted_it->second, ntz_meta)) {
-          LOG_PRINT_L2("But, found in ntzpool. Ignoring...");
-          sorted_it++;
-          continue;
-        } else {
-          MERROR("Failed to find meta for tx in txpool and ntzpool! Tx: " << epee::string_tools::pod_to_hex(sorted_it->second));
-         // sorted_it++;
-          continue;
-        }
-      }
-      LOG_PRINT_L2("Considering " << sorted_it->second << ", size " << meta.blob_size << ", current block size " << total_size << "/" << max_total_size << ", current coinbase " << print_money(best_coinbase));
+      t.tx_hashes.clear();
+      t.k_images.clear();
+      t.total_size = 0;
+      t.fee = 0;
 
-      // Can not exceed maximum block size
-      if (max_total_size < total_size + meta.blob_size)
-      {
-        LOG_PRINT_L2("  would exceed maximum block size");
-        sorted_it++;
-        continue;
-      }
+      //baseline empty block
+      get_block_reward(t.median_size, t.total_size, t.already_generated_coins, t.best_coinbase, t.version);
 
-      // start using the optimal filling algorithm from v5
-      if (version >= 1)
+      uint64_t num_ntz_txes = 0;
+      for (auto sorted_it = m_txs_by_fee_and_receive_time.begin(); sorted_it != m_txs_by_fee_and_receive_time.end(); ++sorted_it)
       {
-        // If we're getting lower coinbase tx,
-        // stop including more tx
-        uint64_t block_reward;
-        if(!get_block_reward(median_size, total_size + meta.blob_size, already_generated_coins, block_reward, version))
+        const crypto::hash &txid = sorted_it->second;
+        txpool_tx_meta_t meta;
+        if (!m_blockchain.get_txpool_tx_meta(txid, meta))
         {
-          LOG_PRINT_L2("  would exceed maximum block size");
-          sorted_it++;
+          ntzpool_tx_meta_t ntz_meta;
+          LOG_PRINT_L2("Failed to find txpool tx meta for tx: " << epee::string_tools::pod_to_hex(txid));
+          if (m_blockchain.get_ntzpool_tx_meta(txid, ntz_meta))
+            LOG_PRINT_L2("But, found in ntzpool. Ignoring...");
+          else
+            MERROR("Failed to find meta for tx in txpool and ntzpool! Tx: " << epee::string_tools::pod_to_hex(txid));
           continue;
         }
-        coinbase = block_reward + fee + meta.fee;
-        if (coinbase < template_accept_threshold(best_coinbase))
+        LOG_PRINT_L2("Considering " << txid << ", size " << meta.blob_size << ", current block size " << t.total_size << "/" << t.max_total_size << ", current coinbase " << print_money(t.best_coinbase));
+
+        uint64_t coinbase = 0;
+        if (!template_has_room(meta, coinbase))
+          continue;
+
+        cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(txid);
+        cryptonote::transaction tx;
+        if (!parse_and_validate_tx_from_blob(txblob, tx))
         {
-          LOG_PRINT_L2("  would decrease coinbase to " << print_money(coinbase));
-          sorted_it++;
+          MERROR("Failed to parse tx from txpool");
           continue;
         }
+
+        if (tx.version == (DPOW_NOTA_TX_VERSION)) {
+          num_ntz_txes++;
+          if ((m_blockchain.get_db().height() < m_blockchain.get_notarization_wait()) || exclude_too_few_notas) {
+            ids_to_flush.push_back(txid);
+            continue;
+          }
+          if ((num_ntz_txes > (DPOW_MAX_NOTA_PER_BLOCK)))
+            continue;
+        }
+
+        try_add_template_tx(txid, meta, tx, coinbase);
       }
 
-      cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(sorted_it->second);
-      cryptonote::transaction tx;
+      if (num_ntz_txes > (DPOW_MAX_NOTA_PER_BLOCK)) {
+        MWARNING("More than " << std::to_string(DPOW_MAX_NOTA_PER_BLOCK) << " nota tx(es) in pool. Excluding " << std::to_string(num_ntz_txes - (DPOW_MAX_NOTA_PER_BLOCK)) << " excess tx(es) from block template!");
+        break;
+      }
+      if (!num_ntz_txes || exclude_too_few_notas || num_ntz_txes == (DPOW_MAX_NOTA_PER_BLOCK))
+        break;
+      exclude_too_few_notas = true;
+    }
+
+    // flushing takes the txes out of the pool, which drops the template,
+    // so it is only marked valid afterwards
+    m_blockchain.flush_txes_from_pool(ids_to_flush);
+    t.added.clear();
+    t.valid = true;
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  void tx_memory_pool::extend_block_template()
+  {
+    block_template_cache &t = m_template;
+    std::vector<crypto::hash> added;
+    added.swap(t.added);
 
+    LockedTXN lock(m_blockchain);
+    for (const crypto::hash &txid: added)
+    {
+      txpool_tx_meta_t meta;
+      if (!m_blockchain.get_txpool_tx_meta(txid, meta))
+        continue;
+      uint64_t coinbase = 0;
+      if (!template_has_room(meta, coinbase))
+        continue;
+      cryptonote::blobdata txblob = m_blockchain.get_txpool_tx_blob(txid);
+      cryptonote::transaction tx;
       if (!parse_and_validate_tx_from_blob(txblob, tx))
       {
         MERROR("Failed to parse tx from txpool");
-        sorted_it++;
         continue;
       }
+      if (try_add_template_tx(txid, meta, tx, coinbase))
+        LOG_PRINT_L2("Extended block template with " << txid);
+    }
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::template_has_room(const txpool_tx_meta_t &meta, uint64_t &coinbase) const
+  {
+    const block_template_cache &t = m_template;
 
-      if (tx.version == (DPOW_NOTA_TX_VERSION)) {
-        num_ntz_txes++;
-        if ((m_blockchain.get_db().height() < m_blockchain.get_notarization_wait()) || exclude_too_few_notas) {
-          ids_to_flush.push_back(sorted_it->second);
-          sorted_it++;
-          continue;
-        }
-        if ((num_ntz_txes > (DPOW_MAX_NOTA_PER_BLOCK))) {
-          sorted_it++;
-          continue;
-       }
-      }
+    // Can not exceed maximum block size
+    if (t.max_total_size < t.total_size + meta.blob_size)
+    {
+      LOG_PRINT_L2("  would exceed maximum block size");
+      return false;
+    }
 
-      // Skip transactions that are not ready to be
-      // included into the blockchain or that are
-      // missing key images
-      const cryptonote::txpool_tx_meta_t original_meta = meta;
-      bool ready = is_transaction_ready_to_go(meta, tx);
-      if (memcmp(&original_meta, &meta, sizeof(meta)))
+    // start using the optimal filling algorithm from v5
+    if (t.version >= 1)
+    {
+      // If we're getting lower coinbase tx,
+      // stop including more tx
+      uint64_t block_reward;
+      if(!get_block_reward(t.median_size, t.total_size + meta.blob_size, t.already_generated_coins, block_reward, t.version))
       {
-        try
-	{
-	  m_blockchain.update_txpool_tx(sorted_it->second, meta);
-	}
-        catch (const std::exception &e)
-	{
-	  LOG_PRINT_L1("Failed to update tx meta: " << e.what());
-	  // continue, not fatal
-	}
+        LOG_PRINT_L2("  would exceed maximum block size");
+        return false;
       }
-      if (!ready)
+      coinbase = block_reward + t.fee + meta.fee;
+      if (coinbase < template_accept_threshold(t.best_coinbase))
       {
-        LOG_PRINT_L2("  not ready to go");
-        sorted_it++;
-        continue;
+        LOG_PRINT_L2("  would decrease coinbase to " << print_money(coinbase));
+        return false;
+      }
+    }
+    return true;
+  }
+  //---------------------------------------------------------------------------------
+  bool tx_memory_pool::try_add_template_tx(const crypto::hash &txid, txpool_tx_meta_t &meta, transaction &tx, uint64_t coinbase)
+  {
+    block_template_cache &t = m_template;
+
+    // Skip transactions that are not ready to be
+    // included into the blockchain or that are
+    // missing key images
+    const cryptonote::txpool_tx_meta_t original_meta = meta;
+    bool ready = is_transaction_ready_to_go(meta, tx);
+    if (memcmp(&original_meta, &meta, sizeof(meta)))
+    {
+      try
+      {
+        m_blockchain.update_txpool_tx(txid, meta);
       }
-      if (have_key_images(k_images, tx))
+      catch (const std::exception &e)
       {
-        LOG_PRINT_L2("  key images already seen");
-        sorted_it++;
-        continue;
+        LOG_PRINT_L1("Failed to update tx meta: " << e.what());
+        // continue, not fatal
       }
-
-      bl.tx_hashes.push_back(sorted_it->second);
-      total_size += meta.blob_size;
-      fee += meta.fee;
-      best_coinbase = coinbase;
-      append_key_images(k_images, tx);
-      sorted_it++;
-      LOG_PRINT_L2("  added, new block size " << total_size << "/" << max_total_size << ", coinbase " << print_money(best_coinbase));
     }
-
-    m_blockchain.flush_txes_from_pool(ids_to_flush);
-    ids_to_flush.clear();
-
-    if (num_ntz_txes > (DPOW_MAX_NOTA_PER_BLOCK)) {
-      MWARNING("More than " << std::to_string(DPOW_MAX_NOTA_PER_BLOCK) << " nota tx(es) in pool. Excluding " << std::to_string(num_ntz_txes - (DPOW_MAX_NOTA_PER_BLOCK)) << " excess tx(es) from block template!");
-    } else if ((num_ntz_txes < (DPOW_MAX_NOTA_PER_BLOCK)) && (num_ntz_txes)) {
-      num_ntz_txes = 0;
-      exclude_too_few_notas = true;
-      goto notas_not_ready;
+    if (!ready)
+    {
+      LOG_PRINT_L2("  not ready to go");
+      return false;
+    }
+    if (have_key_images(t.k_images, tx))
+    {
+      LOG_PRINT_L2("  key images already seen");
+      return false;
     }
 
-    expected_reward = best_coinbase;
-    LOG_PRINT_L2("Block template filled with " << bl.tx_hashes.size() << " txes, size "
-        << total_size << "/" << max_total_size << ", coinbase " << print_money(best_coinbase)
-        << " (including " << print_money(fee) << " in fees)");
+    t.tx_hashes.push_back(txid);
+    t.total_size += meta.blob_size;
+    t.fee += meta.fee;
+    t.best_coinbase = coinbase;
+    append_key_images(t.k_images, tx);
+    LOG_PRINT_L2("  added, new block size " << t.total_size << "/" << t.max_total_size << ", coinbase " << print_money(t.best_coinbase));
     return true;
   }
   //---------------------------------------------------------------------------------
@@ -2109,6 +2205,7 @@ namespace cryptonote
           else
           {
             m_txs_by_fee_and_receive_time.erase(sorted_it);
+            invalidate_block_template();
           }
           ++n_removed;
         }
@@ -2151,6 +2248,7 @@ namespace cryptonote
           else
           {
             m_txs_by_fee_and_receive_time.erase(sorted_it);
+            invalidate_block_template();
           }
           ++n_removed;
         }
@@ -2172,6 +2270,7 @@ namespace cryptonote
 
     m_txpool_max_size = max_txpool_size ? max_txpool_size : DEFAULT_TXPOOL_MAX_SIZE;
     m_txs_by_fee_and_receive_time.clear();
+    invalidate_block_template();
     m_spent_key_images.clear();
     m_txpool_size = 0;
     std::vector<crypto::hash> remove;
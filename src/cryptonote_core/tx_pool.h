@@ -38,6 +38,11 @@
 #include <queue>
 #include <boost/serialization/version.hpp>
 #include <boost/utility.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/member.hpp>
 
 #include "string_tools.h"
 #include "syncobj.h"
@@ -69,13 +74,26 @@ namespace cryptonote
       else if (a.first.first < b.first.first) return false;
       else if (a.first.second < b.first.second) return true;
       else if (a.first.second > b.first.second) return false;
-      else if (a.second != b.second) return true;
-      else return false;
+      // ties are broken by txid so the ordering stays strict
+      else return memcmp(a.second.data, b.second.data, sizeof(crypto::hash)) < 0;
     }
   };
 
-  //! container for sorting transactions by fee per unit size
-  typedef std::set<tx_by_fee_and_receive_time_entry, txCompare> sorted_tx_container;
+  struct by_fee_and_receive_time {};
+  struct by_txid {};
+
+  //! container for sorting transactions by fee per unit size, also hashed by txid
+  /*! The default (ordered) index behaves like the std::set this replaces;
+   *  the txid index lets take/removal find an entry without a linear scan.
+   *  Iterators stay valid across inserts and erases of other entries.
+   */
+  typedef boost::multi_index_container<
+    tx_by_fee_and_receive_time_entry,
+    boost::multi_index::indexed_by<
+      boost::multi_index::ordered_unique<boost::multi_index::tag<by_fee_and_receive_time>, boost::multi_index::identity<tx_by_fee_and_receive_time_entry>, txCompare>,
+      boost::multi_index::hashed_unique<boost::multi_index::tag<by_txid>, boost::multi_index::member<tx_by_fee_and_receive_time_entry, crypto::hash, &tx_by_fee_and_receive_time_entry::second> >
+    >
+  > sorted_tx_container;
 
   /**
    * @brief Transaction pool, handles transactions which are not part of a block
@@ -160,7 +178,7 @@ namespace cryptonote
      *
      * @return true unless the transaction cannot be found in the pool
      */
-     bool take_ntzpool_tx(const crypto::hash &id, transaction &tx, size_t& blob_size, uint64_t& fee, bool &relayed, bool &do_not_relay, bool &double_spend_seen, uint8_t& sig_count, std::list<int>& signers_index, cryptonote::blobdata& ptx_string, crypto::hash& ptx_hash);
+     bool take_ntzpool_tx(const crypto::hash &id, transaction &tx, size_t& blob_size, uint64_t& fee, bool &relayed, bool &do_not_relay, bool &double_spend_seen, uint8_t& sig_count, uint64_t& signers_mask, cryptonote::blobdata& ptx_string, crypto::hash& ptx_hash);
 
     /**
      * @brief checks if the pool has a transaction with the given hash
@@ -237,6 +255,10 @@ namespace cryptonote
     /**
      * @brief Chooses transactions for a block to include
      *
+     * The choice is cached for the current chain tip and parameters; later
+     * calls only consider transactions added to the pool since, and any
+     * removal from the pool makes the next call choose from scratch.
+     *
      * @param bl return-by-reference the block to fill in with transactions
      * @param median_size the current median block size
      * @param already_generated_coins the current total number of coins "minted"
@@ -443,6 +465,18 @@ namespace cryptonote
      */
     size_t get_ntzpool_transactions_count(bool include_unrelayed_txes = true) const;
 
+    /**
+     * @brief get the union of the signer sets of all pending notarization txes
+     *
+     * Walks the ntzpool metadata only, no blobs are loaded.
+     *
+     * @param count return-by-reference the number of txes looked at
+     * @param include_unrelayed_txes include unrelayed txes in the result
+     *
+     * @return the signer mask, bit i set if signer i signed any pending tx
+     */
+    uint64_t get_ntzpool_signers(size_t& count, bool include_unrelayed_txes = true) const;
+
     /**
      * @brief get a string containing human-readable pool information
      *
@@ -657,6 +691,79 @@ private:
      */
     sorted_tx_container::iterator find_tx_in_sorted_container(const crypto::hash& id) const;
 
+    //! the last block template chosen by fill_block_template
+    /*! Valid for one chain tip and set of template parameters. Transactions
+     *  added to the pool since are queued in `added` and offered to the
+     *  template on the next call; any removal from the pool drops it.
+     */
+    struct block_template_cache
+    {
+      bool valid;
+      crypto::hash top_id;
+      size_t median_size;
+      size_t max_total_size;
+      uint64_t already_generated_coins;
+      uint8_t version;
+      std::vector<crypto::hash> tx_hashes;
+      std::unordered_set<crypto::key_image> k_images;
+      size_t total_size;
+      uint64_t fee;
+      uint64_t best_coinbase;
+      std::vector<crypto::hash> added;
+    };
+    block_template_cache m_template;
+
+    /**
+     * @brief drops the cached block template so the next one is rebuilt
+     */
+    void invalidate_block_template();
+
+    /**
+     * @brief queues a transaction just added to the pool for the cached
+     * block template
+     *
+     * @param id the transaction's hash
+     * @param tx the transaction
+     */
+    void queue_template_tx(const crypto::hash &id, const transaction &tx);
+
+    /**
+     * @brief rebuilds the cached block template from the whole pool
+     *
+     * @return false if the pool could not be read
+     */
+    bool build_block_template();
+
+    /**
+     * @brief offers the transactions added since the last call to the
+     * cached block template
+     */
+    void extend_block_template();
+
+    /**
+     * @brief checks a transaction against the cached template's size limit
+     * and coinbase threshold
+     *
+     * @param meta the transaction's pool metadata
+     * @param coinbase return-by-reference the coinbase if it were added
+     *
+     * @return true if adding it would neither exceed the block size nor lower the coinbase
+     */
+    bool template_has_room(const txpool_tx_meta_t &meta, uint64_t &coinbase) const;
+
+    /**
+     * @brief adds a pool transaction to the cached block template if it is
+     * ready to go and spends no key image the template already spends
+     *
+     * @param txid the transaction's hash
+     * @param meta the transaction's pool metadata, stored back if its readiness changed
+     * @param tx the parsed transaction
+     * @param coinbase the coinbase from template_has_room
+     *
+     * @return true if the transaction was added
+     */
+    bool try_add_template_tx(const crypto::hash &txid, txpool_tx_meta_t &meta, transaction &tx, uint64_t coinbase);
+
     //! transactions which are unlikely to be included in blocks
     /*! These transactions are kept in RAM in case they *are* included
      *  in a block eventually, but this container is not saved to disk.
@@ -302,6 +302,7 @@ namespace cryptonote
       crypto::hash prior_ptx_hash;
       std::string payment_id;
       std::string signers_index;
+      uint64_t signers_mask;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(sig_count)
@@ -313,6 +314,7 @@ namespace cryptonote
         KV_SERIALIZE_VAL_POD_AS_BLOB(prior_ptx_hash)
         KV_SERIALIZE(payment_id)
         KV_SERIALIZE(signers_index)
+        KV_SERIALIZE_OPT(signers_mask, (uint64_t)0)
       END_KV_SERIALIZE_MAP()
     };
   };
@@ -332,6 +334,7 @@ namespace cryptonote
       crypto::hash tx_hash;
       std::string payment_id;
       std::vector<int> signers_index;
+      uint64_t signers_mask;
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(sig_count)
@@ -341,6 +344,7 @@ namespace cryptonote
         KV_SERIALIZE_VAL_POD_AS_BLOB(tx_hash)
         KV_SERIALIZE(payment_id)
         KV_SERIALIZE(signers_index)
+        KV_SERIALIZE_OPT(signers_mask, (uint64_t)0)
       END_KV_SERIALIZE_MAP()
     };
   };
@@ -366,4 +370,44 @@ namespace cryptonote
       END_KV_SERIALIZE_MAP()
     };
   };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_NTZ_SIG_ANNOUNCE
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 13;
+
+    struct request
+    {
+      crypto::hash tx_hash;
+      crypto::hash prior_tx_hash;
+      int sig_count;
+      uint64_t signers_mask;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_VAL_POD_AS_BLOB(tx_hash)
+        KV_SERIALIZE_VAL_POD_AS_BLOB(prior_tx_hash)
+        KV_SERIALIZE(sig_count)
+        KV_SERIALIZE(signers_mask)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  struct NOTIFY_REQUEST_NTZ_SIG_MISSING
+  {
+    const static int ID = BC_COMMANDS_POOL_BASE + 14;
+
+    struct request
+    {
+      std::vector<crypto::hash> tx_hashes;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_CONTAINER_POD_AS_BLOB(tx_hashes)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
 }
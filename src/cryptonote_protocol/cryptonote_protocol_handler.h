@@ -32,6 +32,7 @@
 
 #include <boost/program_options/variables_map.hpp>
 #include <string>
+#include <unordered_map>
 
 #include "math_helper.h"
 #include "storages/levin_abstract_invoke2.h"
@@ -86,6 +87,8 @@ namespace cryptonote
       HANDLE_NOTIFY_T2(NOTIFY_REQUEST_FLUFFY_MISSING_TX, &cryptonote_protocol_handler::handle_request_fluffy_missing_tx)
       HANDLE_NOTIFY_T2(NOTIFY_REQUEST_NTZ_SIG, &cryptonote_protocol_handler::handle_request_ntz_sig)
       HANDLE_NOTIFY_T2(NOTIFY_RESPONSE_NTZ_SIG, &cryptonote_protocol_handler::handle_response_ntz_sig)
+      HANDLE_NOTIFY_T2(NOTIFY_NTZ_SIG_ANNOUNCE, &cryptonote_protocol_handler::handle_ntz_sig_announce)
+      HANDLE_NOTIFY_T2(NOTIFY_REQUEST_NTZ_SIG_MISSING, &cryptonote_protocol_handler::handle_request_ntz_sig_missing)
     END_INVOKE_MAP2()
 
     bool on_idle();
@@ -118,6 +121,8 @@ namespace cryptonote
     int handle_request_fluffy_missing_tx(int command, NOTIFY_REQUEST_FLUFFY_MISSING_TX::request& arg, cryptonote_connection_context& context);
     int handle_request_ntz_sig(int command, NOTIFY_REQUEST_NTZ_SIG::request& arg, cryptonote_connection_context& context);
     int handle_response_ntz_sig(int command, NOTIFY_RESPONSE_NTZ_SIG::request& arg, cryptonote_connection_context& context);
+    int handle_ntz_sig_announce(int command, NOTIFY_NTZ_SIG_ANNOUNCE::request& arg, cryptonote_connection_context& context);
+    int handle_request_ntz_sig_missing(int command, NOTIFY_REQUEST_NTZ_SIG_MISSING::request& arg, cryptonote_connection_context& context);
 
     //----------------- i_bc_protocol_layout ---------------------------------------
     virtual bool relay_block(NOTIFY_NEW_BLOCK::request& arg, cryptonote_connection_context& exclude_context);
@@ -148,6 +153,9 @@ namespace cryptonote
     boost::mutex m_buffer_mutex;
     double get_avg_block_size();
     boost::circular_buffer<size_t> m_avg_buffer = boost::circular_buffer<size_t>(10);
+    //! announced ntz sig txes we asked a peer for, and when
+    std::unordered_map<crypto::hash, time_t> m_requested_ntz_sigs;
+    boost::mutex m_requested_ntz_sigs_lock;
 
     template<class t_parameter>
       bool post_notify(typename t_parameter::request& arg, cryptonote_connection_context& context)
@@ -35,9 +35,11 @@
 
 #include <boost/interprocess/detail/atomic.hpp>
 #include <list>
+#include <unordered_set>
 #include <ctime>
 
 #include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_basic/ntz_signers.h"
 #include "profile_tools.h"
 #include "net/network_throttle-detail.hpp"
 
@@ -354,11 +356,11 @@ namespace cryptonote
     std::list<block_complete_entry> blocks;
     blocks.push_back(arg.b);
     m_core.prepare_handle_incoming_blocks(blocks);
-    for(auto tx_blob_it = arg.b.txs.begin(); tx_blob_it!=arg.b.txs.end();tx_blob_it++)
+    std::vector<cryptonote::tx_verification_context> tvc;
+    m_core.handle_incoming_txs(arg.b.txs, tvc, true, true, false);
+    for(const auto& tx_tvc: tvc)
     {
-      cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-      m_core.handle_incoming_tx(*tx_blob_it, tvc, true, true, false);
-      if(tvc.m_verifivation_failed)
+      if(tx_tvc.m_verifivation_failed)
       {
         LOG_PRINT_CCONTEXT_L1("Block verification failed: transaction verification failed, dropping connection");
         drop_connection(context, false, false);
@@ -744,17 +746,23 @@ namespace cryptonote
       return 1;
     }
 
-    for(auto tx_blob_it = arg.txs.begin(); tx_blob_it!=arg.txs.end();)
+    std::vector<cryptonote::tx_verification_context> tvc;
+    m_core.handle_incoming_txs(arg.txs, tvc, false, true, false);
+    if (tvc.size() != arg.txs.size())
     {
-      cryptonote::tx_verification_context tvc = AUTO_VAL_INIT(tvc);
-      m_core.handle_incoming_tx(*tx_blob_it, tvc, false, true, false);
-      if(tvc.m_verifivation_failed)
+      LOG_ERROR_CCONTEXT("Internal error: tvc.size() != arg.txs.size()");
+      return 1;
+    }
+    size_t i = 0;
+    for(auto tx_blob_it = arg.txs.begin(); tx_blob_it!=arg.txs.end(); ++i)
+    {
+      if(tvc[i].m_verifivation_failed)
       {
         LOG_PRINT_CCONTEXT_L1("Tx verification failed, dropping connection");
         drop_connection(context, false, false);
         return 1;
       }
-      if(tvc.m_should_be_relayed)
+      if(tvc[i].m_should_be_relayed)
         ++tx_blob_it;
       else
         arg.txs.erase(tx_blob_it++);
@@ -837,6 +845,21 @@ namespace cryptonote
 
     MWARNING("Received NOTIFY_REQUEST_NTZ_SIG (signature count: " << std::to_string(arg.sig_count) << ", signers_index: "<< signers_index);
 
+    // peers predating signers_mask send 0, anything else must agree with the list
+    uint64_t signers_mask = 0;
+    if (!ntz_signers_mask_from_string(signers_index, signers_mask) || (arg.signers_mask && arg.signers_mask != signers_mask))
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_REQUEST_NTZ_SIG signers_index/signers_mask mismatch, dropping connection");
+      drop_connection(context, false, false);
+      return 1;
+    }
+    arg.signers_mask = signers_mask;
+
+    {
+      boost::unique_lock<boost::mutex> lock(m_requested_ntz_sigs_lock);
+      m_requested_ntz_sigs.erase(arg.tx_hash);
+    }
+
     NOTIFY_REQUEST_NTZ_SIG::request ag;
     cryptonote::ntz_req_verification_context tvc = AUTO_VAL_INIT(tvc);
 
@@ -940,12 +963,88 @@ namespace cryptonote
     ag.sig_count = arg.sig_count;
     ag.payment_id = arg.payment_id;
     ag.signers_index = arg.signers_index;
+    ag.signers_mask = arg.signers_mask ? arg.signers_mask : ntz_signers_mask(arg.signers_index);
     return post_notify<NOTIFY_RESPONSE_NTZ_SIG>(ag, context);
 
    return 1;
   }
   //------------------------------------------------------------------------------------------------------------------------
   template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_ntz_sig_announce(int command, NOTIFY_NTZ_SIG_ANNOUNCE::request& arg, cryptonote_connection_context& context)
+  {
+    MLOG_P2P_MESSAGE("Received NOTIFY_NTZ_SIG_ANNOUNCE (tx: " << arg.tx_hash << ", signature count: " << arg.sig_count << ", signers mask: " << arg.signers_mask << ")");
+
+    if(context.m_state != cryptonote_connection_context::state_normal)
+      return 1;
+    if(!is_synchronized())
+    {
+      LOG_DEBUG_CC(context, "Received ntz sig announce while syncing, ignored");
+      return 1;
+    }
+
+    if ((arg.sig_count < 1) || (arg.sig_count > (DPOW_SIG_COUNT)) || (ntz_signers_count(arg.signers_mask) != arg.sig_count))
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_NTZ_SIG_ANNOUNCE signature count does not match signers mask, dropping connection");
+      drop_connection(context, false, false);
+      return 1;
+    }
+
+    if (m_core.ntzpool_has_tx(arg.tx_hash) || m_core.pool_has_tx(arg.tx_hash))
+      return 1;
+
+    // every notary announces the same tx, only fetch it from the first one
+    // unless that peer hasn't delivered within the timeout
+    {
+      boost::unique_lock<boost::mutex> lock(m_requested_ntz_sigs_lock);
+      const time_t now = time(NULL);
+      for (auto it = m_requested_ntz_sigs.begin(); it != m_requested_ntz_sigs.end(); )
+      {
+        if (now - it->second >= DPOW_NTZ_SIG_FETCH_TIMEOUT)
+          it = m_requested_ntz_sigs.erase(it);
+        else
+          ++it;
+      }
+      if (!m_requested_ntz_sigs.emplace(arg.tx_hash, now).second)
+        return 1;
+    }
+
+    NOTIFY_REQUEST_NTZ_SIG_MISSING::request missing_arg;
+    missing_arg.tx_hashes.push_back(arg.tx_hash);
+    MDEBUG("Requesting announced ntz sig tx " << arg.tx_hash);
+    post_notify<NOTIFY_REQUEST_NTZ_SIG_MISSING>(missing_arg, context);
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
+  int t_cryptonote_protocol_handler<t_core>::handle_request_ntz_sig_missing(int command, NOTIFY_REQUEST_NTZ_SIG_MISSING::request& arg, cryptonote_connection_context& context)
+  {
+    MLOG_P2P_MESSAGE("Received NOTIFY_REQUEST_NTZ_SIG_MISSING (" << arg.tx_hashes.size() << " txes)");
+    if(context.m_state != cryptonote_connection_context::state_normal)
+      return 1;
+    if (arg.tx_hashes.size() > DPOW_MAX_NTZ_SIG_MISSING)
+    {
+      LOG_ERROR_CCONTEXT("NOTIFY_REQUEST_NTZ_SIG_MISSING requested " << arg.tx_hashes.size() << " txes, more than " << DPOW_MAX_NTZ_SIG_MISSING << ", dropping connection");
+      drop_connection(context, false, false);
+      return 1;
+    }
+
+    // each tx is sent at most once per request
+    const std::unordered_set<crypto::hash> tx_hashes(arg.tx_hashes.begin(), arg.tx_hashes.end());
+    for (const auto& tx_hash : tx_hashes)
+    {
+      NOTIFY_REQUEST_NTZ_SIG::request r = AUTO_VAL_INIT(r);
+      if (!m_core.get_ntz_sig_request(tx_hash, r))
+      {
+        // most likely superseded by a tx with more signatures since we announced it
+        MDEBUG("Requested ntz sig tx " << tx_hash << " is no longer in the ntzpool");
+        continue;
+      }
+      post_notify<NOTIFY_REQUEST_NTZ_SIG>(r, context);
+    }
+    return 1;
+  }
+  //------------------------------------------------------------------------------------------------------------------------
+  template<class t_core>
   int t_cryptonote_protocol_handler<t_core>::handle_request_get_objects(int command, NOTIFY_REQUEST_GET_OBJECTS::request& arg, cryptonote_connection_context& context)
   {
     MLOG_P2P_MESSAGE("Received NOTIFY_REQUEST_GET_OBJECTS (" << arg.blocks.size() << " blocks, " << arg.txs.size() << " txes)");
@@ -1712,9 +1811,8 @@ skip:
   {
     NOTIFY_NEW_FLUFFY_BLOCK::request fluffy_arg = AUTO_VAL_INIT(fluffy_arg);
     fluffy_arg.current_blockchain_height = arg.current_blockchain_height;
-    std::list<blobdata> fluffy_txs;
-    fluffy_arg.b = arg.b;
-    fluffy_arg.b.txs = fluffy_txs;
+    // fluffy peers rebuild the block from their pool, only the block itself goes out
+    fluffy_arg.b.block = arg.b.block;
 
     // sort peers between fluffy ones and others
     std::list<boost::uuids::uuid> fullConnections, fluffyConnections;
@@ -1773,7 +1871,47 @@ skip:
     }
     else*/ if ((arg.sig_count > 0) && (arg.sig_count <= (DPOW_SIG_COUNT)))
     {
-      return relay_post_notify<NOTIFY_REQUEST_NTZ_SIG>(arg, exclude_context);
+      // Peers that understand announcements only get the tx hash and signer
+      // set, and fetch the blobs from us if they don't have the tx yet. We
+      // can only answer that from our own ntzpool, so anything not in it
+      // goes out in full as before.
+      if (arg.tx_hash == crypto::null_hash || !m_core.ntzpool_has_tx(arg.tx_hash))
+        return relay_post_notify<NOTIFY_REQUEST_NTZ_SIG>(arg, exclude_context);
+
+      NOTIFY_NTZ_SIG_ANNOUNCE::request announce_arg = AUTO_VAL_INIT(announce_arg);
+      announce_arg.tx_hash = arg.tx_hash;
+      announce_arg.prior_tx_hash = arg.prior_tx_hash;
+      announce_arg.sig_count = arg.sig_count;
+      announce_arg.signers_mask = arg.signers_mask;
+      if (!announce_arg.signers_mask && !ntz_signers_mask_from_string(arg.signers_index, announce_arg.signers_mask))
+      {
+        MERROR("Could not relay_request_ntz_sig! Malformed signers_index: " << arg.signers_index);
+        return false;
+      }
+
+      std::list<boost::uuids::uuid> fullConnections, announceConnections;
+      m_p2p->for_each_connection([&exclude_context, &fullConnections, &announceConnections](connection_context& context, nodetool::peerid_type peer_id, uint32_t support_flags)
+      {
+        if (peer_id && exclude_context.m_connection_id != context.m_connection_id)
+        {
+          if (support_flags & P2P_SUPPORT_FLAG_NTZ_SIG_ANNOUNCE)
+            announceConnections.push_back(context.m_connection_id);
+          else
+            fullConnections.push_back(context.m_connection_id);
+        }
+        return true;
+      });
+
+      if (!announceConnections.empty()) {
+        std::string announceBlob;
+        epee::serialization::store_t_to_binary(announce_arg, announceBlob);
+        m_p2p->relay_notify_to_list(NOTIFY_NTZ_SIG_ANNOUNCE::ID, announceBlob, announceConnections); }
+      if (!fullConnections.empty()) {
+        std::string fullBlob;
+        epee::serialization::store_t_to_binary(arg, fullBlob);
+        m_p2p->relay_notify_to_list(NOTIFY_REQUEST_NTZ_SIG::ID, fullBlob, fullConnections); }
+
+      return true;
     }
     else {
       MERROR("Could not relay_request_ntz_sig!  Sig count must be within range of 0 - " << std::to_string(DPOW_SIG_COUNT));
@@ -47,7 +47,6 @@
 #include "sodium.h"
 #include "daemon/command_line_args.h"
 #include "blockchain_db/db_types.h"
-//#include "bitcoin_spv.h"
 #include "version.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -286,13 +285,6 @@ int main(int argc, char* argv[])
     // logging is now set up
     MGINFO("Blur Network '" << cryptonote::MONERO_RELEASE_NAME << "' (v" << cryptonote::MONERO_VERSION_FULL << ")");
 
- /*   uint32_t process_id = 0;
-    int launch = libbtc_launch("bitcointool", "-command", "genkey", data_dir, relative_path_base, process_id);
-    if (launch != 0) {
-      MERROR("Unexpected exit code in child process for libbtc!");
-      return 1;
-    }
-*/
     MINFO("Moving from main() into the daemonize now.");
 
     return daemonizer::daemonize(argc, argv, daemonize::t_executor{}, vm) ? 0 : 1;
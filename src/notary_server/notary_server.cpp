@@ -44,6 +44,7 @@ using namespace epee;
 #include "cryptonote_config.h"
 #include "cryptonote_core/tx_pool.h"
 #include "cryptonote_basic/komodo_notaries.h"
+#include "cryptonote_basic/ntz_signers.h"
 #include "cryptonote_basic/cryptonote_format_utils.h"
 #include "cryptonote_protocol/cryptonote_protocol_defs.h"
 #include "cryptonote_basic/account.h"
@@ -68,9 +69,22 @@ namespace
   const command_line::arg_descriptor<bool> arg_trusted_daemon = {"trusted-daemon", "Enable commands which rely on a trusted daemon", false};
   const command_line::arg_descriptor<std::string> arg_notary_wallet_dir = {"data-dir", "Directory for notary wallet and KMD state"};
   const command_line::arg_descriptor<bool> arg_prompt_for_password = {"prompt-for-password", "Prompts for password when not provided", false};
+  const command_line::arg_descriptor<unsigned> arg_rpc_threads = {"rpc-threads", "Number of threads serving RPC requests", 4};
 
   constexpr const char default_rpc_username[] = "notary";
 
+  // long-polls are kept short so run() can join the event thread promptly on shutdown
+  constexpr const uint64_t ntz_event_wait_ms = 5000;
+  // re-relay the pools at least this often, whether or not events arrive
+  constexpr const std::chrono::seconds ntz_relay_interval = std::chrono::seconds(20);
+
+  bool same_login(const boost::optional<epee::net_utils::http::login>& a, const boost::optional<epee::net_utils::http::login>& b)
+  {
+    if (!a || !b)
+      return !a && !b;
+    return a->username == b->username && a->password == b->password;
+  }
+
   boost::optional<tools::password_container> password_prompter(const char *prompt, bool verify)
   {
     auto pwd_container = tools::password_container::prompt(verify, prompt);
@@ -97,19 +111,20 @@ namespace tools
   }
 
   //------------------------------------------------------------------------------------------------------------------------------
-  notary_server::notary_server():m_wallet(NULL), rpc_login_file(), m_stop(false), m_trusted_daemon(false), m_vm(NULL)
+  notary_server::notary_server():rpc_login_file(), m_stop(false), m_trusted_daemon(false), m_vm(NULL),
+    m_sent_to_pool(false), m_bound_ntz_count(0), m_chain_event(false), m_ntzpool_event(false), m_ntz_event(AUTO_VAL_INIT(m_ntz_event)),
+    m_ntz_round_stats(AUTO_VAL_INIT(m_ntz_round_stats)), m_ntz_round_latency_total_ms(0)
   {
   }
   //------------------------------------------------------------------------------------------------------------------------------
   notary_server::~notary_server()
   {
-    if (m_wallet)
-      delete m_wallet;
+    delete m_wallet.write().reset(NULL);
   }
   //------------------------------------------------------------------------------------------------------------------------------
   void notary_server::set_wallet(wallet2 *cr)
   {
-    m_wallet = cr;
+    delete m_wallet.write().reset(cr);
   }
   //------------------------------------------------------------------------------------------------------------------------------
   std::string ptx_to_string(const tools::wallet2::pending_tx &ptx)
@@ -139,142 +154,249 @@ namespace tools
     return hash_blob;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  void notary_server::get_ntzpool_tx_infos(std::vector<cryptonote::ntz_tx_info>& tx_infos)
+  bool notary_server::check_if_sent_to_pool()
   {
-    std::vector<cryptonote::spent_key_image_info> ski_infos;
+    // The daemon answers membership from the ntzpool signer masks, so we
+    // no longer pull every pending tx over RPC on each round.
     try {
-      if (m_wallet) {
-        m_wallet->get_ntzpool_txs_and_keys(tx_infos, ski_infos);
+      auto wallet = m_wallet.write();
+      if (!wallet)
+        return false;
+      int signer_index = -1;
+      if (!get_ntz_signer_index(wallet->get_account().get_keys(), signer_index)) {
+        LOG_ERROR("Failed to get ntz_signer_index - We must not be a notary node!");
+        return false;
+      }
+      if (!cryptonote::ntz_signer_valid(signer_index)) {
+        LOG_ERROR("In check_if_sent_to_pool: signer index must be in range of 0-63!");
+        return false;
+      }
+      uint64_t signers_mask = 0;
+      if (wallet->has_ntz_signer(signer_index, signers_mask)) {
+        LOG_PRINT_L0("Found our signer index: " << signer_index << ", in ntzpool (signers mask: " << signers_mask << "), we must have already sent to pool!");
+        return true;
       }
     } catch (const std::exception& e) {
-      LOG_ERROR("Exception when gettings ntzpool_tx_infos: " << e.what());
+      LOG_ERROR("Exception when checking ntzpool for our signer index: " << e.what());
     }
+    //TODO: also need to account for txs in txpool with tx.version = 2
+    // Logic above will not account for txs we may have sent that were already
+    // converted from ntzpool->txpool. Probably doesn't matter in reality, since
+    // > 5 ntz txs can't make it into a block. but will reduce efficiency
+    return false;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  bool notary_server::check_if_sent_to_pool()
+  void notary_server::ntz_event_loop()
   {
-    std::vector<cryptonote::ntz_tx_info> tx_infos;
-    get_ntzpool_tx_infos(tx_infos);
-    cryptonote::account_keys own_keys;
-    try {
-      if (m_wallet) {
-        own_keys = m_wallet->get_account().get_keys();
+    std::string daemon_address;
+    boost::optional<epee::net_utils::http::login> daemon_login;
+    uint64_t chain_revision = 0, ntzpool_revision = 0;
+    while (!m_stop.load(std::memory_order_relaxed))
+    {
+      {
+        boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+        if (daemon_address != m_event_daemon_address || !same_login(daemon_login, m_event_daemon_login))
+        {
+          daemon_address = m_event_daemon_address;
+          daemon_login = m_event_daemon_login;
+          if (m_event_http_client.is_connected())
+            m_event_http_client.disconnect();
+          m_event_http_client.set_server(daemon_address, daemon_login);
+          // revisions are per daemon
+          chain_revision = 0;
+          ntzpool_revision = 0;
+        }
       }
-    } catch (const std::exception& e) {
-      LOG_ERROR("Exception when retrieving our keys from m_wallet: " << e.what());
-    }
-    int signer_index = -1;
-    if (!get_ntz_signer_index(own_keys, signer_index)) {
-      LOG_ERROR("Failed to get ntz_signer_index - We must not be a notary node!");
-      return false;
-    }
-    if ((signer_index < 0) || (signer_index > 63)) {
-      LOG_ERROR("In check_if_sent_to_pool: signer index must be in range of 0-63!");
-      return false;
+      if (daemon_address.empty())
+      {
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(500));
+        continue;
+      }
+
+      cryptonote::COMMAND_RPC_WAIT_NTZ_EVENT::request req = AUTO_VAL_INIT(req);
+      cryptonote::COMMAND_RPC_WAIT_NTZ_EVENT::response res = AUTO_VAL_INIT(res);
+      req.chain_revision = chain_revision;
+      req.ntzpool_revision = ntzpool_revision;
+      req.timeout = ntz_event_wait_ms;
+      const auto start = std::chrono::steady_clock::now();
+      bool r = epee::net_utils::invoke_http_json("/wait_ntz_event", req, res, m_event_http_client, std::chrono::milliseconds(ntz_event_wait_ms) + std::chrono::seconds(30));
+      if (!r || res.status != CORE_RPC_STATUS_OK)
+      {
+        // daemon down or too old for /wait_ntz_event, the idle handler keeps
+        // running timed rounds in the meantime
+        MDEBUG("wait_ntz_event failed, retrying");
+        boost::this_thread::sleep_for(boost::chrono::seconds(1));
+        continue;
+      }
+
+      const bool chain_changed = res.chain_revision != chain_revision;
+      const bool ntzpool_changed = res.ntzpool_revision != ntzpool_revision;
+      if (chain_changed || ntzpool_changed)
+      {
+        boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+        if (!m_chain_event && !m_ntzpool_event)
+          m_ntz_event_time = std::chrono::steady_clock::now();
+        m_chain_event |= chain_changed;
+        m_ntzpool_event |= ntzpool_changed;
+        m_ntz_event = res;
+        if (chain_changed)
+          ++m_ntz_round_stats.chain_events;
+        if (ntzpool_changed)
+          ++m_ntz_round_stats.ntzpool_events;
+      }
+      else if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(ntz_event_wait_ms / 2))
+      {
+        // the daemon answered without waiting (another client holds its long-poll slot)
+        boost::this_thread::sleep_for(boost::chrono::seconds(1));
+      }
+      chain_revision = res.chain_revision;
+      ntzpool_revision = res.ntzpool_revision;
     }
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool notary_server::on_ntz_idle()
+  {
+    bool chain_changed, ntzpool_changed, relay;
+    std::chrono::steady_clock::time_point event_time;
+    cryptonote::COMMAND_RPC_WAIT_NTZ_EVENT::response event;
+    const auto now = std::chrono::steady_clock::now();
+    {
+      auto wallet = m_wallet.read();
+      if (!wallet)
+        return true;
+      boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+      // the wallet may have been reopened against another daemon
+      const std::string daemon_address = wallet->get_daemon_address();
+      const boost::optional<epee::net_utils::http::login>& daemon_login = wallet->get_daemon_login();
+      if (daemon_address != m_event_daemon_address || !same_login(daemon_login, m_event_daemon_login))
+      {
+        m_event_daemon_address = daemon_address;
+        m_event_daemon_login = daemon_login;
+      }
+      chain_changed = m_chain_event;
+      ntzpool_changed = m_ntzpool_event;
+      relay = now - m_last_ntz_relay >= ntz_relay_interval;
+      if (!chain_changed && !ntzpool_changed && !relay)
+        return true;
+      event_time = (chain_changed || ntzpool_changed) ? m_ntz_event_time : now;
+      event = m_ntz_event;
+      m_chain_event = false;
+      m_ntzpool_event = false;
+    }
+
+    ntz_round(chain_changed, ntzpool_changed, relay, event);
+
+    m_last_ntz_round = std::chrono::steady_clock::now();
+    if (relay)
+      m_last_ntz_relay = m_last_ntz_round;
+    const uint64_t latency = std::chrono::duration_cast<std::chrono::milliseconds>(m_last_ntz_round - event_time).count();
+    boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+    ++m_ntz_round_stats.rounds;
+    if (!chain_changed && !ntzpool_changed)
+      ++m_ntz_round_stats.timer_rounds;
+    m_ntz_round_stats.last_round_latency_ms = latency;
+    m_ntz_round_stats.max_round_latency_ms = std::max(m_ntz_round_stats.max_round_latency_ms, latency);
+    m_ntz_round_latency_total_ms += latency;
+    m_ntz_round_stats.avg_round_latency_ms = m_ntz_round_latency_total_ms / m_ntz_round_stats.rounds;
+    MDEBUG("Notarization round done in " << latency << " ms (chain event: " << chain_changed << ", ntzpool event: " << ntzpool_changed << ")");
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  void notary_server::ntz_round(bool chain_changed, bool ntzpool_changed, bool relay, const cryptonote::COMMAND_RPC_WAIT_NTZ_EVENT::response& event)
+  {
+    // Event rounds take height, notarized height and counts from the event
+    // itself. Timed rounds (no events, or no event thread) ask the daemon.
+    // Any round re-relays the pools when asked to, so the 20 second re-relay
+    // of the old idle handlers still happens while events keep arriving.
+    // The wallet lock is dropped around check_if_sent_to_pool() and the
+    // ntz RPC handlers, which take it themselves.
+    const bool timed = !chain_changed && !ntzpool_changed;
+    try
+    {
+      notary_rpc::COMMAND_RPC_CREATE_NTZ_TRANSFER::request req;
+      notary_rpc::COMMAND_RPC_CREATE_NTZ_TRANSFER::response res = AUTO_VAL_INIT(res);
+      std::string error;
+      epee::json_rpc::error e;
+      uint64_t height, notarization_wait;
 
-    for (const auto& each : tx_infos) {
-      for (const auto& signer_entry : each.signers_index)  {
-        if (signer_entry == signer_index) {
-          LOG_PRINT_L0("Found our signer index: " << signer_index << ", in pool tx with hash: " << each.id_hash << ", we must have already sent to pool!");
-          return true;
+      {
+        auto wallet = m_wallet.write();
+        if (!wallet)
+          return;
+
+        if (timed || chain_changed)
+        {
+          try {
+            wallet->refresh();
+          } catch (const std::exception& ex) {
+            LOG_ERROR("Exception while refreshing, what=" << ex.what());
+          }
+        }
+
+        height = timed ? wallet->get_daemon_blockchain_height(error) : event.height;
+        notarization_wait = (timed ? wallet->get_notarized_height() : event.notarized_height) + (DPOW_NOTARIZATION_WINDOW);
+        uint64_t const ntz_count = timed ? wallet->get_ntz_count() : event.notarization_count;
+
+        m_bound_ntz_count = (m_bound_ntz_count == 0) ? ntz_count : m_bound_ntz_count;
+        if (height < notarization_wait) {
+          if (timed || chain_changed)
+            wallet->flush_ntzpool();
+        } else if (relay) {
+          wallet->relay_txpool();
+          wallet->relay_ntzpool(); // re-relay whole pool
+        }
+
+        if (m_bound_ntz_count < ntz_count) {
+          m_bound_ntz_count = ntz_count;
+          m_sent_to_pool = false; // reset once per cycle
+        }
+      }
+
+      if (!check_if_sent_to_pool()) {
+        m_sent_to_pool = false;
+      }
+
+      if (height >= (notarization_wait)) {
+        size_t count = event.ntzpool_count;
+        if (timed) {
+          auto wallet = m_wallet.write();
+          if (!wallet)
+            return;
+          count = wallet->get_ntzpool_count(true);
+        }
+        if ((count >= 1) && !m_sent_to_pool) {
+          notary_rpc::COMMAND_RPC_APPEND_NTZ_SIG::request request;
+          notary_rpc::COMMAND_RPC_APPEND_NTZ_SIG::response response = AUTO_VAL_INIT(response);
+          epee::json_rpc::error err;
+          if (!on_append_ntz_sig(request, response, err)) {
+            MERROR("Something went wrong when calling append_ntz_sig from idle handler!");
+          } else {
+            m_sent_to_pool = response.sent_to_pool;
+          }
+        } else {
+          if (!m_sent_to_pool) {
+            if (on_create_ntz_transfer(req, res, e)) {
+              m_sent_to_pool = res.sent_to_pool;
+            }
+          }
         }
       }
+    } catch (const std::exception& ex) {
+      MERROR("Exception while executing notarization round, what=" << ex.what());
     }
-    //TODO: also need to account for txs in txpool with tx.version = 2
-    // Logic above will not account for txs we may have sent that were already
-    // converted from ntzpool->txpool. Probably doesn't matter in reality, since
-    // > 5 ntz txs can't make it into a block. but will reduce efficiency
-    return false;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::run()
   {
-    bool sent_to_pool = false;
-    uint64_t bound_ntz_count = 0;
     m_stop = false;
-    bool first_run = true;
+    m_sent_to_pool = false;
+    m_bound_ntz_count = 0;
+    m_last_ntz_round = std::chrono::steady_clock::time_point();
+    m_last_ntz_relay = std::chrono::steady_clock::time_point();
 
     m_net_server.add_idle_handler([this](){
-      try {
-        if (m_wallet) m_wallet->refresh();
-      } catch (const std::exception& ex) {
-        LOG_ERROR("Exception while refreshing, what=" << ex.what());
-      }
-      return true;
-    }, 20000);
-
-
-     m_net_server.add_idle_handler([this, &sent_to_pool, &bound_ntz_count, &first_run](){
-       try
-       {
-         notary_rpc::COMMAND_RPC_CREATE_NTZ_TRANSFER::request req;
-         notary_rpc::COMMAND_RPC_CREATE_NTZ_TRANSFER::response res = AUTO_VAL_INIT(res);
-         std::string error;
-         epee::json_rpc::error e;
-         uint64_t const height = m_wallet->get_daemon_blockchain_height(error);
-         uint64_t const notarization_wait = m_wallet->get_notarized_height() + (DPOW_NOTARIZATION_WINDOW);
-         //MWARNING("Height = " << std::to_string(height) << ", notarization_wait = " << std::to_string(notarization_wait) << " ---- ");
-         if (m_wallet)
-         {
-           /*if (first_run) {
-             m_wallet->flush_ntzpool();
-             first_run = false;
-           }*/
-
-           bound_ntz_count = (bound_ntz_count == 0) ? m_wallet->get_ntz_count() : bound_ntz_count;
-           if (height < notarization_wait) {
-             m_wallet->flush_ntzpool();
-           } else {
-             m_wallet->relay_txpool();
-             m_wallet->relay_ntzpool(); // re-relay whole pool
-           }
-
-           if (bound_ntz_count < m_wallet->get_ntz_count()) {
-             bound_ntz_count = m_wallet->get_ntz_count();
-             sent_to_pool = false; // reset once per cycle
-           }
-
-           /*if (get_ntz_cache_count() <= 1)
-           {
-             if (on_create_ntz_transfer(req, res, e)) {
-               sent_to_pool = res.sent_to_pool;
-               if (get_ntz_cache_count() == 1) {
-                 on_create_ntz_transfer(req, res, e);
-                 sent_to_pool = res.sent_to_pool;
-               }
-             }
-           }*/
-
-           if (!check_if_sent_to_pool()) {
-             sent_to_pool = false;
-           }
-
-           if (height >= (notarization_wait)) {
-           const size_t count = m_wallet->get_ntzpool_count(true);
-             if ((count >= 1) && !sent_to_pool) {
-               notary_rpc::COMMAND_RPC_APPEND_NTZ_SIG::request request;
-               notary_rpc::COMMAND_RPC_APPEND_NTZ_SIG::response response = AUTO_VAL_INIT(response);
-               epee::json_rpc::error err;
-               if (!on_append_ntz_sig(request, response, err)) {
-                 MERROR("Something went wrong when calling append_ntz_sig from idle handler!");
-               } else {
-                 sent_to_pool = response.sent_to_pool;
-               }
-             } else {
-               if (!sent_to_pool) {
-                 if (on_create_ntz_transfer(req, res, e)) {
-                   sent_to_pool = res.sent_to_pool;
-                 }
-               }
-             }
-           }
-         }
-       } catch (const std::exception& ex) {
-         MERROR("Exception while executing notarization idle handler sequence, what=" << ex.what());
-       }
-       return true;
-     }, 20000);
+      return on_ntz_idle();
+    }, 100);
 
     m_net_server.add_idle_handler([this](){
       if (m_stop.load(std::memory_order_relaxed))
@@ -285,17 +407,34 @@ namespace tools
       return true;
     }, 500);
 
-    //DO NOT START THIS SERVER IN MORE THEN 1 THREADS WITHOUT REFACTORING
-    return epee::http_server_impl_base<notary_server, connection_context>::run(1, true);
+    m_ntz_event_thread = boost::thread([this](){ ntz_event_loop(); });
+
+    // wallet access goes through m_wallet's reader/writer guards, so
+    // read-only calls no longer queue behind signing and transfers
+    const unsigned threads = std::max(1u, command_line::get_arg(*m_vm, arg_rpc_threads));
+    bool r = false;
+    try
+    {
+      r = epee::http_server_impl_base<notary_server, connection_context>::run(threads, true);
+    }
+    catch (...)
+    {
+      m_stop = true;
+      m_ntz_event_thread.join();
+      throw;
+    }
+    m_stop = true;
+    m_ntz_event_thread.join();
+    return r;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   void notary_server::stop()
   {
-    if (m_wallet)
+    auto wallet = m_wallet.write();
+    if (wallet)
     {
-      m_wallet->store();
-      delete m_wallet;
-      m_wallet = NULL;
+      wallet->store();
+      delete wallet.reset(NULL);
     }
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -306,11 +445,12 @@ namespace tools
       return false;
 
     m_vm = vm;
-    tools::wallet2 *walvars;
+    const tools::wallet2 *walvars;
     std::unique_ptr<tools::wallet2> tmpwal;
 
-    if (m_wallet)
-      walvars = m_wallet;
+    auto wallet = m_wallet.read();
+    if (wallet)
+      walvars = wallet.get();
     else
     {
       tmpwal = tools::wallet2::make_dummy(*m_vm, password_prompter);
@@ -410,7 +550,7 @@ namespace tools
       return false;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  void notary_server::fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const crypto::hash &payment_id, const tools::wallet2::payment_details &pd)
+  void notary_server::fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const crypto::hash &payment_id, const tools::wallet2::payment_details &pd)
   {
     entry.txid = string_tools::pod_to_hex(pd.m_tx_hash);
     entry.payment_id = string_tools::pod_to_hex(payment_id);
@@ -421,13 +561,13 @@ namespace tools
     entry.amount = pd.m_amount;
     entry.unlock_time = pd.m_unlock_time;
     entry.fee = pd.m_fee;
-    entry.note = m_wallet->get_tx_note(pd.m_tx_hash);
+    entry.note = wallet.get_tx_note(pd.m_tx_hash);
     entry.type = "in";
     entry.subaddr_index = pd.m_subaddr_index;
-    entry.address = m_wallet->get_subaddress_as_str(pd.m_subaddr_index);
+    entry.address = wallet.get_subaddress_as_str(pd.m_subaddr_index);
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  void notary_server::fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::confirmed_transfer_details &pd)
+  void notary_server::fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::confirmed_transfer_details &pd)
   {
     entry.txid = string_tools::pod_to_hex(txid);
     entry.payment_id = string_tools::pod_to_hex(pd.m_payment_id);
@@ -439,21 +579,21 @@ namespace tools
     entry.fee = pd.m_amount_in - pd.m_amount_out;
     uint64_t change = pd.m_change == (uint64_t)-1 ? 0 : pd.m_change; // change may not be known
     entry.amount = pd.m_amount_in - change - entry.fee;
-    entry.note = m_wallet->get_tx_note(txid);
+    entry.note = wallet.get_tx_note(txid);
 
     for (const auto &d: pd.m_dests) {
       entry.destinations.push_back(notary_rpc::transfer_destination());
       notary_rpc::transfer_destination &td = entry.destinations.back();
       td.amount = d.amount;
-      td.address = get_account_address_as_str(m_wallet->nettype(), d.is_subaddress, d.addr);
+      td.address = get_account_address_as_str(wallet.nettype(), d.is_subaddress, d.addr);
     }
 
     entry.type = "out";
     entry.subaddr_index = { pd.m_subaddr_account, 0 };
-    entry.address = m_wallet->get_subaddress_as_str({pd.m_subaddr_account, 0});
+    entry.address = wallet.get_subaddress_as_str({pd.m_subaddr_account, 0});
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  void notary_server::fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::unconfirmed_transfer_details &pd)
+  void notary_server::fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::unconfirmed_transfer_details &pd)
   {
     bool is_failed = pd.m_state == tools::wallet2::unconfirmed_transfer_details::failed;
     entry.txid = string_tools::pod_to_hex(txid);
@@ -466,13 +606,13 @@ namespace tools
     entry.fee = pd.m_amount_in - pd.m_amount_out;
     entry.amount = pd.m_amount_in - pd.m_change - entry.fee;
     entry.unlock_time = pd.m_tx.unlock_time;
-    entry.note = m_wallet->get_tx_note(txid);
+    entry.note = wallet.get_tx_note(txid);
     entry.type = is_failed ? "failed" : "pending";
     entry.subaddr_index = { pd.m_subaddr_account, 0 };
-    entry.address = m_wallet->get_subaddress_as_str({pd.m_subaddr_account, 0});
+    entry.address = wallet.get_subaddress_as_str({pd.m_subaddr_account, 0});
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  void notary_server::fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &payment_id, const tools::wallet2::pool_payment_details &ppd)
+  void notary_server::fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &payment_id, const tools::wallet2::pool_payment_details &ppd)
   {
     const tools::wallet2::payment_details &pd = ppd.m_pd;
     entry.txid = string_tools::pod_to_hex(pd.m_tx_hash);
@@ -484,34 +624,35 @@ namespace tools
     entry.amount = pd.m_amount;
     entry.unlock_time = pd.m_unlock_time;
     entry.fee = pd.m_fee;
-    entry.note = m_wallet->get_tx_note(pd.m_tx_hash);
+    entry.note = wallet.get_tx_note(pd.m_tx_hash);
     entry.double_spend_seen = ppd.m_double_spend_seen;
     entry.type = "pool";
     entry.subaddr_index = pd.m_subaddr_index;
-    entry.address = m_wallet->get_subaddress_as_str(pd.m_subaddr_index);
+    entry.address = wallet.get_subaddress_as_str(pd.m_subaddr_index);
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_getbalance(const notary_rpc::COMMAND_RPC_GET_BALANCE::request& req, notary_rpc::COMMAND_RPC_GET_BALANCE::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     try
     {
-      res.balance = m_wallet->balance(req.account_index);
-      res.unlocked_balance = m_wallet->unlocked_balance(req.account_index);
-      res.multisig_import_needed = m_wallet->multisig() && m_wallet->has_multisig_partial_key_images();
-      std::map<uint32_t, uint64_t> balance_per_subaddress = m_wallet->balance_per_subaddress(req.account_index);
-      std::map<uint32_t, uint64_t> unlocked_balance_per_subaddress = m_wallet->unlocked_balance_per_subaddress(req.account_index);
+      res.balance = wallet->balance(req.account_index);
+      res.unlocked_balance = wallet->unlocked_balance(req.account_index);
+      res.multisig_import_needed = wallet->multisig() && wallet->has_multisig_partial_key_images();
+      std::map<uint32_t, uint64_t> balance_per_subaddress = wallet->balance_per_subaddress(req.account_index);
+      std::map<uint32_t, uint64_t> unlocked_balance_per_subaddress = wallet->unlocked_balance_per_subaddress(req.account_index);
       std::vector<tools::wallet2::transfer_details> transfers;
-      m_wallet->get_transfers(transfers);
+      wallet->get_transfers(transfers);
       for (const auto& i : balance_per_subaddress)
       {
         notary_rpc::COMMAND_RPC_GET_BALANCE::per_subaddress_info info;
         info.address_index = i.first;
         cryptonote::subaddress_index index = {req.account_index, info.address_index};
-        info.address = m_wallet->get_subaddress_as_str(index);
+        info.address = wallet->get_subaddress_as_str(index);
         info.balance = i.second;
         info.unlocked_balance = unlocked_balance_per_subaddress[i.first];
-        info.label = m_wallet->get_subaddress_label(index);
+        info.label = wallet->get_subaddress_label(index);
         info.num_unspent_outputs = std::count_if(transfers.begin(), transfers.end(), [&](const tools::wallet2::transfer_details& td) { return !td.m_spent && td.m_subaddr_index == index; });
         res.per_subaddress.push_back(info);
       }
@@ -526,14 +667,15 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_getaddress(const notary_rpc::COMMAND_RPC_GET_ADDRESS::request& req, notary_rpc::COMMAND_RPC_GET_ADDRESS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     try
     {
       res.addresses.clear();
       std::vector<uint32_t> req_address_index;
       if (req.address_index.empty())
       {
-        for (uint32_t i = 0; i < m_wallet->get_num_subaddresses(req.account_index); ++i)
+        for (uint32_t i = 0; i < wallet->get_num_subaddresses(req.account_index); ++i)
           req_address_index.push_back(i);
       }
       else
@@ -541,18 +683,18 @@ namespace tools
         req_address_index = req.address_index;
       }
       tools::wallet2::transfer_container transfers;
-      m_wallet->get_transfers(transfers);
+      wallet->get_transfers(transfers);
       for (uint32_t i : req_address_index)
       {
         res.addresses.resize(res.addresses.size() + 1);
         auto& info = res.addresses.back();
         const cryptonote::subaddress_index index = {req.account_index, i};
-        info.address = m_wallet->get_subaddress_as_str(index);
-        info.label = m_wallet->get_subaddress_label(index);
+        info.address = wallet->get_subaddress_as_str(index);
+        info.label = wallet->get_subaddress_label(index);
         info.address_index = index.minor;
         info.used = std::find_if(transfers.begin(), transfers.end(), [&](const tools::wallet2::transfer_details& td) { return td.m_subaddr_index == index; }) != transfers.end();
       }
-      res.address = m_wallet->get_subaddress_as_str({req.account_index, 0});
+      res.address = wallet->get_subaddress_as_str({req.account_index, 0});
     }
     catch (const std::exception& e)
     {
@@ -564,12 +706,13 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_create_address(const notary_rpc::COMMAND_RPC_CREATE_ADDRESS::request& req, notary_rpc::COMMAND_RPC_CREATE_ADDRESS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->add_subaddress(req.account_index, req.label);
-      res.address_index = m_wallet->get_num_subaddresses(req.account_index) - 1;
-      res.address = m_wallet->get_subaddress_as_str({req.account_index, res.address_index});
+      wallet->add_subaddress(req.account_index, req.label);
+      res.address_index = wallet->get_num_subaddresses(req.account_index) - 1;
+      res.address = wallet->get_subaddress_as_str({req.account_index, res.address_index});
     }
     catch (const std::exception& e)
     {
@@ -581,10 +724,11 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_label_address(const notary_rpc::COMMAND_RPC_LABEL_ADDRESS::request& req, notary_rpc::COMMAND_RPC_LABEL_ADDRESS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->set_subaddress_label(req.index, req.label);
+      wallet->set_subaddress_label(req.index, req.label);
     }
     catch (const std::exception& e)
     {
@@ -596,29 +740,30 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_accounts(const notary_rpc::COMMAND_RPC_GET_ACCOUNTS::request& req, notary_rpc::COMMAND_RPC_GET_ACCOUNTS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
       res.total_balance = 0;
       res.total_unlocked_balance = 0;
       cryptonote::subaddress_index subaddr_index = {0,0};
-      const std::pair<std::map<std::string, std::string>, std::vector<std::string>> account_tags = m_wallet->get_account_tags();
+      const std::pair<std::map<std::string, std::string>, std::vector<std::string>> account_tags = wallet->get_account_tags();
       if (!req.tag.empty() && account_tags.first.count(req.tag) == 0)
       {
         er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
         er.message = (boost::format(tr("Tag %s is unregistered.")) % req.tag).str();
         return false;
       }
-      for (; subaddr_index.major < m_wallet->get_num_subaddress_accounts(); ++subaddr_index.major)
+      for (; subaddr_index.major < wallet->get_num_subaddress_accounts(); ++subaddr_index.major)
       {
         if (!req.tag.empty() && req.tag != account_tags.second[subaddr_index.major])
           continue;
         notary_rpc::COMMAND_RPC_GET_ACCOUNTS::subaddress_account_info info;
         info.account_index = subaddr_index.major;
-        info.base_address = m_wallet->get_subaddress_as_str(subaddr_index);
-        info.balance = m_wallet->balance(subaddr_index.major);
-        info.unlocked_balance = m_wallet->unlocked_balance(subaddr_index.major);
-        info.label = m_wallet->get_subaddress_label(subaddr_index);
+        info.base_address = wallet->get_subaddress_as_str(subaddr_index);
+        info.balance = wallet->balance(subaddr_index.major);
+        info.unlocked_balance = wallet->unlocked_balance(subaddr_index.major);
+        info.label = wallet->get_subaddress_label(subaddr_index);
         info.tag = account_tags.second[subaddr_index.major];
         res.subaddress_accounts.push_back(info);
         res.total_balance += info.balance;
@@ -635,12 +780,13 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_create_account(const notary_rpc::COMMAND_RPC_CREATE_ACCOUNT::request& req, notary_rpc::COMMAND_RPC_CREATE_ACCOUNT::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->add_subaddress_account(req.label);
-      res.account_index = m_wallet->get_num_subaddress_accounts() - 1;
-      res.address = m_wallet->get_subaddress_as_str({res.account_index, 0});
+      wallet->add_subaddress_account(req.label);
+      res.account_index = wallet->get_num_subaddress_accounts() - 1;
+      res.address = wallet->get_subaddress_as_str({res.account_index, 0});
     }
     catch (const std::exception& e)
     {
@@ -652,10 +798,11 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_label_account(const notary_rpc::COMMAND_RPC_LABEL_ACCOUNT::request& req, notary_rpc::COMMAND_RPC_LABEL_ACCOUNT::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->set_subaddress_label({req.account_index, 0}, req.label);
+      wallet->set_subaddress_label({req.account_index, 0}, req.label);
     }
     catch (const std::exception& e)
     {
@@ -667,7 +814,9 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_account_tags(const notary_rpc::COMMAND_RPC_GET_ACCOUNT_TAGS::request& req, notary_rpc::COMMAND_RPC_GET_ACCOUNT_TAGS::response& res, epee::json_rpc::error& er)
   {
-    const std::pair<std::map<std::string, std::string>, std::vector<std::string>> account_tags = m_wallet->get_account_tags();
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    const std::pair<std::map<std::string, std::string>, std::vector<std::string>> account_tags = wallet->get_account_tags();
     for (const std::pair<const std::string, std::string>& p : account_tags.first)
     {
       res.account_tags.resize(res.account_tags.size() + 1);
@@ -685,9 +834,11 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_tag_accounts(const notary_rpc::COMMAND_RPC_TAG_ACCOUNTS::request& req, notary_rpc::COMMAND_RPC_TAG_ACCOUNTS::response& res, epee::json_rpc::error& er)
   {
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->set_account_tag(req.accounts, req.tag);
+      wallet->set_account_tag(req.accounts, req.tag);
     }
     catch (const std::exception& e)
     {
@@ -699,9 +850,11 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_untag_accounts(const notary_rpc::COMMAND_RPC_UNTAG_ACCOUNTS::request& req, notary_rpc::COMMAND_RPC_UNTAG_ACCOUNTS::response& res, epee::json_rpc::error& er)
   {
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->set_account_tag(req.accounts, "");
+      wallet->set_account_tag(req.accounts, "");
     }
     catch (const std::exception& e)
     {
@@ -713,9 +866,11 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_set_account_tag_description(const notary_rpc::COMMAND_RPC_SET_ACCOUNT_TAG_DESCRIPTION::request& req, notary_rpc::COMMAND_RPC_SET_ACCOUNT_TAG_DESCRIPTION::response& res, epee::json_rpc::error& er)
   {
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     try
     {
-      m_wallet->set_account_tag_description(req.tag, req.description);
+      wallet->set_account_tag_description(req.tag, req.description);
     }
     catch (const std::exception& e)
     {
@@ -727,10 +882,11 @@ namespace tools
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_getheight(const notary_rpc::COMMAND_RPC_GET_HEIGHT::request& req, notary_rpc::COMMAND_RPC_GET_HEIGHT::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     try
     {
-      res.height = m_wallet->get_blockchain_current_height();
+      res.height = wallet->get_blockchain_current_height();
     }
     catch (const std::exception& e)
     {
@@ -740,7 +896,7 @@ namespace tools
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  bool notary_server::validate_transfer(const std::list<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, epee::json_rpc::error& er)
+  bool notary_server::validate_transfer(const wallet2 &wallet, const std::list<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, epee::json_rpc::error& er)
   {
     crypto::hash8 integrated_payment_id = crypto::null_hash8;
     std::string extra_nonce;
@@ -749,7 +905,7 @@ namespace tools
       cryptonote::address_parse_info info;
       cryptonote::tx_destination_entry de;
       er.message = "";
-      if(!get_account_address_from_str(info, m_wallet->nettype(), it->address))
+      if(!get_account_address_from_str(info, wallet.nettype(), it->address))
       {
         er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
         if (er.message.empty())
@@ -823,7 +979,7 @@ namespace tools
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
-  bool notary_server::validate_ntz_transfer(const std::vector<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, int& sig_count, std::vector<int>& signers_index_vec, bool& already_signed, epee::json_rpc::error& er)
+  bool notary_server::validate_ntz_transfer(const wallet2 &wallet, const std::vector<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, int& sig_count, std::vector<int>& signers_index_vec, bool& already_signed, epee::json_rpc::error& er)
   {
     std::string ntz_txn_extra_data;
     already_signed = false;
@@ -833,7 +989,7 @@ namespace tools
       cryptonote::tx_destination_entry de;
       er.message = "";
 
-      if(!get_account_address_from_str(info, m_wallet->nettype(), it->address))
+      if(!get_account_address_from_str(info, wallet.nettype(), it->address))
       {
         er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
         if (er.message.empty())
@@ -909,12 +1065,12 @@ namespace tools
     size_t num_stdaddresses = 0;
     int sign_index = -1;
 
-    if (!get_account_address_from_str(info, m_wallet->nettype(), m_wallet->get_account().get_public_address_str(m_wallet->nettype()))) {
+    if (!get_account_address_from_str(info, wallet.nettype(), wallet.get_account().get_public_address_str(wallet.nettype()))) {
       MERROR("Unable to get our own address info from str!");
       return false;
     }
     cryptonote::account_public_address const& own_address = info.address;
-    cryptonote::account_keys const& own_keys = m_wallet->get_account().get_keys();
+    cryptonote::account_keys const& own_keys = wallet.get_account().get_keys();
 
     r = auth_and_get_ntz_signer_index(dsts, own_address, num_stdaddresses, own_keys, sign_index);
     if (!r) {
@@ -983,7 +1139,7 @@ namespace tools
   }
   //------------------------------------------------------------------------------------------------------------------------------
   template<typename Ts, typename Tu>
-  bool notary_server::fill_response(std::vector<tools::wallet2::pending_tx> &ptx_vector,
+  bool notary_server::fill_response(wallet2 &wallet, std::vector<tools::wallet2::pending_tx> &ptx_vector,
       bool get_tx_key, Ts& tx_key, Tu &amount, Tu &fee, std::string &multisig_txset, bool do_not_relay,
       Ts &tx_hash, bool get_tx_hex, Ts &tx_blob, bool get_tx_metadata, Ts &tx_metadata, epee::json_rpc::error &er)
   {
@@ -1001,9 +1157,9 @@ namespace tools
       fill(fee, ptx.fee);
     }
 
-    if (m_wallet->multisig())
+    if (wallet.multisig())
     {
-      multisig_txset = epee::string_tools::buff_to_hex_nodelimer(m_wallet->save_multisig_tx(ptx_vector));
+      multisig_txset = epee::string_tools::buff_to_hex_nodelimer(wallet.save_multisig_tx(ptx_vector));
       if (multisig_txset.empty())
       {
         er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
@@ -1037,8 +1193,9 @@ namespace tools
     std::vector<uint8_t> extra;
 
     LOG_PRINT_L3("on_transfer starts");
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1046,7 +1203,7 @@ namespace tools
     }
 
     // validate the transfer requested and populate dsts & extra
-    if (!validate_transfer(req.destinations, req.payment_id, dsts, extra, true, er))
+    if (!validate_transfer(*wallet, req.destinations, req.payment_id, dsts, extra, true, er))
     {
       return false;
     }
@@ -1056,14 +1213,14 @@ namespace tools
       uint64_t mixin;
       if(req.ring_size != 0)
       {
-        mixin = m_wallet->adjust_mixin(req.ring_size - 1);
+        mixin = wallet->adjust_mixin(req.ring_size - 1);
       }
       else
       {
-        mixin = m_wallet->adjust_mixin(req.mixin);
+        mixin = wallet->adjust_mixin(req.mixin);
       }
-      uint32_t priority = m_wallet->adjust_priority(req.priority);
-      std::vector<wallet2::pending_tx> ptx_vector = m_wallet->create_transactions_2(dsts, mixin, req.unlock_time, priority, extra, req.account_index, req.subaddr_indices, m_trusted_daemon);
+      uint32_t priority = wallet->adjust_priority(req.priority);
+      std::vector<wallet2::pending_tx> ptx_vector = wallet->create_transactions_2(dsts, mixin, req.unlock_time, priority, extra, req.account_index, req.subaddr_indices, m_trusted_daemon);
 
       if (ptx_vector.empty())
       {
@@ -1080,7 +1237,7 @@ namespace tools
         return false;
       }
 
-      return fill_response(ptx_vector, req.get_tx_key, res.tx_key, res.amount, res.fee, res.multisig_txset, req.do_not_relay,
+      return fill_response(*wallet, ptx_vector, req.get_tx_key, res.tx_key, res.amount, res.fee, res.multisig_txset, req.do_not_relay,
           res.tx_hash, req.get_tx_hex, res.tx_blob, req.get_tx_metadata, res.tx_metadata, er);
     }
     catch (const std::exception& e)
@@ -1097,8 +1254,9 @@ namespace tools
     std::vector<cryptonote::tx_destination_entry> dsts;
     std::vector<uint8_t> extra;
 
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1106,7 +1264,7 @@ namespace tools
     }
 
     // validate the transfer requested and populate dsts & extra; RPC_TRANSFER::request and RPC_TRANSFER_SPLIT::request are identical types.
-    if (!validate_transfer(req.destinations, req.payment_id, dsts, extra, true, er))
+    if (!validate_transfer(*wallet, req.destinations, req.payment_id, dsts, extra, true, er))
     {
       return false;
     }
@@ -1116,18 +1274,18 @@ namespace tools
       uint64_t mixin;
       if(req.ring_size != 0)
       {
-        mixin = m_wallet->adjust_mixin(req.ring_size - 1);
+        mixin = wallet->adjust_mixin(req.ring_size - 1);
       }
       else
       {
-        mixin = m_wallet->adjust_mixin(req.mixin);
+        mixin = wallet->adjust_mixin(req.mixin);
       }
-      uint32_t priority = m_wallet->adjust_priority(req.priority);
+      uint32_t priority = wallet->adjust_priority(req.priority);
       LOG_PRINT_L2("on_transfer_split calling create_transactions_2");
-      std::vector<wallet2::pending_tx> ptx_vector = m_wallet->create_transactions_2(dsts, mixin, req.unlock_time, priority, extra, req.account_index, req.subaddr_indices, m_trusted_daemon);
+      std::vector<wallet2::pending_tx> ptx_vector = wallet->create_transactions_2(dsts, mixin, req.unlock_time, priority, extra, req.account_index, req.subaddr_indices, m_trusted_daemon);
       LOG_PRINT_L2("on_transfer_split called create_transactions_2");
 
-      return fill_response(ptx_vector, req.get_tx_keys, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, req.do_not_relay,
+      return fill_response(*wallet, ptx_vector, req.get_tx_keys, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, req.do_not_relay,
           res.tx_hash_list, req.get_tx_hex, res.tx_blob_list, req.get_tx_metadata, res.tx_metadata_list, er);
     }
     catch (const std::exception& e)
@@ -1143,8 +1301,9 @@ namespace tools
     std::vector<cryptonote::tx_destination_entry> dsts;
     std::vector<uint8_t> extra;
 
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1156,7 +1315,7 @@ namespace tools
     destination.push_back(notary_rpc::transfer_destination());
     destination.back().amount = 0;
     destination.back().address = req.address;
-    if (!validate_transfer(destination, req.payment_id, dsts, extra, true, er))
+    if (!validate_transfer(*wallet, destination, req.payment_id, dsts, extra, true, er))
     {
       return false;
     }
@@ -1166,16 +1325,16 @@ namespace tools
       uint64_t mixin;
       if(req.ring_size != 0)
       {
-        mixin = m_wallet->adjust_mixin(req.ring_size - 1);
+        mixin = wallet->adjust_mixin(req.ring_size - 1);
       }
       else
       {
-        mixin = m_wallet->adjust_mixin(req.mixin);
+        mixin = wallet->adjust_mixin(req.mixin);
       }
-      uint32_t priority = m_wallet->adjust_priority(req.priority);
-      std::vector<wallet2::pending_tx> ptx_vector = m_wallet->create_transactions_all(req.below_amount, dsts[0].addr, dsts[0].is_subaddress, mixin, req.unlock_time, priority, extra, req.account_index, req.subaddr_indices, m_trusted_daemon);
+      uint32_t priority = wallet->adjust_priority(req.priority);
+      std::vector<wallet2::pending_tx> ptx_vector = wallet->create_transactions_all(req.below_amount, dsts[0].addr, dsts[0].is_subaddress, mixin, req.unlock_time, priority, extra, req.account_index, req.subaddr_indices, m_trusted_daemon);
 
-      return fill_response(ptx_vector, req.get_tx_keys, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, req.do_not_relay,
+      return fill_response(*wallet, ptx_vector, req.get_tx_keys, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, req.do_not_relay,
           res.tx_hash_list, req.get_tx_hex, res.tx_blob_list, req.get_tx_metadata, res.tx_metadata_list, er);
     }
     catch (const std::exception& e)
@@ -1194,8 +1353,9 @@ namespace tools
     int signer_index = -1;
     int sig_count = 0;
 
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1203,9 +1363,9 @@ namespace tools
     }
 
     cryptonote::address_parse_info info;
-    cryptonote::account_keys const& own_keys = m_wallet->get_account().get_keys();
+    cryptonote::account_keys const& own_keys = wallet->get_account().get_keys();
 
-    if (!get_account_address_from_str(info, m_wallet->nettype(), m_wallet->get_account().get_public_address_str(m_wallet->nettype()))) {
+    if (!get_account_address_from_str(info, wallet->nettype(), wallet->get_account().get_public_address_str(wallet->nettype()))) {
       MERROR("Unable to get our own address info from str!");
       return false;
     }
@@ -1213,7 +1373,7 @@ namespace tools
     cryptonote::account_public_address const& own_address = info.address;
     std::vector<notary_rpc::transfer_destination> not_validated_dsts;
     // validate function expects a vector
-    std::string address_str = get_account_address_as_str(m_wallet->nettype(), false, own_address);
+    std::string address_str = get_account_address_as_str(wallet->nettype(), false, own_address);
 
     // arbitrary, but meaningful: 1 * 10^(-8) BLUR
     notary_rpc::transfer_destination dest = AUTO_VAL_INIT(dest);
@@ -1230,7 +1390,7 @@ namespace tools
     std::string payment_id = "";
     std::vector<int> signers_index(DPOW_SIG_COUNT, -1);
     bool already_signed = false;
-    if (!validate_ntz_transfer(not_validated_dsts, payment_id, dsts, extra, true, sig_count, signers_index, already_signed, er)) {
+    if (!validate_ntz_transfer(*wallet, not_validated_dsts, payment_id, dsts, extra, true, sig_count, signers_index, already_signed, er)) {
       MERROR("Failed to validate_ntz_transfer in notary_server::create_ntz_transfer!");
       return false;
     }
@@ -1242,12 +1402,12 @@ namespace tools
 
     try
     {
-      uint64_t mixin = m_wallet->adjust_mixin(0);
+      uint64_t mixin = wallet->adjust_mixin(0);
       std::vector<tools::wallet2::pending_tx> pen_tx_vec;
-      uint32_t priority = m_wallet->adjust_priority(3);
-      uint64_t unlock_time = m_wallet->get_blockchain_current_height()-1;
+      uint32_t priority = wallet->adjust_priority(3);
+      uint64_t unlock_time = wallet->get_blockchain_current_height()-1;
       MINFO("create_ntz_transfer calling create_ntz_transactions");
-      std::vector<wallet2::pending_tx> ptx_vector = m_wallet->create_ntz_transactions(dsts, unlock_time, priority, extra, 0, {0,0}, m_trusted_daemon, sig_count, pen_tx_vec);
+      std::vector<wallet2::pending_tx> ptx_vector = wallet->create_ntz_transactions(dsts, unlock_time, priority, extra, 0, {0,0}, m_trusted_daemon, sig_count, pen_tx_vec);
       if (ptx_vector.empty()) {
         MERROR("Returned empty ptx in create_ntz_transfer(), probably failed to authenticate in wallet2...");
         return false;
@@ -1269,8 +1429,8 @@ namespace tools
       std::string const prior_ptx_hash = epee::string_tools::pod_to_hex(crypto::null_hash);
       res.sent_to_pool = false;
 
-      if (m_wallet->get_ntzpool_count(true) < 1) {
-        bool fill_res = fill_response(ptx_vector, true, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, false, res.tx_hash_list, true, res.tx_blob_list, true, res.tx_metadata_list, er);
+      if (wallet->get_ntzpool_count(true) < 1) {
+        bool fill_res = fill_response(*wallet, ptx_vector, true, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, false, res.tx_hash_list, true, res.tx_blob_list, true, res.tx_metadata_list, er);
         if (fill_res) {
           std::string tx_metadata;
           for (const auto& each : ptx_vector) {
@@ -1280,7 +1440,7 @@ namespace tools
            // MWARNING("Ptx to string: " << tx_metadata << ", ptx hash: " << epee::string_tools::pod_to_hex(ptx_hash) << std::endl);
             break;
           }
-          m_wallet->request_ntz_sig(tx_metadata, ptx_hash, ptx_vector, sig_count, payment_id, si_const, prior_tx_hash, prior_ptx_hash);
+          wallet->request_ntz_sig(tx_metadata, ptx_hash, ptx_vector, sig_count, payment_id, si_const, prior_tx_hash, prior_ptx_hash);
           MWARNING("Signatures < " << std::to_string(DPOW_SIG_COUNT) << ": [request_ntz_sig, from create_ntz_transfer] sent with sig_count: " << std::to_string(sig_count) << ", signers_index =  " << index_vec << ", and payment id: " << payment_id);
           res.sent_to_pool = true;
         }
@@ -1296,15 +1456,16 @@ namespace tools
 //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_append_ntz_sig(const notary_rpc::COMMAND_RPC_APPEND_NTZ_SIG::request& req, notary_rpc::COMMAND_RPC_APPEND_NTZ_SIG::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
       return false;
     }
 
-    size_t pool_count = m_wallet->get_ntzpool_count(true);
+    size_t pool_count = wallet->get_ntzpool_count(true);
     //MWARNING("Pool count: " << std::to_string(pool_count));
     if (pool_count < 1) {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
@@ -1319,7 +1480,7 @@ namespace tools
     cryptonote::blobdata ptx_blob, ptx_id;
     std::vector<cryptonote::ntz_tx_info> ntzpool_txs;
     std::vector<cryptonote::spent_key_image_info> ntzpool_keys;
-    m_wallet->get_ntzpool_txs_and_keys(ntzpool_txs, ntzpool_keys);
+    wallet->get_ntzpool_txs_and_keys(ntzpool_txs, ntzpool_keys);
     std::pair<int,size_t> best; best.first = 0; best.second = 0;
     std::string prior_tx_hash, prior_ptx_hash;
 
@@ -1451,9 +1612,9 @@ pool_recheck:
     //LOG_PRINT_L1("Recv derivations passed on index: " << std::to_string(pk_counter));
 
     cryptonote::address_parse_info info;
-    cryptonote::account_keys const& own_keys = m_wallet->get_account().get_keys();
+    cryptonote::account_keys const& own_keys = wallet->get_account().get_keys();
 
-    if (!get_account_address_from_str(info, m_wallet->nettype(), m_wallet->get_account().get_public_address_str(m_wallet->nettype()))) {
+    if (!get_account_address_from_str(info, wallet->nettype(), wallet->get_account().get_public_address_str(wallet->nettype()))) {
       MERROR("Unable to get our own address info from str!");
       return false;
     }
@@ -1461,7 +1622,7 @@ pool_recheck:
     cryptonote::account_public_address const& own_address = info.address;
     std::vector<notary_rpc::transfer_destination> not_validated_dsts;
     // validate function expects a vector
-    std::string address_str = get_account_address_as_str(m_wallet->nettype(), false, own_address);
+    std::string address_str = get_account_address_as_str(wallet->nettype(), false, own_address);
 
     // arbitrary, but meaningful: 1 * 10^(-8) BLUR
     notary_rpc::transfer_destination dest = AUTO_VAL_INIT(dest);
@@ -1471,11 +1632,11 @@ pool_recheck:
 
     std::string payment_id = req.payment_id;
     bool already_signed = false;
-    if (!validate_ntz_transfer(not_validated_dsts, payment_id, dsts, extra, true, sig_count, signers_index, already_signed, er)) {
+    if (!validate_ntz_transfer(*wallet, not_validated_dsts, payment_id, dsts, extra, true, sig_count, signers_index, already_signed, er)) {
       LOG_PRINT_L1("Transfer failed validation in validate_ntz_transfer!");
       std::list<std::string> tx_hashes;
       tx_hashes.push_back(tx_hash);
-      if (!m_wallet->remove_ntzpool_txs(tx_hashes)) {
+      if (!wallet->remove_ntzpool_txs(tx_hashes)) {
         MERROR("Error removing the tx that failed validation from ntz_pool!");
         return false;
       } else {
@@ -1499,21 +1660,21 @@ pool_recheck:
 
     try
     {
-      uint64_t mixin = m_wallet->adjust_mixin(sig_count);
+      uint64_t mixin = wallet->adjust_mixin(sig_count);
 
-      uint32_t priority = m_wallet->adjust_priority(3);
-      uint64_t unlock_time = m_wallet->get_blockchain_current_height()-1;
+      uint32_t priority = wallet->adjust_priority(3);
+      uint64_t unlock_time = wallet->get_blockchain_current_height()-1;
       std::vector<wallet2::pending_tx> ptx_vector;
-      ptx_vector = m_wallet->create_ntz_transactions(dsts, unlock_time, priority, extra, 0, {0,0}, m_trusted_daemon, sig_count, pen_tx_vec);
+      ptx_vector = wallet->create_ntz_transactions(dsts, unlock_time, priority, extra, 0, {0,0}, m_trusted_daemon, sig_count, pen_tx_vec);
       MINFO("create_ntz_transactions, from notary_server::append_ntz_sig called with sig_count = " << std::to_string(sig_count) <<
             ", and signers_index = " << index_str);
 
-      if (m_wallet->get_ntzpool_count(true) > 1)
+      if (wallet->get_ntzpool_count(true) > 1)
       {
         std::list<std::string> hashes;
         for (const auto& each : removals)
           hashes.push_back(each.first);
-        if(!m_wallet->remove_ntzpool_txs(hashes))
+        if(!wallet->remove_ntzpool_txs(hashes))
           MERROR("Failed to remove ntzpool txs!");
         //Not fatal
       }
@@ -1527,7 +1688,7 @@ pool_recheck:
       res.sent_to_pool = false;
       const std::vector<int> si_const = signers_index;
       crypto::hash ptx_hash;
-      bool fill_res = fill_response(ptx_vector, true, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, false,
+      bool fill_res = fill_response(*wallet, ptx_vector, true, res.tx_key_list, res.amount_list, res.fee_list, res.multisig_txset, false,
           res.tx_hash_list, true, res.tx_blob_list, true, res.tx_metadata_list, er);
       if (fill_res) {
         std::string tx_metadata;
@@ -1535,7 +1696,7 @@ pool_recheck:
         tx_metadata = hash_string.second;
         ptx_hash = hash_string.first;
 //          MWARNING("Ptx to string: " << tx_metadata << ", ptx hash: " << epee::string_tools::pod_to_hex(ptx_hash) << std::endl);
-        m_wallet->request_ntz_sig(tx_metadata, ptx_hash, ptx_vector, sig_count, payment_id, si_const, prior_tx_hash, prior_ptx_hash);
+        wallet->request_ntz_sig(tx_metadata, ptx_hash, ptx_vector, sig_count, payment_id, si_const, prior_tx_hash, prior_ptx_hash);
         res.sent_to_pool = true;
         MWARNING(" [request_ntz_sig, from append_ntz_sig] sent with sig_count: " << std::to_string(sig_count) << ", signers_index =  " << index_vec << ", and payment id: " << payment_id);
       }
@@ -1554,8 +1715,9 @@ pool_recheck:
     std::vector<cryptonote::tx_destination_entry> dsts;
     std::vector<uint8_t> extra;
 
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1567,7 +1729,7 @@ pool_recheck:
     destination.push_back(notary_rpc::transfer_destination());
     destination.back().amount = 0;
     destination.back().address = req.address;
-    if (!validate_transfer(destination, req.payment_id, dsts, extra, true, er))
+    if (!validate_transfer(*wallet, destination, req.payment_id, dsts, extra, true, er))
     {
       return false;
     }
@@ -1585,14 +1747,14 @@ pool_recheck:
       uint64_t mixin;
       if(req.ring_size != 0)
       {
-        mixin = m_wallet->adjust_mixin(req.ring_size - 1);
+        mixin = wallet->adjust_mixin(req.ring_size - 1);
       }
       else
       {
-        mixin = m_wallet->adjust_mixin(req.mixin);
+        mixin = wallet->adjust_mixin(req.mixin);
       }
-      uint32_t priority = m_wallet->adjust_priority(req.priority);
-      std::vector<wallet2::pending_tx> ptx_vector = m_wallet->create_transactions_single(ki, dsts[0].addr, dsts[0].is_subaddress, mixin, req.unlock_time, priority, extra, m_trusted_daemon);
+      uint32_t priority = wallet->adjust_priority(req.priority);
+      std::vector<wallet2::pending_tx> ptx_vector = wallet->create_transactions_single(ki, dsts[0].addr, dsts[0].is_subaddress, mixin, req.unlock_time, priority, extra, m_trusted_daemon);
 
       if (ptx_vector.empty())
       {
@@ -1614,7 +1776,7 @@ pool_recheck:
         return false;
       }
 
-      return fill_response(ptx_vector, req.get_tx_key, res.tx_key, res.amount, res.fee, res.multisig_txset, req.do_not_relay,
+      return fill_response(*wallet, ptx_vector, req.get_tx_key, res.tx_key, res.amount, res.fee, res.multisig_txset, req.do_not_relay,
           res.tx_hash, req.get_tx_hex, res.tx_blob, req.get_tx_metadata, res.tx_metadata, er);
     }
     catch (const std::exception& e)
@@ -1633,7 +1795,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_relay_tx(const notary_rpc::COMMAND_RPC_RELAY_TX::request& req, notary_rpc::COMMAND_RPC_RELAY_TX::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     cryptonote::blobdata blob;
     if (!epee::string_tools::parse_hexstr_to_binbuff(req.hex, blob))
@@ -1659,7 +1822,7 @@ pool_recheck:
 
     try
     {
-      m_wallet->commit_tx(ptx);
+      wallet->commit_tx(ptx);
     }
     catch(const std::exception &e)
     {
@@ -1675,7 +1838,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_make_integrated_address(const notary_rpc::COMMAND_RPC_MAKE_INTEGRATED_ADDRESS::request& req, notary_rpc::COMMAND_RPC_MAKE_INTEGRATED_ADDRESS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     try
     {
       crypto::hash8 payment_id;
@@ -1693,7 +1857,7 @@ pool_recheck:
         }
       }
 
-      res.integrated_address = m_wallet->get_integrated_address_as_str(payment_id);
+      res.integrated_address = wallet->get_integrated_address_as_str(payment_id);
       res.payment_id = epee::string_tools::pod_to_hex(payment_id);
       return true;
     }
@@ -1707,12 +1871,13 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_split_integrated_address(const notary_rpc::COMMAND_RPC_SPLIT_INTEGRATED_ADDRESS::request& req, notary_rpc::COMMAND_RPC_SPLIT_INTEGRATED_ADDRESS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     try
     {
       cryptonote::address_parse_info info;
 
-      if(!get_account_address_from_str(info, m_wallet->nettype(), req.integrated_address))
+      if(!get_account_address_from_str(info, wallet->nettype(), req.integrated_address))
       {
         er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
         er.message = "Invalid address";
@@ -1724,7 +1889,7 @@ pool_recheck:
         er.message = "Address is not an integrated address";
         return false;
       }
-      res.standard_address = get_account_address_as_str(m_wallet->nettype(), info.is_subaddress, info.address);
+      res.standard_address = get_account_address_as_str(wallet->nettype(), info.is_subaddress, info.address);
       res.payment_id = epee::string_tools::pod_to_hex(info.payment_id);
       return true;
     }
@@ -1738,8 +1903,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_store(const notary_rpc::COMMAND_RPC_STORE::request& req, notary_rpc::COMMAND_RPC_STORE::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1748,7 +1914,7 @@ pool_recheck:
 
     try
     {
-      m_wallet->store();
+      wallet->store();
     }
     catch (const std::exception& e)
     {
@@ -1760,7 +1926,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_payments(const notary_rpc::COMMAND_RPC_GET_PAYMENTS::request& req, notary_rpc::COMMAND_RPC_GET_PAYMENTS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     crypto::hash payment_id;
     crypto::hash8 payment_id8;
     cryptonote::blobdata payment_id_blob;
@@ -1790,7 +1957,7 @@ pool_recheck:
 
     res.payments.clear();
     std::list<wallet2::payment_details> payment_list;
-    m_wallet->get_payments(payment_id, payment_list);
+    wallet->get_payments(payment_id, payment_list);
     for (auto & payment : payment_list)
     {
       notary_rpc::payment_details rpc_payment;
@@ -1800,7 +1967,7 @@ pool_recheck:
       rpc_payment.block_height = payment.m_block_height;
       rpc_payment.unlock_time  = payment.m_unlock_time;
       rpc_payment.subaddr_index = payment.m_subaddr_index;
-      rpc_payment.address      = m_wallet->get_subaddress_as_str(payment.m_subaddr_index);
+      rpc_payment.address      = wallet->get_subaddress_as_str(payment.m_subaddr_index);
       res.payments.push_back(rpc_payment);
     }
 
@@ -1810,13 +1977,14 @@ pool_recheck:
   bool notary_server::on_get_bulk_payments(const notary_rpc::COMMAND_RPC_GET_BULK_PAYMENTS::request& req, notary_rpc::COMMAND_RPC_GET_BULK_PAYMENTS::response& res, epee::json_rpc::error& er)
   {
     res.payments.clear();
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
 
     /* If the payment ID list is empty, we get payments to any payment ID (or lack thereof) */
     if (req.payment_ids.empty())
     {
       std::list<std::pair<crypto::hash,wallet2::payment_details>> payment_list;
-      m_wallet->get_payments(payment_list, req.min_block_height);
+      wallet->get_payments(payment_list, req.min_block_height);
 
       for (auto & payment : payment_list)
       {
@@ -1827,7 +1995,7 @@ pool_recheck:
         rpc_payment.block_height = payment.second.m_block_height;
         rpc_payment.unlock_time  = payment.second.m_unlock_time;
         rpc_payment.subaddr_index = payment.second.m_subaddr_index;
-        rpc_payment.address      = m_wallet->get_subaddress_as_str(payment.second.m_subaddr_index);
+        rpc_payment.address      = wallet->get_subaddress_as_str(payment.second.m_subaddr_index);
         res.payments.push_back(std::move(rpc_payment));
       }
 
@@ -1867,7 +2035,7 @@ pool_recheck:
       }
 
       std::list<wallet2::payment_details> payment_list;
-      m_wallet->get_payments(payment_id, payment_list, req.min_block_height);
+      wallet->get_payments(payment_id, payment_list, req.min_block_height);
 
       for (auto & payment : payment_list)
       {
@@ -1878,7 +2046,7 @@ pool_recheck:
         rpc_payment.block_height = payment.m_block_height;
         rpc_payment.unlock_time  = payment.m_unlock_time;
         rpc_payment.subaddr_index = payment.m_subaddr_index;
-        rpc_payment.address      = m_wallet->get_subaddress_as_str(payment.m_subaddr_index);
+        rpc_payment.address      = wallet->get_subaddress_as_str(payment.m_subaddr_index);
         res.payments.push_back(std::move(rpc_payment));
       }
     }
@@ -1888,7 +2056,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_incoming_transfers(const notary_rpc::COMMAND_RPC_INCOMING_TRANSFERS::request& req, notary_rpc::COMMAND_RPC_INCOMING_TRANSFERS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     if(req.transfer_type.compare("all") != 0 && req.transfer_type.compare("available") != 0 && req.transfer_type.compare("unavailable") != 0)
     {
       er.code = NOTARY_RPC_ERROR_CODE_TRANSFER_TYPE;
@@ -1910,7 +2079,7 @@ pool_recheck:
     }
 
     wallet2::transfer_container transfers;
-    m_wallet->get_transfers(transfers);
+    wallet->get_transfers(transfers);
 
     bool transfers_found = false;
     for (const auto& td : transfers)
@@ -1941,8 +2110,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_query_key(const notary_rpc::COMMAND_RPC_QUERY_KEY::request& req, notary_rpc::COMMAND_RPC_QUERY_KEY::response& res, epee::json_rpc::error& er)
   {
-      if (!m_wallet) return not_open(er);
-      if (m_wallet->restricted())
+      auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
+      if (wallet->restricted())
       {
         er.code = NOTARY_RPC_ERROR_CODE_DENIED;
         er.message = "Command unavailable in restricted mode.";
@@ -1951,7 +2121,7 @@ pool_recheck:
 
       if (req.key_type.compare("mnemonic") == 0)
       {
-        if (!m_wallet->get_seed(res.key))
+        if (!wallet->get_seed(res.key))
         {
             er.message = "The wallet is non-deterministic. Cannot display seed.";
             return false;
@@ -1959,11 +2129,11 @@ pool_recheck:
       }
       else if(req.key_type.compare("view_key") == 0)
       {
-          res.key = string_tools::pod_to_hex(m_wallet->get_account().get_keys().m_view_secret_key);
+          res.key = string_tools::pod_to_hex(wallet->get_account().get_keys().m_view_secret_key);
       }
       else if(req.key_type.compare("spend_key") == 0)
       {
-          res.key = string_tools::pod_to_hex(m_wallet->get_account().get_keys().m_spend_secret_key);
+          res.key = string_tools::pod_to_hex(wallet->get_account().get_keys().m_spend_secret_key);
       }
       else
       {
@@ -1976,8 +2146,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_rescan_blockchain(const notary_rpc::COMMAND_RPC_RESCAN_BLOCKCHAIN::request& req, notary_rpc::COMMAND_RPC_RESCAN_BLOCKCHAIN::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -1986,7 +2157,7 @@ pool_recheck:
 
     try
     {
-      m_wallet->rescan_blockchain();
+      wallet->rescan_blockchain();
     }
     catch (const std::exception& e)
     {
@@ -1998,22 +2169,24 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_sign(const notary_rpc::COMMAND_RPC_SIGN::request& req, notary_rpc::COMMAND_RPC_SIGN::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
       return false;
     }
 
-    res.signature = m_wallet->sign(req.data);
+    res.signature = wallet->sign(req.data);
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_verify(const notary_rpc::COMMAND_RPC_VERIFY::request& req, notary_rpc::COMMAND_RPC_VERIFY::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2022,20 +2195,21 @@ pool_recheck:
 
     cryptonote::address_parse_info info;
     er.message = "";
-    if(!get_account_address_from_str(info, m_wallet->nettype(), req.address))
+    if(!get_account_address_from_str(info, wallet->nettype(), req.address))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
       return false;
     }
 
-    res.good = m_wallet->verify(req.data, info.address, req.signature);
+    res.good = wallet->verify(req.data, info.address, req.signature);
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_stop_wallet(const notary_rpc::COMMAND_RPC_STOP_WALLET::request& req, notary_rpc::COMMAND_RPC_STOP_WALLET::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2044,7 +2218,7 @@ pool_recheck:
 
     try
     {
-      m_wallet->store();
+      wallet->store();
       m_stop.store(true, std::memory_order_relaxed);
     }
     catch (const std::exception& e)
@@ -2057,8 +2231,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_set_tx_notes(const notary_rpc::COMMAND_RPC_SET_TX_NOTES::request& req, notary_rpc::COMMAND_RPC_SET_TX_NOTES::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2092,7 +2267,7 @@ pool_recheck:
     std::list<std::string>::const_iterator in = req.notes.begin();
     while (il != txids.end())
     {
-      m_wallet->set_tx_note(*il++, *in++);
+      wallet->set_tx_note(*il++, *in++);
     }
 
     return true;
@@ -2101,7 +2276,8 @@ pool_recheck:
   bool notary_server::on_get_tx_notes(const notary_rpc::COMMAND_RPC_GET_TX_NOTES::request& req, notary_rpc::COMMAND_RPC_GET_TX_NOTES::response& res, epee::json_rpc::error& er)
   {
     res.notes.clear();
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
 
     std::list<crypto::hash> txids;
     std::list<std::string>::const_iterator i = req.txids.begin();
@@ -2122,42 +2298,45 @@ pool_recheck:
     std::list<crypto::hash>::const_iterator il = txids.begin();
     while (il != txids.end())
     {
-      res.notes.push_back(m_wallet->get_tx_note(*il++));
+      res.notes.push_back(wallet->get_tx_note(*il++));
     }
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_set_attribute(const notary_rpc::COMMAND_RPC_SET_ATTRIBUTE::request& req, notary_rpc::COMMAND_RPC_SET_ATTRIBUTE::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
       return false;
     }
 
-    m_wallet->set_attribute(req.key, req.value);
+    wallet->set_attribute(req.key, req.value);
 
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_attribute(const notary_rpc::COMMAND_RPC_GET_ATTRIBUTE::request& req, notary_rpc::COMMAND_RPC_GET_ATTRIBUTE::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
       return false;
     }
 
-    res.value = m_wallet->get_attribute(req.key);
+    res.value = wallet->get_attribute(req.key);
     return true;
   }
   bool notary_server::on_get_tx_key(const notary_rpc::COMMAND_RPC_GET_TX_KEY::request& req, notary_rpc::COMMAND_RPC_GET_TX_KEY::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
 
     crypto::hash txid;
     if (!epee::string_tools::hex_to_pod(req.txid, txid))
@@ -2169,7 +2348,7 @@ pool_recheck:
 
     crypto::secret_key tx_key;
     std::vector<crypto::secret_key> additional_tx_keys;
-    if (!m_wallet->get_tx_key(txid, tx_key, additional_tx_keys))
+    if (!wallet->get_tx_key(txid, tx_key, additional_tx_keys))
     {
       er.code = NOTARY_RPC_ERROR_CODE_NO_TXKEY;
       er.message = "No tx secret key is stored for this tx";
@@ -2186,7 +2365,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_check_tx_key(const notary_rpc::COMMAND_RPC_CHECK_TX_KEY::request& req, notary_rpc::COMMAND_RPC_CHECK_TX_KEY::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     crypto::hash txid;
     if (!epee::string_tools::hex_to_pod(req.txid, txid))
@@ -2219,7 +2399,7 @@ pool_recheck:
     }
 
     cryptonote::address_parse_info info;
-    if(!get_account_address_from_str(info, m_wallet->nettype(), req.address))
+    if(!get_account_address_from_str(info, wallet->nettype(), req.address))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
       er.message = "Invalid address";
@@ -2228,7 +2408,7 @@ pool_recheck:
 
     try
     {
-      m_wallet->check_tx_key(txid, tx_key, additional_tx_keys, info.address, res.received, res.in_pool, res.confirmations, res.rawconfirmations);
+      wallet->check_tx_key(txid, tx_key, additional_tx_keys, info.address, res.received, res.in_pool, res.confirmations, res.rawconfirmations);
     }
     catch (const std::exception &e)
     {
@@ -2241,7 +2421,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_tx_proof(const notary_rpc::COMMAND_RPC_GET_TX_PROOF::request& req, notary_rpc::COMMAND_RPC_GET_TX_PROOF::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     crypto::hash txid;
     if (!epee::string_tools::hex_to_pod(req.txid, txid))
@@ -2252,7 +2433,7 @@ pool_recheck:
     }
 
     cryptonote::address_parse_info info;
-    if(!get_account_address_from_str(info, m_wallet->nettype(), req.address))
+    if(!get_account_address_from_str(info, wallet->nettype(), req.address))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
       er.message = "Invalid address";
@@ -2261,7 +2442,7 @@ pool_recheck:
 
     try
     {
-      res.signature = m_wallet->get_tx_proof(txid, info.address, info.is_subaddress, req.message);
+      res.signature = wallet->get_tx_proof(txid, info.address, info.is_subaddress, req.message);
     }
     catch (const std::exception &e)
     {
@@ -2274,7 +2455,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_check_tx_proof(const notary_rpc::COMMAND_RPC_CHECK_TX_PROOF::request& req, notary_rpc::COMMAND_RPC_CHECK_TX_PROOF::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     crypto::hash txid;
     if (!epee::string_tools::hex_to_pod(req.txid, txid))
@@ -2285,7 +2467,7 @@ pool_recheck:
     }
 
     cryptonote::address_parse_info info;
-    if(!get_account_address_from_str(info, m_wallet->nettype(), req.address))
+    if(!get_account_address_from_str(info, wallet->nettype(), req.address))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
       er.message = "Invalid address";
@@ -2298,7 +2480,7 @@ pool_recheck:
       bool in_pool;
       uint64_t confirmations;
       uint64_t rawconfirmations;
-      res.good = m_wallet->check_tx_proof(txid, info.address, info.is_subaddress, req.message, req.signature, res.received, res.in_pool, res.confirmations, res.rawconfirmations);
+      res.good = wallet->check_tx_proof(txid, info.address, info.is_subaddress, req.message, req.signature, res.received, res.in_pool, res.confirmations, res.rawconfirmations);
     }
     catch (const std::exception &e)
     {
@@ -2311,7 +2493,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_spend_proof(const notary_rpc::COMMAND_RPC_GET_SPEND_PROOF::request& req, notary_rpc::COMMAND_RPC_GET_SPEND_PROOF::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     crypto::hash txid;
     if (!epee::string_tools::hex_to_pod(req.txid, txid))
@@ -2323,7 +2506,7 @@ pool_recheck:
 
     try
     {
-      res.signature = m_wallet->get_spend_proof(txid, req.message);
+      res.signature = wallet->get_spend_proof(txid, req.message);
     }
     catch (const std::exception &e)
     {
@@ -2336,7 +2519,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_check_spend_proof(const notary_rpc::COMMAND_RPC_CHECK_SPEND_PROOF::request& req, notary_rpc::COMMAND_RPC_CHECK_SPEND_PROOF::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     crypto::hash txid;
     if (!epee::string_tools::hex_to_pod(req.txid, txid))
@@ -2348,7 +2532,7 @@ pool_recheck:
 
     try
     {
-      res.good = m_wallet->check_spend_proof(txid, req.message, req.signature);
+      res.good = wallet->check_spend_proof(txid, req.message, req.signature);
     }
     catch (const std::exception &e)
     {
@@ -2361,12 +2545,13 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_reserve_proof(const notary_rpc::COMMAND_RPC_GET_RESERVE_PROOF::request& req, notary_rpc::COMMAND_RPC_GET_RESERVE_PROOF::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     boost::optional<std::pair<uint32_t, uint64_t>> account_minreserve;
     if (!req.all)
     {
-      if (req.account_index >= m_wallet->get_num_subaddress_accounts())
+      if (req.account_index >= wallet->get_num_subaddress_accounts())
       {
         er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
         er.message = "Account index is out of bound";
@@ -2377,7 +2562,7 @@ pool_recheck:
 
     try
     {
-      res.signature = m_wallet->get_reserve_proof(account_minreserve, req.message);
+      res.signature = wallet->get_reserve_proof(account_minreserve, req.message);
     }
     catch (const std::exception &e)
     {
@@ -2390,10 +2575,11 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_check_reserve_proof(const notary_rpc::COMMAND_RPC_CHECK_RESERVE_PROOF::request& req, notary_rpc::COMMAND_RPC_CHECK_RESERVE_PROOF::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
 
     cryptonote::address_parse_info info;
-    if (!get_account_address_from_str(info, m_wallet->nettype(), req.address))
+    if (!get_account_address_from_str(info, wallet->nettype(), req.address))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
       er.message = "Invalid address";
@@ -2408,7 +2594,7 @@ pool_recheck:
 
     try
     {
-      res.good = m_wallet->check_reserve_proof(info.address, req.message, req.signature, res.total, res.spent);
+      res.good = wallet->check_reserve_proof(info.address, req.message, req.signature, res.total, res.spent);
     }
     catch (const std::exception &e)
     {
@@ -2421,8 +2607,19 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_transfers(const notary_rpc::COMMAND_RPC_GET_TRANSFERS::request& req, notary_rpc::COMMAND_RPC_GET_TRANSFERS::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    if (req.pool)
+    {
+      // the only step that mutates the wallet, done up front so the
+      // listing itself can share the wallet with other readers
+      auto wallet = m_wallet.write();
+      if (!wallet) return not_open(er);
+      if (!wallet->restricted())
+        wallet->update_pool_state();
+    }
+
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2439,26 +2636,26 @@ pool_recheck:
     if (req.in)
     {
       std::list<std::pair<crypto::hash, tools::wallet2::payment_details>> payments;
-      m_wallet->get_payments(payments, min_height, max_height, req.account_index, req.subaddr_indices);
+      wallet->get_payments(payments, min_height, max_height, req.account_index, req.subaddr_indices);
       for (std::list<std::pair<crypto::hash, tools::wallet2::payment_details>>::const_iterator i = payments.begin(); i != payments.end(); ++i) {
         res.in.push_back(notary_rpc::transfer_entry());
-        fill_transfer_entry(res.in.back(), i->second.m_tx_hash, i->first, i->second);
+        fill_transfer_entry(*wallet, res.in.back(), i->second.m_tx_hash, i->first, i->second);
       }
     }
 
     if (req.out)
     {
       std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>> payments;
-      m_wallet->get_payments_out(payments, min_height, max_height, req.account_index, req.subaddr_indices);
+      wallet->get_payments_out(payments, min_height, max_height, req.account_index, req.subaddr_indices);
       for (std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>>::const_iterator i = payments.begin(); i != payments.end(); ++i) {
         res.out.push_back(notary_rpc::transfer_entry());
-        fill_transfer_entry(res.out.back(), i->first, i->second);
+        fill_transfer_entry(*wallet, res.out.back(), i->first, i->second);
       }
     }
 
     if (req.pending || req.failed) {
       std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>> upayments;
-      m_wallet->get_unconfirmed_payments_out(upayments, req.account_index, req.subaddr_indices);
+      wallet->get_unconfirmed_payments_out(upayments, req.account_index, req.subaddr_indices);
       for (std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>>::const_iterator i = upayments.begin(); i != upayments.end(); ++i) {
         const tools::wallet2::unconfirmed_transfer_details &pd = i->second;
         bool is_failed = pd.m_state == tools::wallet2::unconfirmed_transfer_details::failed;
@@ -2466,19 +2663,17 @@ pool_recheck:
           continue;
         std::list<notary_rpc::transfer_entry> &entries = is_failed ? res.failed : res.pending;
         entries.push_back(notary_rpc::transfer_entry());
-        fill_transfer_entry(entries.back(), i->first, i->second);
+        fill_transfer_entry(*wallet, entries.back(), i->first, i->second);
       }
     }
 
     if (req.pool)
     {
-      m_wallet->update_pool_state();
-
       std::list<std::pair<crypto::hash, tools::wallet2::pool_payment_details>> payments;
-      m_wallet->get_unconfirmed_payments(payments, req.account_index, req.subaddr_indices);
+      wallet->get_unconfirmed_payments(payments, req.account_index, req.subaddr_indices);
       for (std::list<std::pair<crypto::hash, tools::wallet2::pool_payment_details>>::const_iterator i = payments.begin(); i != payments.end(); ++i) {
         res.pool.push_back(notary_rpc::transfer_entry());
-        fill_transfer_entry(res.pool.back(), i->first, i->second);
+        fill_transfer_entry(*wallet, res.pool.back(), i->first, i->second);
       }
     }
 
@@ -2487,14 +2682,6 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_transfer_by_txid(const notary_rpc::COMMAND_RPC_GET_TRANSFER_BY_TXID::request& req, notary_rpc::COMMAND_RPC_GET_TRANSFER_BY_TXID::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
-    {
-      er.code = NOTARY_RPC_ERROR_CODE_DENIED;
-      er.message = "Command unavailable in restricted mode.";
-      return false;
-    }
-
     crypto::hash txid;
     cryptonote::blobdata txid_blob;
     if(!epee::string_tools::parse_hexstr_to_binbuff(req.txid, txid_blob))
@@ -2515,51 +2702,68 @@ pool_recheck:
       return false;
     }
 
-    if (req.account_index >= m_wallet->get_num_subaddress_accounts())
     {
-      er.code = NOTARY_RPC_ERROR_CODE_ACCOUNT_INDEX_OUT_OF_BOUNDS;
-      er.message = "Account index is out of bound";
-      return false;
-    }
-
-    std::list<std::pair<crypto::hash, tools::wallet2::payment_details>> payments;
-    m_wallet->get_payments(payments, 0, (uint64_t)-1, req.account_index);
-    for (std::list<std::pair<crypto::hash, tools::wallet2::payment_details>>::const_iterator i = payments.begin(); i != payments.end(); ++i) {
-      if (i->second.m_tx_hash == txid)
+      auto wallet = m_wallet.read();
+      if (!wallet) return not_open(er);
+      if (wallet->restricted())
       {
-        fill_transfer_entry(res.transfer, i->second.m_tx_hash, i->first, i->second);
-        return true;
+        er.code = NOTARY_RPC_ERROR_CODE_DENIED;
+        er.message = "Command unavailable in restricted mode.";
+        return false;
       }
-    }
 
-    std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>> payments_out;
-    m_wallet->get_payments_out(payments_out, 0, (uint64_t)-1, req.account_index);
-    for (std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>>::const_iterator i = payments_out.begin(); i != payments_out.end(); ++i) {
-      if (i->first == txid)
+      if (req.account_index >= wallet->get_num_subaddress_accounts())
       {
-        fill_transfer_entry(res.transfer, i->first, i->second);
-        return true;
+        er.code = NOTARY_RPC_ERROR_CODE_ACCOUNT_INDEX_OUT_OF_BOUNDS;
+        er.message = "Account index is out of bound";
+        return false;
       }
-    }
 
-    std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>> upayments;
-    m_wallet->get_unconfirmed_payments_out(upayments, req.account_index);
-    for (std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>>::const_iterator i = upayments.begin(); i != upayments.end(); ++i) {
-      if (i->first == txid)
-      {
-        fill_transfer_entry(res.transfer, i->first, i->second);
-        return true;
+      std::list<std::pair<crypto::hash, tools::wallet2::payment_details>> payments;
+      wallet->get_payments(payments, 0, (uint64_t)-1, req.account_index);
+      for (std::list<std::pair<crypto::hash, tools::wallet2::payment_details>>::const_iterator i = payments.begin(); i != payments.end(); ++i) {
+        if (i->second.m_tx_hash == txid)
+        {
+          fill_transfer_entry(*wallet, res.transfer, i->second.m_tx_hash, i->first, i->second);
+          return true;
+        }
+      }
+
+      std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>> payments_out;
+      wallet->get_payments_out(payments_out, 0, (uint64_t)-1, req.account_index);
+      for (std::list<std::pair<crypto::hash, tools::wallet2::confirmed_transfer_details>>::const_iterator i = payments_out.begin(); i != payments_out.end(); ++i) {
+        if (i->first == txid)
+        {
+          fill_transfer_entry(*wallet, res.transfer, i->first, i->second);
+          return true;
+        }
+      }
+
+      std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>> upayments;
+      wallet->get_unconfirmed_payments_out(upayments, req.account_index);
+      for (std::list<std::pair<crypto::hash, tools::wallet2::unconfirmed_transfer_details>>::const_iterator i = upayments.begin(); i != upayments.end(); ++i) {
+        if (i->first == txid)
+        {
+          fill_transfer_entry(*wallet, res.transfer, i->first, i->second);
+          return true;
+        }
       }
     }
 
-    m_wallet->update_pool_state();
+    {
+      auto wallet = m_wallet.write();
+      if (!wallet) return not_open(er);
+      wallet->update_pool_state();
+    }
 
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     std::list<std::pair<crypto::hash, tools::wallet2::pool_payment_details>> pool_payments;
-    m_wallet->get_unconfirmed_payments(pool_payments, req.account_index);
+    wallet->get_unconfirmed_payments(pool_payments, req.account_index);
     for (std::list<std::pair<crypto::hash, tools::wallet2::pool_payment_details>>::const_iterator i = pool_payments.begin(); i != pool_payments.end(); ++i) {
       if (i->second.m_pd.m_tx_hash == txid)
       {
-        fill_transfer_entry(res.transfer, i->first, i->second);
+        fill_transfer_entry(*wallet, res.transfer, i->first, i->second);
         return true;
       }
     }
@@ -2571,10 +2775,11 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_export_key_images(const notary_rpc::COMMAND_RPC_EXPORT_KEY_IMAGES::request& req, notary_rpc::COMMAND_RPC_EXPORT_KEY_IMAGES::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     try
     {
-      std::vector<std::pair<crypto::key_image, crypto::signature>> ski = m_wallet->export_key_images();
+      std::vector<std::pair<crypto::key_image, crypto::signature>> ski = wallet->export_key_images();
       res.signed_key_images.resize(ski.size());
       for (size_t n = 0; n < ski.size(); ++n)
       {
@@ -2594,8 +2799,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_import_key_images(const notary_rpc::COMMAND_RPC_IMPORT_KEY_IMAGES::request& req, notary_rpc::COMMAND_RPC_IMPORT_KEY_IMAGES::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2632,7 +2838,7 @@ pool_recheck:
         ski[n].second = *reinterpret_cast<const crypto::signature*>(bd.data());
       }
       uint64_t spent = 0, unspent = 0;
-      uint64_t height = m_wallet->import_key_images(ski, spent, unspent);
+      uint64_t height = wallet->import_key_images(ski, spent, unspent);
       res.spent = spent;
       res.unspent = unspent;
       res.height = height;
@@ -2649,8 +2855,10 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_make_uri(const notary_rpc::COMMAND_RPC_MAKE_URI::request& req, notary_rpc::COMMAND_RPC_MAKE_URI::response& res, epee::json_rpc::error& er)
   {
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
     std::string error;
-    std::string uri = m_wallet->make_uri(req.address, req.payment_id, req.amount, req.tx_description, req.recipient_name, error);
+    std::string uri = wallet->make_uri(req.address, req.payment_id, req.amount, req.tx_description, req.recipient_name, error);
     if (uri.empty())
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_URI;
@@ -2664,9 +2872,10 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_parse_uri(const notary_rpc::COMMAND_RPC_PARSE_URI::request& req, notary_rpc::COMMAND_RPC_PARSE_URI::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     std::string error;
-    if (!m_wallet->parse_uri(req.uri, res.uri.address, res.uri.payment_id, res.uri.amount, res.uri.tx_description, res.uri.recipient_name, res.unknown_parameters, error))
+    if (!wallet->parse_uri(req.uri, res.uri.address, res.uri.payment_id, res.uri.amount, res.uri.tx_description, res.uri.recipient_name, res.unknown_parameters, error))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_URI;
       er.message = "Error parsing URI: " + error;
@@ -2677,13 +2886,14 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_get_address_book(const notary_rpc::COMMAND_RPC_GET_ADDRESS_BOOK_ENTRY::request& req, notary_rpc::COMMAND_RPC_GET_ADDRESS_BOOK_ENTRY::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    const auto ab = m_wallet->get_address_book();
+    auto wallet = m_wallet.read();
+    if (!wallet) return not_open(er);
+    const auto ab = wallet->get_address_book();
     if (req.entries.empty())
     {
       uint64_t idx = 0;
       for (const auto &entry: ab)
-        res.entries.push_back(notary_rpc::COMMAND_RPC_GET_ADDRESS_BOOK_ENTRY::entry{idx++, get_account_address_as_str(m_wallet->nettype(), entry.m_is_subaddress, entry.m_address), epee::string_tools::pod_to_hex(entry.m_payment_id), entry.m_description});
+        res.entries.push_back(notary_rpc::COMMAND_RPC_GET_ADDRESS_BOOK_ENTRY::entry{idx++, get_account_address_as_str(wallet->nettype(), entry.m_is_subaddress, entry.m_address), epee::string_tools::pod_to_hex(entry.m_payment_id), entry.m_description});
     }
     else
     {
@@ -2696,7 +2906,7 @@ pool_recheck:
           return false;
         }
         const auto &entry = ab[idx];
-        res.entries.push_back(notary_rpc::COMMAND_RPC_GET_ADDRESS_BOOK_ENTRY::entry{idx, get_account_address_as_str(m_wallet->nettype(), entry.m_is_subaddress, entry.m_address), epee::string_tools::pod_to_hex(entry.m_payment_id), entry.m_description});
+        res.entries.push_back(notary_rpc::COMMAND_RPC_GET_ADDRESS_BOOK_ENTRY::entry{idx, get_account_address_as_str(wallet->nettype(), entry.m_is_subaddress, entry.m_address), epee::string_tools::pod_to_hex(entry.m_payment_id), entry.m_description});
       }
     }
     return true;
@@ -2704,8 +2914,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_add_address_book(const notary_rpc::COMMAND_RPC_ADD_ADDRESS_BOOK_ENTRY::request& req, notary_rpc::COMMAND_RPC_ADD_ADDRESS_BOOK_ENTRY::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2715,7 +2926,7 @@ pool_recheck:
     cryptonote::address_parse_info info;
     crypto::hash payment_id = crypto::null_hash;
     er.message = "";
-    if(!get_account_address_from_str(info, m_wallet->nettype(), req.address))
+    if(!get_account_address_from_str(info, wallet->nettype(), req.address))
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_ADDRESS;
       if (er.message.empty())
@@ -2754,34 +2965,35 @@ pool_recheck:
         }
       }
     }
-    if (!m_wallet->add_address_book_row(info.address, payment_id, req.description, info.is_subaddress))
+    if (!wallet->add_address_book_row(info.address, payment_id, req.description, info.is_subaddress))
     {
       er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
       er.message = "Failed to add address book entry";
       return false;
     }
-    res.index = m_wallet->get_address_book().size() - 1;
+    res.index = wallet->get_address_book().size() - 1;
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_delete_address_book(const notary_rpc::COMMAND_RPC_DELETE_ADDRESS_BOOK_ENTRY::request& req, notary_rpc::COMMAND_RPC_DELETE_ADDRESS_BOOK_ENTRY::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
       return false;
     }
 
-    const auto ab = m_wallet->get_address_book();
+    const auto ab = wallet->get_address_book();
     if (req.index >= ab.size())
     {
       er.code = NOTARY_RPC_ERROR_CODE_WRONG_INDEX;
       er.message = "Index out of range: " + std::to_string(req.index);
       return false;
     }
-    if (!m_wallet->delete_address_book_row(req.index))
+    if (!wallet->delete_address_book_row(req.index))
     {
       er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
       er.message = "Failed to delete address book entry";
@@ -2792,8 +3004,9 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_rescan_spent(const notary_rpc::COMMAND_RPC_RESCAN_SPENT::request& req, notary_rpc::COMMAND_RPC_RESCAN_SPENT::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
-    if (m_wallet->restricted())
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
+    if (wallet->restricted())
     {
       er.code = NOTARY_RPC_ERROR_CODE_DENIED;
       er.message = "Command unavailable in restricted mode.";
@@ -2801,7 +3014,7 @@ pool_recheck:
     }
     try
     {
-      m_wallet->rescan_spent();
+      wallet->rescan_spent();
       return true;
     }
     catch (const std::exception& e)
@@ -2814,7 +3027,8 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_start_mining(const notary_rpc::COMMAND_RPC_START_MINING::request& req, notary_rpc::COMMAND_RPC_START_MINING::response& res, epee::json_rpc::error& er)
   {
-    if (!m_wallet) return not_open(er);
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     if (!m_trusted_daemon)
     {
       er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
@@ -2831,11 +3045,11 @@ pool_recheck:
     }
 
     cryptonote::COMMAND_RPC_START_MINING::request daemon_req = AUTO_VAL_INIT(daemon_req); 
-    daemon_req.miner_address = m_wallet->get_account().get_public_address_str(m_wallet->nettype());
+    daemon_req.miner_address = wallet->get_account().get_public_address_str(wallet->nettype());
     daemon_req.threads_count        = req.threads_count;
 
     cryptonote::COMMAND_RPC_START_MINING::response daemon_res;
-    bool r = m_wallet->invoke_http_json("/start_mining", daemon_req, daemon_res);
+    bool r = wallet->invoke_http_json("/start_mining", daemon_req, daemon_res);
     if (!r || daemon_res.status != CORE_RPC_STATUS_OK)
     {
       er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
@@ -2847,9 +3061,11 @@ pool_recheck:
   //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_stop_mining(const notary_rpc::COMMAND_RPC_STOP_MINING::request& req, notary_rpc::COMMAND_RPC_STOP_MINING::response& res, epee::json_rpc::error& er)
   {
+    auto wallet = m_wallet.write();
+    if (!wallet) return not_open(er);
     cryptonote::COMMAND_RPC_STOP_MINING::request daemon_req;
     cryptonote::COMMAND_RPC_STOP_MINING::response daemon_res;
-    bool r = m_wallet->invoke_http_json("/stop_mining", daemon_req, daemon_res);
+    bool r = wallet->invoke_http_json("/stop_mining", daemon_req, daemon_res);
     if (!r || daemon_res.status != CORE_RPC_STATUS_OK)
     {
       er.code = NOTARY_RPC_ERROR_CODE_UNKNOWN_ERROR;
@@ -2865,6 +3081,13 @@ pool_recheck:
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool notary_server::on_get_ntz_round_stats(const notary_rpc::COMMAND_RPC_GET_NTZ_ROUND_STATS::request& req, notary_rpc::COMMAND_RPC_GET_NTZ_ROUND_STATS::response& res, epee::json_rpc::error& er)
+  {
+    boost::lock_guard<boost::mutex> lock(m_ntz_event_lock);
+    res = m_ntz_round_stats;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool notary_server::on_create_wallet(const notary_rpc::COMMAND_RPC_CREATE_WALLET::request& req, notary_rpc::COMMAND_RPC_CREATE_WALLET::response& res, epee::json_rpc::error& er)
   {
     if (m_notary_wallet_dir.empty())
@@ -2946,9 +3169,7 @@ pool_recheck:
       er.message = "Failed to generate wallet";
       return false;
     }
-    if (m_wallet)
-      delete m_wallet;
-    m_wallet = wal.release();
+    delete m_wallet.write().reset(wal.release());
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -3004,9 +3225,7 @@ pool_recheck:
       er.message = "Failed to open wallet";
       return false;
     }
-    if (m_wallet)
-      delete m_wallet;
-    m_wallet = wal.release();
+    delete m_wallet.write().reset(wal.release());
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -3109,6 +3328,7 @@ namespace po = boost::program_options;
   command_line::add_arg(desc_params, arg_from_json);
   command_line::add_arg(desc_params, arg_notary_wallet_dir);
   command_line::add_arg(desc_params, arg_prompt_for_password);
+  command_line::add_arg(desc_params, arg_rpc_threads);
 
   const auto vm = wallet_args::main(
     argc, argv,
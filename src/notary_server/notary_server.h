@@ -34,10 +34,14 @@
 
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <chrono>
 #include <string>
 #include "common/util.h"
 #include "net/http_server_impl_base.h"
 #include "notary_server_commands_defs.h"
+#include "wallet_facade.h"
 #include "wallet/wallet2.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -128,6 +132,7 @@ namespace tools
         MAP_JON_RPC_WE("start_mining",       on_start_mining,       notary_rpc::COMMAND_RPC_START_MINING)
         MAP_JON_RPC_WE("stop_mining",        on_stop_mining,        notary_rpc::COMMAND_RPC_STOP_MINING)
         MAP_JON_RPC_WE("get_languages",      on_get_languages,      notary_rpc::COMMAND_RPC_GET_LANGUAGES)
+        MAP_JON_RPC_WE("get_ntz_round_stats",on_get_ntz_round_stats,notary_rpc::COMMAND_RPC_GET_NTZ_ROUND_STATS)
         MAP_JON_RPC_WE("create_wallet",      on_create_wallet,      notary_rpc::COMMAND_RPC_CREATE_WALLET)
         MAP_JON_RPC_WE("open_wallet",        on_open_wallet,        notary_rpc::COMMAND_RPC_OPEN_WALLET)
       END_JSON_RPC_MAP()
@@ -146,8 +151,8 @@ namespace tools
       bool on_untag_accounts(const notary_rpc::COMMAND_RPC_UNTAG_ACCOUNTS::request& req, notary_rpc::COMMAND_RPC_UNTAG_ACCOUNTS::response& res, epee::json_rpc::error& er);
       bool on_set_account_tag_description(const notary_rpc::COMMAND_RPC_SET_ACCOUNT_TAG_DESCRIPTION::request& req, notary_rpc::COMMAND_RPC_SET_ACCOUNT_TAG_DESCRIPTION::response& res, epee::json_rpc::error& er);
       bool on_getheight(const notary_rpc::COMMAND_RPC_GET_HEIGHT::request& req, notary_rpc::COMMAND_RPC_GET_HEIGHT::response& res, epee::json_rpc::error& er);
-      bool validate_transfer(const std::list<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, epee::json_rpc::error& er);
-      bool validate_ntz_transfer(const std::vector<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, int& sig_count, std::vector<int>& signer_index_vec, bool& already_signed, epee::json_rpc::error& er);
+      bool validate_transfer(const wallet2 &wallet, const std::list<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, epee::json_rpc::error& er);
+      bool validate_ntz_transfer(const wallet2 &wallet, const std::vector<notary_rpc::transfer_destination>& destinations, const std::string& payment_id, std::vector<cryptonote::tx_destination_entry>& dsts, std::vector<uint8_t>& extra, bool at_least_one_destination, int& sig_count, std::vector<int>& signer_index_vec, bool& already_signed, epee::json_rpc::error& er);
       bool on_transfer(const notary_rpc::COMMAND_RPC_TRANSFER::request& req, notary_rpc::COMMAND_RPC_TRANSFER::response& res, epee::json_rpc::error& er);
       bool on_transfer_split(const notary_rpc::COMMAND_RPC_TRANSFER_SPLIT::request& req, notary_rpc::COMMAND_RPC_TRANSFER_SPLIT::response& res, epee::json_rpc::error& er);
       bool on_create_ntz_transfer(const notary_rpc::COMMAND_RPC_CREATE_NTZ_TRANSFER::request& req, notary_rpc::COMMAND_RPC_CREATE_NTZ_TRANSFER::response& res, epee::json_rpc::error& er);
@@ -190,6 +195,7 @@ namespace tools
       bool on_start_mining(const notary_rpc::COMMAND_RPC_START_MINING::request& req, notary_rpc::COMMAND_RPC_START_MINING::response& res, epee::json_rpc::error& er);
       bool on_stop_mining(const notary_rpc::COMMAND_RPC_STOP_MINING::request& req, notary_rpc::COMMAND_RPC_STOP_MINING::response& res, epee::json_rpc::error& er);
       bool on_get_languages(const notary_rpc::COMMAND_RPC_GET_LANGUAGES::request& req, notary_rpc::COMMAND_RPC_GET_LANGUAGES::response& res, epee::json_rpc::error& er);
+      bool on_get_ntz_round_stats(const notary_rpc::COMMAND_RPC_GET_NTZ_ROUND_STATS::request& req, notary_rpc::COMMAND_RPC_GET_NTZ_ROUND_STATS::response& res, epee::json_rpc::error& er);
       bool on_create_wallet(const notary_rpc::COMMAND_RPC_CREATE_WALLET::request& req, notary_rpc::COMMAND_RPC_CREATE_WALLET::response& res, epee::json_rpc::error& er);
       bool on_open_wallet(const notary_rpc::COMMAND_RPC_OPEN_WALLET::request& req, notary_rpc::COMMAND_RPC_OPEN_WALLET::response& res, epee::json_rpc::error& er);
 
@@ -197,25 +203,46 @@ namespace tools
       bool on_query_key(const notary_rpc::COMMAND_RPC_QUERY_KEY::request& req, notary_rpc::COMMAND_RPC_QUERY_KEY::response& res, epee::json_rpc::error& er);
 
       // helpers
-      void fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const crypto::hash &payment_id, const tools::wallet2::payment_details &pd);
-      void fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::confirmed_transfer_details &pd);
-      void fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::unconfirmed_transfer_details &pd);
-      void fill_transfer_entry(tools::notary_rpc::transfer_entry &entry, const crypto::hash &payment_id, const tools::wallet2::pool_payment_details &pd);
-      void get_ntzpool_tx_infos(std::vector<cryptonote::ntz_tx_info>& tx_infos);
+      void fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const crypto::hash &payment_id, const tools::wallet2::payment_details &pd);
+      void fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::confirmed_transfer_details &pd);
+      void fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &txid, const tools::wallet2::unconfirmed_transfer_details &pd);
+      void fill_transfer_entry(const wallet2 &wallet, tools::notary_rpc::transfer_entry &entry, const crypto::hash &payment_id, const tools::wallet2::pool_payment_details &pd);
       bool check_if_sent_to_pool();
+      void ntz_event_loop();
+      bool on_ntz_idle();
+      void ntz_round(bool chain_changed, bool ntzpool_changed, bool relay, const cryptonote::COMMAND_RPC_WAIT_NTZ_EVENT::response& event);
       bool not_open(epee::json_rpc::error& er);
       void handle_rpc_exception(const std::exception_ptr& e, epee::json_rpc::error& er, int default_error_code);
 
       template<typename Ts, typename Tu>
-      bool fill_response(std::vector<tools::wallet2::pending_tx> &ptx_vector,
+      bool fill_response(wallet2 &wallet, std::vector<tools::wallet2::pending_tx> &ptx_vector,
           bool get_tx_key, Ts& tx_key, Tu &amount, Tu &fee, std::string &multisig_txset, bool do_not_relay,
           Ts &tx_hash, bool get_tx_hex, Ts &tx_blob, bool get_tx_metadata, Ts &tx_metadata, epee::json_rpc::error &er);
 
-      wallet2 *m_wallet;
+      rw_wallet_facade<wallet2> m_wallet;
       std::string m_notary_wallet_dir;
       tools::private_file rpc_login_file;
       std::atomic<bool> m_stop;
       bool m_trusted_daemon;
       const boost::program_options::variables_map *m_vm;
+
+      // notarization state machine, only touched from the on_ntz_idle() handler
+      bool m_sent_to_pool;
+      uint64_t m_bound_ntz_count;
+      std::chrono::steady_clock::time_point m_last_ntz_round;
+      std::chrono::steady_clock::time_point m_last_ntz_relay;
+
+      // handed from the ntz event thread to the server thread, see ntz_event_loop()
+      boost::mutex m_ntz_event_lock;
+      boost::thread m_ntz_event_thread;
+      std::string m_event_daemon_address;
+      boost::optional<epee::net_utils::http::login> m_event_daemon_login;
+      epee::net_utils::http::http_simple_client m_event_http_client;
+      bool m_chain_event;
+      bool m_ntzpool_event;
+      std::chrono::steady_clock::time_point m_ntz_event_time;
+      cryptonote::COMMAND_RPC_WAIT_NTZ_EVENT::response m_ntz_event;
+      notary_rpc::COMMAND_RPC_GET_NTZ_ROUND_STATS::response m_ntz_round_stats;
+      uint64_t m_ntz_round_latency_total_ms;
   };
 }
@@ -1677,6 +1677,35 @@ namespace notary_rpc
     };
   };
 
+  struct COMMAND_RPC_GET_NTZ_ROUND_STATS
+  {
+    struct request
+    {
+      BEGIN_KV_SERIALIZE_MAP()
+      END_KV_SERIALIZE_MAP()
+    };
+    struct response
+    {
+      uint64_t rounds;
+      uint64_t timer_rounds;
+      uint64_t chain_events;
+      uint64_t ntzpool_events;
+      uint64_t last_round_latency_ms;
+      uint64_t avg_round_latency_ms;
+      uint64_t max_round_latency_ms;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(rounds)
+        KV_SERIALIZE(timer_rounds)
+        KV_SERIALIZE(chain_events)
+        KV_SERIALIZE(ntzpool_events)
+        KV_SERIALIZE(last_round_latency_ms)
+        KV_SERIALIZE(avg_round_latency_ms)
+        KV_SERIALIZE(max_round_latency_ms)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
   struct COMMAND_RPC_CREATE_WALLET
   {
     struct request
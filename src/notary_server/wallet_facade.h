@@ -0,0 +1,96 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <boost/thread/locks.hpp>
+#include <boost/thread/shared_mutex.hpp>
+
+namespace tools
+{
+  /************************************************************************/
+  /*                                                                      */
+  /************************************************************************/
+  /**
+   * @brief reader/writer locked owner of the notary server's wallet
+   *
+   * read() hands out a const view of the wallet under a shared lock, so
+   * read-only RPCs run side by side.  write() hands out a mutable view
+   * under an exclusive lock, for anything that signs, spends, stores or
+   * swaps the wallet.  Neither guard is recursive: a thread holding one
+   * must not ask for another.
+   */
+  template<typename W>
+  class rw_wallet_facade
+  {
+  public:
+    class reader
+    {
+    public:
+      explicit reader(const rw_wallet_facade& facade): m_lock(facade.m_mutex), m_wallet(facade.m_wallet) {}
+
+      const W* operator->() const { return m_wallet; }
+      const W& operator*() const { return *m_wallet; }
+      const W* get() const { return m_wallet; }
+      explicit operator bool() const { return m_wallet != NULL; }
+
+    private:
+      boost::shared_lock<boost::shared_mutex> m_lock;
+      const W* m_wallet;
+    };
+
+    class writer
+    {
+    public:
+      explicit writer(rw_wallet_facade& facade): m_lock(facade.m_mutex), m_wallet(&facade.m_wallet) {}
+
+      W* operator->() const { return *m_wallet; }
+      W& operator*() const { return **m_wallet; }
+      W* get() const { return *m_wallet; }
+      explicit operator bool() const { return *m_wallet != NULL; }
+
+      //! installs a new wallet (may be NULL) and hands the previous one back to the caller
+      W* reset(W* wallet) { W* previous = *m_wallet; *m_wallet = wallet; return previous; }
+
+    private:
+      boost::unique_lock<boost::shared_mutex> m_lock;
+      W** m_wallet;
+    };
+
+    rw_wallet_facade(): m_wallet(NULL) {}
+
+    reader read() const { return reader(*this); }
+    writer write() { return writer(*this); }
+
+  private:
+    rw_wallet_facade(const rw_wallet_facade&) = delete;
+    rw_wallet_facade& operator=(const rw_wallet_facade&) = delete;
+
+    mutable boost::shared_mutex m_mutex;
+    W* m_wallet;
+  };
+}
@@ -30,7 +30,7 @@
 
 #include <stdlib.h>
 #include <openssl/ssl.h>
-#include <boost/thread/mutex.hpp>
+#include "common/threadpool.h"
 #include "misc_log_ex.h"
 #include "common/perf_timer.h"
 extern "C"
@@ -38,6 +38,7 @@ extern "C"
 #include "crypto/crypto-ops.h"
 }
 #include "rctOps.h"
+#include "multiexp.h"
 #include "bulletproofs.h"
 
 #undef MONERO_DEFAULT_LOG_CATEGORY
@@ -56,12 +57,13 @@ static rct::key inner_product(const rct::keyV &a, const rct::keyV &b);
 
 static constexpr size_t maxN = 64;
 static rct::key Hi[maxN], Gi[maxN];
-static ge_dsmp Gprecomp[64], Hprecomp[64];
+// multiexp tables over G, H, then Gi and Hi, in this order
+static constexpr size_t G_index = 0, H_index = 1, Gi_index = 2, Hi_index = 2 + maxN;
+static std::unique_ptr<const multiexp_table> generators;
 static const rct::key TWO = { {0x02, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00 , 0x00, 0x00, 0x00,0x00  } };
 static const rct::keyV oneN = vector_powers(rct::identity(), maxN);
 static const rct::keyV twoN = vector_powers(TWO, maxN);
 static const rct::key ip12 = inner_product(oneN, twoN);
-static boost::mutex init_mutex;
 
 static rct::key get_exponent(const rct::key &base, size_t idx)
 {
@@ -70,21 +72,40 @@ static rct::key get_exponent(const rct::key &base, size_t idx)
   return rct::hashToPoint(rct::hash2rct(crypto::cn_fast_hash(hashed.data(), hashed.size())));
 }
 
-static void init_exponents()
+static bool init_generators()
 {
-  boost::lock_guard<boost::mutex> lock(init_mutex);
-
-  static bool init_done = false;
-  if (init_done)
-    return;
   for (size_t i = 0; i < maxN; ++i)
   {
     Hi[i] = get_exponent(rct::H, i * 2);
-    rct::precomp(Hprecomp[i], Hi[i]);
     Gi[i] = get_exponent(rct::H, i * 2 + 1);
-    rct::precomp(Gprecomp[i], Gi[i]);
   }
-  init_done = true;
+
+  std::vector<MultiexpData> bases;
+  bases.reserve(2 + 2 * maxN);
+  bases.push_back({rct::zero(), rct::scalarmultBase(rct::identity())});
+  bases.push_back({rct::zero(), rct::H});
+  for (size_t i = 0; i < maxN; ++i)
+    bases.push_back({rct::zero(), Gi[i]});
+  for (size_t i = 0; i < maxN; ++i)
+    bases.push_back({rct::zero(), Hi[i]});
+  generators.reset(new multiexp_table(bases));
+  return true;
+}
+
+static void init_exponents()
+{
+  // built by whichever thread gets here first, the others wait for it, and
+  // once done this is only a flag check
+  static const bool init_done = init_generators();
+  (void)init_done;
+}
+
+/* The generator tables, built once per process and shared by every prover and
+   verifier thread */
+const multiexp_table &bulletproof_generators()
+{
+  init_exponents();
+  return *generators;
 }
 
 /* Given two scalar arrays, construct a vector commitment */
@@ -92,14 +113,13 @@ static rct::key vector_exponent(const rct::keyV &a, const rct::keyV &b)
 {
   CHECK_AND_ASSERT_THROW_MES(a.size() == b.size(), "Incompatible sizes of a and b");
   CHECK_AND_ASSERT_THROW_MES(a.size() <= maxN, "Incompatible sizes of a and maxN");
-  rct::key res = rct::identity();
+  std::vector<MultiexpData> data(generators->bases);
   for (size_t i = 0; i < a.size(); ++i)
   {
-    rct::key term;
-    rct::addKeys3(term, a[i], Gprecomp[i], b[i], Hprecomp[i]);
-    rct::addKeys(res, res, term);
+    data[Gi_index + i].scalar = a[i];
+    data[Hi_index + i].scalar = b[i];
   }
-  return res;
+  return straus(data, generators->straus_cache);
 }
 
 /* Compute a custom vector-scalar commitment */
@@ -113,32 +133,9 @@ static rct::key vector_exponent_custom(const rct::keyV &A, const rct::keyV &B, c
   for (size_t i = 0; i < a.size(); ++i)
   {
     rct::key term;
-#if 0
-    // we happen to know where A and B might fall, so don't bother checking the rest
-    ge_dsmp *Acache = NULL, *Bcache = NULL;
-    ge_dsmp Acache_custom[1], Bcache_custom[1];
-    if (Gi[i] == A[i])
-      Acache = Gprecomp + i;
-    else if (i<32 && Gi[i+32] == A[i])
-      Acache = Gprecomp + i + 32;
-    else
-    {
-      rct::precomp(Acache_custom[0], A[i]);
-      Acache = Acache_custom;
-    }
-    if (i == 0 && B[i] == Hi[0])
-      Bcache = Hprecomp;
-    else
-    {
-      rct::precomp(Bcache_custom[0], B[i]);
-      Bcache = Bcache_custom;
-    }
-    rct::addKeys3(term, a[i], *Acache, b[i], *Bcache);
-#else
-    ge_dsmp Acache, Bcache;
+    ge_dsmp Bcache;
     rct::precomp(Bcache, B[i]);
     rct::addKeys3(term, a[i], A[i], b[i], Bcache);
-#endif
     rct::addKeys(res, res, term);
   }
   return res;
@@ -567,8 +564,21 @@ Bulletproof bulletproof_PROVE(uint64_t v, const rct::key &gamma)
   return bulletproof_PROVE(sv, gamma);
 }
 
-/* Given a range proof, determine if it is valid */
-bool bulletproof_VERIFY(const Bulletproof &proof)
+/* Whether every scalar of the proof is reduced. Both verification paths
+   reduce them mod l along the way, so a proof must be rejected up front for
+   the batch and the single check to agree on it */
+static bool check_scalars(const Bulletproof &proof)
+{
+  CHECK_AND_ASSERT_MES(sc_check(proof.taux.bytes) == 0, false, "Input scalar not in range");
+  CHECK_AND_ASSERT_MES(sc_check(proof.mu.bytes) == 0, false, "Input scalar not in range");
+  CHECK_AND_ASSERT_MES(sc_check(proof.a.bytes) == 0, false, "Input scalar not in range");
+  CHECK_AND_ASSERT_MES(sc_check(proof.b.bytes) == 0, false, "Input scalar not in range");
+  CHECK_AND_ASSERT_MES(sc_check(proof.t.bytes) == 0, false, "Input scalar not in range");
+  return true;
+}
+
+/* Given a range proof, determine if it is valid, checking both equations on their own */
+static bool verify_single(const Bulletproof &proof)
 {
   init_exponents();
 
@@ -576,6 +586,8 @@ bool bulletproof_VERIFY(const Bulletproof &proof)
   CHECK_AND_ASSERT_MES(proof.L.size() == proof.R.size(), false, "Mismatched L and R sizes");
   CHECK_AND_ASSERT_MES(proof.L.size() > 0, false, "Empty proof");
   CHECK_AND_ASSERT_MES(proof.L.size() == 6, false, "Proof is not for 64 bits");
+  if (!check_scalars(proof))
+    return false;
 
   const size_t logN = proof.L.size();
   const size_t N = 1 << logN;
@@ -655,7 +667,7 @@ bool bulletproof_VERIFY(const Bulletproof &proof)
   PERF_TIMER_START_BP(VERIFY_line_24_25);
   // Basically PAPER LINES 24-25
   // Compute the curvepoints from G[i] and H[i]
-  rct::key inner_prod = rct::identity();
+  std::vector<MultiexpData> data(generators->bases);
   rct::key yinvpow = rct::identity();
   rct::key ypow = rct::identity();
 
@@ -695,10 +707,8 @@ bool bulletproof_VERIFY(const Bulletproof &proof)
     sc_muladd(tmp.bytes, z.bytes, ypow.bytes, tmp.bytes);
     sc_mulsub(h_scalar.bytes, tmp.bytes, yinvpow.bytes, h_scalar.bytes);
 
-    // Now compute the basepoint's scalar multiplication
-    // Each of these could be written as a multiexp operation instead
-    rct::addKeys3(tmp, g_scalar, Gprecomp[i], h_scalar, Hprecomp[i]);
-    rct::addKeys(inner_prod, inner_prod, tmp);
+    data[Gi_index + i].scalar = g_scalar;
+    data[Hi_index + i].scalar = h_scalar;
 
     if (i != N-1)
     {
@@ -706,6 +716,8 @@ bool bulletproof_VERIFY(const Bulletproof &proof)
       sc_mul(ypow.bytes, ypow.bytes, y.bytes);
     }
   }
+  // Now compute the basepoints' scalar multiplications in one multiexp
+  const rct::key inner_prod = straus(data, generators->straus_cache);
   PERF_TIMER_STOP(VERIFY_line_24_25);
 
   PERF_TIMER_START_BP(VERIFY_line_26);
@@ -749,4 +761,227 @@ bool bulletproof_VERIFY(const Bulletproof &proof)
   return true;
 }
 
+/* Whether P has no small order component, ie l*P is the identity */
+static bool is_torsion_free(const ge_p3 &P)
+{
+  ge_p2 lP;
+  rct::key res;
+  ge_double_scalarmult_base_vartime(&lP, rct::curveOrder().bytes, &P, rct::zero().bytes);
+  ge_tobytes(res.bytes, &lP);
+  return res == rct::identity();
+}
+
+/* One proof's share of a batch: its own points with their weighted scalars,
+   and what it adds to the scalars of G, H, Gi and Hi */
+struct bulletproof_batch_terms
+{
+  bool batched;
+  std::vector<MultiexpData> points;
+  rct::key G_scalar, H_scalar;
+  rct::keyV Gi_scalars, Hi_scalars;
+};
+
+/* Weigh both checks of a proof for a batch, or verify it on its own if the
+   weights could hide a small order component of its points */
+static bool get_batch_terms(const Bulletproof &proof, bulletproof_batch_terms &terms)
+{
+  CHECK_AND_ASSERT_MES(proof.V.size() == 1, false, "V does not have exactly one element");
+  CHECK_AND_ASSERT_MES(proof.L.size() == proof.R.size(), false, "Mismatched L and R sizes");
+  CHECK_AND_ASSERT_MES(proof.L.size() > 0, false, "Empty proof");
+  CHECK_AND_ASSERT_MES(proof.L.size() == 6, false, "Proof is not for 64 bits");
+  if (!check_scalars(proof))
+    return false;
+
+  const size_t logN = proof.L.size();
+  const size_t N = 1 << logN;
+
+  std::vector<MultiexpData> &points = terms.points;
+  points.clear();
+  points.reserve(5 + 2 * logN);
+  points.push_back({rct::zero(), proof.V[0]});
+  points.push_back({rct::zero(), proof.T1});
+  points.push_back({rct::zero(), proof.T2});
+  points.push_back({rct::zero(), proof.A});
+  points.push_back({rct::zero(), proof.S});
+  for (size_t i = 0; i < logN; ++i)
+  {
+    points.push_back({rct::zero(), proof.L[i]});
+    points.push_back({rct::zero(), proof.R[i]});
+  }
+  terms.batched = true;
+  for (size_t i = 0; i < points.size() && terms.batched; ++i)
+    terms.batched = is_torsion_free(points[i].point);
+  if (!terms.batched)
+    return verify_single(proof);
+
+  // Reconstruct the challenges
+  rct::key hash_cache = rct::hash_to_scalar(proof.V[0]);
+  const rct::key y = hash_cache_mash(hash_cache, proof.A, proof.S);
+  const rct::key z = hash_cache = rct::hash_to_scalar(y);
+  const rct::key x = hash_cache_mash(hash_cache, z, proof.T1, proof.T2);
+  const rct::key x_ip = hash_cache_mash(hash_cache, x, proof.taux, proof.mu, proof.t);
+  rct::keyV w(logN), winv(logN);
+  for (size_t i = 0; i < logN; ++i)
+  {
+    w[i] = hash_cache_mash(hash_cache, proof.L[i], proof.R[i]);
+    winv[i] = invert(w[i]);
+  }
+  const rct::key yinv = invert(y);
+
+  const rct::key weight_y = rct::skGen();
+  const rct::key weight_z = rct::skGen();
+  rct::key tmp;
+
+  // PAPER LINE 61, as taux*G + (t - z*ip1y - k)*H - z^2*V - x*T1 - x^2*T2
+  rct::key k = rct::zero();
+  const rct::key ip1y = inner_product(oneN, vector_powers(y, N));
+  rct::key zsq, zcu, xsq;
+  sc_mul(zsq.bytes, z.bytes, z.bytes);
+  sc_mul(zcu.bytes, zsq.bytes, z.bytes);
+  sc_mul(xsq.bytes, x.bytes, x.bytes);
+  sc_mulsub(k.bytes, zsq.bytes, ip1y.bytes, k.bytes);
+  sc_mulsub(k.bytes, zcu.bytes, ip12.bytes, k.bytes);
+  sc_muladd(tmp.bytes, z.bytes, ip1y.bytes, k.bytes);
+  sc_sub(tmp.bytes, proof.t.bytes, tmp.bytes);
+  sc_mul(terms.H_scalar.bytes, tmp.bytes, weight_y.bytes);
+  sc_mul(terms.G_scalar.bytes, proof.taux.bytes, weight_y.bytes);
+  sc_mulsub(points[0].scalar.bytes, zsq.bytes, weight_y.bytes, rct::zero().bytes);
+  sc_mulsub(points[1].scalar.bytes, x.bytes, weight_y.bytes, rct::zero().bytes);
+  sc_mulsub(points[2].scalar.bytes, xsq.bytes, weight_y.bytes, rct::zero().bytes);
+
+  // PAPER LINES 62 and 26, as A + x*S - mu*G + sum(w^2*L + w^-2*R)
+  // + (t - a*b)*x_ip*H - sum(g_i*Gi + h_i*Hi)
+  points[3].scalar = weight_z;
+  sc_mul(points[4].scalar.bytes, x.bytes, weight_z.bytes);
+  sc_mulsub(terms.G_scalar.bytes, proof.mu.bytes, weight_z.bytes, terms.G_scalar.bytes);
+  for (size_t i = 0; i < logN; ++i)
+  {
+    sc_mul(tmp.bytes, w[i].bytes, w[i].bytes);
+    sc_mul(points[5 + 2 * i].scalar.bytes, tmp.bytes, weight_z.bytes);
+    sc_mul(tmp.bytes, winv[i].bytes, winv[i].bytes);
+    sc_mul(points[6 + 2 * i].scalar.bytes, tmp.bytes, weight_z.bytes);
+  }
+  sc_mulsub(tmp.bytes, proof.a.bytes, proof.b.bytes, proof.t.bytes);
+  sc_mul(tmp.bytes, tmp.bytes, x_ip.bytes);
+  sc_muladd(terms.H_scalar.bytes, tmp.bytes, weight_z.bytes, terms.H_scalar.bytes);
+
+  // Products of the inner product challenges, one per index, with bit j of
+  // the index picking w or w^-1 for round logN-j-1. Flipping every bit
+  // inverts the product, so h_i uses the one at the mirrored index.
+  rct::keyV challenges(N);
+  challenges[0] = winv[0];
+  challenges[1] = w[0];
+  for (size_t j = 1; j < logN; ++j)
+  {
+    for (size_t s = (1 << (j + 1)); s > 0; s -= 2)
+    {
+      sc_mul(challenges[s - 1].bytes, challenges[s / 2 - 1].bytes, w[j].bytes);
+      sc_mul(challenges[s - 2].bytes, challenges[s / 2 - 1].bytes, winv[j].bytes);
+    }
+  }
+
+  rct::key a_weighted, b_weighted, z_weighted;
+  sc_mul(a_weighted.bytes, proof.a.bytes, weight_z.bytes);
+  sc_mul(b_weighted.bytes, proof.b.bytes, weight_z.bytes);
+  sc_mul(z_weighted.bytes, z.bytes, weight_z.bytes);
+  terms.Gi_scalars.resize(N);
+  terms.Hi_scalars.resize(N);
+  rct::key yinvpow = rct::identity();
+  rct::key ypow = rct::identity();
+  rct::key g_scalar, h_scalar;
+  for (size_t i = 0; i < N; ++i)
+  {
+    // Adjust the scalars using the exponents from PAPER LINE 62, and negate
+    sc_muladd(g_scalar.bytes, a_weighted.bytes, challenges[i].bytes, z_weighted.bytes);
+    sc_sub(terms.Gi_scalars[i].bytes, rct::zero().bytes, g_scalar.bytes);
+
+    sc_mul(h_scalar.bytes, b_weighted.bytes, challenges[N - 1 - i].bytes);
+    sc_mul(tmp.bytes, zsq.bytes, twoN[i].bytes);
+    sc_muladd(tmp.bytes, z.bytes, ypow.bytes, tmp.bytes);
+    sc_mul(tmp.bytes, tmp.bytes, weight_z.bytes);
+    sc_sub(h_scalar.bytes, h_scalar.bytes, tmp.bytes);
+    sc_mul(h_scalar.bytes, h_scalar.bytes, yinvpow.bytes);
+    sc_sub(terms.Hi_scalars[i].bytes, rct::zero().bytes, h_scalar.bytes);
+
+    if (i != N-1)
+    {
+      sc_mul(yinvpow.bytes, yinvpow.bytes, yinv.bytes);
+      sc_mul(ypow.bytes, ypow.bytes, y.bytes);
+    }
+  }
+
+  return true;
+}
+
+/* Given a range proof, determine if it is valid, without batching */
+bool bulletproof_VERIFY_single(const Bulletproof &proof)
+{
+  return verify_single(proof);
+}
+
+/* Given a range proof, determine if it is valid */
+bool bulletproof_VERIFY(const Bulletproof &proof)
+{
+  return verify_single(proof);
+}
+
+/* Given a set of range proofs, determine if they are all valid. Both checks of
+   every proof are folded into a single multiexp, each check scaled by its own
+   random weight, which sums to the identity iff all of them hold (but with
+   negligible probability) */
+bool bulletproof_VERIFY(const std::vector<const Bulletproof*> &proofs)
+{
+  init_exponents();
+
+  PERF_TIMER_START_BP(VERIFY_batch);
+  std::vector<bulletproof_batch_terms> terms(proofs.size());
+  std::deque<bool> results(proofs.size(), false);
+  tools::threadpool& tpool = tools::threadpool::getInstance();
+  tools::threadpool::waiter waiter;
+  for (size_t i = 0; i < proofs.size(); ++i)
+  {
+    tpool.submit(&waiter, [&, i] {
+      // we can get deep throws from ge_frombytes_vartime if input isn't valid
+      try { results[i] = proofs[i] && get_batch_terms(*proofs[i], terms[i]); }
+      catch (...) { results[i] = false; }
+    });
+  }
+  waiter.wait();
+
+  std::vector<MultiexpData> data(generators->bases);
+  data.reserve(data.size() + proofs.size() * (5 + 2 * 6));
+  for (size_t i = 0; i < proofs.size(); ++i)
+  {
+    if (!results[i])
+    {
+      MERROR("Verification failure for proof " << i << " of " << proofs.size());
+      return false;
+    }
+    if (!terms[i].batched)
+      continue;
+    sc_add(data[G_index].scalar.bytes, data[G_index].scalar.bytes, terms[i].G_scalar.bytes);
+    sc_add(data[H_index].scalar.bytes, data[H_index].scalar.bytes, terms[i].H_scalar.bytes);
+    for (size_t j = 0; j < maxN; ++j)
+    {
+      sc_add(data[Gi_index + j].scalar.bytes, data[Gi_index + j].scalar.bytes, terms[i].Gi_scalars[j].bytes);
+      sc_add(data[Hi_index + j].scalar.bytes, data[Hi_index + j].scalar.bytes, terms[i].Hi_scalars[j].bytes);
+    }
+    data.insert(data.end(), terms[i].points.begin(), terms[i].points.end());
+  }
+  if (data.size() == generators->bases.size())
+    return true;
+
+  PERF_TIMER_START_BP(VERIFY_batch_multiexp);
+  const rct::key check = pippenger(data, generators->pippenger_cache, generators->bases.size(), get_pippenger_c(data.size()));
+  PERF_TIMER_STOP(VERIFY_batch_multiexp);
+  if (!(check == rct::identity()))
+  {
+    MERROR("Verification failure in batch of " << proofs.size() << " proofs");
+    return false;
+  }
+
+  PERF_TIMER_STOP(VERIFY_batch);
+  return true;
+}
+
 }
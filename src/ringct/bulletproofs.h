@@ -34,6 +34,7 @@
 #define BULLETPROOFS_H
 
 #include "rctTypes.h"
+#include "multiexp.h"
 
 namespace rct
 {
@@ -41,6 +42,9 @@ namespace rct
 Bulletproof bulletproof_PROVE(const rct::key &v, const rct::key &gamma);
 Bulletproof bulletproof_PROVE(uint64_t v, const rct::key &gamma);
 bool bulletproof_VERIFY(const Bulletproof &proof);
+bool bulletproof_VERIFY_single(const Bulletproof &proof);
+bool bulletproof_VERIFY(const std::vector<const Bulletproof*> &proofs);
+const multiexp_table &bulletproof_generators();
 
 }
 
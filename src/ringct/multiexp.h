@@ -66,6 +66,17 @@ size_t pippenger_get_cache_size(const std::shared_ptr<pippenger_cached_data> &ca
 size_t get_pippenger_c(size_t N);
 rct::key pippenger(const std::vector<MultiexpData> &data, const std::shared_ptr<pippenger_cached_data> &cache = NULL, size_t cache_size = 0, size_t c = 0);
 
+/* Straus and Pippenger caches over a fixed set of base points. Neither cache
+   is written to once built, so a single table can be shared by all threads */
+struct multiexp_table
+{
+  std::vector<MultiexpData> bases;
+  std::shared_ptr<straus_cached_data> straus_cache;
+  std::shared_ptr<pippenger_cached_data> pippenger_cache;
+
+  multiexp_table(const std::vector<MultiexpData> &points): bases(points), straus_cache(straus_init_cache(points)), pippenger_cache(pippenger_init_cache(points)) {}
+};
+
 }
 
 #endif
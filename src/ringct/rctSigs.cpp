@@ -83,6 +83,27 @@ namespace rct {
       catch (...) { return false; }
     }
 
+    bool verBulletproof(const std::vector<const Bulletproof*> &proofs)
+    {
+      try { return bulletproof_VERIFY(proofs); }
+      // we can get deep throws from ge_frombytes_vartime if input isn't valid
+      catch (...) { return false; }
+    }
+
+    static bool verBulletproofs(const rctSig &rv)
+    {
+      std::vector<const Bulletproof*> proofs;
+      proofs.reserve(rv.p.bulletproofs.size());
+      for (const Bulletproof &proof: rv.p.bulletproofs)
+        proofs.push_back(&proof);
+      if (!verBulletproof(proofs))
+      {
+        LOG_PRINT_L1("Range proof verification failed for a bulletproof");
+        return false;
+      }
+      return true;
+    }
+
     //Borromean (c.f. gmax/andytoshi's paper)
     boroSig genBorromean(const key64 x, const key64 P1, const key64 P2, const bits indices) {
         key64 L[2], alpha;
@@ -566,6 +587,45 @@ namespace rct {
         return MLSAG_Ver(message, M, mg, rows);
     }
 
+    //one check per MG signature of rv, holding on to rv by reference
+    bool getRctMGChecks(const rctSig & rv, std::vector<std::function<bool()>> &checks) {
+      try
+      {
+        const key message = get_pre_mlsag_hash(rv, hw::get_device("default"));
+        if (rv.type == RCTTypeFull || rv.type == RCTTypeFullBulletproof) {
+          CHECK_AND_ASSERT_MES(rv.p.MGs.size() == 1, false, "full rctSig has not one MG");
+          const key txnFeeKey = scalarmultH(d2h(rv.txnFee));
+          checks.push_back([&rv, txnFeeKey, message] {
+            try { return verRctMG(rv.p.MGs[0], rv.mixRing, rv.outPk, txnFeeKey, message); }
+            catch (...) { return false; }
+          });
+          return true;
+        }
+
+        CHECK_AND_ASSERT_MES(rv.type == RCTTypeSimple || rv.type == RCTTypeSimpleBulletproof, false, "getRctMGChecks called on unsupported rctSig type");
+        const keyV &pseudoOuts = is_bulletproof(rv.type) ? rv.p.pseudoOuts : rv.pseudoOuts;
+        CHECK_AND_ASSERT_MES(pseudoOuts.size() == rv.mixRing.size(), false, "Mismatched sizes of pseudoOuts and mixRing");
+        CHECK_AND_ASSERT_MES(rv.p.MGs.size() == rv.mixRing.size(), false, "Mismatched sizes of rv.p.MGs and mixRing");
+        for (size_t i = 0; i < rv.mixRing.size(); ++i) {
+          checks.push_back([&rv, &pseudoOuts, message, i] {
+            return verRctMGSimple(message, rv.p.MGs[i], rv.mixRing[i], pseudoOuts[i]);
+          });
+        }
+        return true;
+      }
+      // we can get deep throws from ge_frombytes_vartime if input isn't valid
+      catch (const std::exception &e)
+      {
+        LOG_PRINT_L1("Error in getRctMGChecks: " << e.what());
+        return false;
+      }
+      catch (...)
+      {
+        LOG_PRINT_L1("Error in getRctMGChecks, but not an actual exception");
+        return false;
+      }
+    }
+
     //Ring-ct Simple MG sigs
     //Ver: 
     //This does a simplified version, assuming only post Rct
@@ -829,7 +889,7 @@ namespace rct {
     //decodeRct: (c.f. http://eprint.iacr.org/2015/1098 section 5.1.1)
     //   uses the attached ecdh info to find the amounts represented by each output commitment 
     //   must know the destination private key to find the correct amount, else will return a random number    
-    bool verRct(const rctSig & rv, bool semantics) {
+    bool verRct(const rctSig & rv, bool semantics, bool bulletproofs) {
         PERF_TIMER(verRct);
         CHECK_AND_ASSERT_MES(rv.type == RCTTypeFull || rv.type == RCTTypeFullBulletproof, false, "verRct called on non-full rctSig");
         if (semantics)
@@ -849,17 +909,18 @@ namespace rct {
         // some rct ops can throw
         try
         {
-          if (semantics) {
+          if (semantics && rv.p.rangeSigs.empty()) {
+            if (bulletproofs && !verBulletproofs(rv))
+              return false;
+          }
+          else if (semantics) {
             tools::threadpool& tpool = tools::threadpool::getInstance();
             tools::threadpool::waiter waiter;
             std::deque<bool> results(rv.outPk.size(), false);
             DP("range proofs verified?");
             for (size_t i = 0; i < rv.outPk.size(); i++) {
               tpool.submit(&waiter, [&, i] {
-                if (rv.p.rangeSigs.empty())
-                  results[i] = verBulletproof(rv.p.bulletproofs[i]);
-                else
-                  results[i] = verRange(rv.outPk[i].mask, rv.p.rangeSigs[i]);
+                results[i] = verRange(rv.outPk[i].mask, rv.p.rangeSigs[i]);
               });
             }
             waiter.wait();
@@ -900,7 +961,7 @@ namespace rct {
 
     //ver RingCT simple
     //assumes only post-rct style inputs (at least for max anonymity)
-    bool verRctSimple(const rctSig & rv, bool semantics) {
+    bool verRctSimple(const rctSig & rv, bool semantics, bool bulletproofs) {
       try
       {
         PERF_TIMER(verRctSimple);
@@ -960,14 +1021,16 @@ namespace rct {
               return false;
           }
 
+          if (rv.p.rangeSigs.empty()) {
+            if (bulletproofs && !verBulletproofs(rv))
+              return false;
+          }
+
           results.clear();
-          results.resize(rv.outPk.size());
-          for (size_t i = 0; i < rv.outPk.size(); i++) {
+          results.resize(rv.p.rangeSigs.size());
+          for (size_t i = 0; i < rv.p.rangeSigs.size(); i++) {
             tpool.submit(&waiter, [&, i] {
-              if (rv.p.rangeSigs.empty())
-                results[i] = verBulletproof(rv.p.bulletproofs[i]);
-              else
-                results[i] = verRange(rv.outPk[i].mask, rv.p.rangeSigs[i]);
+              results[i] = verRange(rv.outPk[i].mask, rv.p.rangeSigs[i]);
             });
           }
           waiter.wait();
@@ -980,13 +1043,15 @@ namespace rct {
           }
         }
         else {
-          const key message = get_pre_mlsag_hash(rv, hw::get_device("default"));
+          std::vector<std::function<bool()>> checks;
+          if (!getRctMGChecks(rv, checks))
+            return false;
 
           results.clear();
-          results.resize(rv.mixRing.size());
-          for (size_t i = 0 ; i < rv.mixRing.size() ; i++) {
+          results.resize(checks.size());
+          for (size_t i = 0 ; i < checks.size() ; i++) {
             tpool.submit(&waiter, [&, i] {
-                results[i] = verRctMGSimple(message, rv.p.MGs[i], rv.mixRing[i], pseudoOuts[i]);
+                results[i] = checks[i]();
             });
           }
           waiter.wait();
@@ -36,6 +36,7 @@
 #define RCTSIGS_H
 
 #include <cstddef>
+#include <functional>
 #include <vector>
 #include <tuple>
 
@@ -88,6 +89,11 @@ namespace rct {
     rangeSig proveRange(key & C, key & mask, const xmr_amount & amount);
     bool verRange(const key & C, const rangeSig & as);
 
+    //verBulletproof checks a set of bulletproofs as one batch, which is
+    //   much cheaper than checking them one by one, but only says whether all
+    //   of them are valid
+    bool verBulletproof(const std::vector<const Bulletproof*> &proofs);
+
     //Ring-ct MG sigs
     //Prove:
     //   c.f. http://eprint.iacr.org/2015/1098 section 4. definition 10.
@@ -116,6 +122,12 @@ namespace rct {
     //   Also contains masked "amount" and "mask" so the receiver can see how much they received
     //verRct:
     //   verifies that all signatures (rangeProogs, MG sig, sum inputs = outputs) are correct
+    //   semantics checks leave bulletproofs out if bulletproofs is false, for callers
+    //   which batch them over several rctSigs with verBulletproof
+    //getRctMGChecks:
+    //   the checks verRct/verRctSimple make when semantics is false, as one independent check
+    //   per MG signature, for callers spreading the MGs of several rctSigs over one set of
+    //   threads. rv must outlive the checks
     //decodeRct: (c.f. http://eprint.iacr.org/2015/1098 section 5.1.1)
     //   uses the attached ecdh info to find the amounts represented by each output commitment
     //   must know the destination private key to find the correct amount, else will return a random number
@@ -123,10 +135,11 @@ namespace rct {
     rctSig genRct(const key &message, const ctkeyV & inSk, const ctkeyV  & inPk, const keyV & destinations, const std::vector<xmr_amount> & amounts, const keyV &amount_keys, const multisig_kLRki *kLRki, multisig_out *msout, const int mixin, hw::device &hwdev);
     rctSig genRctSimple(const key & message, const ctkeyV & inSk, const ctkeyV & inPk, const keyV & destinations, const std::vector<xmr_amount> & inamounts, const std::vector<xmr_amount> & outamounts, const keyV &amount_keys, const std::vector<multisig_kLRki> *kLRki, multisig_out *msout, xmr_amount txnFee, unsigned int mixin, hw::device &hwdev);
     rctSig genRctSimple(const key & message, const ctkeyV & inSk, const keyV & destinations, const std::vector<xmr_amount> & inamounts, const std::vector<xmr_amount> & outamounts, xmr_amount txnFee, const ctkeyM & mixRing, const keyV &amount_keys, const std::vector<multisig_kLRki> *kLRki, multisig_out *msout, const std::vector<unsigned int> & index, ctkeyV &outSk, bool bulletproof, hw::device &hwdev);
-    bool verRct(const rctSig & rv, bool semantics);
+    bool verRct(const rctSig & rv, bool semantics, bool bulletproofs = true);
     static inline bool verRct(const rctSig & rv) { return verRct(rv, true) && verRct(rv, false); }
-    bool verRctSimple(const rctSig & rv, bool semantics);
+    bool verRctSimple(const rctSig & rv, bool semantics, bool bulletproofs = true);
     static inline bool verRctSimple(const rctSig & rv) { return verRctSimple(rv, true) && verRctSimple(rv, false); }
+    bool getRctMGChecks(const rctSig & rv, std::vector<std::function<bool()>> &checks);
     xmr_amount decodeRct(const rctSig & rv, const key & sk, unsigned int i, key & mask, hw::device &hwdev);
     xmr_amount decodeRct(const rctSig & rv, const key & sk, unsigned int i, hw::device &hwdev);
     xmr_amount decodeRctSimple(const rctSig & rv, const key & sk, unsigned int i, key & mask, hw::device &hwdev);
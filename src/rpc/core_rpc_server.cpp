@@ -50,6 +50,7 @@ using namespace epee;
 #include "core_rpc_server_error_codes.h"
 #include "p2p/net_node.h"
 #include "cryptonote_basic/komodo_notaries.h"
+#include "cryptonote_basic/ntz_signers.h"
 #include "blockchain_db/db_structs.h"
 #include "version.h"
 
@@ -58,6 +59,7 @@ using namespace epee;
 
 #define MAX_RESTRICTED_FAKE_OUTS_COUNT 40
 #define MAX_RESTRICTED_GLOBAL_FAKE_OUTS_COUNT 5000
+#define MAX_RESTRICTED_NTZ_PAGE_COUNT 1000
 
 #define P2PK_LENGTH "21"
 // above is 0x21
@@ -102,6 +104,10 @@ namespace cryptonote
     )
     : m_core(cr)
     , m_p2p(p2p)
+    , m_ntz_event_waiters(0)
+    , m_getblocks_cache(COMMAND_RPC_GET_BLOCKS_FAST_CACHE_SIZE)
+    , m_getblocks_cache_hits(0)
+    , m_getblocks_cache_misses(0)
   {}
   //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::init(
@@ -241,6 +247,8 @@ namespace cryptonote
       boost::shared_lock<boost::shared_mutex> lock(m_bootstrap_daemon_mutex);
       res.was_bootstrap_ever_used = m_was_bootstrap_ever_used;
     }
+    res.getblocks_cache_hits = m_getblocks_cache_hits;
+    res.getblocks_cache_misses = m_getblocks_cache_misses;
     return true;
   }
   //-----------------------------------------------------------------------------------------------------------------
@@ -322,6 +330,49 @@ namespace cryptonote
     return ss.str();
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::load_getblocks_entry(uint64_t height, bool prune, getblocks_entry& entry)
+  {
+    Blockchain &blockchain = m_core.get_blockchain_storage();
+    entry.hash = blockchain.get_block_id_by_height(height);
+    entry.block.block = blockchain.get_db().get_block_blob_from_height(height);
+    entry.block.txs.clear();
+    entry.output_indices.indices.clear();
+    entry.unpruned_size = entry.block.block.size();
+
+    block b;
+    if (!parse_and_validate_block_from_blob(entry.block.block, b))
+    {
+      MERROR("Invalid block at height " << height);
+      return false;
+    }
+
+    std::list<cryptonote::blobdata> txs;
+    std::list<crypto::hash> missed_txs;
+    blockchain.get_transactions_blobs(b.tx_hashes, txs, missed_txs);
+    CHECK_AND_ASSERT_MES(missed_txs.empty(), false, "internal error, transaction from block not found");
+    for (std::list<cryptonote::blobdata>::iterator i = txs.begin(); i != txs.end(); ++i)
+    {
+      entry.unpruned_size += i->size();
+      if (prune)
+        entry.block.txs.push_back(get_pruned_tx_blob(std::move(*i)));
+      else
+        entry.block.txs.push_back(std::move(*i));
+    }
+
+    // miner tx first, then the block's txes, all looked up in one db batch
+    std::vector<crypto::hash> tx_hashes;
+    tx_hashes.reserve(b.tx_hashes.size() + 1);
+    tx_hashes.push_back(get_transaction_hash(b.miner_tx));
+    tx_hashes.insert(tx_hashes.end(), b.tx_hashes.begin(), b.tx_hashes.end());
+    std::vector<std::vector<uint64_t>> indices;
+    if (!m_core.get_tx_outputs_gindexs(tx_hashes, indices))
+      return false;
+    entry.output_indices.indices.resize(indices.size());
+    for (size_t n = 0; n < indices.size(); ++n)
+      entry.output_indices.indices[n].indices = std::move(indices[n]);
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_get_blocks(const COMMAND_RPC_GET_BLOCKS_FAST::request& req, COMMAND_RPC_GET_BLOCKS_FAST::response& res)
   {
     PERF_TIMER(on_get_blocks);
@@ -329,59 +380,91 @@ namespace cryptonote
     if (use_bootstrap_daemon_if_necessary<COMMAND_RPC_GET_BLOCKS_FAST>(invoke_http_mode::BIN, "/getblocks.bin", req, res, r))
       return r;
 
-    std::list<std::pair<cryptonote::blobdata, std::list<cryptonote::blobdata> > > bs;
+    // Same range rules as Blockchain::find_blockchain_supplement, but each block's
+    // response entry comes from the cache when the chain still has that block at
+    // that height. The blockchain lock keeps the range consistent across a reorg.
+    Blockchain &blockchain = m_core.get_blockchain_storage();
+    blockchain.lock();
+    blockchain.get_db().block_txn_start(true);
+    epee::misc_utils::auto_scope_leave_caller unlock = epee::misc_utils::create_scope_leave_handler([&blockchain](){
+      blockchain.get_db().block_txn_stop();
+      blockchain.unlock();
+    });
 
-    if(!m_core.find_blockchain_supplement(req.start_height, req.block_ids, bs, res.current_height, res.start_height, COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT))
+    if (req.start_height > 0)
+    {
+      if (req.start_height >= blockchain.get_current_blockchain_height())
+      {
+        res.status = "Failed";
+        return false;
+      }
+      res.start_height = req.start_height;
+    }
+    else if (!blockchain.find_blockchain_supplement(req.block_ids, res.start_height))
     {
       res.status = "Failed";
       return false;
     }
+    res.current_height = blockchain.get_current_blockchain_height();
 
-    size_t pruned_size = 0, unpruned_size = 0, ntxes = 0;
-    for(auto& bd: bs)
+    size_t pruned_size = 0, unpruned_size = 0, ntxes = 0, hits = 0;
+    size_t count = 0;
+    for (uint64_t height = res.start_height; height < res.current_height && count < COMMAND_RPC_GET_BLOCKS_FAST_MAX_COUNT && (unpruned_size < FIND_BLOCKCHAIN_SUPPLEMENT_MAX_SIZE || count < 3); ++height, ++count)
     {
-      res.blocks.resize(res.blocks.size()+1);
-      res.blocks.back().block = bd.first;
-      pruned_size += bd.first.size();
-      unpruned_size += bd.first.size();
-      res.output_indices.push_back(COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices());
-      res.output_indices.back().indices.push_back(COMMAND_RPC_GET_BLOCKS_FAST::tx_output_indices());
-      block b;
-      if (!parse_and_validate_block_from_blob(bd.first, b))
+      const uint64_t key = height * 2 + (req.prune ? 1 : 0);
+      bool found = false;
       {
-        res.status = "Invalid block";
-        return false;
+        boost::lock_guard<boost::mutex> lock(m_getblocks_cache_mutex);
+        const getblocks_entry *cached = m_getblocks_cache.find(key);
+        if (cached)
+        {
+          if (cached->hash == blockchain.get_block_id_by_height(height))
+          {
+            res.blocks.push_back(cached->block);
+            res.output_indices.push_back(cached->output_indices);
+            unpruned_size += cached->unpruned_size;
+            found = true;
+          }
+          else
+          {
+            // the block at this height was reorganized away
+            m_getblocks_cache.erase(key);
+          }
+        }
       }
-      bool r = m_core.get_tx_outputs_gindexs(get_transaction_hash(b.miner_tx), res.output_indices.back().indices.back().indices);
-      if (!r)
+
+      if (found)
       {
-        res.status = "Failed";
-        return false;
+        ++hits;
       }
-      size_t txidx = 0;
-      ntxes += bd.second.size();
-      for (std::list<cryptonote::blobdata>::iterator i = bd.second.begin(); i != bd.second.end(); ++i)
+      else
       {
-        unpruned_size += i->size();
-        if (req.prune)
-          res.blocks.back().txs.push_back(get_pruned_tx_blob(std::move(*i)));
-        else
-          res.blocks.back().txs.push_back(std::move(*i));
-        i->clear();
-        i->shrink_to_fit();
-        pruned_size += res.blocks.back().txs.back().size();
-
-        res.output_indices.back().indices.push_back(COMMAND_RPC_GET_BLOCKS_FAST::tx_output_indices());
-        bool r = m_core.get_tx_outputs_gindexs(b.tx_hashes[txidx++], res.output_indices.back().indices.back().indices);
-        if (!r)
+        getblocks_entry entry;
+        if (!load_getblocks_entry(height, req.prune, entry))
         {
           res.status = "Failed";
           return false;
         }
+        res.blocks.push_back(entry.block);
+        res.output_indices.push_back(entry.output_indices);
+        unpruned_size += entry.unpruned_size;
+        size_t entry_size = entry.block.block.size();
+        for (const auto &tx: entry.block.txs)
+          entry_size += tx.size();
+        boost::lock_guard<boost::mutex> lock(m_getblocks_cache_mutex);
+        m_getblocks_cache.put(key, std::move(entry), entry_size);
       }
+
+      const block_complete_entry &bce = res.blocks.back();
+      pruned_size += bce.block.size();
+      for (const auto &tx: bce.txs)
+        pruned_size += tx.size();
+      ntxes += bce.txs.size();
     }
 
-    MDEBUG("on_get_blocks: " << bs.size() << " blocks, " << ntxes << " txes, pruned size " << pruned_size << ", unpruned size " << unpruned_size);
+    m_getblocks_cache_hits += hits;
+    m_getblocks_cache_misses += count - hits;
+    MDEBUG("on_get_blocks: " << count << " blocks (" << hits << " cached), " << ntxes << " txes, pruned size " << pruned_size << ", unpruned size " << unpruned_size);
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
@@ -796,162 +879,85 @@ namespace cryptonote
   //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_get_notarizations(const COMMAND_RPC_GET_NOTARIZATIONS::request& req, COMMAND_RPC_GET_NOTARIZATIONS::response& res)
   {
-    std::vector<crypto::hash> vh;
-    std::vector<std::pair<crypto::hash,uint64_t>> ntz_hash_height;
-    uint64_t ntz_count = m_core.get_blockchain_storage().get_ntz_count(ntz_hash_height);
-    std::vector<std::string> ntz_hexs;
-    std::vector<std::pair<std::string,uint64_t>> ntz_hexs_height;
-    for (const auto& each : ntz_hash_height)
-    {
-      if (!req.txs_hashes.empty())
-      {
-        for (const auto& req_each : req.txs_hashes)
-        {
-          std::string ntz_hashstr = epee::string_tools::pod_to_hex(each.first);
-          if (ntz_hashstr == req_each)
-          {
-            ntz_hexs_height.push_back(std::make_pair(ntz_hashstr,each.second));
-            ntz_hexs.push_back(ntz_hashstr);
-          }
-        }
-      } else {
-        ntz_hexs_height.push_back(std::make_pair(epee::string_tools::pod_to_hex(each.first),each.second));
-        ntz_hexs.push_back(epee::string_tools::pod_to_hex(each.first));
-      }
-    }
-    for(const auto& tx_hex_str: ntz_hexs_height)
+    PERF_TIMER(on_get_notarizations);
+    std::unordered_set<crypto::hash> filter;
+    filter.reserve(req.txs_hashes.size());
+    for (const auto& tx_hex_str: req.txs_hashes)
     {
-      blobdata b;
-      if(!string_tools::parse_hexstr_to_binbuff(tx_hex_str.first, b))
+      crypto::hash h;
+      if (!epee::string_tools::hex_to_pod(tx_hex_str, h))
       {
         res.status = "Failed to parse hex representation of transaction hash";
         return true;
       }
-      if(b.size() != sizeof(crypto::hash))
-      {
-        res.status = "Failed, size of data mismatch";
-        return true;
-      }
-      vh.push_back(*reinterpret_cast<const crypto::hash*>(b.data()));
+      filter.insert(h);
     }
-    std::list<crypto::hash> missed_txs;
-    std::list<transaction> txs;
-    for (const auto& each : vh) {
-      cryptonote::transaction each_tx;
-      bool r = m_core.get_blockchain_storage().get_db().get_tx(each, each_tx);
-      if (!r) {
-        missed_txs.push_back(get_transaction_hash(each_tx));
-      } else {
-        txs.push_back(each_tx);
-      }
+
+    uint64_t end_height = req.end_height;
+    if (end_height == 0)
+      end_height = std::numeric_limits<uint64_t>::max();
+    size_t limit = req.limit;
+    if (m_restricted && filter.empty() && (limit == 0 || limit > MAX_RESTRICTED_NTZ_PAGE_COUNT))
+      limit = MAX_RESTRICTED_NTZ_PAGE_COUNT;
+
+    std::vector<Blockchain::ntz_tx_entry> ntzs;
+    if (!m_core.get_blockchain_storage().get_ntz_txs_range(req.start_height, end_height, limit, filter, ntzs, res.more, res.next_height))
+    {
+      res.status = "Failed to read notarizations";
+      return true;
     }
-    // try the pool for any missing txes
-    size_t found_in_pool = 0;
-    std::unordered_set<crypto::hash> pool_tx_hashes;
-    std::unordered_map<crypto::hash, bool> double_spend_seen;
-    if (!missed_txs.empty())
+
+    res.txs.reserve(ntzs.size());
+    for (auto& ntz: ntzs)
     {
-      std::vector<tx_info> pool_tx_info;
-      std::vector<spent_key_image_info> pool_key_image_info;
-      bool r = m_core.get_pool_transactions_and_spent_keys_info(pool_tx_info, pool_key_image_info);
-      if(r)
+      res.txs.push_back(COMMAND_RPC_GET_NOTARIZATIONS::entry());
+      COMMAND_RPC_GET_NOTARIZATIONS::entry &e = res.txs.back();
+      e.ntz_tx_hash = epee::string_tools::pod_to_hex(ntz.tx_hash);
+      e.as_hex = string_tools::buff_to_hex_nodelimer(ntz.blob);
+      if (req.decode_as_json)
       {
-        // sort to match original request
-        std::vector<tx_info>::const_iterator i;
-        std::list<transaction> sorted_txs;
-        for (const crypto::hash &h: vh)
+        transaction tx;
+        if (!parse_and_validate_tx_from_blob(ntz.blob, tx))
         {
-          if (std::find(missed_txs.begin(), missed_txs.end(), h) == missed_txs.end())
-          {
-            if (txs.empty())
-            {
-              res.status = "Failed: internal error - txs is empty";
-              return true;
-            }
-            // core returns the ones it finds in the right order
-            if (get_transaction_hash(txs.front()) != h)
-            {
-              res.status = "Failed: tx hash mismatch";
-              return true;
-            }
-            sorted_txs.push_back(std::move(txs.front()));
-            txs.pop_front();
-          }
-          else if ((i = std::find_if(pool_tx_info.begin(), pool_tx_info.end(), [h](const tx_info &txi) { return epee::string_tools::pod_to_hex(h) == txi.id_hash; })) != pool_tx_info.end())
-          {
-            cryptonote::transaction tx;
-            if (!cryptonote::parse_and_validate_tx_from_blob(i->tx_blob, tx))
-            {
-              res.status = "Failed to parse and validate tx from blob";
-              return true;
-            }
-            sorted_txs.push_back(tx);
-            missed_txs.remove(h);
-            pool_tx_hashes.insert(h);
-            const std::string hash_string = epee::string_tools::pod_to_hex(h);
-            for (const auto &ti: pool_tx_info)
-            {
-              if (ti.id_hash == hash_string)
-              {
-                double_spend_seen.insert(std::make_pair(h, ti.double_spend_seen));
-                break;
-              }
-            }
-            ++found_in_pool;
-          }
+          res.status = "Failed to parse and validate tx from blob";
+          return true;
         }
+        e.as_json = obj_to_json_str(tx);
       }
+      e.in_pool = false;
+      e.double_spend_seen = false;
+      e.block_height = ntz.height;
+      e.block_timestamp = ntz.timestamp;
+      e.output_indices = std::move(ntz.output_indices);
+      filter.erase(ntz.tx_hash);
     }
-    LOG_PRINT_L2("Found " << txs.size() << "/" << vh.size() << " transactions on the blockchain");
 
-    std::vector<std::string>::const_iterator txhi = ntz_hexs.begin();
-    std::vector<crypto::hash>::const_iterator vhi = vh.begin();
-    for(auto& tx: txs)
+    // requested hashes the chain did not have may still be pending in the pool
+    if (!res.more)
     {
-      if (tx.version != 2) {
-
-      } else {
+      for (const crypto::hash& h: filter)
+      {
+        cryptonote::blobdata blob;
+        txpool_tx_meta_t meta;
+        transaction tx;
+        if (!m_core.get_pool_transaction(h, blob) || !parse_and_validate_tx_from_blob(blob, tx) || tx.version != DPOW_NOTA_TX_VERSION)
+        {
+          res.missed_tx.push_back(string_tools::pod_to_hex(h));
+          continue;
+        }
         res.txs.push_back(COMMAND_RPC_GET_NOTARIZATIONS::entry());
         COMMAND_RPC_GET_NOTARIZATIONS::entry &e = res.txs.back();
-
-        crypto::hash tx_hash = *vhi++;
-        e.ntz_tx_hash = *txhi++;
-        blobdata blob = t_serializable_object_to_blob(tx);
+        e.ntz_tx_hash = epee::string_tools::pod_to_hex(h);
         e.as_hex = string_tools::buff_to_hex_nodelimer(blob);
         if (req.decode_as_json)
           e.as_json = obj_to_json_str(tx);
-        e.in_pool = pool_tx_hashes.find(tx_hash) != pool_tx_hashes.end();
-        if (e.in_pool)
-        {
-          e.block_height = e.block_timestamp = std::numeric_limits<uint64_t>::max();
-          if (double_spend_seen.find(tx_hash) != double_spend_seen.end())
-          {
-            e.double_spend_seen = double_spend_seen[tx_hash];
-          }
-          else
-          {
-            MERROR("Failed to determine double spend status for " << tx_hash);
-            e.double_spend_seen = false;
-          }
-        } else {
-          e.block_height = m_core.get_blockchain_storage().get_db().get_tx_block_height(tx_hash);
-          e.block_timestamp = m_core.get_blockchain_storage().get_db().get_block_timestamp(e.block_height);
-          e.double_spend_seen = false;
-          bool r = m_core.get_tx_outputs_gindexs(tx_hash, e.output_indices);
-          if (!r)
-          {
-              res.status = "Failed";
-              return false;
-          }
-        }
+        e.in_pool = true;
+        e.block_height = e.block_timestamp = std::numeric_limits<uint64_t>::max();
+        e.double_spend_seen = m_core.get_blockchain_storage().get_txpool_tx_meta(h, meta) && meta.double_spend_seen;
       }
     }
-    for(const auto& miss_tx: missed_txs)
-    {
-      res.missed_tx.push_back(string_tools::pod_to_hex(miss_tx));
-    }
 
-    LOG_PRINT_L2(res.txs.size() << " transactions found, " << res.missed_tx.size() << " not found");
+    LOG_PRINT_L2(res.txs.size() << " notarizations found, " << res.missed_tx.size() << " not found");
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
@@ -1425,6 +1431,12 @@ namespace cryptonote
       r.sig_count = req.sig_count;
       r.payment_id = req.payment_id;
       r.signers_index = req.signers_index;
+      if (!ntz_signers_mask_from_string(req.signers_index, r.signers_mask))
+      {
+        res.status = "Failed";
+        res.reason = "malformed signers_index";
+        return true;
+      }
 
 //      MWARNING("Ptx string in RPC: " << r.ptx_string);
       m_core.get_protocol()->relay_request_ntz_sig(r, fake_context);
@@ -1651,6 +1663,42 @@ namespace cryptonote
     return r;
   }
   //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_has_ntz_signer(const COMMAND_RPC_HAS_NTZ_SIGNER::request& req, COMMAND_RPC_HAS_NTZ_SIGNER::response& res, bool request_has_rpc_origin)
+  {
+    PERF_TIMER(on_has_ntz_signer);
+    res.untrusted = false;
+    if (!ntz_signer_valid(req.signer_index))
+    {
+      res.status = "Failed: signer_index must be in range [0, 63]";
+      return true;
+    }
+    size_t count = 0;
+    res.signers_mask = m_core.get_ntzpool_signers(count, !request_has_rpc_origin || !m_restricted);
+    res.has_signed = ntz_has_signer(res.signers_mask, req.signer_index);
+    res.count = count;
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
+  bool core_rpc_server::on_wait_ntz_event(const COMMAND_RPC_WAIT_NTZ_EVENT::request& req, COMMAND_RPC_WAIT_NTZ_EVENT::response& res)
+  {
+    // The daemon RPC server only runs a couple of threads, so never let
+    // long-polls occupy all of them: extra waiters get an immediate answer
+    // and fall back to polling at their own pace.
+    uint64_t timeout = std::min<uint64_t>(req.timeout, DPOW_EVENT_MAX_WAIT_MS);
+    if (m_ntz_event_waiters.fetch_add(1) >= 1)
+      timeout = 0;
+    res.changed = m_core.get_blockchain_storage().wait_for_ntz_event(req.chain_revision, req.ntzpool_revision, timeout, res.chain_revision, res.ntzpool_revision);
+    --m_ntz_event_waiters;
+
+    res.height = m_core.get_current_blockchain_height();
+    res.notarized_height = komodo::NOTARIZED_HEIGHT;
+    res.notarization_count = komodo::NUM_NPOINTS;
+    res.ntzpool_count = m_core.get_blockchain_storage().get_ntzpool_tx_count(true);
+    res.status = CORE_RPC_STATUS_OK;
+    return true;
+  }
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_remove_ntzpool_tx(const COMMAND_RPC_REMOVE_NTZPOOL_TX::request& req, COMMAND_RPC_REMOVE_NTZPOOL_TX::response& res, bool request_has_rpc_origin)
   {
     std::list<crypto::hash> hashes;
@@ -2537,6 +2585,8 @@ namespace cryptonote
       boost::shared_lock<boost::shared_mutex> lock(m_bootstrap_daemon_mutex);
       res.was_bootstrap_ever_used = m_was_bootstrap_ever_used;
     }
+    res.getblocks_cache_hits = m_getblocks_cache_hits;
+    res.getblocks_cache_misses = m_getblocks_cache_misses;
     return true;
   }
   //------------------------------------------------------------------------------------------------------------------------------
@@ -2755,22 +2805,24 @@ namespace cryptonote
   {
     uint64_t height;
     uint64_t MoMdepth;
-    uint256 MoM;
 
+    if (req.size() < 2) {
+      res.status = "Failed! calc_MoM needs height and MoMdepth";
+      return true;
+    }
     std::string s_height = req[0];
     std::string s_MoMdepth = req[1];
     MoMdepth = std::stoull(s_MoMdepth, 0, 10);
     height = std::stoull(s_height, 0, 10);
 
-    if ( MoMdepth >= height ) {
+    if ( MoMdepth == 0 || MoMdepth >= height || height >= m_core.get_current_blockchain_height() ) {
       res.status = "Failed! calc_MoM illegal height or MoMdepth";
       return true;
     }
 
-    std::vector<uint8_t> v_mom(komodo::NOTARIZED_MOM.begin(), komodo::NOTARIZED_MOM.begin()+32);
-
+    crypto::hash const MoM = m_core.get_blockchain_storage().get_MoM(height, MoMdepth);
+    std::vector<uint8_t> v_mom(MoM.data, MoM.data + sizeof(MoM.data));
     std::string str_MoM = bytes256_to_hex(v_mom);
-    // use null hash as placeholder - Can change if we need this call
 
     char* coin = (char*)(komodo::ASSETCHAINS_SYMBOL[0] == 0 ? "KMD" : "BLUR");
     res.coin = coin;
@@ -2780,72 +2832,63 @@ namespace cryptonote
     res.status = CORE_RPC_STATUS_OK;
     return true;
   }
-/*  //------------------------------------------------------------------------------------------------------------------------------
+  //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_height_MoM(const COMMAND_RPC_HEIGHT_MOM::request& req, COMMAND_RPC_HEIGHT_MOM::response& res, epee::json_rpc::error& error_resp)
   {
     std::string coin = (char*)(komodo::ASSETCHAINS_SYMBOL[0] == 0 ? "KMD" : komodo::ASSETCHAINS_SYMBOL);
 
-      if (req.height == 0 || m_core.get_current_blockchain_height() == 0 )
-      {
-        error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
-        error_resp.message = "Error no active chain yet";
-        return false;
-      }
-      uint64_t height = m_core.get_blockchain_storage().get_db().height()-1;
+    const uint64_t chain_height = m_core.get_current_blockchain_height();
+    if (chain_height <= 1)
+    {
+      error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
+      error_resp.message = "Error no active chain yet";
+      return false;
+    }
+    if (req.height <= 0)
+    {
+      error_resp.code = CORE_RPC_ERROR_CODE_WRONG_PARAM;
+      error_resp.message = std::string("Invalid height: ") + std::to_string(req.height);
+      return false;
+    }
+    if ((uint64_t)req.height >= chain_height)
+    {
+      error_resp.code = CORE_RPC_ERROR_CODE_TOO_BIG_HEIGHT;
+      error_resp.message = std::string("Too big height: ") + std::to_string(req.height) + ", current blockchain height = " +  std::to_string(chain_height);
+      return false;
+    }
 
-      cryptonote::block blk = m_core.get_blockchain_storage().get_db().get_block_from_height(req.height);
+    uint64_t notarized_height = 0, prev_height = 0;
+    crypto::hash ntz_txid = crypto::null_hash;
+    if (!m_core.get_blockchain_storage().get_notarization_covering(req.height, notarized_height, prev_height, ntz_txid))
+    {
+      error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
+      error_resp.message = "Error: no MoM for height";
+      return false;
+    }
 
+    // the window runs from the block after the previous notarization up to
+    // the notarized block, as komodo's MoMdepth does
+    const uint64_t depth = notarized_height - prev_height;
+    crypto::hash const MoM = m_core.get_blockchain_storage().get_MoM(notarized_height, depth);
 
-    uint64_t timestamp = blk.timestamp;
-    int32_t notarized_height;
-    uint256 MoM;
-    uint256 kmdtxid;
-    uint256 MoMoM;
-    int32_t MoMoMoffset;
-    int32_t MoMoMdepth;
-    int32_t kmdstarti;
-    int32_t kmdendi;
+    std::vector<uint8_t> v_MoM(MoM.data, MoM.data + sizeof(MoM.data));
+    std::vector<uint8_t> v_txid(ntz_txid.data, ntz_txid.data + sizeof(ntz_txid.data));
 
-    //fprintf(stderr,"height_MoM height.%d\n",height);
-    int32_t depth = komodo::komodo_MoM(&notarized_height,&MoM,&kmdtxid,height,&MoMoM,&MoMoMoffset,&MoMoMdepth,&kmdstarti,&kmdendi);
     res.coin = coin;
+    res.prevMoMheight = prev_height;
+    res.timestamp = m_core.get_blockchain_storage().get_db().get_block_timestamp(req.height);
     res.notarized_height = notarized_height;
-    res.timestamp = timestamp;
-    if ( depth > 0 )
-    {
-        res.notarized_MoMdepth = depth;
-        res.notarized_height = notarized_height;
-
-        std::vector<uint8_t> v_MoM(MoM.begin(), MoM.begin() + 32);
-        std::string str_MoM = bytes256_to_hex(v_MoM);
-
-        std::vector<uint8_t> v_kmdtxid(kmdtxid.begin(), kmdtxid.begin() + 32);
-        std::string str_kmdtxid = bytes256_to_hex(v_kmdtxid);
-
-        res.notarized_MoM = str_MoM;
-        res.notarized_desttxid = str_kmdtxid;
-
-        if ( komodo::ASSETCHAINS_SYMBOL[0] != 0 )
-        {
-        std::vector<uint8_t> v_MoMoM(MoMoM.begin(), MoMoM.begin()+32);
-        std::string str_MoMoM = bytes256_to_hex(v_MoMoM);
-
-            res.MoMoM = str_MoMoM;
-            res.MoMoMoffset = MoMoMoffset;
-            res.MoMoMdepth = MoMoMdepth;
-            res.kmdstarti = kmdstarti;
-            res.kmdendi = kmdendi;
-            res.status = CORE_RPC_STATUS_OK;
-            return true;
-        }
-    } else {
-        error_resp.code = CORE_RPC_ERROR_CODE_INTERNAL_ERROR;
-        error_resp.message = "Error: no MoM for height";
-        return false; }
-
+    res.notarized_MoMdepth = depth;
+    res.notarized_MoM = bytes256_to_hex(v_MoM);
+    res.notarized_desttxid = bytes256_to_hex(v_txid);
+    // MoMoM and the kmd range are filled in by the komodo side only
+    res.MoMoMoffset = 0;
+    res.MoMoMdepth = 0;
+    res.kmdstarti = 0;
+    res.kmdendi = 0;
     res.status = CORE_RPC_STATUS_OK;
     return true;
-  }*/
+  }
   //------------------------------------------------------------------------------------------------------------------------------
   bool core_rpc_server::on_base64_encode(const COMMAND_RPC_BASE64_ENCODE::request& req, COMMAND_RPC_BASE64_ENCODE::response& res, epee::json_rpc::error& error_resp)
   {
@@ -3235,11 +3278,11 @@ namespace cryptonote
         r.ptx_string = ptxblob;
         r.ptx_hash = meta.ptx_hash;
         r.tx_blob = txblob;
+        r.tx_hash = txid;
         r.sig_count = meta.sig_count;
-        for (size_t i = 0; i < DPOW_SIG_COUNT; i++) {
-          int each_ind = meta.signers_index[i];
-          r.signers_index.push_back(each_ind);
-        }
+        const std::vector<int> signers_index(meta.signers_index, meta.signers_index + DPOW_SIG_COUNT);
+        r.signers_index = ntz_signers_to_string(signers_index);
+        r.signers_mask = ntz_signers_mask(signers_index);
         m_core.get_protocol()->relay_request_ntz_sig(r, fake_context);
         //TODO: make sure that tx has reached other nodes here, probably wait to receive reflections from other nodes
       }
@@ -31,11 +31,13 @@
 
 #pragma  once
 
+#include <atomic>
 #include <boost/program_options/options_description.hpp>
 #include <boost/program_options/variables_map.hpp>
 
 #include "net/http_server_impl_base.h"
 #include "net/http_client.h"
+#include "common/lru_cache.h"
 #include "core_rpc_server_commands_defs.h"
 #include "cryptonote_core/cryptonote_core.h"
 #include "p2p/net_node.h"
@@ -100,6 +102,7 @@ namespace cryptonote
       MAP_URI_AUTO_BIN2("/getrandom_rctouts.bin", on_get_random_rct_outs, COMMAND_RPC_GET_RANDOM_RCT_OUTPUTS)
       MAP_URI_AUTO_JON2("/get_transactions", on_get_transactions, COMMAND_RPC_GET_TRANSACTIONS)
       MAP_URI_AUTO_JON2("/get_notarizations", on_get_notarizations, COMMAND_RPC_GET_NOTARIZATIONS)
+      MAP_URI_AUTO_BIN2("/get_notarizations.bin", on_get_notarizations, COMMAND_RPC_GET_NOTARIZATIONS)
       MAP_URI_AUTO_JON2("/gettransactions", on_get_transactions, COMMAND_RPC_GET_TRANSACTIONS)
       MAP_URI_AUTO_JON2("/gettransactions_by_heights", on_get_transactions_by_heights, COMMAND_RPC_GET_TRANSACTIONS_BY_HEIGHTS)
       MAP_URI_AUTO_JON2("/get_alt_blocks_hashes", on_get_alt_blocks_hashes, COMMAND_RPC_GET_ALT_BLOCKS_HASHES)
@@ -119,6 +122,8 @@ namespace cryptonote
       MAP_URI_AUTO_JON2("/get_transaction_pool_hashes.bin", on_get_transaction_pool_hashes, COMMAND_RPC_GET_TRANSACTION_POOL_HASHES)
       MAP_URI_AUTO_JON2("/get_pending_ntz_pool", on_get_pending_ntz_pool, COMMAND_RPC_GET_PENDING_NTZ_POOL)
       MAP_URI_AUTO_JON2("/get_ntz_pool_count", on_get_ntz_pool_count, COMMAND_RPC_GET_PENDING_NTZ_POOL_COUNT)
+      MAP_URI_AUTO_JON2("/has_ntz_signer", on_has_ntz_signer, COMMAND_RPC_HAS_NTZ_SIGNER)
+      MAP_URI_AUTO_JON2_IF("/wait_ntz_event", on_wait_ntz_event, COMMAND_RPC_WAIT_NTZ_EVENT, !m_restricted)
       MAP_URI_AUTO_JON2("/remove_ntzpool_tx", on_remove_ntzpool_tx, COMMAND_RPC_REMOVE_NTZPOOL_TX)
       MAP_URI_AUTO_JON2("/get_pending_ntz_pool_hashes.bin", on_get_pending_ntz_pool_hashes, COMMAND_RPC_GET_PENDING_NTZ_POOL_HASHES)
       MAP_URI_AUTO_JON2("/get_blocks_json", on_get_blocks_json, COMMAND_RPC_GET_BLOCKS_JSON)
@@ -182,7 +187,7 @@ namespace cryptonote
         MAP_JON_RPC_WE_IF("relay_tx",                on_relay_tx,                   COMMAND_RPC_RELAY_TX, !m_restricted)
         MAP_JON_RPC_WE_IF("relay_ntzpool_tx",        on_relay_ntzpool_tx,           COMMAND_RPC_RELAY_NTZPOOL_TX, !m_restricted)
         MAP_JON_RPC_WE_IF("sync_info",               on_sync_info,                  COMMAND_RPC_SYNC_INFO, !m_restricted)
-        //MAP_JON_RPC_WE_IF("height_MoM",            on_height_MoM,                 COMMAND_RPC_HEIGHT_MOM, !m_restricted)
+        MAP_JON_RPC_WE_IF("height_MoM",              on_height_MoM,                 COMMAND_RPC_HEIGHT_MOM, !m_restricted)
         MAP_JON_RPC_WE_IF("get_merkle_root",         on_get_merkle_root,            COMMAND_RPC_GET_MERKLE_ROOT, !m_restricted)
       END_JSON_RPC_MAP()
     END_URI_MAP2()
@@ -218,6 +223,8 @@ namespace cryptonote
     bool on_get_pending_ntz_pool(const COMMAND_RPC_GET_PENDING_NTZ_POOL::request& req, COMMAND_RPC_GET_PENDING_NTZ_POOL::response& res, bool request_has_rpc_origin = true);
     bool on_remove_ntzpool_tx(const COMMAND_RPC_REMOVE_NTZPOOL_TX::request& req, COMMAND_RPC_REMOVE_NTZPOOL_TX::response& res, bool request_has_rpc_origin = true);
     bool on_get_ntz_pool_count(const COMMAND_RPC_GET_PENDING_NTZ_POOL_COUNT::request& req, COMMAND_RPC_GET_PENDING_NTZ_POOL_COUNT::response& res, bool request_has_rpc_origin = true);
+    bool on_has_ntz_signer(const COMMAND_RPC_HAS_NTZ_SIGNER::request& req, COMMAND_RPC_HAS_NTZ_SIGNER::response& res, bool request_has_rpc_origin = true);
+    bool on_wait_ntz_event(const COMMAND_RPC_WAIT_NTZ_EVENT::request& req, COMMAND_RPC_WAIT_NTZ_EVENT::response& res);
     bool on_get_blocks_json(const COMMAND_RPC_GET_BLOCKS_JSON::request& req, COMMAND_RPC_GET_BLOCKS_JSON::response& res, bool request_has_rpc_origin = true);
     bool on_get_transaction_pool_hashes(const COMMAND_RPC_GET_TRANSACTION_POOL_HASHES::request& req, COMMAND_RPC_GET_TRANSACTION_POOL_HASHES::response& res, bool request_has_rpc_origin = true);
     bool on_get_transaction_pool_stats(const COMMAND_RPC_GET_TRANSACTION_POOL_STATS::request& req, COMMAND_RPC_GET_TRANSACTION_POOL_STATS::response& res, bool request_has_rpc_origin = true);
@@ -268,7 +275,7 @@ namespace cryptonote
     bool on_get_txpool_backlog(const COMMAND_RPC_GET_TRANSACTION_POOL_BACKLOG::request& req, COMMAND_RPC_GET_TRANSACTION_POOL_BACKLOG::response& res, epee::json_rpc::error& error_resp);
     bool on_get_output_distribution(const COMMAND_RPC_GET_OUTPUT_DISTRIBUTION::request& req, COMMAND_RPC_GET_OUTPUT_DISTRIBUTION::response& res, epee::json_rpc::error& error_resp);
     bool on_calc_MoM(const COMMAND_RPC_CALC_MOM::request& req, COMMAND_RPC_CALC_MOM::response& res);
-//    bool on_height_MoM(const COMMAND_RPC_HEIGHT_MOM::request& req, COMMAND_RPC_HEIGHT_MOM::response& res, epee::json_rpc::error& error);
+    bool on_height_MoM(const COMMAND_RPC_HEIGHT_MOM::request& req, COMMAND_RPC_HEIGHT_MOM::response& res, epee::json_rpc::error& error);
     bool on_get_ntz_data(const COMMAND_RPC_GET_NTZ_DATA::request& req, COMMAND_RPC_GET_NTZ_DATA::response& res, epee::json_rpc::error& error);
     bool on_get_merkle_root(const COMMAND_RPC_GET_MERKLE_ROOT::request& req, COMMAND_RPC_GET_MERKLE_ROOT::response& res, epee::json_rpc::error& error);
     bool on_base64_encode(const COMMAND_RPC_BASE64_ENCODE::request& req, COMMAND_RPC_BASE64_ENCODE::response& res, epee::json_rpc::error& error);
@@ -285,6 +292,16 @@ private:
     template <typename COMMAND_TYPE>
     bool use_bootstrap_daemon_if_necessary(const invoke_http_mode &mode, const std::string &command_name, const typename COMMAND_TYPE::request& req, typename COMMAND_TYPE::response& res, bool &r);
 
+    // one block's worth of a getblocks.bin response, ready to be copied out
+    struct getblocks_entry
+    {
+      crypto::hash hash;
+      block_complete_entry block;
+      COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices output_indices;
+      size_t unpruned_size;
+    };
+    bool load_getblocks_entry(uint64_t height, bool prune, getblocks_entry& entry);
+
     core& m_core;
     nodetool::node_server<cryptonote::t_cryptonote_protocol_handler<cryptonote::core> >& m_p2p;
     std::vector<std::string> btc_scriptpubkeys;
@@ -297,6 +314,14 @@ private:
     bool m_was_bootstrap_ever_used;
     network_type m_nettype;
     bool m_restricted;
+    std::atomic<unsigned> m_ntz_event_waiters;
+
+    // keyed by height * 2 + prune, checked against the chain's hash at that height on every use;
+    // bounded by the bytes of the blobs held, since pruned and unpruned copies of a block may both be cached
+    tools::lru_cache<uint64_t, getblocks_entry> m_getblocks_cache;
+    boost::mutex m_getblocks_cache_mutex;
+    std::atomic<uint64_t> m_getblocks_cache_hits;
+    std::atomic<uint64_t> m_getblocks_cache_misses;
   };
 
 }
@@ -51,7 +51,7 @@ namespace cryptonote
 // advance which version they will stop working with
 // Don't go over 32767 for any of these
 #define CORE_RPC_VERSION_MAJOR 1
-#define CORE_RPC_VERSION_MINOR 21
+#define CORE_RPC_VERSION_MINOR 25
 #define MAKE_CORE_RPC_VERSION(major,minor) (((major)<<16)|(minor))
 #define CORE_RPC_VERSION MAKE_CORE_RPC_VERSION(CORE_RPC_VERSION_MAJOR, CORE_RPC_VERSION_MINOR)
 
@@ -622,10 +622,16 @@ namespace cryptonote
     {
       std::list<std::string> txs_hashes;
       bool decode_as_json;
+      uint64_t start_height;
+      uint64_t end_height;   // 0 for the chain top
+      uint64_t limit;        // 0 for no limit
 
       BEGIN_KV_SERIALIZE_MAP()
         KV_SERIALIZE(txs_hashes)
         KV_SERIALIZE(decode_as_json)
+        KV_SERIALIZE_OPT(start_height, (uint64_t)0)
+        KV_SERIALIZE_OPT(end_height, (uint64_t)0)
+        KV_SERIALIZE_OPT(limit, (uint64_t)0)
       END_KV_SERIALIZE_MAP()
     };
 
@@ -663,6 +669,8 @@ namespace cryptonote
 
       // new style
       std::vector<entry> txs;
+      bool more;             // the range holds notarizations past this page
+      uint64_t next_height;  // start_height of the next page, if more
       std::string status;
       bool untrusted;
 
@@ -671,6 +679,8 @@ namespace cryptonote
         KV_SERIALIZE(txs_as_json)
         KV_SERIALIZE(txs)
         KV_SERIALIZE(missed_tx)
+        KV_SERIALIZE_OPT(more, false)
+        KV_SERIALIZE_OPT(next_height, (uint64_t)0)
         KV_SERIALIZE(status)
         KV_SERIALIZE(untrusted)
       END_KV_SERIALIZE_MAP()
@@ -1267,6 +1277,8 @@ namespace cryptonote
       std::string bootstrap_daemon_address;
       uint64_t height_without_bootstrap;
       bool was_bootstrap_ever_used;
+      uint64_t getblocks_cache_hits;
+      uint64_t getblocks_cache_misses;
       std::string version;
 
       BEGIN_KV_SERIALIZE_MAP()
@@ -1305,6 +1317,8 @@ namespace cryptonote
         KV_SERIALIZE(bootstrap_daemon_address)
         KV_SERIALIZE(height_without_bootstrap)
         KV_SERIALIZE(was_bootstrap_ever_used)
+        KV_SERIALIZE(getblocks_cache_hits)
+        KV_SERIALIZE(getblocks_cache_misses)
 //	KV_SERIALIZE(version)
       END_KV_SERIALIZE_MAP()
     };
@@ -2188,6 +2202,7 @@ namespace cryptonote
     std::string ptx_hash;
     int sig_count;
     std::list<int> signers_index;
+    uint64_t signers_mask;
 
 
     BEGIN_KV_SERIALIZE_MAP()
@@ -2211,6 +2226,7 @@ namespace cryptonote
       KV_SERIALIZE(ptx_hash)
       KV_SERIALIZE(sig_count)
       KV_SERIALIZE(signers_index)
+      KV_SERIALIZE_OPT(signers_mask, (uint64_t)0)
    END_KV_SERIALIZE_MAP()
   };
 
@@ -2309,6 +2325,74 @@ namespace cryptonote
     };
   };
 
+  struct COMMAND_RPC_HAS_NTZ_SIGNER
+  {
+    struct request
+    {
+      int signer_index;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(signer_index)
+      END_KV_SERIALIZE_MAP()
+    };
+
+    struct response
+    {
+      std::string status;
+      bool has_signed;
+      uint64_t signers_mask;
+      uint64_t count;
+      bool untrusted;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(status)
+        KV_SERIALIZE(has_signed)
+        KV_SERIALIZE(signers_mask)
+        KV_SERIALIZE(count)
+        KV_SERIALIZE(untrusted)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
+  struct COMMAND_RPC_WAIT_NTZ_EVENT
+  {
+    struct request
+    {
+      uint64_t chain_revision;
+      uint64_t ntzpool_revision;
+      uint64_t timeout;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE_OPT(chain_revision, (uint64_t)0)
+        KV_SERIALIZE_OPT(ntzpool_revision, (uint64_t)0)
+        KV_SERIALIZE_OPT(timeout, (uint64_t)DPOW_EVENT_WAIT_MS)
+      END_KV_SERIALIZE_MAP()
+    };
+
+    struct response
+    {
+      std::string status;
+      bool changed;
+      uint64_t chain_revision;
+      uint64_t ntzpool_revision;
+      uint64_t height;
+      uint64_t notarized_height;
+      uint64_t notarization_count;
+      uint64_t ntzpool_count;
+
+      BEGIN_KV_SERIALIZE_MAP()
+        KV_SERIALIZE(status)
+        KV_SERIALIZE(changed)
+        KV_SERIALIZE(chain_revision)
+        KV_SERIALIZE(ntzpool_revision)
+        KV_SERIALIZE(height)
+        KV_SERIALIZE(notarized_height)
+        KV_SERIALIZE(notarization_count)
+        KV_SERIALIZE(ntzpool_count)
+      END_KV_SERIALIZE_MAP()
+    };
+  };
+
   struct COMMAND_RPC_REMOVE_NTZPOOL_TX
   {
     struct request
@@ -119,6 +119,7 @@ namespace rpc
     bool has_ntz_data;
     int sig_count;
     std::list<int> signers_index;
+    uint64_t signers_mask;
   };
 
   typedef std::unordered_map<crypto::key_image, std::vector<crypto::hash> > key_images_with_tx_hashes;
@@ -804,6 +804,7 @@ void toJsonValue(rapidjson::Document& doc, const cryptonote::rpc::tx_in_ntzpool&
   INSERT_INTO_JSON_OBJECT(val, doc, has_ntz_data, tx.has_ntz_data);
   INSERT_INTO_JSON_OBJECT(val, doc, sig_count, tx.sig_count);
   INSERT_INTO_JSON_OBJECT(val, doc, signers_index, tx.signers_index);
+  INSERT_INTO_JSON_OBJECT(val, doc, signers_mask, tx.signers_mask);
 }
 
 void fromJsonValue(const rapidjson::Value& val, cryptonote::rpc::tx_in_ntzpool& tx)
@@ -831,6 +832,7 @@ void fromJsonValue(const rapidjson::Value& val, cryptonote::rpc::tx_in_ntzpool&
   GET_FROM_JSON_OBJECT(val, tx.has_ntz_data, has_ntz_data);
   GET_FROM_JSON_OBJECT(val, tx.sig_count, sig_count);
   GET_FROM_JSON_OBJECT(val, tx.signers_index, signers_index);
+  GET_FROM_JSON_OBJECT(val, tx.signers_mask, signers_mask);
 }
 
 void toJsonValue(rapidjson::Document& doc, const cryptonote::rpc::hard_fork_info& info, rapidjson::Value& val)
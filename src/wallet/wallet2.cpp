@@ -1202,7 +1202,7 @@ void wallet2::scan_output(const cryptonote::transaction &tx, const crypto::publi
   ++num_vouts_received;
 }
 //----------------------------------------------------------------------------------------------------
-void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote::transaction& tx, const std::vector<uint64_t> &o_indices, uint64_t height, uint64_t ts, bool miner_tx, bool pool, bool double_spend_seen)
+void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote::transaction& tx, const std::vector<uint64_t> &o_indices, uint64_t height, uint64_t ts, bool miner_tx, bool pool, bool double_spend_seen, const std::vector<tx_scan_info_t> *precomputed_scan_info)
 {
   //ensure device is let in NONE mode in any case
   hw::device &hwdev = m_account.get_device();
@@ -1260,42 +1260,65 @@ void wallet2::process_new_transaction(const crypto::hash &txid, const cryptonote
     tools::threadpool::waiter waiter;
     const cryptonote::account_keys& keys = m_account.get_keys();
     crypto::key_derivation derivation;
-
-    hwdev_lock.lock();
-    hwdev.set_mode(hw::device::TRANSACTION_PARSE);
-    if (!hwdev.generate_key_derivation(tx_pub_key, keys.m_view_secret_key, derivation))
-    {
-      MWARNING("Failed to generate key derivation from tx pubkey, skipping");
-      static_assert(sizeof(derivation) == sizeof(rct::key), "Mismatched sizes of key_derivation and rct::key");
-      memcpy(&derivation, rct::identity().bytes, sizeof(derivation));
-    }
-
     // additional tx pubkeys and derivations for multi-destination transfers involving one or more subaddresses
-    std::vector<crypto::public_key> additional_tx_pub_keys = get_additional_tx_pub_keys_from_extra(tx);
     std::vector<crypto::key_derivation> additional_derivations;
 
-    for (size_t i = 0; i < additional_tx_pub_keys.size(); ++i)
+    if (!precomputed_scan_info)
     {
-      additional_derivations.push_back({});
-      if (!hwdev.generate_key_derivation(additional_tx_pub_keys[i], keys.m_view_secret_key, additional_derivations.back()))
+      hwdev_lock.lock();
+      hwdev.set_mode(hw::device::TRANSACTION_PARSE);
+      if (!hwdev.generate_key_derivation(tx_pub_key, keys.m_view_secret_key, derivation))
       {
         MWARNING("Failed to generate key derivation from tx pubkey, skipping");
-        additional_derivations.pop_back();
+        static_assert(sizeof(derivation) == sizeof(rct::key), "Mismatched sizes of key_derivation and rct::key");
+        memcpy(&derivation, rct::identity().bytes, sizeof(derivation));
+      }
+
+      std::vector<crypto::public_key> additional_tx_pub_keys = get_additional_tx_pub_keys_from_extra(tx);
+      for (size_t i = 0; i < additional_tx_pub_keys.size(); ++i)
+      {
+        additional_derivations.push_back({});
+        if (!hwdev.generate_key_derivation(additional_tx_pub_keys[i], keys.m_view_secret_key, additional_derivations.back()))
+        {
+          MWARNING("Failed to generate key derivation from tx pubkey, skipping");
+          additional_derivations.pop_back();
+        }
       }
-    }
 
-    hwdev_lock.unlock();
+      hwdev_lock.unlock();
+    }
 
     if (miner_tx && m_refresh_type == RefreshNoCoinbase)
     {
       // assume coinbase isn't for us
     }
+    else if (precomputed_scan_info)
+    {
+      // outputs were already checked against our keys by process_blocks, only matches are left to scan
+      THROW_WALLET_EXCEPTION_IF(precomputed_scan_info->size() != tx.vout.size(), error::wallet_internal_error,
+          "precomputed scan info size=" + std::to_string(precomputed_scan_info->size()) +
+          " not match with transaction outputs size=" + std::to_string(tx.vout.size()));
+      tx_scan_info = *precomputed_scan_info;
+
+      hwdev_lock.lock();
+      hwdev.set_mode(hw::device::NONE);
+      for (size_t i = 0; i < tx.vout.size(); ++i)
+      {
+        THROW_WALLET_EXCEPTION_IF(tx_scan_info[i].error, error::acc_outs_lookup_error, tx, tx_pub_key, m_account.get_keys());
+        if (tx_scan_info[i].received)
+        {
+          hwdev.generate_key_derivation(tx_pub_key,  keys.m_view_secret_key, tx_scan_info[i].received->derivation);
+          scan_output(tx, tx_pub_key, i, tx_scan_info[i], num_vouts_received, tx_money_got_in_outs, outs);
+        }
+      }
+      hwdev_lock.unlock();
+    }
     else if (tx.vout.size() > 1 && tools::threadpool::getInstance().get_max_concurrency() > 1)
     {
       for (size_t i = 0; i < tx.vout.size(); ++i)
       {
         tpool.submit(&waiter, boost::bind(&wallet2::check_acc_out_precomp_once, this, std::cref(tx.vout[i]), std::cref(derivation), std::cref(additional_derivations), i,
-        std::ref(tx_scan_info[i]), std::ref(output_found[i])));
+        std::ref(tx_scan_info[i]), std::ref(output_found[i])), tools::threadpool::PRIORITY_LOW);
       }
       waiter.wait();
 
@@ -1686,8 +1709,10 @@ void wallet2::process_outgoing(const crypto::hash &txid, const cryptonote::trans
   add_rings(tx);
 }
 //----------------------------------------------------------------------------------------------------
-void wallet2::process_new_blockchain_entry(const cryptonote::block& b, const cryptonote::block_complete_entry& bche, const crypto::hash& bl_id, uint64_t height, const cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices &o_indices)
+void wallet2::process_new_blockchain_entry(const parsed_block &pb, const cryptonote::block_complete_entry& bche, uint64_t height, const cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices &o_indices)
 {
+  const cryptonote::block &b = pb.block;
+  const crypto::hash &bl_id = pb.hash;
   size_t txidx = 0;
   THROW_WALLET_EXCEPTION_IF(bche.txs.size() + 1 != o_indices.indices.size(), error::wallet_internal_error,
       "block transactions=" + std::to_string(bche.txs.size()) +
@@ -1696,22 +1721,23 @@ void wallet2::process_new_blockchain_entry(const cryptonote::block& b, const cry
   //handle transactions from new block
     
   //optimization: seeking only for blocks that are not older then the wallet creation time plus 1 day. 1 day is for possible user incorrect time setup
-  if(b.timestamp + 60*60*24 > m_account.get_createtime() && height >= m_refresh_from_block_height)
+  if(should_scan_block(b, height))
   {
+    const bool precomputed = !pb.tx_scan_info.empty();
+    THROW_WALLET_EXCEPTION_IF(precomputed && pb.tx_scan_info.size() != pb.txes.size() + 1, error::wallet_internal_error, "Wrong amount of precomputed scan info for block");
+
     TIME_MEASURE_START(miner_tx_handle_time);
-    process_new_transaction(get_transaction_hash(b.miner_tx), b.miner_tx, o_indices.indices[txidx++].indices, height, b.timestamp, true, false, false);
+    process_new_transaction(get_transaction_hash(b.miner_tx), b.miner_tx, o_indices.indices[txidx].indices, height, b.timestamp, true, false, false, precomputed ? &pb.tx_scan_info[txidx] : NULL);
+    ++txidx;
     TIME_MEASURE_FINISH(miner_tx_handle_time);
 
     TIME_MEASURE_START(txs_handle_time);
     THROW_WALLET_EXCEPTION_IF(bche.txs.size() != b.tx_hashes.size(), error::wallet_internal_error, "Wrong amount of transactions for block");
-    size_t idx = 0;
-    for (const auto& txblob: bche.txs)
+    THROW_WALLET_EXCEPTION_IF(pb.txes.size() != b.tx_hashes.size(), error::wallet_internal_error, "Wrong amount of parsed transactions for block");
+    for (size_t idx = 0; idx < pb.txes.size(); ++idx)
     {
-      cryptonote::transaction tx;
-      bool r = parse_and_validate_tx_base_from_blob(txblob, tx);
-      THROW_WALLET_EXCEPTION_IF(!r, error::tx_parse_error, txblob);
-      process_new_transaction(b.tx_hashes[idx], tx, o_indices.indices[txidx++].indices, height, b.timestamp, false, false, false);
-      ++idx;
+      process_new_transaction(b.tx_hashes[idx], pb.txes[idx], o_indices.indices[txidx].indices, height, b.timestamp, false, false, false, precomputed ? &pb.tx_scan_info[txidx] : NULL);
+      ++txidx;
     }
     TIME_MEASURE_FINISH(txs_handle_time);
     LOG_PRINT_L2("Processed block: " << bl_id << ", height " << height << ", " <<  miner_tx_handle_time + txs_handle_time << "(" << miner_tx_handle_time << "/" << txs_handle_time <<")ms");
@@ -1759,11 +1785,83 @@ void wallet2::get_short_chain_history(std::list<crypto::hash>& ids) const
     ids.push_back(m_blockchain.genesis());
 }
 //----------------------------------------------------------------------------------------------------
-void wallet2::parse_block_round(const cryptonote::blobdata &blob, cryptonote::block &bl, crypto::hash &bl_id, bool &error) const
+void wallet2::parse_block_entry(const cryptonote::block_complete_entry &bche, uint64_t height, parsed_block &pb) const
+{
+  pb.error = true;
+  if (!cryptonote::parse_and_validate_block_from_blob(bche.block, pb.block))
+    return;
+  pb.hash = get_block_hash(pb.block);
+  // txes of blocks we do not scan are never looked at
+  if (!should_scan_block(pb.block, height))
+  {
+    pb.error = false;
+    return;
+  }
+  pb.txes.resize(bche.txs.size());
+  size_t idx = 0;
+  for (const auto &txblob: bche.txs)
+  {
+    if (!parse_and_validate_tx_base_from_blob(txblob, pb.txes[idx++]))
+      return;
+  }
+  pb.error = false;
+}
+//----------------------------------------------------------------------------------------------------
+bool wallet2::should_scan_block(const cryptonote::block &b, uint64_t height) const
 {
-  error = !cryptonote::parse_and_validate_block_from_blob(blob, bl);
-  if (!error)
-    bl_id = get_block_hash(bl);
+  return b.timestamp + 60*60*24 > m_account.get_createtime() && height >= m_refresh_from_block_height;
+}
+//----------------------------------------------------------------------------------------------------
+// Lock free counterpart of the derivation and check_acc_out_precomp steps of process_new_transaction,
+// only valid when the account lives on the software device, which keeps no per call state
+void wallet2::scan_tx_outputs(const cryptonote::transaction &tx, bool miner_tx, std::vector<tx_scan_info_t> &tx_scan_info) const
+{
+  tx_scan_info.clear();
+  tx_scan_info.resize(tx.vout.size());
+  for (auto &info: tx_scan_info)
+    info.error = false;
+  if (tx.vout.empty() || (miner_tx && m_refresh_type == RefreshNoCoinbase))
+    return;
+
+  crypto::public_key tx_pub_key = get_tx_pub_key_from_extra(tx);
+  if (tx_pub_key == null_pkey)
+    return;
+
+  hw::device &hwdev = m_account.get_device();
+  const cryptonote::account_keys& keys = m_account.get_keys();
+  crypto::key_derivation derivation;
+  if (!hwdev.generate_key_derivation(tx_pub_key, keys.m_view_secret_key, derivation))
+  {
+    MWARNING("Failed to generate key derivation from tx pubkey, skipping");
+    static_assert(sizeof(derivation) == sizeof(rct::key), "Mismatched sizes of key_derivation and rct::key");
+    memcpy(&derivation, rct::identity().bytes, sizeof(derivation));
+  }
+
+  std::vector<crypto::public_key> additional_tx_pub_keys = get_additional_tx_pub_keys_from_extra(tx);
+  std::vector<crypto::key_derivation> additional_derivations;
+  for (size_t i = 0; i < additional_tx_pub_keys.size(); ++i)
+  {
+    additional_derivations.push_back({});
+    if (!hwdev.generate_key_derivation(additional_tx_pub_keys[i], keys.m_view_secret_key, additional_derivations.back()))
+    {
+      MWARNING("Failed to generate key derivation from tx pubkey, skipping");
+      additional_derivations.pop_back();
+    }
+  }
+
+  for (size_t i = 0; i < tx.vout.size(); ++i)
+  {
+    const tx_out &o = tx.vout[i];
+    tx_scan_info_t &info = tx_scan_info[i];
+    if (o.target.type() != typeid(txout_to_key))
+    {
+      info.error = true;
+      LOG_ERROR("wrong type id in transaction out");
+      continue;
+    }
+    info.received = is_out_to_acc_precomp(m_subaddresses, boost::get<txout_to_key>(o.target).key, derivation, additional_derivations, i, hwdev);
+    info.money_transfered = info.received ? o.amount : 0; // may be 0 for ringct outputs
+  }
 }
 //----------------------------------------------------------------------------------------------------
 void wallet2::pull_blocks(uint64_t start_height, uint64_t &blocks_start_height, const std::list<crypto::hash> &short_chain_history, std::list<cryptonote::block_complete_entry> &blocks, std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> &o_indices, bool m_is_initialized)
@@ -1865,81 +1963,76 @@ void wallet2::process_blocks(uint64_t start_height, const std::list<cryptonote::
 {
   size_t current_index = start_height;
   blocks_added = 0;
-  size_t tx_o_indices_idx = 0;
 
   THROW_WALLET_EXCEPTION_IF(blocks.size() != o_indices.size(), error::wallet_internal_error, "size mismatch");
   THROW_WALLET_EXCEPTION_IF(!m_blockchain.is_in_bounds(current_index), error::wallet_internal_error, "Index out of bounds of hashchain");
 
   tools::threadpool& tpool = tools::threadpool::getInstance();
-  int threads = tpool.get_max_concurrency();
-  if (threads > 1)
+  const bool use_pool = tpool.get_max_concurrency() > 1;
+  const size_t blocks_size = blocks.size();
+  std::vector<parsed_block> parsed_blocks(blocks_size);
+
+  // parse blocks and their transactions for the whole range up front
+  {
+    tools::threadpool::waiter waiter;
+    size_t i = 0;
+    for (const auto &bche: blocks)
+    {
+      if (use_pool)
+        tpool.submit(&waiter, boost::bind(&wallet2::parse_block_entry, this, std::cref(bche), start_height + i, std::ref(parsed_blocks[i])), tools::threadpool::PRIORITY_LOW);
+      else
+        parse_block_entry(bche, start_height + i, parsed_blocks[i]);
+      ++i;
+    }
+    waiter.wait();
+  }
   {
-    std::vector<crypto::hash> round_block_hashes(threads);
-    std::vector<cryptonote::block> round_blocks(threads);
-    std::deque<bool> error(threads);
-    size_t blocks_size = blocks.size();
-    std::list<block_complete_entry>::const_iterator blocki = blocks.begin();
-    for (size_t b = 0; b < blocks_size; b += threads)
+    size_t i = 0;
+    for (const auto &bche: blocks)
     {
-      size_t round_size = std::min((size_t)threads, blocks_size - b);
-      tools::threadpool::waiter waiter;
+      THROW_WALLET_EXCEPTION_IF(parsed_blocks[i].error, error::block_parse_error, bche.block);
+      ++i;
+    }
+  }
 
-      std::list<block_complete_entry>::const_iterator tmpblocki = blocki;
-      for (size_t i = 0; i < round_size; ++i)
-      {
-        tpool.submit(&waiter, boost::bind(&wallet2::parse_block_round, this, std::cref(tmpblocki->block),
-          std::ref(round_blocks[i]), std::ref(round_block_hashes[i]), std::ref(error[i])));
-        ++tmpblocki;
-      }
-      waiter.wait();
-      tmpblocki = blocki;
-      for (size_t i = 0; i < round_size; ++i)
-      {
-        THROW_WALLET_EXCEPTION_IF(error[i], error::block_parse_error, tmpblocki->block);
-        ++tmpblocki;
-      }
-      for (size_t i = 0; i < round_size; ++i)
+  // Check every output of the range against our keys in one batch, so the derivations run
+  // in parallel rather than one tx at a time. The hardware device has to be driven serially
+  // under its lock, so it keeps scanning each tx as it is processed.
+  const size_t scanned_subaddresses = m_subaddresses.size();
+  if (&m_account.get_device() == &hw::get_device("default"))
+  {
+    tools::threadpool::waiter waiter;
+    for (size_t i = 0; i < blocks_size; ++i)
+    {
+      parsed_block &pb = parsed_blocks[i];
+      if (start_height + i < m_blockchain.size() && pb.hash == m_blockchain[start_height + i])
+        continue;
+      if (!should_scan_block(pb.block, start_height + i))
+        continue;
+      pb.tx_scan_info.resize(pb.txes.size() + 1);
+      for (size_t j = 0; j < pb.tx_scan_info.size(); ++j)
       {
-        const crypto::hash &bl_id = round_block_hashes[i];
-        cryptonote::block &bl = round_blocks[i];
-
-        if(current_index >= m_blockchain.size())
-        {
-          process_new_blockchain_entry(bl, *blocki, bl_id, current_index, o_indices[b+i]);
-          ++blocks_added;
-        }
-        else if(bl_id != m_blockchain[current_index])
-        {
-          //split detected here !!!
-          THROW_WALLET_EXCEPTION_IF(current_index == start_height, error::wallet_internal_error,
-            "wrong daemon response: split starts from the first block in response " + string_tools::pod_to_hex(bl_id) +
-            " (height " + std::to_string(start_height) + "), local block id at this height: " +
-            string_tools::pod_to_hex(m_blockchain[current_index]));
-
-          detach_blockchain(current_index);
-          process_new_blockchain_entry(bl, *blocki, bl_id, current_index, o_indices[b+i]);
-        }
+        const cryptonote::transaction &tx = j == 0 ? pb.block.miner_tx : pb.txes[j - 1];
+        if (use_pool)
+          tpool.submit(&waiter, boost::bind(&wallet2::scan_tx_outputs, this, std::cref(tx), j == 0, std::ref(pb.tx_scan_info[j])), tools::threadpool::PRIORITY_LOW);
         else
-        {
-          LOG_PRINT_L2("Block is already in blockchain: " << string_tools::pod_to_hex(bl_id));
-        }
-        ++current_index;
-        ++blocki;
+          scan_tx_outputs(tx, j == 0, pb.tx_scan_info[j]);
       }
     }
+    waiter.wait();
   }
-  else
-  {
-  for(auto& bl_entry: blocks)
-  {
-    cryptonote::block bl;
-    bool r = cryptonote::parse_and_validate_block_from_blob(bl_entry.block, bl);
-    THROW_WALLET_EXCEPTION_IF(!r, error::block_parse_error, bl_entry.block);
 
-    crypto::hash bl_id = get_block_hash(bl);
+  std::list<cryptonote::block_complete_entry>::const_iterator blocki = blocks.begin();
+  for (size_t i = 0; i < blocks_size; ++i, ++blocki)
+  {
+    parsed_block &pb = parsed_blocks[i];
+    const crypto::hash &bl_id = pb.hash;
+    // receiving to a subaddress grows the lookahead, which the batch above did not check against
+    if (m_subaddresses.size() != scanned_subaddresses)
+      pb.tx_scan_info.clear();
     if(current_index >= m_blockchain.size())
     {
-      process_new_blockchain_entry(bl, bl_entry, bl_id, current_index, o_indices[tx_o_indices_idx]);
+      process_new_blockchain_entry(pb, *blocki, current_index, o_indices[i]);
       ++blocks_added;
     }
     else if(bl_id != m_blockchain[current_index])
@@ -1951,16 +2044,13 @@ void wallet2::process_blocks(uint64_t start_height, const std::list<cryptonote::
         string_tools::pod_to_hex(m_blockchain[current_index]));
 
       detach_blockchain(current_index);
-      process_new_blockchain_entry(bl, bl_entry, bl_id, current_index, o_indices[tx_o_indices_idx]);
+      process_new_blockchain_entry(pb, *blocki, current_index, o_indices[i]);
     }
     else
     {
       LOG_PRINT_L2("Block is already in blockchain: " << string_tools::pod_to_hex(bl_id));
     }
-
     ++current_index;
-    ++tx_o_indices_idx;
-  }
   }
 }
 //----------------------------------------------------------------------------------------------------
@@ -2083,6 +2173,21 @@ size_t wallet2::get_ntzpool_count(bool include_unrelayed)
   return nres.count;
 }
 //----------------------------------------------------------------------------------------------------
+bool wallet2::has_ntz_signer(int signer_index, uint64_t& signers_mask)
+{
+  cryptonote::COMMAND_RPC_HAS_NTZ_SIGNER::request nreq;
+  cryptonote::COMMAND_RPC_HAS_NTZ_SIGNER::response nres;
+  nreq.signer_index = signer_index;
+  m_daemon_rpc_mutex.lock();
+  bool nr = epee::net_utils::invoke_http_json("/has_ntz_signer", nreq, nres, m_http_client, rpc_timeout);
+  m_daemon_rpc_mutex.unlock();
+  THROW_WALLET_EXCEPTION_IF(!nr, error::no_connection_to_daemon, "has_ntz_signer");
+  THROW_WALLET_EXCEPTION_IF(nres.status == CORE_RPC_STATUS_BUSY, error::daemon_busy, "has_ntz_signer");
+  THROW_WALLET_EXCEPTION_IF(nres.status != CORE_RPC_STATUS_OK, error::wallet_internal_error, "has_ntz_signer: " + nres.status);
+  signers_mask = nres.signers_mask;
+  return nres.has_signed;
+}
+//----------------------------------------------------------------------------------------------------
 void wallet2::get_ntzpool_txs_and_keys(std::vector<cryptonote::ntz_tx_info>& txs, std::vector<cryptonote::spent_key_image_info>& spent_key_images)
 {
   if (!txs.empty() || !spent_key_images.empty()) {
@@ -2624,7 +2729,7 @@ void wallet2::refresh(uint64_t start_height, uint64_t & blocks_fetched, bool& re
         refreshed = false;
         break;
       }
-      tpool.submit(&waiter, [&]{pull_next_blocks(start_height, next_blocks_start_height, short_chain_history, blocks, next_blocks, next_o_indices, error);});
+      tpool.submit(&waiter, [&]{pull_next_blocks(start_height, next_blocks_start_height, short_chain_history, blocks, next_blocks, next_o_indices, error);}, tools::threadpool::PRIORITY_LOW);
 
       process_blocks(blocks_start_height, blocks, o_indices, added_blocks);
       blocks_fetched += added_blocks;
@@ -64,6 +64,7 @@
 #define MONERO_DEFAULT_LOG_CATEGORY "wallet.wallet2"
 
 class Serialization_portability_wallet_Test;
+template<bool> class test_wallet_scan;
 
 namespace tools
 {
@@ -137,6 +138,7 @@ namespace tools
   class wallet2
   {
     friend class ::Serialization_portability_wallet_Test;
+    template<bool> friend class ::test_wallet_scan;
   public:
     static constexpr const std::chrono::seconds rpc_timeout = std::chrono::minutes(3) + std::chrono::seconds(30);
 
@@ -209,6 +211,18 @@ namespace tools
       tx_scan_info_t(): money_transfered(0), error(true) {}
     };
 
+    struct parsed_block
+    {
+      crypto::hash hash;
+      cryptonote::block block;
+      std::vector<cryptonote::transaction> txes;
+      // per tx (miner tx first) output scan results, empty if not precomputed
+      std::vector<std::vector<tx_scan_info_t>> tx_scan_info;
+      bool error;
+
+      parsed_block(): error(true) {}
+    };
+
     struct transfer_details
     {
       uint64_t m_block_height;
@@ -1006,6 +1020,7 @@ namespace tools
 
     void update_pool_state(bool refreshed = false);
     size_t get_ntzpool_count(bool include_unrelayed);
+    bool has_ntz_signer(int signer_index, uint64_t& signers_mask);
     bool remove_ntzpool_txs(std::list<std::string> const& txids);
 
     void remove_obsolete_pool_txs(const std::vector<crypto::hash> &tx_hashes);
@@ -1101,8 +1116,8 @@ namespace tools
      * \param password       Password of wallet file
      */
     bool load_keys(const std::string& keys_file_name, const epee::wipeable_string& password);
-    void process_new_transaction(const crypto::hash &txid, const cryptonote::transaction& tx, const std::vector<uint64_t> &o_indices, uint64_t height, uint64_t ts, bool miner_tx, bool pool, bool double_spend_seen);
-    void process_new_blockchain_entry(const cryptonote::block& b, const cryptonote::block_complete_entry& bche, const crypto::hash& bl_id, uint64_t height, const cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices &o_indices);
+    void process_new_transaction(const crypto::hash &txid, const cryptonote::transaction& tx, const std::vector<uint64_t> &o_indices, uint64_t height, uint64_t ts, bool miner_tx, bool pool, bool double_spend_seen, const std::vector<tx_scan_info_t> *precomputed_scan_info = NULL);
+    void process_new_blockchain_entry(const parsed_block &pb, const cryptonote::block_complete_entry& bche, uint64_t height, const cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices &o_indices);
     void detach_blockchain(uint64_t height);
     void get_short_chain_history(std::list<crypto::hash>& ids) const;
     bool is_tx_spendtime_unlocked(uint64_t unlock_time, uint64_t block_height) const;
@@ -1124,7 +1139,9 @@ namespace tools
     crypto::hash get_payment_id(const pending_tx &ptx) const;
     void check_acc_out_precomp(const cryptonote::tx_out &o, const crypto::key_derivation &derivation, const std::vector<crypto::key_derivation> &additional_derivations, size_t i, tx_scan_info_t &tx_scan_info) const;
     void check_acc_out_precomp_once(const cryptonote::tx_out &o, const crypto::key_derivation &derivation, const std::vector<crypto::key_derivation> &additional_derivations, size_t i, tx_scan_info_t &tx_scan_info, bool &already_seen) const;
-    void parse_block_round(const cryptonote::blobdata &blob, cryptonote::block &bl, crypto::hash &bl_id, bool &error) const;
+    void parse_block_entry(const cryptonote::block_complete_entry &bche, uint64_t height, parsed_block &pb) const;
+    bool should_scan_block(const cryptonote::block &b, uint64_t height) const;
+    void scan_tx_outputs(const cryptonote::transaction &tx, bool miner_tx, std::vector<tx_scan_info_t> &tx_scan_info) const;
     uint64_t get_upper_transaction_size_limit() const;
     std::vector<uint64_t> get_unspent_amounts_vector() const;
     uint64_t get_dynamic_per_kb_fee_estimate() const;
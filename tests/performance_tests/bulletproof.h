@@ -1,7 +1,4 @@
 // Copyright (c) 2018-2022, Blur Network
-// Copyright (c) 2017-2018, The Masari Project
-// Copyright (c) 2014-2018, The Monero Project
-//
 // All rights reserved.
 //
 // Redistribution and use in source and binary forms, with or without modification, are
@@ -28,14 +25,49 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
-#include <string>
-#include "boost/filesystem.hpp"
+#pragma once
+
+#include <vector>
+
+#include "ringct/rctOps.h"
+#include "ringct/bulletproofs.h"
+
+// proving is slow, so every test_bulletproof instance draws from one set
+inline const std::vector<rct::Bulletproof> &get_test_bulletproofs(size_t count)
+{
+  static std::vector<rct::Bulletproof> proofs;
+  while (proofs.size() < count)
+    proofs.push_back(rct::bulletproof_PROVE(crypto::rand<uint64_t>(), rct::skGen()));
+  return proofs;
+}
+
+// Verifies batch_size range proofs, either as one batch or one at a time
+// with the unbatched verifier, as when each tx is checked on its own
+template<bool batched, size_t batch_size>
+class test_bulletproof
+{
+public:
+  static const size_t loop_count = batch_size < 64 ? 64 / batch_size : 1;
 
+  bool init()
+  {
+    const std::vector<rct::Bulletproof> &proofs = get_test_bulletproofs(batch_size);
+    m_proofs.clear();
+    for (size_t i = 0; i < batch_size; ++i)
+      m_proofs.push_back(&proofs[i]);
+    return true;
+  }
 
-int libbtc_launch(std::string const& command,
-                   std::string const& arg1,
-                   std::string const& arg2,
-                   boost::filesystem::path const& logfile_path,
-                   boost::filesystem::path const& relative_path_base,
-                   uint32_t& process_id);
+  bool test()
+  {
+    if (batched)
+      return rct::bulletproof_VERIFY(m_proofs);
+    for (const rct::Bulletproof *proof: m_proofs)
+      if (!rct::bulletproof_VERIFY_single(*proof))
+        return false;
+    return true;
+  }
 
+private:
+  std::vector<const rct::Bulletproof*> m_proofs;
+};
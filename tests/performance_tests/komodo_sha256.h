@@ -0,0 +1,81 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#pragma once
+
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "cryptonote_basic/komodo_sha256.h"
+
+struct sha256_scalar
+{
+  static const cryptonote::komodo::sha256_backend backend = cryptonote::komodo::sha256_backend::scalar;
+};
+
+struct sha256_sha_ni
+{
+  static const cryptonote::komodo::sha256_backend backend = cryptonote::komodo::sha256_backend::sha_ni;
+};
+
+struct sha256_avx2
+{
+  static const cryptonote::komodo::sha256_backend backend = cryptonote::komodo::sha256_backend::avx2;
+};
+
+// double SHA-256 of a batch of 64 byte merkle nodes with a given backend
+template<typename backend_t, size_t count>
+class test_komodo_doublesha256
+{
+public:
+  static const size_t loop_count = count < 64 ? 10000 : 1000;
+
+  bool init()
+  {
+    if (!cryptonote::komodo::sha256_backend_supported(backend_t::backend))
+      return false;
+    m_data.resize(64 * count);
+    crypto::rand(m_data.size(), m_data.data());
+    m_ptrs.resize(count);
+    for (size_t i = 0; i < count; ++i)
+      m_ptrs[i] = m_data.data() + 64 * i;
+    m_lens.assign(count, 64);
+    m_hashes.resize(count);
+    return true;
+  }
+
+  bool test()
+  {
+    cryptonote::komodo::bits256_doublesha256_many(m_ptrs.data(), m_lens.data(), m_hashes.data(), count, backend_t::backend);
+    return true;
+  }
+
+private:
+  std::vector<uint8_t> m_data;
+  std::vector<const uint8_t*> m_ptrs;
+  std::vector<int32_t> m_lens;
+  std::vector<cryptonote::bits256> m_hashes;
+};
@@ -52,7 +52,13 @@
 #include "sc_reduce32.h"
 #include "sc_check.h"
 #include "cn_fast_hash.h"
+#include "komodo_sha256.h"
+#include "mom_window.h"
+#include "txpool_churn.h"
 #include "rct_mlsag.h"
+#include "bulletproof.h"
+#include "multiexp.h"
+#include "wallet_scan.h"
 #include "equality.h"
 
 namespace po = boost::program_options;
@@ -154,6 +160,19 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE1(filter, p, test_cn_fast_hash, 32);
   TEST_PERFORMANCE1(filter, p, test_cn_fast_hash, 16384);
 
+  TEST_PERFORMANCE2(filter, p, test_komodo_doublesha256, sha256_scalar, 8);
+  TEST_PERFORMANCE2(filter, p, test_komodo_doublesha256, sha256_sha_ni, 8);
+  TEST_PERFORMANCE2(filter, p, test_komodo_doublesha256, sha256_avx2, 8);
+  TEST_PERFORMANCE2(filter, p, test_komodo_doublesha256, sha256_scalar, 1024);
+  TEST_PERFORMANCE2(filter, p, test_komodo_doublesha256, sha256_sha_ni, 1024);
+  TEST_PERFORMANCE2(filter, p, test_komodo_doublesha256, sha256_avx2, 1024);
+
+  TEST_PERFORMANCE1(filter, p, test_mom_window, false);
+  TEST_PERFORMANCE1(filter, p, test_mom_window, true);
+
+  TEST_PERFORMANCE1(filter, p, test_txpool_churn, false);
+  TEST_PERFORMANCE1(filter, p, test_txpool_churn, true);
+
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 3, false);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 5, false);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 10, false);
@@ -163,6 +182,49 @@ int main(int argc, char** argv)
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 10, true);
   TEST_PERFORMANCE3(filter, p, test_ringct_mlsag, 1, 100, true);
 
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 1);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 2);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 4);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 8);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 16);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 32);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 64);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 128);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, false, 256);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 1);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 2);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 4);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 8);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 16);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 32);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 64);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 128);
+  TEST_PERFORMANCE2(filter, p, test_bulletproof, true, 256);
+
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus, 2);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus, 8);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus, 32);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus, 64);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus, 130);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus_cached, 2);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus_cached, 8);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus_cached, 32);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus_cached, 64);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_straus_cached, 130);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger, 2);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger, 8);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger, 32);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger, 64);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger, 130);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_cached, 2);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_cached, 8);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_cached, 32);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_cached, 64);
+  TEST_PERFORMANCE2(filter, p, test_multiexp, multiexp_pippenger_cached, 130);
+
+  TEST_PERFORMANCE1(filter, p, test_wallet_scan, false);
+  TEST_PERFORMANCE1(filter, p, test_wallet_scan, true);
+
   TEST_PERFORMANCE2(filter, p, test_equality, memcmp32, true);
   TEST_PERFORMANCE2(filter, p, test_equality, memcmp32, false);
   TEST_PERFORMANCE2(filter, p, test_equality, verify32, false);
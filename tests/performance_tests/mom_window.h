@@ -1,5 +1,4 @@
 // Copyright (c) 2018-2022, Blur Network
-//
 // All rights reserved.
 //
 // Redistribution and use in source and binary forms, with or without modification, are
@@ -26,44 +25,54 @@
 // STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
 // THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#pragma once
 
-#include "boost/process.hpp"
-#include "boost/filesystem.hpp"
-#include "common/util.h"
-#include "misc_log_ex.h"
-
-int libbtc_launch(std::string const& command,
-                   std::string const& arg1,
-                   std::string const& arg2,
-                   boost::filesystem::path const& logfile_path,
-                   boost::filesystem::path const& relative_path_base,
-                   uint32_t& process_id)
-{
-  boost::filesystem::path btc_logfile = { logfile_path / (command + ".log") } ;
-  btc_logfile = boost::filesystem::absolute(btc_logfile, relative_path_base);
+#include <vector>
 
-  boost::process::child c(command, arg1, arg2, boost::process::std_out > btc_logfile);
+#include "crypto/crypto.h"
+#include "blockchain_db/ntz_state.h"
 
-  if (c.running()) {
-    process_id = c.id();
-    MWARNING("Command: "<< std::string(command) << ", launched with args: " << arg1 << " " << arg2 << ", at PID: " << std::to_string(process_id));
-    c.wait();
-  }
+// MoM of random (height, depth) windows over the most recent blocks, either
+// from the mom_index or by folding the window's tree hashes
+template<bool indexed>
+class test_mom_window
+{
+public:
+  // folding costs up to 2^DPOW_MOM_INDEX_LEVELS hashes per query
+  static const size_t loop_count = indexed ? 100000 : 1000;
 
+  bool init()
+  {
+    m_leaves.resize(DPOW_MOM_INDEX_HEIGHTS);
+    crypto::rand(m_leaves.size() * sizeof(crypto::hash), (uint8_t*)m_leaves.data());
+    m_index.reset(0);
+    for (const auto& leaf : m_leaves)
+      m_index.push(leaf);
 
-   switch (c.exit_code())
+    m_windows.resize(100000);
+    for (auto& w : m_windows)
     {
-      case -1:
-        MERROR("Forking of " << command << " failed!" << std::endl);
-        break;
-      case 0:
-        MINFO("Forking of " << command << " successful." << std::endl);
-        break;
-      case 1:
-        MERROR("Unexpected exit code in child process for command: " << command << std::endl);
-        break;
+      w.second = 1 + crypto::rand<uint64_t>() % m_index.max_depth();
+      w.first = w.second - 1 + crypto::rand<uint64_t>() % (m_leaves.size() - w.second + 1);
     }
+    m_next = 0;
+    return true;
+  }
 
-  return c.exit_code();
+  bool test()
+  {
+    const std::pair<uint64_t, uint64_t>& w = m_windows[m_next++ % m_windows.size()];
+    if (indexed)
+      return m_index.root(w.first, w.second) != crypto::null_hash;
+
+    crypto::hash root;
+    crypto::tree_hash(&m_leaves[w.first + 1 - w.second], w.second, root);
+    return root != crypto::null_hash;
+  }
 
-}
+private:
+  std::vector<crypto::hash> m_leaves;
+  std::vector<std::pair<uint64_t, uint64_t>> m_windows;
+  cryptonote::mom_index m_index;
+  size_t m_next;
+};
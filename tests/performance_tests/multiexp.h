@@ -0,0 +1,89 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <vector>
+
+#include "ringct/rctOps.h"
+#include "ringct/multiexp.h"
+#include "ringct/bulletproofs.h"
+
+enum test_multiexp_algorithm
+{
+  multiexp_straus,
+  multiexp_straus_cached,
+  multiexp_pippenger,
+  multiexp_pippenger_cached,
+};
+
+// One multiexp over the first npoints bulletproof generators, with or without
+// the shared precomputed tables. Divide the time per call by npoints for the
+// cost per point.
+template<test_multiexp_algorithm algorithm, size_t npoints>
+class test_multiexp
+{
+public:
+  static const size_t loop_count = npoints >= 128 ? 100 : npoints >= 32 ? 500 : 1000;
+
+  bool init()
+  {
+    const rct::multiexp_table &generators = rct::bulletproof_generators();
+    if (npoints > generators.bases.size())
+      return false;
+    m_data.assign(generators.bases.begin(), generators.bases.begin() + npoints);
+    for (rct::MultiexpData &e: m_data)
+      e.scalar = rct::skGen();
+    m_straus_cache = generators.straus_cache;
+    m_pippenger_cache = generators.pippenger_cache;
+    m_expected = rct::straus(m_data);
+    return true;
+  }
+
+  bool test()
+  {
+    switch (algorithm)
+    {
+      case multiexp_straus:
+        return rct::straus(m_data) == m_expected;
+      case multiexp_straus_cached:
+        return rct::straus(m_data, m_straus_cache) == m_expected;
+      case multiexp_pippenger:
+        return rct::pippenger(m_data, NULL, 0, rct::get_pippenger_c(npoints)) == m_expected;
+      case multiexp_pippenger_cached:
+        return rct::pippenger(m_data, m_pippenger_cache, npoints, rct::get_pippenger_c(npoints)) == m_expected;
+      default:
+        return false;
+    }
+  }
+
+private:
+  std::vector<rct::MultiexpData> m_data;
+  std::shared_ptr<rct::straus_cached_data> m_straus_cache;
+  std::shared_ptr<rct::pippenger_cached_data> m_pippenger_cache;
+  rct::key m_expected;
+};
@@ -0,0 +1,105 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "crypto/crypto.h"
+#include "cryptonote_core/tx_pool.h"
+
+// steady pool churn: each test takes one tx out by txid and adds a fresh
+// one, against either the txid-indexed pool container or a plain set that
+// has to be scanned for the txid
+template<bool indexed>
+class test_txpool_churn
+{
+public:
+  static const size_t pool_size = 100000;
+  // the scan visits half the pool per removal on average
+  static const size_t loop_count = indexed ? 100000 : 200;
+
+  typedef std::set<cryptonote::tx_by_fee_and_receive_time_entry, cryptonote::txCompare> scanned_container;
+
+  bool init()
+  {
+    m_ids.resize(pool_size);
+    for (auto& id : m_ids)
+      add(id);
+    m_next = 0;
+    return true;
+  }
+
+  bool test()
+  {
+    crypto::hash& id = m_ids[m_next++ % m_ids.size()];
+    if (!remove(id))
+      return false;
+    add(id);
+    return true;
+  }
+
+private:
+  void add(crypto::hash& id)
+  {
+    id = crypto::rand<crypto::hash>();
+    const double fee_per_byte = (1 + crypto::rand<uint32_t>() % 1000) / 1000.0;
+    const std::time_t receive_time = crypto::rand<uint32_t>() % 86400;
+    if (indexed)
+      m_indexed.emplace(std::make_pair(fee_per_byte, receive_time), id);
+    else
+      m_scanned.emplace(std::make_pair(fee_per_byte, receive_time), id);
+  }
+
+  bool remove(const crypto::hash& id)
+  {
+    if (indexed)
+    {
+      auto& by_id = m_indexed.get<cryptonote::by_txid>();
+      auto it = by_id.find(id);
+      if (it == by_id.end())
+        return false;
+      by_id.erase(it);
+      return true;
+    }
+
+    auto it = std::find_if(m_scanned.begin(), m_scanned.end(), [&](const scanned_container::value_type& a) {
+      return a.second == id;
+    });
+    if (it == m_scanned.end())
+      return false;
+    m_scanned.erase(it);
+    return true;
+  }
+
+  std::vector<crypto::hash> m_ids;
+  cryptonote::sorted_tx_container m_indexed;
+  scanned_container m_scanned;
+  size_t m_next;
+};
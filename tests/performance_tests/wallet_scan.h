@@ -0,0 +1,167 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <list>
+#include <vector>
+
+#include "common/threadpool.h"
+#include "cryptonote_basic/account.h"
+#include "cryptonote_basic/cryptonote_basic.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_core/cryptonote_tx_utils.h"
+#include "wallet/wallet2.h"
+
+#include "performance_utils.h"
+
+// A wallet2 scanning a range of synthetic blocks, each holding one miner tx,
+// one in a hundred of them paying to the wallet. The batched variant hands the
+// range to wallet2::process_blocks, which scans it on the threadpool; the other
+// processes the blocks one at a time with no precomputed scan info, the way a
+// hardware device wallet does.
+// The runner pins itself to one core, and the pool threads inherit that, so
+// the batched variant lets them use every core again before it is timed.
+template<bool batched>
+class test_wallet_scan
+{
+public:
+  static const size_t loop_count = 1;
+  static const size_t blocks = 10000;
+
+  test_wallet_scan(): m_wallet(cryptonote::TESTNET), m_expected(0), m_outputs(0) {}
+
+  bool init()
+  {
+    if (batched)
+      unpin_threadpool();
+
+    // recovering keeps generate() from asking a daemon for a refresh height
+    crypto::public_key pub;
+    crypto::secret_key seed;
+    crypto::generate_keys(pub, seed);
+    m_wallet.generate("", "", seed, true);
+    const cryptonote::account_public_address bob = m_wallet.get_account().get_keys().m_account_address;
+
+    cryptonote::account_base alice;
+    alice.generate();
+
+    // the wallet already knows the genesis block, the range starts there
+    cryptonote::block b;
+    if (!cryptonote::generate_genesis_block(b, cryptonote::TESTNET))
+      return false;
+    add_block(b);
+    for (size_t i = 1; i <= blocks; ++i)
+    {
+      const crypto::hash prev_id = cryptonote::get_block_hash(b);
+      b = cryptonote::block();
+      b.major_version = 1;
+      b.minor_version = 1;
+      b.timestamp = time(NULL);
+      b.prev_id = prev_id;
+      const bool to_bob = i % 100 == 0;
+      if (!cryptonote::construct_miner_tx(i, 0, 0, 2, 0, to_bob ? bob : alice.get_keys().m_account_address, b.miner_tx))
+        return false;
+      if (to_bob)
+        m_expected += b.miner_tx.vout.size();
+      add_block(b);
+    }
+    return true;
+  }
+
+  bool test()
+  {
+    if (batched)
+    {
+      uint64_t blocks_added = 0;
+      m_wallet.process_blocks(0, m_blocks, m_o_indices, blocks_added);
+      if (blocks_added != blocks)
+        return false;
+    }
+    else
+    {
+      std::list<cryptonote::block_complete_entry>::const_iterator bche = m_blocks.begin();
+      for (size_t i = 1; i < m_o_indices.size(); ++i)
+      {
+        ++bche;
+        tools::wallet2::parsed_block pb;
+        m_wallet.parse_block_entry(*bche, i, pb);
+        if (pb.error)
+          return false;
+        m_wallet.process_new_blockchain_entry(pb, *bche, i, m_o_indices[i]);
+      }
+    }
+
+    const bool found = m_wallet.get_num_transfer_details() == m_expected;
+    // forget the range again, so that every call scans it from scratch
+    m_wallet.detach_blockchain(1);
+    return found;
+  }
+
+private:
+  static void unpin_threadpool()
+  {
+    // each task holds its worker until all have started, so every worker runs one
+    tools::threadpool& tpool = tools::threadpool::getInstance();
+    const size_t workers = tpool.get_max_concurrency();
+    std::atomic<size_t> started(0);
+    tools::threadpool::waiter waiter;
+    for (size_t i = 0; i < workers; ++i)
+    {
+      tpool.submit(&waiter, [&started, workers](){
+        clear_thread_affinity();
+        ++started;
+        while (started < workers)
+          boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+      });
+    }
+    while (started < workers)
+      boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+    waiter.wait();
+  }
+
+  void add_block(const cryptonote::block &b)
+  {
+    cryptonote::block_complete_entry bche;
+    bche.block = cryptonote::block_to_blob(b);
+    m_blocks.push_back(bche);
+
+    cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices o_indices;
+    o_indices.indices.resize(1);
+    for (size_t i = 0; i < b.miner_tx.vout.size(); ++i)
+      o_indices.indices[0].indices.push_back(m_outputs++);
+    m_o_indices.push_back(o_indices);
+  }
+
+  tools::wallet2 m_wallet;
+  std::list<cryptonote::block_complete_entry> m_blocks;
+  std::vector<cryptonote::COMMAND_RPC_GET_BLOCKS_FAST::block_output_indices> m_o_indices;
+  size_t m_expected;
+  uint64_t m_outputs;
+};
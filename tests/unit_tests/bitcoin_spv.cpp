@@ -0,0 +1,153 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "cryptonote_basic/bitcoin_spv.h"
+#include "string_tools.h"
+
+namespace
+{
+  // regtest-style fixture: minimal difficulty, so a few nonces suffice
+  const uint32_t regtest_bits = 0x207fffff;
+
+  crypto::hash make_hash(uint8_t n)
+  {
+    crypto::hash h = crypto::null_hash;
+    h.data[0] = n;
+    h.data[31] = n ^ 0x5a;
+    return h;
+  }
+
+  cryptonote::btc_block_header mine(const crypto::hash& prev, const crypto::hash& merkle_root, uint32_t timestamp)
+  {
+    cryptonote::btc_block_header header;
+    header.version = 4;
+    header.prev_hash = prev;
+    header.merkle_root = merkle_root;
+    header.timestamp = timestamp;
+    header.bits = regtest_bits;
+    while (!cryptonote::btc_spv::check_pow(header.hash(), header.bits))
+      ++header.nonce;
+    return header;
+  }
+
+  std::vector<cryptonote::btc_block_header> mine_chain(const crypto::hash& prev, size_t count, uint32_t timestamp)
+  {
+    std::vector<cryptonote::btc_block_header> headers;
+    crypto::hash top = prev;
+    for (size_t i = 0; i < count; ++i)
+    {
+      headers.push_back(mine(top, make_hash(i), timestamp + i));
+      top = headers.back().hash();
+    }
+    return headers;
+  }
+
+  cryptonote::btc_block_header regtest_checkpoint()
+  {
+    return mine(crypto::null_hash, make_hash(0xff), 1296688602);
+  }
+}
+
+TEST(bitcoin_spv, header_roundtrip)
+{
+  const cryptonote::btc_block_header header = regtest_checkpoint();
+  uint8_t blob[cryptonote::btc_block_header::size];
+  header.serialize(blob);
+  cryptonote::btc_block_header parsed;
+  ASSERT_TRUE(parsed.parse(blob, sizeof(blob)));
+  ASSERT_EQ(parsed.hash(), header.hash());
+  ASSERT_EQ(parsed.prev_hash, header.prev_hash);
+  ASSERT_EQ(parsed.merkle_root, header.merkle_root);
+  ASSERT_FALSE(parsed.parse(blob, sizeof(blob) - 1));
+}
+
+TEST(bitcoin_spv, genesis_hash)
+{
+  // bitcoin mainnet genesis block
+  cryptonote::btc_block_header genesis;
+  genesis.version = 1;
+  ASSERT_TRUE(epee::string_tools::hex_to_pod("4a5e1e4baab89f3a32518a88c31bc87f618f76673e2cc77ab2127b7afdeda33b", genesis.merkle_root));
+  genesis.timestamp = 1231006505;
+  genesis.bits = 0x1d00ffff;
+  genesis.nonce = 2083236893;
+  crypto::hash expected;
+  ASSERT_TRUE(epee::string_tools::hex_to_pod("000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f", expected));
+  ASSERT_EQ(genesis.hash(), expected);
+  ASSERT_TRUE(cryptonote::btc_spv::check_pow(expected, genesis.bits));
+}
+
+TEST(bitcoin_spv, sync_and_reorg)
+{
+  cryptonote::btc_spv spv(cryptonote::btc_spv_params::regtest());
+  const cryptonote::btc_block_header checkpoint = regtest_checkpoint();
+  ASSERT_TRUE(spv.start(checkpoint, 100));
+
+  const auto chain = mine_chain(checkpoint.hash(), 10, 1296688700);
+  ASSERT_EQ(spv.submit_headers(chain).get(), 10);
+  ASSERT_EQ(spv.get_height().get(), 110);
+  ASSERT_EQ(spv.submit_headers(chain).get(), 0);
+
+  const auto header = spv.get_header(chain[4].hash()).get();
+  ASSERT_TRUE(!!header);
+  ASSERT_EQ(header->height, 105);
+
+  // a header that does not connect ends the batch
+  std::vector<cryptonote::btc_block_header> orphan = { mine(make_hash(1), make_hash(2), 1296689000) };
+  ASSERT_EQ(spv.submit_headers(orphan).get(), 0);
+  ASSERT_FALSE(!!spv.get_header(orphan[0].hash()).get());
+
+  // a header easing the target is rejected when retargeting is disabled
+  cryptonote::btc_block_header easier = mine(chain.back().hash(), make_hash(3), 1296689000);
+  easier.bits = 0x2100ffff;
+  ASSERT_EQ(spv.submit_headers({easier}).get(), 0);
+
+  // a tx in the 6th block, proven with a two level merkle branch
+  const crypto::hash txid = make_hash(0x42), sibling = make_hash(0x43), uncle = make_hash(0x44);
+  const std::vector<crypto::hash> branch = { sibling, uncle };
+  const crypto::hash root = cryptonote::btc_spv::merkle_root_from_branch(txid, branch, 1);
+  const std::vector<cryptonote::btc_block_header> fork = { mine(chain[4].hash(), root, 1296689100) };
+  ASSERT_EQ(spv.submit_headers(fork).get(), 1);
+  ASSERT_EQ(spv.get_height().get(), 110);
+
+  ASSERT_FALSE(spv.add_tx_proof(txid, fork[0].hash(), branch, 0).get());
+  ASSERT_TRUE(spv.add_tx_proof(txid, fork[0].hash(), branch, 1).get());
+  // on a side chain, so not confirmed yet
+  ASSERT_EQ(spv.get_confirmations(txid).get(), 0);
+
+  // extend the fork past the main chain: it becomes the main chain
+  const auto fork_tail = mine_chain(fork[0].hash(), 6, 1296689200);
+  ASSERT_EQ(spv.submit_headers(fork_tail).get(), 6);
+  ASSERT_EQ(spv.get_height().get(), 112);
+  ASSERT_EQ(spv.get_confirmations(txid).get(), 7);
+
+  spv.stop();
+  // queries still work on the index once the worker is stopped
+  ASSERT_EQ(spv.get_height().get(), 112);
+  ASSERT_EQ(spv.get_confirmations(make_hash(0x45)).get(), 0);
+}
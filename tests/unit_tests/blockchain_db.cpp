@@ -30,6 +30,7 @@
 #include <boost/algorithm/string/predicate.hpp>
 #include <cstdio>
 #include <iostream>
+#include <limits>
 #include <chrono>
 #include <thread>
 
@@ -344,4 +345,74 @@ TYPED_TEST(BlockchainDBTest, RetrieveBlockData)
   ASSERT_HASH_EQ(get_block_hash(this->m_blocks[1]), hashes[1]);
 }
 
+TYPED_TEST(BlockchainDBTest, BatchedOutputLookups)
+{
+  boost::filesystem::path tempPath = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+  std::string dirPath = tempPath.string();
+
+  this->set_prefix(dirPath);
+
+  // make sure open does not throw
+  ASSERT_NO_THROW(this->m_db->open(dirPath));
+  this->get_filenames();
+  this->init_hard_fork();
+
+  ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[0], t_sizes[0], t_diffs[0], t_coins[0], this->m_txs[0]));
+  ASSERT_NO_THROW(this->m_db->add_block(this->m_blocks[1], t_sizes[1], t_diffs[1], t_coins[1], this->m_txs[1]));
+
+  // newest first, so the batch has to put results back in request order
+  std::vector<transaction> txs;
+  std::vector<bool> miner_txs;
+  for (size_t n = 2; n-- > 0; )
+  {
+    txs.push_back(this->m_blocks[n].miner_tx);
+    miner_txs.push_back(true);
+    txs.insert(txs.end(), this->m_txs[n].begin(), this->m_txs[n].end());
+    miner_txs.resize(txs.size(), false);
+  }
+  std::vector<crypto::hash> tx_hashes;
+  for (const auto &tx: txs)
+    tx_hashes.push_back(get_transaction_hash(tx));
+
+  std::vector<std::vector<uint64_t>> batch_indices;
+  ASSERT_NO_THROW(this->m_db->get_tx_amount_output_indices_batch(tx_hashes, batch_indices));
+  ASSERT_EQ(tx_hashes.size(), batch_indices.size());
+
+  std::vector<std::pair<uint64_t, uint64_t>> outputs;
+  for (size_t n = 0; n < tx_hashes.size(); ++n)
+  {
+    uint64_t tx_id;
+    ASSERT_TRUE(this->m_db->tx_exists(tx_hashes[n], tx_id));
+    ASSERT_EQ(this->m_db->get_tx_amount_output_indices(tx_id), batch_indices[n]);
+    ASSERT_EQ(txs[n].vout.size(), batch_indices[n].size());
+    for (size_t i = 0; i < txs[n].vout.size(); ++i)
+    {
+      // miner outputs are all stored as rct outputs
+      const uint64_t amount = miner_txs[n] ? 0 : txs[n].vout[i].amount;
+      outputs.push_back(std::make_pair(amount, batch_indices[n][i]));
+    }
+  }
+
+  std::vector<output_data_t> data;
+  std::vector<tx_out_index> tois;
+  ASSERT_NO_THROW(this->m_db->get_output_keys_batch(outputs, data, &tois));
+  ASSERT_EQ(outputs.size(), data.size());
+  ASSERT_EQ(outputs.size(), tois.size());
+  for (size_t n = 0; n < outputs.size(); ++n)
+  {
+    const output_data_t od = this->m_db->get_output_key(outputs[n].first, outputs[n].second);
+    ASSERT_HASH_EQ(od.pubkey, data[n].pubkey);
+    ASSERT_EQ(od.unlock_time, data[n].unlock_time);
+    ASSERT_EQ(od.height, data[n].height);
+    const tx_out_index toi = this->m_db->get_output_tx_and_index(outputs[n].first, outputs[n].second);
+    ASSERT_HASH_EQ(toi.first, tois[n].first);
+    ASSERT_EQ(toi.second, tois[n].second);
+  }
+
+  tx_hashes.push_back(crypto::null_hash);
+  ASSERT_THROW(this->m_db->get_tx_amount_output_indices_batch(tx_hashes, batch_indices), TX_DNE);
+  outputs.push_back(std::make_pair(0, std::numeric_limits<uint64_t>::max()));
+  ASSERT_THROW(this->m_db->get_output_keys_batch(outputs, data), OUTPUT_DNE);
+}
+
 }  // anonymous namespace
@@ -0,0 +1,227 @@
+// Copyright (c) 2018-2022, Blur Network
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+
+#include "blockchain_utilities/bootstrap_file.h"
+#include "serialization/binary_utils.h"
+
+namespace
+{
+  const uint64_t test_blocks = 600;
+  const uint32_t test_blocks_per_chunk = 100;
+
+  // enough of a block to tell packages apart after a round trip
+  void make_package(uint64_t height, bootstrap::block_package& bp)
+  {
+    cryptonote::txin_gen in;
+    in.height = height;
+    bp.block.major_version = 1;
+    bp.block.nonce = height;
+    bp.block.miner_tx.version = 1;
+    bp.block.miner_tx.vin.assign(1, in);
+    bp.block_size = 1000 + height;
+    bp.cumulative_difficulty = height * 7;
+    bp.coins_generated = height * 11;
+  }
+
+  class packed_file
+  {
+  public:
+    packed_file(): m_path(boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()) {}
+    ~packed_file() { boost::system::error_code ec; boost::filesystem::remove(m_path, ec); }
+
+    bool write(bootstrap::chunk_codec codec)
+    {
+      BootstrapFile bootstrap;
+      return bootstrap.store_packages_packed(&make_package, m_path, test_blocks - 1, codec, test_blocks_per_chunk);
+    }
+
+    std::string path() const { return m_path.string(); }
+    uint64_t size() const { return boost::filesystem::file_size(m_path); }
+    void truncate(uint64_t size) { boost::filesystem::resize_file(m_path, size); }
+
+    bool read_chunk(const bootstrap::chunk_index_entry& entry, bootstrap::chunk_header& header, std::string& payload, uint64_t& payload_pos) const
+    {
+      std::ifstream f(path(), std::ios_base::binary | std::ifstream::in);
+      f.seekg(entry.offset);
+      if (!BootstrapFile::read_chunk_header(f, header))
+        return false;
+      payload_pos = f.tellg();
+      payload.resize(header.packed_size);
+      f.read(&payload[0], payload.size());
+      return (bool)f;
+    }
+
+  private:
+    boost::filesystem::path m_path;
+  };
+
+  void check_round_trip(bootstrap::chunk_codec codec)
+  {
+    packed_file file;
+    ASSERT_TRUE(file.write(codec));
+    ASSERT_TRUE(BootstrapFile::is_packed_file(file.path()));
+
+    BootstrapFile bootstrap;
+    bootstrap::packed_index index;
+    ASSERT_TRUE(bootstrap.load_packed_index(file.path(), index));
+    ASSERT_EQ(index.block_end, test_blocks);
+    ASSERT_EQ(index.chunks.size(), test_blocks / test_blocks_per_chunk);
+
+    uint64_t height = 0;
+    for (const auto& entry: index.chunks)
+    {
+      ASSERT_EQ(entry.block_first, height);
+      bootstrap::chunk_header header;
+      std::string payload;
+      uint64_t payload_pos;
+      ASSERT_TRUE(file.read_chunk(entry, header, payload, payload_pos));
+      ASSERT_EQ(header.codec, codec);
+      std::vector<std::string> blocks;
+      ASSERT_TRUE(BootstrapFile::unpack_chunk(header, payload, blocks));
+      ASSERT_EQ(blocks.size(), test_blocks_per_chunk);
+      for (const auto& blob: blocks)
+      {
+        bootstrap::block_package bp, expected;
+        ASSERT_TRUE(::serialization::parse_binary(blob, bp));
+        make_package(height, expected);
+        ASSERT_EQ(bp.block.nonce, expected.block.nonce);
+        ASSERT_EQ(cryptonote::get_block_hash(bp.block), cryptonote::get_block_hash(expected.block));
+        ASSERT_EQ(bp.block_size, expected.block_size);
+        ASSERT_EQ(bp.cumulative_difficulty, expected.cumulative_difficulty);
+        ASSERT_EQ(bp.coins_generated, expected.coins_generated);
+        ++height;
+      }
+    }
+    ASSERT_EQ(height, test_blocks);
+  }
+}
+
+TEST(bootstrap_file, packed_round_trip)
+{
+  check_round_trip(bootstrap::CODEC_NONE);
+}
+
+TEST(bootstrap_file, packed_round_trip_zstd)
+{
+  if (!BootstrapFile::codec_supported(bootstrap::CODEC_ZSTD))
+    return;
+  check_round_trip(bootstrap::CODEC_ZSTD);
+}
+
+TEST(bootstrap_file, packed_corrupt_checksum)
+{
+  packed_file file;
+  ASSERT_TRUE(file.write(bootstrap::CODEC_NONE));
+  BootstrapFile bootstrap;
+  bootstrap::packed_index index;
+  ASSERT_TRUE(bootstrap.load_packed_index(file.path(), index));
+
+  bootstrap::chunk_header header;
+  std::string payload;
+  uint64_t payload_pos;
+  ASSERT_TRUE(file.read_chunk(index.chunks[2], header, payload, payload_pos));
+
+  // flip one payload byte on disk
+  {
+    std::fstream f(file.path(), std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+    f.seekp(payload_pos + 10);
+    f.put(payload[10] ^ 0x01);
+  }
+  std::vector<std::string> blocks;
+  ASSERT_TRUE(file.read_chunk(index.chunks[2], header, payload, payload_pos));
+  ASSERT_FALSE(BootstrapFile::unpack_chunk(header, payload, blocks));
+
+  // the other chunks are unaffected
+  ASSERT_TRUE(file.read_chunk(index.chunks[1], header, payload, payload_pos));
+  ASSERT_TRUE(BootstrapFile::unpack_chunk(header, payload, blocks));
+}
+
+TEST(bootstrap_file, packed_truncated_trailer)
+{
+  packed_file file;
+  ASSERT_TRUE(file.write(bootstrap::CODEC_NONE));
+  BootstrapFile bootstrap;
+  bootstrap::packed_index index, rebuilt;
+  ASSERT_TRUE(bootstrap.load_packed_index(file.path(), index));
+
+  // without a whole trailer the chunk headers are scanned instead
+  file.truncate(file.size() - 10);
+  ASSERT_TRUE(bootstrap.load_packed_index(file.path(), rebuilt));
+  ASSERT_EQ(rebuilt.block_end, index.block_end);
+  ASSERT_EQ(rebuilt.data_end, index.data_end);
+  ASSERT_EQ(rebuilt.chunks.size(), index.chunks.size());
+  for (size_t i = 0; i < index.chunks.size(); ++i)
+  {
+    ASSERT_EQ(rebuilt.chunks[i].block_first, index.chunks[i].block_first);
+    ASSERT_EQ(rebuilt.chunks[i].offset, index.chunks[i].offset);
+    ASSERT_EQ(rebuilt.chunks[i].block_count, index.chunks[i].block_count);
+    ASSERT_EQ(rebuilt.chunks[i].raw_size, index.chunks[i].raw_size);
+  }
+
+  // a partly written last chunk is dropped
+  file.truncate(index.chunks.back().offset + 20);
+  ASSERT_TRUE(bootstrap.load_packed_index(file.path(), rebuilt));
+  ASSERT_EQ(rebuilt.chunks.size(), index.chunks.size() - 1);
+  ASSERT_EQ(rebuilt.block_end, index.chunks.back().block_first);
+  ASSERT_EQ(rebuilt.data_end, index.chunks.back().offset);
+}
+
+TEST(bootstrap_file, packed_resume_mid_chunk)
+{
+  packed_file file;
+  ASSERT_TRUE(file.write(bootstrap::CODEC_NONE));
+  BootstrapFile bootstrap;
+  bootstrap::packed_index index;
+  ASSERT_TRUE(bootstrap.load_packed_index(file.path(), index));
+
+  // resuming at 250 starts from the chunk holding 200..299 and skips 50 blocks
+  const uint64_t resume_height = 250;
+  const size_t n = BootstrapFile::find_packed_chunk(index, resume_height);
+  ASSERT_EQ(n, 2);
+  ASSERT_EQ(BootstrapFile::find_packed_chunk(index, 200), 2);
+  ASSERT_EQ(BootstrapFile::find_packed_chunk(index, 199), 1);
+  ASSERT_EQ(BootstrapFile::find_packed_chunk(index, test_blocks + 5), index.chunks.size() - 1);
+
+  bootstrap::chunk_header header;
+  std::string payload;
+  uint64_t payload_pos;
+  ASSERT_TRUE(file.read_chunk(index.chunks[n], header, payload, payload_pos));
+  std::vector<std::string> blocks;
+  ASSERT_TRUE(BootstrapFile::unpack_chunk(header, payload, blocks));
+  bootstrap::block_package bp;
+  ASSERT_TRUE(::serialization::parse_binary(blocks[resume_height - header.block_first], bp));
+  ASSERT_EQ(bp.block.nonce, resume_height);
+
+  // a db batch starting mid-chunk is sized from every chunk it touches
+  ASSERT_EQ(BootstrapFile::count_packed_bytes(index, resume_height, 100),
+      index.chunks[2].raw_size + index.chunks[3].raw_size);
+}
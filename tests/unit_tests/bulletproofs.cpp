@@ -69,3 +69,46 @@ TEST(bulletproofs, invalid_31)
   rct::Bulletproof proof = bulletproof_PROVE(invalid_amount, rct::skGen());
   ASSERT_FALSE(rct::bulletproof_VERIFY(proof));
 }
+
+TEST(bulletproofs, invalid_scalar)
+{
+  rct::Bulletproof proof = bulletproof_PROVE(crypto::rand<uint64_t>(), rct::skGen());
+  ASSERT_TRUE(rct::bulletproof_VERIFY(proof));
+
+  // a + l is the same scalar mod l, but not reduced
+  unsigned int carry = 0;
+  for (size_t i = 0; i < 32; ++i)
+  {
+    carry += proof.a.bytes[i] + rct::curveOrder().bytes[i];
+    proof.a.bytes[i] = carry & 0xff;
+    carry >>= 8;
+  }
+  ASSERT_FALSE(rct::bulletproof_VERIFY(proof));
+  ASSERT_FALSE(rct::bulletproof_VERIFY_single(proof));
+  ASSERT_FALSE(rct::bulletproof_VERIFY(std::vector<const rct::Bulletproof*>(1, &proof)));
+}
+
+TEST(bulletproofs, valid_batch)
+{
+  std::vector<rct::Bulletproof> proofs;
+  for (int n = 0; n < 8; ++n)
+    proofs.push_back(bulletproof_PROVE(crypto::rand<uint64_t>(), rct::skGen()));
+  std::vector<const rct::Bulletproof*> batch;
+  for (const rct::Bulletproof &proof: proofs)
+    batch.push_back(&proof);
+  ASSERT_TRUE(rct::bulletproof_VERIFY(batch));
+}
+
+TEST(bulletproofs, invalid_in_batch)
+{
+  rct::key invalid_amount = rct::zero();
+  invalid_amount[8] = 1;
+  std::vector<rct::Bulletproof> proofs;
+  for (int n = 0; n < 4; ++n)
+    proofs.push_back(bulletproof_PROVE(crypto::rand<uint64_t>(), rct::skGen()));
+  proofs.push_back(bulletproof_PROVE(invalid_amount, rct::skGen()));
+  std::vector<const rct::Bulletproof*> batch;
+  for (const rct::Bulletproof &proof: proofs)
+    batch.push_back(&proof);
+  ASSERT_FALSE(rct::bulletproof_VERIFY(batch));
+}
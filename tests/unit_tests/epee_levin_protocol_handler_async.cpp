@@ -414,6 +414,41 @@ TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_process
   ASSERT_TRUE(conn->last_send_data().empty());
 }
 
+TEST_F(positive_test_connection_to_levin_protocol_handler_calls, shared_notify_sends_same_message_to_all_connections)
+{
+  // Setup
+  const int expected_command = 8452173;
+  const std::string in_data(4096, 'n');
+
+  test_connection_ptr conn1 = create_connection();
+  test_connection_ptr conn2 = create_connection();
+
+  // Test
+  const epee::net_utils::shared_buffer message = epee::levin::make_notify_buffer(expected_command, in_data);
+  ASSERT_EQ(1, conn1->m_protocol_handler.notify(message));
+  ASSERT_EQ(1, conn2->m_protocol_handler.notify(message));
+
+  // Check
+  ASSERT_EQ(*message, conn1->last_send_data());
+  ASSERT_EQ(*message, conn2->last_send_data());
+
+  epee::levin::bucket_head2 head;
+  ASSERT_EQ(sizeof(head) + in_data.size(), message->size());
+  memcpy(&head, message->data(), sizeof(head));
+  ASSERT_EQ(LEVIN_SIGNATURE, head.m_signature);
+  ASSERT_EQ(expected_command, head.m_command);
+  ASSERT_EQ(in_data.size(), head.m_cb);
+  ASSERT_FALSE(head.m_have_to_return_data);
+  ASSERT_EQ(LEVIN_PACKET_REQUEST, head.m_flags);
+  ASSERT_EQ(LEVIN_PROTOCOL_VER_1, head.m_protocol_version);
+  ASSERT_EQ(in_data, message->substr(sizeof(head)));
+
+  // the plain notify frames the same bytes
+  conn1->reset_last_send_data();
+  ASSERT_EQ(1, conn1->m_protocol_handler.notify(expected_command, in_data));
+  ASSERT_EQ(*message, conn1->last_send_data());
+}
+
 TEST_F(positive_test_connection_to_levin_protocol_handler_calls, handler_processes_qued_callback)
 {
   test_connection_ptr conn = create_connection();
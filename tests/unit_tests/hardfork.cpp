@@ -86,6 +86,10 @@ public:
   virtual uint64_t get_tx_count() const { return 0; }
   virtual std::vector<transaction> get_tx_list(const std::vector<crypto::hash>& hlist) const { return std::vector<transaction>(); }
   virtual uint64_t get_tx_block_height(const crypto::hash& h) const { return 0; }
+  virtual uint64_t get_ntz_tx_count() const { return 0; }
+  virtual uint64_t get_notarized_height(crypto::hash& ntz_txid) const { ntz_txid = crypto::null_hash; return 0; }
+  virtual uint64_t get_notarized_prevheight() const { return 0; }
+  virtual void get_block_tree_hashes(const uint64_t start_height, const size_t count, std::vector<crypto::hash>& hashes) const { hashes.assign(count, crypto::null_hash); }
   virtual uint64_t get_num_outputs(const uint64_t& amount) const { return 1; }
   virtual uint64_t get_indexing_base() const { return 0; }
   virtual output_data_t get_output_key(const uint64_t& amount, const uint64_t& index) { return output_data_t(); }
@@ -94,9 +98,11 @@ public:
   virtual tx_out_index get_output_tx_and_index(const uint64_t& amount, const uint64_t& index) const { return tx_out_index(); }
   virtual void get_output_tx_and_index(const uint64_t& amount, const std::vector<uint64_t> &offsets, std::vector<tx_out_index> &indices) const {}
   virtual void get_output_key(const uint64_t &amount, const std::vector<uint64_t> &offsets, std::vector<output_data_t> &outputs, bool allow_partial = false) {}
+  virtual void get_output_keys_batch(const std::vector<std::pair<uint64_t, uint64_t>> &outputs, std::vector<output_data_t> &data, std::vector<tx_out_index> *tx_out_indices = NULL) const {}
   virtual bool can_thread_bulk_indices() const { return false; }
   virtual std::vector<uint64_t> get_tx_output_indices(const crypto::hash& h) const { return std::vector<uint64_t>(); }
   virtual std::vector<uint64_t> get_tx_amount_output_indices(const uint64_t tx_index) const { return std::vector<uint64_t>(); }
+  virtual void get_tx_amount_output_indices_batch(const std::vector<crypto::hash>& tx_hashes, std::vector<std::vector<uint64_t>>& amount_output_indices) const {}
   virtual bool has_key_image(const crypto::key_image& img) const { return false; }
   virtual void remove_block() { blocks.pop_back(); }
   virtual uint64_t add_transaction_data(const crypto::hash& blk_hash, const transaction& tx, const crypto::hash& tx_hash) {return 0;}
@@ -105,10 +111,16 @@ public:
   virtual void add_tx_amount_output_indices(const uint64_t tx_index, const std::vector<uint64_t>& amount_output_indices) {}
   virtual void add_spent_key(const crypto::key_image& k_image) {}
   virtual void remove_spent_key(const crypto::key_image& k_image) {}
+  virtual uint64_t add_ntz_tx(const crypto::hash& tx_hash, const uint64_t height, const crypto::hash& tree_hash) { return 0; }
+  virtual void remove_ntz_tx_data(const crypto::hash& tx_hash) {}
+  virtual void add_block_tree_hash(const uint64_t height, const crypto::hash& tree_hash) {}
+  virtual void remove_block_tree_hash(const uint64_t height) {}
 
   virtual bool for_all_key_images(std::function<bool(const crypto::key_image&)>) const { return true; }
   virtual bool for_blocks_range(const uint64_t&, const uint64_t&, std::function<bool(uint64_t, const crypto::hash&, const cryptonote::block&)>) const { return true; }
   virtual bool for_all_transactions(std::function<bool(const crypto::hash&, const cryptonote::transaction&)>) const { return true; }
+  virtual bool for_all_ntz_txs(std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)>) const { return true; }
+  virtual bool for_ntz_txs_range(const uint64_t&, const uint64_t&, std::function<bool(uint64_t, const crypto::hash&, uint64_t, const crypto::hash&)>) const { return true; }
   virtual bool for_all_outputs(std::function<bool(uint64_t amount, const crypto::hash &tx_hash, uint64_t height, size_t tx_idx)> f) const { return true; }
   virtual bool for_all_outputs(uint64_t amount, const std::function<bool(uint64_t height)> &f) const { return true; }
   virtual bool is_read_only() const { return false; }
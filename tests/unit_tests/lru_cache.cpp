@@ -0,0 +1,113 @@
+// Copyright (c) 2018-2022, Blur Network
+//
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+#include "common/lru_cache.h"
+
+#include <string>
+
+TEST(lru_cache, find_missing)
+{
+  tools::lru_cache<int, std::string> cache(2);
+  ASSERT_TRUE(cache.find(0) == NULL);
+  ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(lru_cache, put_and_find)
+{
+  tools::lru_cache<int, std::string> cache(2);
+  cache.put(1, "one");
+  cache.put(2, "two");
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_TRUE(cache.find(1) != NULL);
+  ASSERT_EQ(*cache.find(1), "one");
+  ASSERT_EQ(*cache.find(2), "two");
+}
+
+TEST(lru_cache, evicts_least_recently_used)
+{
+  tools::lru_cache<int, std::string> cache(2);
+  cache.put(1, "one");
+  cache.put(2, "two");
+  ASSERT_TRUE(cache.find(1) != NULL);
+  cache.put(3, "three");
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_TRUE(cache.find(2) == NULL);
+  ASSERT_EQ(*cache.find(1), "one");
+  ASSERT_EQ(*cache.find(3), "three");
+}
+
+TEST(lru_cache, replace_refreshes)
+{
+  tools::lru_cache<int, std::string> cache(2);
+  cache.put(1, "one");
+  cache.put(2, "two");
+  cache.put(1, "uno");
+  cache.put(3, "three");
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(*cache.find(1), "uno");
+  ASSERT_TRUE(cache.find(2) == NULL);
+}
+
+TEST(lru_cache, erase)
+{
+  tools::lru_cache<int, std::string> cache(2);
+  cache.put(1, "one");
+  ASSERT_TRUE(cache.erase(1));
+  ASSERT_FALSE(cache.erase(1));
+  ASSERT_TRUE(cache.find(1) == NULL);
+  ASSERT_EQ(cache.size(), 0);
+}
+
+TEST(lru_cache, zero_capacity)
+{
+  tools::lru_cache<int, std::string> cache(0);
+  cache.put(1, "one");
+  ASSERT_EQ(cache.size(), 0);
+  ASSERT_TRUE(cache.find(1) == NULL);
+}
+
+TEST(lru_cache, weighted)
+{
+  tools::lru_cache<int, std::string> cache(10);
+  cache.put(1, "one", 4);
+  cache.put(2, "two", 4);
+  ASSERT_EQ(cache.weight(), 8);
+  ASSERT_TRUE(cache.find(1) != NULL);
+  cache.put(3, "three", 5);
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_EQ(cache.weight(), 9);
+  ASSERT_TRUE(cache.find(2) == NULL);
+  cache.put(1, "uno", 1);
+  ASSERT_EQ(cache.weight(), 6);
+  cache.put(4, "four", 11);
+  ASSERT_TRUE(cache.find(4) == NULL);
+  ASSERT_EQ(cache.size(), 2);
+  ASSERT_TRUE(cache.erase(3));
+  ASSERT_EQ(cache.weight(), 1);
+}
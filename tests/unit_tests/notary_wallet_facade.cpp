@@ -0,0 +1,193 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "notary_server/wallet_facade.h"
+
+namespace
+{
+  struct fake_wallet
+  {
+    fake_wallet(): value(0) {}
+    uint64_t value;
+  };
+
+  typedef tools::rw_wallet_facade<fake_wallet> facade_t;
+
+  template<typename F>
+  void run_threads(size_t threads, F f)
+  {
+    std::vector<boost::thread> workers;
+    for (size_t n = 0; n < threads; ++n)
+      workers.emplace_back(f);
+    for (auto &worker: workers)
+      worker.join();
+  }
+}
+
+TEST(notary_wallet_facade, reset)
+{
+  facade_t facade;
+  ASSERT_FALSE(facade.read());
+  ASSERT_FALSE(facade.write());
+
+  fake_wallet *wallet = new fake_wallet();
+  ASSERT_EQ(facade.write().reset(wallet), nullptr);
+  {
+    auto reader = facade.read();
+    ASSERT_TRUE(reader);
+    ASSERT_EQ(reader.get(), wallet);
+  }
+  {
+    auto writer = facade.write();
+    writer->value = 42;
+  }
+  ASSERT_EQ(facade.read()->value, 42);
+  ASSERT_EQ(facade.write().reset(NULL), wallet);
+  ASSERT_FALSE(facade.read());
+  delete wallet;
+}
+
+TEST(notary_wallet_facade, readers_overlap)
+{
+  static const size_t threads = 4;
+  facade_t facade;
+  fake_wallet wallet;
+  facade.write().reset(&wallet);
+
+  // every reader holds its guard until all of them are inside, which can
+  // only happen if the read guards are shared
+  boost::mutex lock;
+  boost::condition_variable cond;
+  size_t inside = 0;
+  std::atomic<size_t> met(0);
+  run_threads(threads, [&](){
+    auto reader = facade.read();
+    boost::unique_lock<boost::mutex> l(lock);
+    ++inside;
+    cond.notify_all();
+    if (cond.wait_for(l, boost::chrono::seconds(10), [&](){ return inside == threads; }))
+      ++met;
+  });
+  ASSERT_EQ(met, threads);
+  facade.write().reset(NULL);
+}
+
+TEST(notary_wallet_facade, writers_exclusive)
+{
+  static const size_t threads = 4;
+  static const size_t calls = 1000;
+  facade_t facade;
+  fake_wallet wallet;
+  facade.write().reset(&wallet);
+
+  std::atomic<size_t> inside(0);
+  std::atomic<bool> overlapped(false);
+  run_threads(threads, [&](){
+    for (size_t n = 0; n < calls; ++n)
+    {
+      auto writer = facade.write();
+      if (++inside > 1)
+        overlapped = true;
+      ++writer->value;
+      --inside;
+    }
+  });
+  ASSERT_FALSE(overlapped);
+  ASSERT_EQ(wallet.value, threads * calls);
+  facade.write().reset(NULL);
+}
+
+TEST(notary_wallet_facade, writers_exclude_readers)
+{
+  static const size_t threads = 4;
+  static const size_t calls = 1000;
+  facade_t facade;
+  fake_wallet wallet;
+  facade.write().reset(&wallet);
+
+  // half the threads read, half write, each side checking the other is out
+  std::atomic<size_t> readers(0), writers(0);
+  std::atomic<bool> overlapped(false);
+  std::atomic<size_t> next(0);
+  run_threads(threads, [&](){
+    const bool write = next++ % 2;
+    for (size_t n = 0; n < calls; ++n)
+    {
+      if (write)
+      {
+        auto writer = facade.write();
+        ++writers;
+        if (readers != 0 || writers > 1)
+          overlapped = true;
+        ++writer->value;
+        --writers;
+      }
+      else
+      {
+        auto reader = facade.read();
+        ++readers;
+        if (writers != 0)
+          overlapped = true;
+        --readers;
+      }
+    }
+  });
+  ASSERT_FALSE(overlapped);
+  ASSERT_EQ(wallet.value, threads / 2 * calls);
+
+  // a writer arriving while readers hold their guards only gets in once they left
+  boost::mutex lock;
+  boost::condition_variable cond;
+  bool release = false;
+  size_t seen = threads;
+  readers = 0;
+  boost::thread writer_thread;
+  run_threads(threads, [&](){
+    auto reader = facade.read();
+    boost::unique_lock<boost::mutex> l(lock);
+    if (++readers == threads)
+    {
+      writer_thread = boost::thread([&](){
+        auto writer = facade.write();
+        seen = readers;
+      });
+      release = true;
+      cond.notify_all();
+    }
+    cond.wait(l, [&](){ return release; });
+    --readers;
+  });
+  writer_thread.join();
+  ASSERT_EQ(seen, 0);
+  facade.write().reset(NULL);
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <list>
+#include <vector>
+
+#include "cryptonote_basic/ntz_signers.h"
+#include "cryptonote_protocol/cryptonote_protocol_defs.h"
+#include "storages/portable_storage_template_helper.h"
+
+namespace
+{
+  TEST(ntz_signers, mask_from_list)
+  {
+    std::list<int> signers = { 3, 0, 63, -1, -1 };
+    uint64_t mask = cryptonote::ntz_signers_mask(signers);
+    ASSERT_EQ(mask, (uint64_t(1) << 63) | (uint64_t(1) << 3) | 1);
+    ASSERT_EQ(cryptonote::ntz_signers_count(mask), 3);
+    ASSERT_TRUE(cryptonote::ntz_has_signer(mask, 63));
+    ASSERT_FALSE(cryptonote::ntz_has_signer(mask, 4));
+  }
+
+  TEST(ntz_signers, out_of_range_ignored)
+  {
+    std::vector<int> signers = { -1, 64, 100, -5 };
+    ASSERT_EQ(cryptonote::ntz_signers_mask(signers), (uint64_t)0);
+    ASSERT_FALSE(cryptonote::ntz_has_signer(~uint64_t(0), -1));
+    ASSERT_FALSE(cryptonote::ntz_has_signer(~uint64_t(0), 64));
+  }
+
+  TEST(ntz_signers, mask_from_string)
+  {
+    uint64_t mask = 0;
+    ASSERT_TRUE(cryptonote::ntz_signers_mask_from_string("0712-1-1-1", mask));
+    ASSERT_EQ(mask, (uint64_t(1) << 7) | (uint64_t(1) << 12));
+    ASSERT_TRUE(cryptonote::ntz_signers_mask_from_string("-1-1-1-1-1", mask));
+    ASSERT_EQ(mask, (uint64_t)0);
+  }
+
+  TEST(ntz_signers, mask_from_bad_string)
+  {
+    uint64_t mask = 0;
+    ASSERT_FALSE(cryptonote::ntz_signers_mask_from_string("071", mask));
+    ASSERT_FALSE(cryptonote::ntz_signers_mask_from_string("07x2", mask));
+    ASSERT_FALSE(cryptonote::ntz_signers_mask_from_string("0764", mask));
+  }
+
+  TEST(ntz_signers, string_round_trip)
+  {
+    std::vector<int> signers = { 5, 12, 63, -1, -1 };
+    const std::string str = cryptonote::ntz_signers_to_string(signers);
+    ASSERT_EQ(str, "051263-1-1");
+    uint64_t mask = 0;
+    ASSERT_TRUE(cryptonote::ntz_signers_mask_from_string(str, mask));
+    ASSERT_EQ(mask, cryptonote::ntz_signers_mask(signers));
+  }
+
+  TEST(ntz_signers, announce_round_trip)
+  {
+    cryptonote::NOTIFY_NTZ_SIG_ANNOUNCE::request announce = AUTO_VAL_INIT(announce);
+    memset(announce.tx_hash.data, 0x11, sizeof(announce.tx_hash.data));
+    memset(announce.prior_tx_hash.data, 0x22, sizeof(announce.prior_tx_hash.data));
+    announce.sig_count = 3;
+    announce.signers_mask = cryptonote::ntz_signers_mask(std::vector<int>{ 1, 2, 40 });
+
+    std::string blob;
+    ASSERT_TRUE(epee::serialization::store_t_to_binary(announce, blob));
+    ASSERT_LT(blob.size(), 256u);
+
+    cryptonote::NOTIFY_NTZ_SIG_ANNOUNCE::request out = AUTO_VAL_INIT(out);
+    ASSERT_TRUE(epee::serialization::load_t_from_binary(out, blob));
+    ASSERT_EQ(out.tx_hash, announce.tx_hash);
+    ASSERT_EQ(out.prior_tx_hash, announce.prior_tx_hash);
+    ASSERT_EQ(out.sig_count, 3);
+    ASSERT_EQ(out.signers_mask, announce.signers_mask);
+  }
+}
@@ -0,0 +1,283 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include "blockchain_db/ntz_state.h"
+#include "blockchain_db/blockchain_db.h"
+#include "cryptonote_basic/cryptonote_format_utils.h"
+
+static crypto::hash make_leaf(uint64_t n)
+{
+  return crypto::cn_fast_hash(&n, sizeof(n));
+}
+
+static crypto::hash tree_root(const std::vector<crypto::hash>& leaves)
+{
+  crypto::hash root = crypto::null_hash;
+  if (!leaves.empty())
+    crypto::tree_hash(leaves.data(), leaves.size(), root);
+  return root;
+}
+
+TEST(ntz_state, empty)
+{
+  cryptonote::merkle_accumulator acc;
+  ASSERT_EQ(acc.size(), 0);
+  ASSERT_EQ(acc.root(), crypto::null_hash);
+  ASSERT_FALSE(acc.pop());
+}
+
+TEST(ntz_state, append)
+{
+  cryptonote::merkle_accumulator acc;
+  std::vector<crypto::hash> leaves;
+  for (uint64_t n = 0; n < 40; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    acc.append(leaves.back());
+    ASSERT_EQ(acc.size(), leaves.size());
+    ASSERT_EQ(acc.root(), tree_root(leaves));
+  }
+}
+
+TEST(ntz_state, pop)
+{
+  cryptonote::merkle_accumulator acc;
+  std::vector<crypto::hash> leaves;
+  for (uint64_t n = 0; n < 40; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    acc.append(leaves.back());
+  }
+  while (!leaves.empty())
+  {
+    ASSERT_TRUE(acc.pop());
+    leaves.pop_back();
+    ASSERT_EQ(acc.size(), leaves.size());
+    ASSERT_EQ(acc.root(), tree_root(leaves));
+  }
+  ASSERT_FALSE(acc.pop());
+}
+
+TEST(ntz_state, reorg)
+{
+  cryptonote::merkle_accumulator acc;
+  std::vector<crypto::hash> leaves;
+  for (uint64_t n = 0; n < 23; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    acc.append(leaves.back());
+  }
+  for (int i = 0; i < 7; ++i)
+  {
+    ASSERT_TRUE(acc.pop());
+    leaves.pop_back();
+  }
+  for (uint64_t n = 100; n < 110; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    acc.append(leaves.back());
+  }
+  ASSERT_EQ(acc.root(), tree_root(leaves));
+
+  acc.clear();
+  ASSERT_EQ(acc.size(), 0);
+  ASSERT_EQ(acc.root(), crypto::null_hash);
+}
+
+TEST(ntz_state, notarized_tree_hashes_one_leaf_per_ntz_tx)
+{
+  cryptonote::notarized_tree_hashes leaves;
+  ASSERT_EQ(leaves.root(), crypto::null_hash);
+  ASSERT_FALSE(leaves.pop());
+
+  // blocks 10 and 30 hold two ntz txes each; get_ntz_merkle() took the tree
+  // hash of the block of every notarization
+  const uint64_t heights[] = { 10, 10, 20, 30, 30, 40 };
+  std::vector<crypto::hash> baseline;
+  for (uint64_t h : heights)
+  {
+    baseline.push_back(make_leaf(h));
+    leaves.push(h, make_leaf(h));
+    ASSERT_EQ(leaves.size(), baseline.size());
+    ASSERT_EQ(leaves.root(), cryptonote::get_tx_tree_hash(baseline));
+  }
+  ASSERT_EQ(leaves.size(), 6);
+
+  // popping drops one leaf per ntz tx, block 30's two included
+  while (baseline.size() > 3)
+  {
+    ASSERT_TRUE(leaves.pop());
+    baseline.pop_back();
+    ASSERT_EQ(leaves.root(), cryptonote::get_tx_tree_hash(baseline));
+  }
+
+  leaves.clear();
+  ASSERT_EQ(leaves.size(), 0);
+  ASSERT_EQ(leaves.root(), crypto::null_hash);
+}
+
+TEST(ntz_state, notarized_tree_hashes_covering)
+{
+  cryptonote::notarized_tree_hashes leaves;
+  uint64_t ntz_height = 0, prev_height = 0;
+  ASSERT_FALSE(leaves.covering(1, ntz_height, prev_height));
+
+  const uint64_t heights[] = { 10, 10, 20, 30, 30, 40 };
+  for (uint64_t h : heights)
+    leaves.push(h, make_leaf(h));
+
+  ASSERT_TRUE(leaves.covering(1, ntz_height, prev_height));
+  ASSERT_EQ(ntz_height, 10);
+  ASSERT_EQ(prev_height, 0);
+  ASSERT_TRUE(leaves.covering(10, ntz_height, prev_height));
+  ASSERT_EQ(ntz_height, 10);
+  ASSERT_EQ(prev_height, 0);
+  ASSERT_TRUE(leaves.covering(11, ntz_height, prev_height));
+  ASSERT_EQ(ntz_height, 20);
+  ASSERT_EQ(prev_height, 10);
+  ASSERT_TRUE(leaves.covering(40, ntz_height, prev_height));
+  ASSERT_EQ(ntz_height, 40);
+  ASSERT_EQ(prev_height, 30);
+  ASSERT_FALSE(leaves.covering(41, ntz_height, prev_height));
+
+  leaves.pop();
+  ASSERT_FALSE(leaves.covering(31, ntz_height, prev_height));
+}
+
+// a MoM window is the tree hash of its leaves in ascending height order
+static crypto::hash naive_mom(const std::vector<crypto::hash>& leaves, uint64_t base, uint64_t height, uint64_t depth)
+{
+  return tree_root(std::vector<crypto::hash>(leaves.begin() + (height + 1 - depth - base), leaves.begin() + (height + 1 - base)));
+}
+
+TEST(ntz_state, mom_index_windows)
+{
+  const uint64_t base = 7;
+  cryptonote::mom_index idx(5, 100);
+  idx.reset(base);
+  std::vector<crypto::hash> leaves;
+  for (uint64_t n = 0; n < 300; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    idx.push(leaves.back());
+  }
+  ASSERT_EQ(idx.height(), base + 300);
+  ASSERT_EQ(idx.start_height(), base + 200);
+
+  for (uint64_t h = idx.start_height(); h < idx.height(); ++h)
+  {
+    for (uint64_t d = 1; d <= idx.max_depth(); ++d)
+    {
+      if (h + 1 < idx.start_height() + d)
+      {
+        ASSERT_FALSE(idx.covers(h, d));
+        continue;
+      }
+      ASSERT_TRUE(idx.covers(h, d));
+      ASSERT_EQ(idx.root(h, d), naive_mom(leaves, base, h, d));
+    }
+  }
+  ASSERT_FALSE(idx.covers(idx.height(), 1));
+  ASSERT_FALSE(idx.covers(idx.height() - 1, 0));
+  ASSERT_FALSE(idx.covers(idx.height() - 1, idx.max_depth() + 1));
+}
+
+TEST(ntz_state, mom_index_reorg)
+{
+  cryptonote::mom_index idx(4, 64);
+  idx.reset(0);
+  std::vector<crypto::hash> leaves;
+  for (uint64_t n = 0; n < 50; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    idx.push(leaves.back());
+  }
+  for (int i = 0; i < 9; ++i)
+  {
+    ASSERT_TRUE(idx.pop());
+    leaves.pop_back();
+  }
+  for (uint64_t n = 100; n < 120; ++n)
+  {
+    leaves.push_back(make_leaf(n));
+    idx.push(leaves.back());
+  }
+  ASSERT_EQ(idx.height(), leaves.size());
+  for (uint64_t d = 1; d <= idx.max_depth(); ++d)
+    ASSERT_EQ(idx.root(idx.height() - 1, d), naive_mom(leaves, 0, idx.height() - 1, d));
+}
+
+TEST(ntz_state, mom_index_matches_notarized_mom)
+{
+  // with every block of a range notarized once, the notarized MoM and the
+  // MoM window over that range fold the same leaves
+  const uint64_t base = 50;
+  cryptonote::mom_index idx(6, 200);
+  idx.reset(base);
+  cryptonote::notarized_tree_hashes notarized;
+  for (uint64_t h = base; h < base + 150; ++h)
+  {
+    idx.push(make_leaf(h));
+    notarized.push(h, make_leaf(h));
+    const uint64_t depth = h + 1 - base;
+    if (depth <= idx.max_depth())
+      ASSERT_EQ(idx.root(h, depth), notarized.root());
+  }
+}
+
+TEST(ntz_state, ntzpool_cache_snapshots)
+{
+  cryptonote::ntzpool_cache cache;
+  ASSERT_TRUE(cache.snapshot()->empty());
+
+  cryptonote::ntzpool_entry entry = AUTO_VAL_INIT(entry);
+  entry.blob = "tx";
+  entry.ptx_blob = "ptx";
+  cache.put(make_leaf(1), entry);
+  const cryptonote::ntzpool_cache::snapshot_t before = cache.snapshot();
+
+  entry.meta.sig_count = 3;
+  cache.put(make_leaf(2), entry);
+  ASSERT_TRUE(cache.update_meta(make_leaf(1), entry.meta));
+  ASSERT_TRUE(cache.erase(make_leaf(2)));
+  ASSERT_FALSE(cache.erase(make_leaf(2)));
+  ASSERT_FALSE(cache.update_meta(make_leaf(3), entry.meta));
+
+  // a snapshot taken earlier does not see later writes
+  ASSERT_EQ(before->size(), 1);
+  ASSERT_EQ(before->at(make_leaf(1)).meta.sig_count, 0);
+  const cryptonote::ntzpool_cache::snapshot_t after = cache.snapshot();
+  ASSERT_EQ(after->size(), 1);
+  ASSERT_EQ(after->at(make_leaf(1)).meta.sig_count, 3);
+  ASSERT_EQ(after->at(make_leaf(1)).ptx_blob, "ptx");
+
+  cache.reset(cryptonote::ntzpool_cache::entries_t());
+  ASSERT_TRUE(cache.snapshot()->empty());
+  ASSERT_EQ(after->size(), 1);
+}
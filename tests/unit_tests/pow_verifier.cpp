@@ -0,0 +1,88 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <vector>
+
+#include "cryptonote_basic/cryptonote_format_utils.h"
+#include "cryptonote_core/pow_verifier.h"
+
+namespace
+{
+  std::vector<cryptonote::block> make_blocks(size_t count)
+  {
+    std::vector<cryptonote::block> blocks(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      blocks[i].major_version = 1;
+      blocks[i].minor_version = 1;
+      blocks[i].timestamp = 1000 + i;
+      blocks[i].nonce = i;
+    }
+    return blocks;
+  }
+
+  TEST(pow_verifier, matches_serial_hashes)
+  {
+    const uint64_t height = 100;
+    const std::vector<cryptonote::block> blocks = make_blocks(5);
+    std::atomic<bool> cancel(false);
+
+    cryptonote::pow_verifier verifier;
+    std::vector<crypto::hash> pow;
+    ASSERT_TRUE(verifier.compute(height, blocks, pow, cancel));
+    ASSERT_EQ(pow.size(), blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i)
+      ASSERT_EQ(pow[i], cryptonote::get_block_longhash(blocks[i], height + i));
+
+    const cryptonote::pow_verifier_stats stats = verifier.get_stats();
+    ASSERT_EQ(stats.batches, 1);
+    ASSERT_EQ(stats.hashes, blocks.size());
+    ASSERT_GE(stats.threads, 1);
+    ASSERT_LE(stats.threads, blocks.size());
+  }
+
+  TEST(pow_verifier, thread_limit)
+  {
+    cryptonote::pow_verifier verifier;
+    verifier.set_max_threads(1);
+    ASSERT_EQ(verifier.get_max_threads(), 1);
+    verifier.set_max_threads(0);
+    ASSERT_GE(verifier.get_max_threads(), 1);
+  }
+
+  TEST(pow_verifier, cancelled)
+  {
+    std::atomic<bool> cancel(true);
+    cryptonote::pow_verifier verifier;
+    std::vector<crypto::hash> pow;
+    ASSERT_FALSE(verifier.compute(0, make_blocks(3), pow, cancel));
+    ASSERT_EQ(verifier.get_stats().hashes, 0);
+  }
+}
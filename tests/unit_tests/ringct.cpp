@@ -1066,6 +1066,29 @@ TEST(ringct, reject_gen_non_simple_ver_simple)
   ASSERT_FALSE(rct::verRctSimple(sig));
 }
 
+TEST(ringct, mg_checks)
+{
+  const uint64_t inputs[] = {1000, 1000};
+  const uint64_t outputs[] = {1500};
+  rct::rctSig sig = make_sample_simple_rct_sig(NELTS(inputs), inputs, NELTS(outputs), outputs, 500);
+  std::vector<std::function<bool()>> checks;
+  ASSERT_TRUE(rct::getRctMGChecks(sig, checks));
+  ASSERT_EQ(checks.size(), NELTS(inputs));
+  for (const auto &check: checks)
+    ASSERT_TRUE(check());
+
+  sig.p.MGs[1].cc[0] ^= 1;
+  ASSERT_TRUE(checks[0]());
+  ASSERT_FALSE(checks[1]());
+
+  const uint64_t outputs_with_fee[] = {1500, 500};
+  sig = make_sample_rct_sig(NELTS(inputs), inputs, NELTS(outputs_with_fee), outputs_with_fee, true);
+  checks.clear();
+  ASSERT_TRUE(rct::getRctMGChecks(sig, checks));
+  ASSERT_EQ(checks.size(), 1u);
+  ASSERT_TRUE(checks[0]());
+}
+
 TEST(ringct, key_ostream)
 {
   std::stringstream out;
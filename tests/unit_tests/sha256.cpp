@@ -29,6 +29,8 @@
 #include "gtest/gtest.h"
 
 #include "common/util.h"
+#include "cryptonote_basic/komodo_notaries.h"
+#include "cryptonote_basic/komodo_sha256.h"
 #include "string_tools.h"
 
 static bool check(const std::string &data, const char *expected_hash_hex)
@@ -43,3 +45,48 @@ TEST(sha256, empty) { ASSERT_TRUE(check(std::string(), "e3b0c44298fc1c149afbf4c8
 TEST(sha256, small) { ASSERT_TRUE(check("0123456789", "84d89877f0d4041efb6bf91a16f0248f2fd573e6af05c19f96bedb9f882f7882")); }
 TEST(sha256, large) { ASSERT_TRUE(check(std::string(65536*256, 0), "080acf35a507ac9849cfcba47dc2ad83e01b75663a516279c8b9d243b719643e")); }
 
+
+static void check_komodo_backend(cryptonote::komodo::sha256_backend backend)
+{
+  if (!cryptonote::komodo::sha256_backend_supported(backend))
+    return;
+
+  // cover empty, one and two block paddings, and lanes of mixed length
+  std::vector<std::string> messages;
+  for (size_t len = 0; len < 200; len += 7)
+    messages.push_back(std::string(len, (char)len));
+  std::vector<const uint8_t*> data;
+  std::vector<int32_t> lens;
+  for (const auto &m: messages)
+  {
+    data.push_back((const uint8_t*)m.data());
+    lens.push_back(m.size());
+  }
+
+  std::vector<uint8_t> hashes(32 * messages.size());
+  cryptonote::komodo::sha256_many(data.data(), lens.data(), reinterpret_cast<uint8_t(*)[32]>(hashes.data()), messages.size(), backend);
+  for (size_t i = 0; i < messages.size(); ++i)
+  {
+    crypto::hash expected;
+    ASSERT_TRUE(tools::sha256sum((const uint8_t*)messages[i].data(), messages[i].size(), expected));
+    ASSERT_EQ(0, memcmp(&expected, hashes.data() + 32 * i, 32)) << cryptonote::komodo::sha256_backend_name(backend) << " len " << lens[i];
+  }
+
+  std::vector<cryptonote::bits256> doubles(messages.size());
+  cryptonote::komodo::bits256_doublesha256_many(data.data(), lens.data(), doubles.data(), messages.size(), backend);
+  for (size_t i = 0; i < messages.size(); ++i)
+  {
+    // komodo's own sha256, twice, with the bytes reversed
+    uint8_t first[32], second[32];
+    cryptonote::komodo::vcalc_sha256(first, data[i], lens[i]);
+    cryptonote::komodo::vcalc_sha256(second, first, sizeof(first));
+    for (size_t j = 0; j < 32; ++j)
+      ASSERT_EQ(second[31 - j], doubles[i].bytes[j]) << cryptonote::komodo::sha256_backend_name(backend) << " len " << lens[i];
+    const cryptonote::bits256 single = cryptonote::komodo::bits256_doublesha256(data[i], lens[i]);
+    ASSERT_EQ(0, memcmp(single.bytes, doubles[i].bytes, 32)) << cryptonote::komodo::sha256_backend_name(backend) << " len " << lens[i];
+  }
+}
+
+TEST(sha256, komodo_scalar) { check_komodo_backend(cryptonote::komodo::sha256_backend::scalar); }
+TEST(sha256, komodo_sha_ni) { check_komodo_backend(cryptonote::komodo::sha256_backend::sha_ni); }
+TEST(sha256, komodo_avx2) { check_komodo_backend(cryptonote::komodo::sha256_backend::avx2); }
@@ -0,0 +1,161 @@
+// Copyright (c) 2018-2022, Blur Network
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification, are
+// permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this list of
+//    conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice, this list
+//    of conditions and the following disclaimer in the documentation and/or other
+//    materials provided with the distribution.
+//
+// 3. Neither the name of the copyright holder nor the names of its contributors may be
+//    used to endorse or promote products derived from this software without specific
+//    prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+// MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL
+// THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+// PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT,
+// STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF
+// THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <vector>
+
+#include "common/threadpool.h"
+
+namespace
+{
+  // each task submits fanout subtasks and waits on them, down to depth 0
+  void nested(tools::threadpool &tpool, size_t depth, size_t fanout, std::atomic<size_t> &leaves)
+  {
+    if (depth == 0)
+    {
+      ++leaves;
+      return;
+    }
+    tools::threadpool::waiter waiter;
+    for (size_t i = 0; i < fanout; ++i)
+      tpool.submit(&waiter, [&tpool, depth, fanout, &leaves] { nested(tpool, depth - 1, fanout, leaves); });
+    waiter.wait();
+  }
+
+  // each task queues the next one to the same waiter, until count have run
+  void chain(tools::threadpool &tpool, tools::threadpool::waiter &waiter, size_t count, std::atomic<size_t> &ran)
+  {
+    if (++ran < count)
+      tpool.submit(&waiter, [&tpool, &waiter, count, &ran] { chain(tpool, waiter, count, ran); });
+  }
+}
+
+TEST(threadpool, runs_all)
+{
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  const tools::threadpool::stats before = tpool.get_stats();
+  std::vector<int> done(1000, 0);
+  tools::threadpool::waiter waiter;
+  for (size_t i = 0; i < done.size(); ++i)
+    tpool.submit(&waiter, [&done, i] { done[i] = 1; });
+  waiter.wait();
+  for (size_t i = 0; i < done.size(); ++i)
+    ASSERT_EQ(done[i], 1);
+
+  const tools::threadpool::stats after = tpool.get_stats();
+  ASSERT_EQ(after.submitted - before.submitted, done.size());
+  ASSERT_GE(after.executed - before.executed, done.size());
+}
+
+TEST(threadpool, nested_waits)
+{
+  // many more waiting tasks than threads, which must not deadlock
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  std::atomic<size_t> leaves(0);
+  nested(tpool, 4, 6, leaves);
+  ASSERT_EQ(leaves, 6 * 6 * 6 * 6);
+}
+
+TEST(threadpool, waits_for_tasks_queued_while_waiting)
+{
+  // the waiter has to pick up tasks its own tasks queue after wait() started
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  for (size_t n = 0; n < 20; ++n)
+  {
+    std::atomic<size_t> ran(0);
+    tools::threadpool::waiter waiter;
+    tpool.submit(&waiter, [&tpool, &waiter, &ran] { chain(tpool, waiter, 500, ran); });
+    waiter.wait();
+    ASSERT_EQ(ran, 500);
+  }
+}
+
+TEST(threadpool, priorities)
+{
+  // Hold every worker in a blocker task, queue LOW then HIGH tasks, and let a
+  // single worker go, so they run one at a time in the order the pool picks.
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  const size_t workers = tpool.get_max_concurrency();
+  std::atomic<size_t> started(0), released(0);
+  tools::threadpool::waiter blockers;
+  for (size_t i = 0; i < workers; ++i)
+  {
+    tpool.submit(&blockers, [&started, &released] {
+      const size_t id = started++;
+      while (released <= id)
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+    });
+  }
+  while (started < workers)
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+
+  const size_t count = 20;
+  boost::mutex order_mutex;
+  std::vector<tools::threadpool::priority> order;
+  tools::threadpool::waiter waiter;
+  for (tools::threadpool::priority p: {tools::threadpool::PRIORITY_LOW, tools::threadpool::PRIORITY_HIGH})
+  {
+    for (size_t i = 0; i < count; ++i)
+    {
+      tpool.submit(&waiter, [&order_mutex, &order, p] {
+        boost::unique_lock<boost::mutex> lock(order_mutex);
+        order.push_back(p);
+      }, p);
+    }
+  }
+
+  // waiting now would have this thread run tasks too, so poll instead
+  released = 1;
+  while (true)
+  {
+    {
+      boost::unique_lock<boost::mutex> lock(order_mutex);
+      if (order.size() == 2 * count)
+        break;
+    }
+    boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+  }
+  released = workers;
+  waiter.wait();
+  blockers.wait();
+
+  for (size_t i = 0; i < order.size(); ++i)
+    ASSERT_EQ(order[i], i < count ? tools::threadpool::PRIORITY_HIGH : tools::threadpool::PRIORITY_LOW);
+}
+
+TEST(threadpool, exception)
+{
+  tools::threadpool &tpool = tools::threadpool::getInstance();
+  std::atomic<size_t> count(0);
+  tools::threadpool::waiter waiter;
+  tpool.submit(&waiter, [] { throw std::runtime_error("test"); });
+  tpool.submit(&waiter, [&count] { ++count; });
+  waiter.wait();
+  ASSERT_EQ(count, 1);
+}